@@ -0,0 +1,264 @@
+/**
+ * @file EngineBench.cpp
+ * @brief Runs the whole engine on a scripted scene and reports the frame statistics as JSON.
+ *
+ * The scene, the camera path and the frame count are read from the `bench` section of the config.json,
+ * see engine/bench/config.json. Every frame advances the time by a fixed dt, so two runs draw the same frames.
+ * Run it from a directory with the resources, preferably headless:
+ *
+ * Usage: engine-bench --configuration ../../bench/config.json --headless [--output bench.json]
+ */
+
+#include <engine/core/Engine.hpp>
+#include <engine/graphics/GraphicsController.hpp>
+#include <json.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+namespace engine::bench {
+    /**
+    * @brief A closed Catmull-Rom spline through the control points, traversed once every `loop_seconds`.
+    */
+    struct CameraPath {
+        std::vector<glm::vec3> points;
+        glm::vec3 target{0.0f};
+        float loop_seconds{10.0f};
+
+        glm::vec3 sample(float seconds) const {
+            const auto count = static_cast<int>(points.size());
+            if (count == 1) {
+                return points.front();
+            }
+            const float u         = std::fmod(seconds / loop_seconds, 1.0f) * static_cast<float>(count);
+            const int segment     = static_cast<int>(u) % count;
+            const float t         = u - std::floor(u);
+            const glm::vec3 &p0   = points[(segment + count - 1) % count];
+            const glm::vec3 &p1   = points[segment];
+            const glm::vec3 &p2   = points[(segment + 1) % count];
+            const glm::vec3 &p3   = points[(segment + 2) % count];
+            return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t * t +
+                           (3.0f * p1 - p0 - 3.0f * p2 + p3) * t * t * t);
+        }
+    };
+
+    struct SceneObject {
+        const resources::Model *model;
+        resources::Shader *shader;
+        glm::mat4 transform;
+    };
+
+    struct FrameSample {
+        double frame_ms;
+        graphics::RenderStats stats;
+        uint32_t state_calls_elided;
+    };
+
+    glm::vec3 to_vec3(const nlohmann::json &value) {
+        return glm::vec3(value.at(0).get<float>(), value.at(1).get<float>(), value.at(2).get<float>());
+    }
+
+    /**
+    * @brief Percentile of sorted samples, the same way @ref util::Profiler computes p99.
+    */
+    double percentile(const std::vector<double> &sorted, double p) {
+        const auto index = static_cast<std::size_t>(std::ceil(p * static_cast<double>(sorted.size()))) - 1;
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    class BenchController final : public core::Controller {
+    public:
+        std::string_view name() const override {
+            return "BenchController";
+        }
+
+    private:
+        void initialize() override {
+            const auto &config = util::Configuration::config();
+            RG_GUARANTEE(config.contains("bench"), "engine-bench needs the \"bench\" section in the config.json.");
+            const auto &bench = config["bench"];
+            m_frames          = bench.value<int>("frames", 600);
+            m_warmup_frames   = bench.value<int>("warmup_frames", 60);
+            m_finish_frames   = bench.value<bool>("finish_frames", true);
+            m_output          = util::ArgParser::instance()->arg<std::string>("--output", "bench.json").value();
+
+            auto resources = core::Controller::get<resources::ResourcesController>();
+            resources->finish_loading();
+            for (const auto &entry: bench.at("scene")) {
+                const auto model     = resources->model(entry.at("model").get<std::string>());
+                const auto shader    = resources->shader(entry.at("shader").get<std::string>());
+                const glm::vec3 base = to_vec3(entry.value("position", nlohmann::json::array({0, 0, 0})));
+                const float scale    = entry.value<float>("scale", 1.0f);
+                const float spacing  = entry.value<float>("spacing", 0.0f);
+                const glm::vec3 grid = to_vec3(entry.value("grid", nlohmann::json::array({1, 1, 1})));
+                for (int x = 0; x < static_cast<int>(grid.x); ++x) {
+                    for (int y = 0; y < static_cast<int>(grid.y); ++y) {
+                        for (int z = 0; z < static_cast<int>(grid.z); ++z) {
+                            const glm::vec3 position = base + spacing * glm::vec3(x, y, z);
+                            m_scene.push_back(SceneObject{
+                                    model, shader,
+                                    glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(scale))
+                            });
+                        }
+                    }
+                }
+            }
+            if (bench.contains("skybox")) {
+                m_skybox_shader = resources->shader(bench["skybox"].at("shader").get<std::string>());
+                m_skybox        = resources->skybox(bench["skybox"].at("skybox").get<std::string>());
+            }
+            const auto &camera = bench.at("camera");
+            for (const auto &point: camera.at("path")) {
+                m_camera_path.points.push_back(to_vec3(point));
+            }
+            RG_GUARANTEE(!m_camera_path.points.empty(), "The bench camera path needs at least one point.");
+            m_camera_path.target       = to_vec3(camera.value("target", nlohmann::json::array({0, 0, 0})));
+            m_camera_path.loop_seconds = camera.value<float>("loop_seconds", 10.0f);
+
+            core::Controller::get<platform::PlatformController>()->set_fixed_dt(bench.value<float>("dt", 1.0f / 60.0f));
+            graphics::OpenGL::enable_depth_testing();
+            m_load_time_ms = resources->load_time_ms();
+            m_samples.reserve(m_frames);
+            m_frame_begin = std::chrono::steady_clock::now();
+        }
+
+        bool loop() override {
+            if (m_frame < m_warmup_frames + m_frames) {
+                return true;
+            }
+            write_report();
+            return false;
+        }
+
+        void update() override {
+            const auto platform = core::Controller::get<platform::PlatformController>();
+            auto camera         = core::Controller::get<graphics::GraphicsController>()->camera();
+            camera->Position    = m_camera_path.sample(platform->frame_time().current);
+            camera->look_at(m_camera_path.target);
+        }
+
+        void begin_draw() override {
+            graphics::OpenGL::clear_buffers();
+        }
+
+        void draw() override {
+            auto graphics = core::Controller::get<graphics::GraphicsController>();
+            for (const auto &object: m_scene) {
+                graphics->draw_model(object.model, object.shader, object.transform);
+            }
+            if (m_skybox) {
+                graphics->draw_skybox(m_skybox_shader, m_skybox);
+            }
+        }
+
+        void end_draw() override {
+            core::Controller::get<platform::PlatformController>()->swap_buffers();
+            if (m_finish_frames) {
+                // Count the GPU work in the frame time, instead of letting the driver queue up frames.
+                graphics::OpenGL::finish();
+            }
+            const auto now       = std::chrono::steady_clock::now();
+            const double frame_ms = std::chrono::duration<double, std::milli>(now - m_frame_begin).count();
+            m_frame_begin         = now;
+            if (m_frame++ >= m_warmup_frames) {
+                const auto graphics = core::Controller::get<graphics::GraphicsController>();
+                m_samples.push_back(FrameSample{frame_ms, graphics->render_stats(), graphics->state_stats().elided()});
+            }
+        }
+
+        void write_report() const {
+            using json = nlohmann::json;
+            std::vector<double> frame_ms;
+            frame_ms.reserve(m_samples.size());
+            double frame_sum = 0.0;
+            graphics::RenderStats total{};
+            graphics::RenderStats peak{};
+            uint64_t state_calls_elided = 0;
+            for (const auto &[ms, stats, elided]: m_samples) {
+                state_calls_elided += elided;
+                frame_ms.push_back(ms);
+                frame_sum += ms;
+                total.draw_calls += stats.draw_calls;
+                total.triangles += stats.triangles;
+                total.culled += stats.culled;
+                total.program_binds += stats.program_binds;
+                total.texture_binds += stats.texture_binds;
+                total.vao_binds += stats.vao_binds;
+                total.uniform_buffer_binds += stats.uniform_buffer_binds;
+                total.batches += stats.batches;
+                total.batched_draws += stats.batched_draws;
+                peak.draw_calls = std::max(peak.draw_calls, stats.draw_calls);
+                peak.triangles  = std::max(peak.triangles, stats.triangles);
+            }
+            std::sort(frame_ms.begin(), frame_ms.end());
+            const double frames = std::max<double>(1.0, static_cast<double>(m_samples.size()));
+
+            json report;
+            report["frames"]        = m_samples.size();
+            report["warmup_frames"] = m_warmup_frames;
+            report["dt"]            = core::Controller::get<platform::PlatformController>()->fixed_dt();
+            report["objects"]       = m_scene.size();
+            report["load_ms"]       = m_load_time_ms;
+            if (!frame_ms.empty()) {
+                report["frame_ms"] = {
+                        {"min", frame_ms.front()},
+                        {"avg", frame_sum / frames},
+                        {"p50", percentile(frame_ms, 0.50)},
+                        {"p90", percentile(frame_ms, 0.90)},
+                        {"p99", percentile(frame_ms, 0.99)},
+                        {"max", frame_ms.back()},
+                };
+            }
+            report["draw_calls"] = {{"avg", total.draw_calls / frames}, {"max", peak.draw_calls}};
+            report["triangles"]  = {{"avg", total.triangles / frames}, {"max", peak.triangles}};
+            report["culled"]     = {{"avg", total.culled / frames}};
+            report["batches"]    = {{"avg", total.batches / frames}, {"meshes", total.batched_draws / frames}};
+            report["state_changes"] = {
+                    {"program_binds", total.program_binds / frames},
+                    {"texture_binds", total.texture_binds / frames},
+                    {"vao_binds", total.vao_binds / frames},
+                    {"uniform_buffer_binds", total.uniform_buffer_binds / frames},
+                    {"elided", static_cast<double>(state_calls_elided) / frames},
+            };
+
+            const std::string text = report.dump(4);
+            std::ofstream file(m_output);
+            file << text << '\n';
+            if (file.good()) {
+                spdlog::info("[engine-bench]: wrote the report to {}", m_output);
+            } else {
+                spdlog::error("[engine-bench]: failed to write the report to {}", m_output);
+            }
+            std::puts(text.c_str());
+        }
+
+        std::vector<SceneObject> m_scene;
+        resources::Shader *m_skybox_shader{nullptr};
+        resources::Skybox *m_skybox{nullptr};
+        CameraPath m_camera_path;
+
+        int m_frames{0};
+        int m_warmup_frames{0};
+        int m_frame{0};
+        bool m_finish_frames{true};
+        std::string m_output;
+
+        double m_load_time_ms{0.0};
+        std::chrono::steady_clock::time_point m_frame_begin;
+        std::vector<FrameSample> m_samples;
+    };
+
+    class BenchApp final : public core::App {
+        void app_setup() override {
+            auto bench = register_controller<BenchController>();
+            bench->after(core::Controller::get<core::EngineControllersEnd>());
+        }
+    };
+} // namespace engine::bench
+
+int main(int argc, char **argv) {
+    return std::make_unique<engine::bench::BenchApp>()->run(argc, argv);
+}
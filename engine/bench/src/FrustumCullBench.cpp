@@ -0,0 +1,58 @@
+/**
+ * @file FrustumCullBench.cpp
+ * @brief Measures the batched frustum culling of bounding spheres.
+ *
+ * Usage: frustum-cull-bench [--objects 100000] [--iterations 100]
+ */
+
+#include <engine/graphics/Frustum.hpp>
+#include <engine/util/ArgParser.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using namespace engine;
+
+int main(int argc, char **argv) {
+    auto arg_parser = util::ArgParser::instance();
+    arg_parser->initialize(argc, argv);
+    const int objects    = std::max(1, arg_parser->arg<int>("--objects", 100000).value());
+    const int iterations = std::max(1, arg_parser->arg<int>("--iterations", 100).value());
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> radius(0.5f, 5.0f);
+    graphics::SphereBatch batch;
+    for (int i = 0; i < objects; ++i) {
+        batch.push(graphics::BoundingSphere{glm::vec3(position(random), position(random), position(random)),
+                                            radius(random)});
+    }
+
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+    const glm::mat4 view       = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const auto frustum         = graphics::Frustum::from_matrix(projection * view);
+
+    std::vector<uint8_t> visible;
+    std::size_t visible_count = 0;
+    double total_ms           = 0.0;
+    double best_ms            = 1e9;
+    for (int i = 0; i < iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        visible_count    = frustum.cull(batch, visible);
+        const double ms  = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        total_ms += ms;
+        best_ms = std::min(best_ms, ms);
+    }
+
+    std::size_t scalar_visible = 0;
+    for (int i = 0; i < objects; ++i) {
+        scalar_visible += frustum.intersects(graphics::BoundingSphere{
+                glm::vec3(batch.x[i], batch.y[i], batch.z[i]), batch.radius[i]
+        });
+    }
+
+    std::printf("objects: %d, visible: %zu (scalar check: %zu)\n", objects, visible_count, scalar_visible);
+    std::printf("cull avg: %.4f ms, best: %.4f ms\n", total_ms / iterations, best_ms);
+    return visible_count == scalar_visible ? 0 : 1;
+}
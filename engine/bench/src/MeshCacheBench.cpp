@@ -0,0 +1,90 @@
+/**
+ * @file MeshCacheBench.cpp
+ * @brief Compares loading a model with Assimp (cold) against mapping its baked file (warm).
+ *
+ * Usage: mesh-cache-bench --model resources/models/backpack/backpack.obj [--iterations 10] [--cache /tmp/rg-cache]
+ */
+
+#include <assimp/postprocess.h>
+#include <engine/resources/BakedModel.hpp>
+#include <engine/resources/ResourcesController.hpp>
+#include <engine/util/ArgParser.hpp>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+
+using namespace engine;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    /**
+    * @brief Reads every vertex and index, so that the lazily mapped pages are counted in the warm path too.
+    */
+    uint64_t touch(const resources::BakedModel &baked_model) {
+        uint64_t checksum = 0;
+        for (const auto &mesh: baked_model.meshes()) {
+            checksum += std::accumulate(mesh.indices.begin(), mesh.indices.end(), uint64_t{0});
+            for (const auto byte: mesh.vertices) {
+                checksum += static_cast<uint64_t>(byte != std::byte{0});
+            }
+        }
+        return checksum;
+    }
+
+    template<typename Load>
+    double measure_ms(int iterations, Load load) {
+        double total = 0.0;
+        for (int i = 0; i < iterations; ++i) {
+            const auto start = Clock::now();
+            load();
+            total += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+        return total / iterations;
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    auto arg_parser = util::ArgParser::instance();
+    arg_parser->initialize(argc, argv);
+    const std::filesystem::path model_path = arg_parser->arg<std::string>("--model").value();
+    const int iterations                   = std::max(1, arg_parser->arg<int>("--iterations", 10).value());
+    const std::filesystem::path cache_path =
+            arg_parser->arg<std::string>("--cache", "resources/.cache/models").value();
+    if (model_path.empty() || !std::filesystem::exists(model_path)) {
+        std::fprintf(stderr, "usage: mesh-cache-bench --model <path> [--iterations N] [--cache <dir>]\n");
+        return 1;
+    }
+
+    resources::ImportSettings settings;
+    settings.flags        = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace;
+    const auto key        = resources::BakedModelKey::of(model_path, settings);
+    const auto baked_path = cache_path / resources::BakedModel::file_name(model_path, settings.flags);
+
+    uint64_t checksum = 0;
+    const double cold_ms = measure_ms(iterations, [&] {
+        auto baked_model = resources::BakedModel::bake(key, resources::ResourcesController::import_model(model_path, settings));
+        checksum += touch(baked_model);
+    });
+
+    auto baked_model = resources::BakedModel::bake(key, resources::ResourcesController::import_model(model_path, settings));
+    if (!baked_model.write(baked_path)) {
+        std::fprintf(stderr, "failed to write %s\n", baked_path.string().c_str());
+        return 1;
+    }
+
+    const double warm_ms = measure_ms(iterations, [&] {
+        auto mapped = resources::BakedModel::open(baked_path, key);
+        if (mapped.has_value()) {
+            checksum += touch(mapped.value());
+        }
+    });
+
+    std::printf("model:      %s\n", model_path.string().c_str());
+    std::printf("baked size: %zu bytes\n", baked_model.bytes().size());
+    std::printf("cold (assimp import + bake): %10.3f ms\n", cold_ms);
+    std::printf("warm (mmap baked file):      %10.3f ms\n", warm_ms);
+    std::printf("speedup:                     %10.1fx\n", cold_ms / warm_ms);
+    std::printf("checksum:                    %llu\n", static_cast<unsigned long long>(checksum));
+    return 0;
+}
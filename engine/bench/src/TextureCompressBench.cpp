@@ -0,0 +1,100 @@
+/**
+ * @file TextureCompressBench.cpp
+ * @brief Transcodes a texture offline into a DDS file next to it, and compares decoding the source image against reading the DDS.
+ *
+ * Usage: texture-compress-bench --texture resources/models/backpack/ao.jpg [--type diffuse|specular|normal|height]
+ *                               [--bc7 1] [--iterations 10] [--output <file.dds>]
+ */
+
+#include <engine/resources/CompressedImage.hpp>
+#include <engine/resources/TextureCompressor.hpp>
+#include <engine/util/ArgParser.hpp>
+#include <chrono>
+#include <cstdio>
+
+using namespace engine;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    template<typename Load>
+    double measure_ms(int iterations, Load load) {
+        double total = 0.0;
+        for (int i = 0; i < iterations; ++i) {
+            const auto start = Clock::now();
+            load();
+            total += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+        return total / iterations;
+    }
+
+    resources::TextureType parse_type(const std::string &type) {
+        if (type == "specular") {
+            return resources::TextureType::Specular;
+        }
+        if (type == "normal") {
+            return resources::TextureType::Normal;
+        }
+        if (type == "height") {
+            return resources::TextureType::Height;
+        }
+        return resources::TextureType::Diffuse;
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    auto arg_parser = util::ArgParser::instance();
+    arg_parser->initialize(argc, argv);
+    const std::filesystem::path texture_path = arg_parser->arg<std::string>("--texture").value();
+    const auto type       = parse_type(arg_parser->arg<std::string>("--type", "diffuse").value());
+    const int iterations  = std::max(1, arg_parser->arg<int>("--iterations", 10).value());
+    const bool bc7        = arg_parser->arg<int>("--bc7", 0).value() != 0;
+    std::filesystem::path output_path = arg_parser->arg<std::string>("--output", "").value();
+    if (texture_path.empty() || !std::filesystem::exists(texture_path)) {
+        std::fprintf(stderr, "usage: texture-compress-bench --texture <path> [--type diffuse|specular|normal|height] "
+                     "[--bc7 1] [--iterations N] [--output <file.dds>]\n");
+        return 1;
+    }
+    if (output_path.empty()) {
+        // Next to the source, where the ResourcesController looks for the pre-compressed variant.
+        output_path = texture_path;
+        output_path.replace_extension(".dds");
+    }
+
+    // Offline, the target GPU isn't known; every desktop GPU of the last decade supports all the formats.
+    constexpr uint32_t all_formats = ~0u;
+    resources::TextureCompression settings;
+    settings.bc7 = bc7;
+
+    const auto image  = resources::Image::load(texture_path, false);
+    const auto format = resources::TextureCompressor::choose_format(image, type, all_formats, settings).value();
+
+    const auto compress_start = Clock::now();
+    const auto compressed = resources::TextureCompressor::compress(image, format, type == resources::TextureType::Normal);
+    const double compress_ms = std::chrono::duration<double, std::milli>(Clock::now() - compress_start).count();
+    if (!compressed.save_dds(output_path)) {
+        std::fprintf(stderr, "failed to write %s\n", output_path.string().c_str());
+        return 1;
+    }
+
+    std::size_t checksum   = 0;
+    const double decode_ms = measure_ms(iterations, [&] {
+        checksum += resources::Image::load(texture_path, false).pixels.size();
+    });
+    const double read_ms = measure_ms(iterations, [&] {
+        checksum += resources::CompressedImage::load(output_path).data.size();
+    });
+
+    const std::size_t uncompressed_bytes = image.pixels.size() * 4 / 3;
+    std::printf("texture:    %s (%dx%d, %d channels)\n", texture_path.string().c_str(), image.width, image.height,
+                image.channels);
+    std::printf("output:     %s (%s, %zu levels)\n", output_path.string().c_str(),
+                resources::block_format_name(format).data(), compressed.levels.size());
+    std::printf("size:       %zu bytes instead of %zu bytes with mipmaps (%.1fx smaller)\n", compressed.data.size(),
+                uncompressed_bytes, static_cast<double>(uncompressed_bytes) / compressed.data.size());
+    std::printf("transcode (mip chain + encode, once):  %10.3f ms\n", compress_ms);
+    std::printf("decode source image:                   %10.3f ms\n", decode_ms);
+    std::printf("read compressed file:                  %10.3f ms\n", read_ms);
+    std::printf("checksum:                              %zu\n", checksum);
+    return 0;
+}
@@ -10,6 +10,9 @@ namespace engine::util {
     class Error;
 }
 
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 namespace engine::core {
@@ -114,9 +117,36 @@ namespace engine::core {
         *
         * This is where all the App state should be updated including handling events
         * registered in @ref App::poll_events, processing physics, world logic etc.
+        *
+        * When `jobs.parallel_update` is set in the config.json, the controllers that return true from
+        * @ref Controller::is_update_thread_safe update on the @ref util::JobSystem workers, and the rest on the main thread.
+        * A controller starts as soon as all the controllers ordered before it finished, so the independent branches
+        * of the dependency graph update in parallel. The timing of every update is stored in @ref Controller::update_timing.
         */
         void update();
 
+        using Clock = std::chrono::steady_clock;
+
+        /**
+        * @brief Updates the controllers one by one, in the topological order.
+        */
+        void update_serial(Clock::time_point update_start);
+
+        /**
+        * @brief Updates the controllers concurrently, following the dependency graph.
+        */
+        void update_parallel(Clock::time_point update_start);
+
+        /**
+        * @brief Updates the controller if it's enabled and records its @ref UpdateTiming.
+        */
+        static void update_controller(Controller *controller, Clock::time_point update_start);
+
+        /**
+        * @brief Finds the longest chain of dependent updates in the last frame and marks its controllers.
+        */
+        void mark_critical_path();
+
         /**
         * @brief Draws the frame. Calls @ref engine::Controller::draw for registered controllers.
         *
@@ -171,6 +201,15 @@ namespace engine::core {
 
     private:
         std::vector<Controller *> m_controllers;
+        /**
+        * @brief Index of each controller in the `m_controllers`, after the topological sort.
+        */
+        std::unordered_map<Controller *, std::size_t> m_controller_index;
+        /**
+        * @brief Number of controllers ordered directly before each controller, indexed like `m_controllers`.
+        */
+        std::vector<uint32_t> m_in_degree;
+        bool m_parallel_update{false};
     };
 } // namespace engine
 
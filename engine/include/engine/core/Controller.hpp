@@ -7,12 +7,43 @@
 #define MATF_RG_PROJECT_CONTROLLER_HPP
 
 #include <engine/util/Errors.hpp>
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <string_view>
 #include <vector>
 #include <typeinfo>
 
 namespace engine::core {
+    /**
+    * @struct UpdateTiming
+    * @brief When and where the @ref Controller::update ran in the last frame, measured by the @ref App.
+    */
+    struct UpdateTiming {
+        /**
+        * @brief Milliseconds from the start of the update phase to the start of the controller update.
+        */
+        double start_ms{0.0};
+        /**
+        * @brief Milliseconds the controller update took.
+        */
+        double duration_ms{0.0};
+        /**
+        * @brief Milliseconds from the start of the update phase to the end of the controller update, if every
+        * controller started as soon as the controllers before it finished. The largest one is the length of the critical path.
+        */
+        double critical_finish_ms{0.0};
+        /**
+        * @brief @ref util::JobSystem::thread_index of the thread that ran the update; 0 is the main thread.
+        */
+        uint32_t thread_index{0};
+        /**
+        * @brief Whether the controller is on the longest chain of dependent updates in the last frame.
+        */
+        bool on_critical_path{false};
+    };
+
     /**
     * @class Controller
     * @brief Controllers are a hook into the @ref App `main loop` execution.
@@ -69,6 +100,25 @@ namespace engine::core {
 
         virtual ~Controller() = default;
 
+        /**
+        * @brief Override to return true if the @ref Controller::update of this controller can run on a worker thread,
+        * concurrently with the updates of the controllers it isn't ordered with by @ref Controller::before/@ref Controller::after.
+        *
+        * Only used when `jobs.parallel_update` is set in the config.json; see @ref App::update.
+        * The update of a thread-safe controller must not call OpenGL or the window functions, and must
+        * only touch the state of the controllers it is ordered after.
+        */
+        virtual bool is_update_thread_safe() const {
+            return false;
+        }
+
+        /**
+        * @brief Returns the timing of the last @ref Controller::update.
+        */
+        const UpdateTiming &update_timing() const {
+            return m_update_timing;
+        }
+
         /**
         * Orders the controller `next` to be after `this` controller.
         * All the virtual member methods of the controller `this` will always execute
@@ -198,6 +248,31 @@ namespace engine::core {
         * @brief Internal field used to control weather the @ref ControllerManager executes the controller.
         */
         bool m_enabled{true};
+
+        /**
+        * @brief Timing of the last update, measured by the @ref App.
+        */
+        UpdateTiming m_update_timing{};
+
+        /**
+        * @brief The phases of the main loop the @ref App profiles for every controller.
+        */
+        enum Phase {
+            Initialize,
+            Loop,
+            PollEvents,
+            Update,
+            BeginDraw,
+            Draw,
+            EndDraw,
+            Terminate,
+            PhaseCount
+        };
+
+        /**
+        * @brief Profiler zone names of the phases, like `GraphicsController::draw`. Set by the @ref App::initialize.
+        */
+        std::array<std::string, PhaseCount> m_zone_names;
     };
 
     /**
@@ -219,6 +294,10 @@ namespace engine::core {
         std::string_view name() const override {
             return "EngineControllersBegin";
         }
+
+        bool is_update_thread_safe() const override {
+            return true;
+        }
     };
 
     /**
@@ -240,6 +319,10 @@ namespace engine::core {
         std::string_view name() const override {
             return "EngineControllersEnd";
         }
+
+        bool is_update_thread_safe() const override {
+            return true;
+        }
     };
 } // namespace engine
 
@@ -17,17 +17,31 @@
 
 #include <engine/graphics/OpenGL.hpp>
 #include <engine/graphics/Camera.hpp>
+#include <engine/graphics/GeometryArena.hpp>
+#include <engine/graphics/GpuProfiler.hpp>
+#include <engine/graphics/TextureStreamer.hpp>
+#include <engine/graphics/TextureUploader.hpp>
+#include <engine/graphics/UniformBlocks.hpp>
+#include <engine/graphics/VertexFormat.hpp>
 
 #include <engine/util/Utils.hpp>
 #include <engine/util/Configuration.hpp>
 #include <engine/util/ArgParser.hpp>
 #include <engine/util/Errors.hpp>
+#include <engine/util/JobSystem.hpp>
+#include <engine/util/Profiler.hpp>
 
 #include <engine/resources/ShaderCompiler.hpp>
 #include <engine/resources/ResourcesController.hpp>
+#include <engine/resources/Material.hpp>
 #include <engine/resources/Model.hpp>
+#include <engine/resources/MeshOptimizer.hpp>
+#include <engine/resources/MeshSimplifier.hpp>
 #include <engine/resources/Shader.hpp>
 #include <engine/resources/Texture.hpp>
+#include <engine/resources/CompressedImage.hpp>
+#include <engine/resources/TextureCompressor.hpp>
+#include <engine/resources/TexturePack.hpp>
 #include <engine/resources/Skybox.hpp>
 
 #endif//MATF_RG_PROJECT_ENGINE_HPP
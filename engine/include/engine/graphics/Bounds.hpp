@@ -0,0 +1,70 @@
+/**
+ * @file Bounds.hpp
+ * @brief Defines the bounding volumes used for culling.
+ */
+
+#ifndef MATF_RG_PROJECT_BOUNDS_HPP
+#define MATF_RG_PROJECT_BOUNDS_HPP
+
+#include <glm/glm.hpp>
+#include <limits>
+
+namespace engine::graphics {
+    /**
+    * @struct BoundingBox
+    * @brief Axis-aligned bounding box. A default constructed box is empty and grows with @ref BoundingBox::expand.
+    */
+    struct BoundingBox {
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+        bool empty() const {
+            return min.x > max.x || min.y > max.y || min.z > max.z;
+        }
+
+        glm::vec3 center() const {
+            return (min + max) * 0.5f;
+        }
+
+        void expand(const glm::vec3 &point) {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        void expand(const BoundingBox &other) {
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+        }
+    };
+
+    /**
+    * @struct BoundingSphere
+    * @brief Bounding sphere. Cheaper to test against the frustum than the @ref BoundingBox, and cheap to transform.
+    */
+    struct BoundingSphere {
+        glm::vec3 center{0.0f};
+        float radius{0.0f};
+
+        /**
+        * @brief Returns the sphere transformed by the model matrix. Non-uniform scale grows the radius
+        * by the largest axis scale, so the result still bounds the transformed geometry.
+        */
+        BoundingSphere transformed(const glm::mat4 &transform) const;
+    };
+
+    /**
+    * @struct Bounds
+    * @brief The box and the sphere bounding the same geometry.
+    */
+    struct Bounds {
+        BoundingBox box;
+        BoundingSphere sphere;
+
+        /**
+        * @brief Returns the bounds enclosing both `a` and `b`.
+        */
+        static Bounds merge(const Bounds &a, const Bounds &b);
+    };
+} // namespace engine::graphics
+
+#endif//MATF_RG_PROJECT_BOUNDS_HPP
@@ -106,6 +106,11 @@ namespace engine::graphics {
          */
         void process_mouse_movement(float x_offset, float y_offset, bool constrainPitch = true);
 
+        /**
+         * @brief Turns the camera to face the target point, keeping its position.
+         */
+        void look_at(glm::vec3 target);
+
         /**
          * @brief Processes input received from a mouse scroll-wheel event. Only requires to be input on the vertical wheel-axis
          */
@@ -0,0 +1,95 @@
+/**
+ * @file Frustum.hpp
+ * @brief Defines the Frustum class and the batched bounding sphere tests used for culling.
+ */
+
+#ifndef MATF_RG_PROJECT_FRUSTUM_HPP
+#define MATF_RG_PROJECT_FRUSTUM_HPP
+
+#include <engine/graphics/Bounds.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace engine::graphics {
+    /**
+    * @struct SphereBatch
+    * @brief Bounding spheres stored as a structure of arrays, so that @ref Frustum::cull tests four spheres per instruction.
+    */
+    struct SphereBatch {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<float> radius;
+
+        void push(const BoundingSphere &sphere) {
+            x.push_back(sphere.center.x);
+            y.push_back(sphere.center.y);
+            z.push_back(sphere.center.z);
+            radius.push_back(sphere.radius);
+        }
+
+        void clear() {
+            x.clear();
+            y.clear();
+            z.clear();
+            radius.clear();
+        }
+
+        std::size_t size() const {
+            return x.size();
+        }
+    };
+
+    /**
+    * @class Frustum
+    * @brief The six planes of a view frustum, in world space when extracted from `projection * view`.
+    *
+    * The planes point inward and are normalized, so the signed distance of a point to a plane is `dot(plane, vec4(point, 1))`.
+    */
+    class Frustum {
+    public:
+        enum Plane {
+            Left,
+            Right,
+            Bottom,
+            Top,
+            Near,
+            Far,
+            PlaneCount
+        };
+
+        /**
+        * @brief Extracts the frustum planes from a clip matrix (Gribb-Hartmann).
+        * @param clip `projection * view` for world space planes, or `projection * view * model` for model space planes.
+        */
+        static Frustum from_matrix(const glm::mat4 &clip);
+
+        /**
+        * @returns false if the `sphere` is completely outside the frustum.
+        */
+        bool intersects(const BoundingSphere &sphere) const;
+
+        /**
+        * @returns false if the `box` is completely outside the frustum.
+        */
+        bool intersects(const BoundingBox &box) const;
+
+        /**
+        * @brief Tests all the spheres in the `batch` against the frustum, four at a time with SSE when available.
+        * @param batch The spheres to test.
+        * @param visible Set to 1 for the spheres that intersect the frustum and to 0 for the culled ones; resized to the batch size.
+        * @returns The number of the visible spheres.
+        */
+        std::size_t cull(const SphereBatch &batch, std::vector<uint8_t> &visible) const;
+
+        const std::array<glm::vec4, PlaneCount> &planes() const {
+            return m_planes;
+        }
+
+    private:
+        std::array<glm::vec4, PlaneCount> m_planes{};
+    };
+} // namespace engine::graphics
+
+#endif//MATF_RG_PROJECT_FRUSTUM_HPP
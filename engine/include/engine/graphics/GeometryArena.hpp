@@ -0,0 +1,197 @@
+/**
+ * @file GeometryArena.hpp
+ * @brief Defines the GeometryArena class that sub-allocates the vertices and indices of all the meshes from a few large buffers.
+ */
+
+#ifndef MATF_RG_PROJECT_GEOMETRY_ARENA_HPP
+#define MATF_RG_PROJECT_GEOMETRY_ARENA_HPP
+
+#include <engine/graphics/VertexFormat.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace engine::graphics {
+    /**
+    * @struct GeometryRange
+    * @brief The vertices and indices of a mesh in the @ref GeometryArena. Draw it with the vertex array bound and
+    * `glDrawElementsBaseVertex(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, first_index * 4, base_vertex)`;
+    * the indices are relative to the first vertex of the mesh.
+    */
+    struct GeometryRange {
+        uint32_t vao{0};
+        uint32_t block{0};
+        VertexFormat format{VertexFormat::Standard};
+        int32_t base_vertex{0};
+        uint32_t vertex_count{0};
+        uint32_t first_index{0};
+        uint32_t index_count{0};
+
+        /**
+        * @brief Returns the offset of the first index in the index buffer, in the form `glDrawElements*` take it.
+        */
+        const void *index_offset() const {
+            return reinterpret_cast<const void *>(static_cast<std::uintptr_t>(first_index) * sizeof(uint32_t));
+        }
+    };
+
+    /**
+    * @class RangeAllocator
+    * @brief First-fit allocator of the ranges of `[0, capacity)`. Freed ranges are merged with their free neighbours.
+    */
+    class RangeAllocator {
+    public:
+        explicit RangeAllocator(uint32_t capacity = 0);
+
+        /**
+        * @returns The offset of `count` consecutive units, or std::nullopt if there is no free range that large.
+        */
+        std::optional<uint32_t> allocate(uint32_t count);
+
+        /**
+        * @brief Returns the range to the allocator.
+        */
+        void free(uint32_t offset, uint32_t count);
+
+        uint32_t capacity() const {
+            return m_capacity;
+        }
+
+        uint32_t used() const {
+            return m_used;
+        }
+
+    private:
+        /**
+        * @brief The free ranges as (offset, count), sorted by the offset.
+        */
+        std::vector<std::pair<uint32_t, uint32_t> > m_free;
+        uint32_t m_capacity{0};
+        uint32_t m_used{0};
+    };
+
+    /**
+    * @class GeometryArena
+    * @brief Stores the vertices and the indices of all the meshes in a few large `GL_STATIC_DRAW` buffers.
+    *
+    * The buffers are grouped in blocks of a vertex buffer, an index buffer and a vertex array for one @ref VertexFormat.
+    * A mesh gets a range of vertices and a range of indices from the first block of its format with room for both;
+    * a new block is created when none has, sized to fit the mesh if it's larger than a default block.
+    * The meshes in a block share its vertex array, so drawing them one after another binds the vertex array once,
+    * and their draws can be merged into multi-draw calls.
+    *
+    * The arena owns the OpenGL buffers: @ref GeometryArena::free returns the ranges of a destroyed mesh,
+    * and @ref GeometryArena::terminate deletes all the blocks.
+    */
+    class GeometryArena {
+    public:
+        /**
+        * @brief The size of the vertex buffer of a block, in bytes.
+        */
+        static constexpr std::size_t BLOCK_VERTEX_BYTES = 32u << 20;
+
+        /**
+        * @brief The number of indices in the index buffer of a block.
+        */
+        static constexpr uint32_t BLOCK_INDEX_COUNT = 4u << 20;
+
+        /**
+        * @brief The attribute location of the draw id of the batched draws, see @ref RenderQueue.
+        * In the vertex shader: `layout (location = 9) in uint aDrawId;`
+        */
+        static constexpr uint32_t DRAW_ID_LOCATION = 9;
+
+        /**
+        * @brief Memory used by the arena.
+        */
+        struct Stats {
+            uint32_t blocks{0};
+            std::size_t vertex_bytes_used{0};
+            std::size_t vertex_bytes_capacity{0};
+            std::size_t index_bytes_used{0};
+            std::size_t index_bytes_capacity{0};
+        };
+
+        /**
+        * @brief Get the instance of the @ref GeometryArena class.
+        */
+        static GeometryArena *instance();
+
+        /**
+        * @brief Copies the vertices and the indices of a mesh into the arena. Requires the OpenGL context.
+        * @param format The format of the `vertices`.
+        * @param vertices The vertices, `vertex_size(format)` bytes each.
+        * @param indices The indices, relative to the first of the `vertices`.
+        * @returns The range of the mesh in the arena.
+        */
+        GeometryRange allocate(VertexFormat format, std::span<const std::byte> vertices,
+                               std::span<const uint32_t> indices);
+
+        /**
+        * @brief Returns the range of a destroyed mesh to the arena. Its vertices and indices can be overwritten by the next meshes.
+        */
+        void free(const GeometryRange &range);
+
+        /**
+        * @brief Points the per-instance attributes of the vertex array of the `range` to the `instance_vbo`,
+        * see @ref resources::Mesh::attach_instance_buffer. Does nothing if they already point there.
+        */
+        void attach_instance_buffer(const GeometryRange &range, uint32_t instance_vbo);
+
+        /**
+        * @brief Forgets the `instance_vbo` before it's deleted, so that a new buffer that gets its id is attached again.
+        */
+        void detach_instance_buffer(uint32_t instance_vbo);
+
+        /**
+        * @brief Points the @ref GeometryArena::DRAW_ID_LOCATION attribute of the vertex array of the `range` to the
+        * `draw_id_vbo`, a buffer of consecutive `uint32_t` ids read once per instance. With one instance per draw,
+        * the base instance of an indirect draw command selects the id. Does nothing if the attribute already points there.
+        */
+        void attach_draw_id_buffer(const GeometryRange &range, uint32_t draw_id_vbo);
+
+        /**
+        * @brief Forgets the `draw_id_vbo` before it's deleted, like @ref GeometryArena::detach_instance_buffer.
+        */
+        void detach_draw_id_buffer(uint32_t draw_id_vbo);
+
+        /**
+        * @brief Deletes all the blocks. The ranges handed out so far are invalid afterwards.
+        */
+        void terminate();
+
+        Stats stats() const;
+
+    private:
+        struct Block {
+            VertexFormat format;
+            uint32_t vao{0};
+            uint32_t vbo{0};
+            uint32_t ebo{0};
+            RangeAllocator vertices;
+            RangeAllocator indices;
+            /**
+            * @brief The buffer the per-instance attributes of the vertex array read from, see @ref GeometryArena::attach_instance_buffer.
+            */
+            uint32_t instance_vbo{0};
+            /**
+            * @brief The buffer the draw id attribute reads from, see @ref GeometryArena::attach_draw_id_buffer.
+            */
+            uint32_t draw_id_vbo{0};
+        };
+
+        GeometryArena() = default;
+
+        /**
+        * @brief Creates a block with room for at least `vertex_count` vertices and `index_count` indices.
+        */
+        Block &create_block(VertexFormat format, uint32_t vertex_count, uint32_t index_count);
+
+        std::vector<Block> m_blocks;
+    };
+} // namespace engine::graphics
+
+#endif//MATF_RG_PROJECT_GEOMETRY_ARENA_HPP
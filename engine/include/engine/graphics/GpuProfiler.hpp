@@ -0,0 +1,164 @@
+/**
+ * @file GpuProfiler.hpp
+ * @brief Defines the GpuProfiler class that times GPU work with a pool of timestamp queries, and the RG_PROFILE_GPU_ZONE macro.
+ */
+
+#ifndef MATF_RG_PROJECT_GPUPROFILER_HPP
+#define MATF_RG_PROJECT_GPUPROFILER_HPP
+
+#include <engine/util/Utils.hpp>
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+* @brief Profiles the GPU work issued in the enclosing scope as a GPU zone with the given name.
+* The name must outlive the profiler; string literals are the common case.
+* @code
+* void ShadowPass::draw() {
+*     RG_PROFILE_GPU_ZONE("GPU::shadows");
+*     ...
+* }
+* @endcode
+*/
+#define RG_PROFILE_GPU_ZONE(name) engine::graphics::GpuZone CONCAT(rg_profile_gpu_zone_, __LINE__)(name)
+
+namespace engine::graphics {
+    /**
+    * @class GpuProfiler
+    * @brief Measures how long the GPU takes to execute the commands issued inside the GPU zones.
+    *
+    * Every zone writes a GPU timestamp at its beginning and at its end, with @ref OpenGL::query_timestamp.
+    * Timestamps, unlike the `GL_TIME_ELAPSED` queries, can nest, so zones can be put around a pass and around the draws inside it.
+    * The queries of a frame come from one of the @ref GpuProfiler::FRAMES_IN_FLIGHT slots of the pool, and are read
+    * when the slot is reused, a few frames later, when the GPU has long finished them. The results are never waited for:
+    * if they still aren't available, the frame is dropped and counted in @ref GpuProfiler::dropped_frames.
+    *
+    * The results go to @ref util::Profiler::record_gpu, and show up next to the CPU zones.
+    * The @ref GraphicsController initializes the profiler, and ends its frame in @ref GraphicsController::end_draw.
+    * The profiler turns itself off when the driver reports a timestamp counter with zero bits, or when it's disabled in the config.json:
+    * @code
+    * "profiler": {
+    *   "gpu": false
+    * }
+    * @endcode
+    */
+    class GpuProfiler {
+    public:
+        /**
+        * @brief Number of frames whose queries are in flight. The results of a frame are read this many frames later.
+        */
+        static constexpr uint32_t FRAMES_IN_FLIGHT = 3;
+
+        /**
+        * @brief Number of zones a frame can record. Zones over the limit aren't measured.
+        */
+        static constexpr uint32_t MAX_ZONES_PER_FRAME = 256;
+
+        /**
+        * @brief Returned by @ref GpuProfiler::begin_zone when the zone isn't measured.
+        */
+        static constexpr uint32_t INVALID_ZONE = ~0u;
+
+        /**
+        * @brief Get the instance of the @ref GpuProfiler class.
+        */
+        static GpuProfiler *instance();
+
+        /**
+        * @brief Creates the query pool. Requires the OpenGL context.
+        * @param enabled If false, the profiler stays off and the zones cost nothing.
+        */
+        void initialize(bool enabled);
+
+        /**
+        * @brief Deletes the query pool.
+        */
+        void terminate();
+
+        bool available() const {
+            return m_available;
+        }
+
+        /**
+        * @brief Writes the begin timestamp of a zone. Use @ref RG_PROFILE_GPU_ZONE instead of calling it directly.
+        * @returns The zone to pass to @ref GpuProfiler::end_zone, or @ref GpuProfiler::INVALID_ZONE.
+        */
+        uint32_t begin_zone(std::string_view name);
+
+        /**
+        * @brief Writes the end timestamp of a zone.
+        */
+        void end_zone(uint32_t zone);
+
+        /**
+        * @brief Ends the current frame and reads the results of the oldest frame in flight, if they're available.
+        * Called by @ref GraphicsController::end_draw.
+        */
+        void end_frame();
+
+        /**
+        * @brief Returns the number of frames whose results weren't available when their queries were reused.
+        */
+        uint64_t dropped_frames() const {
+            return m_dropped_frames;
+        }
+
+    private:
+        struct Zone {
+            std::string_view name;
+            uint32_t begin_query;
+            uint32_t end_query;
+            bool ended{false};
+        };
+
+        struct Frame {
+            std::vector<Zone> zones;
+            /**
+            * @brief Converts the GPU timestamps of the frame into the @ref util::Profiler::now_ns time domain.
+            */
+            int64_t gpu_to_cpu_ns{0};
+        };
+
+        GpuProfiler() = default;
+
+        /**
+        * @brief Reads the frame results into the @ref util::Profiler.
+        * @returns false if a result isn't available yet.
+        */
+        bool collect(const Frame &frame);
+
+        std::array<Frame, FRAMES_IN_FLIGHT> m_frames;
+        /**
+        * @brief Two queries per zone, @ref GpuProfiler::MAX_ZONES_PER_FRAME zones per frame slot.
+        */
+        std::vector<uint32_t> m_queries;
+        uint32_t m_current_frame{0};
+        uint64_t m_dropped_frames{0};
+        bool m_available{false};
+    };
+
+    /**
+    * @class GpuZone
+    * @brief Measures the GPU work issued from its construction to its destruction. See @ref RG_PROFILE_GPU_ZONE.
+    */
+    class GpuZone {
+    public:
+        explicit GpuZone(std::string_view name) : m_zone(GpuProfiler::instance()->begin_zone(name)) {
+        }
+
+        ~GpuZone() {
+            GpuProfiler::instance()->end_zone(m_zone);
+        }
+
+        GpuZone(const GpuZone &) = delete;
+
+        GpuZone &operator=(const GpuZone &) = delete;
+
+    private:
+        uint32_t m_zone;
+    };
+} // namespace engine::graphics
+
+#endif//MATF_RG_PROJECT_GPUPROFILER_HPP
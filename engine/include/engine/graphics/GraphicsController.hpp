@@ -6,6 +6,8 @@
 #ifndef GRAPHICSCONTROLLER_HPP
 #define GRAPHICSCONTROLLER_HPP
 #include <engine/graphics/Camera.hpp>
+#include <engine/graphics/OpenGL.hpp>
+#include <engine/graphics/RenderQueue.hpp>
 #include <engine/core/Controller.hpp>
 #include <engine/platform/PlatformEventObserver.hpp>
 
@@ -14,6 +16,8 @@ struct ImGuiContext;
 namespace engine::resources {
     class Skybox;
     class Shader;
+    class Mesh;
+    class Model;
 }
 
 namespace engine::graphics {
@@ -51,6 +55,12 @@ namespace engine::graphics {
     *
     * This class should implement all the complex functions needed for drawing an entity in the scene.
     * For example @ref GraphicsController::draw_skybox.
+    *
+    * Meshes submitted with @ref GraphicsController::submit or @ref GraphicsController::draw_model during `draw()`
+    * go through the @ref RenderQueue: they are sorted to minimize the state changes and drawn in @ref GraphicsController::end_draw,
+    * or earlier if something that draws directly, like @ref GraphicsController::draw_skybox or
+    * @ref GraphicsController::begin_gui, is called first. Meshes whose bounds are outside of the camera
+    * @ref GraphicsController::frustum are culled before drawing.
     */
     class GraphicsController final : public core::Controller {
     public:
@@ -81,9 +91,92 @@ namespace engine::graphics {
 
         /**
         * @brief Draws a @ref resources::Skybox with the @ref resources::Shader.
+        * Flushes the @ref RenderQueue first, so the meshes submitted before the skybox are drawn before it.
         */
         void draw_skybox(const resources::Shader *shader, const resources::Skybox *skybox);
 
+        /**
+        * @brief Submits a mesh to the @ref RenderQueue to be drawn with the `shader`.
+        * Shaders that declare the `Camera` and `Object` uniform blocks (see @ref UniformBinding) need no uniforms set:
+        * the camera is updated once per frame, and the `transform` is bound to the `Object` block right before the mesh is drawn.
+        * @code
+        * graphics->draw_model(backpack, shader, glm::scale(glm::mat4(1.0f), glm::vec3(0.5f)));
+        * @endcode
+        * Shaders without the blocks get the `transform` in the `model` uniform; set the others, like `view` and `projection`,
+        * on the shader before submitting. The `lod` is the level of detail of the mesh to draw, see @ref resources::Mesh::lod.
+        */
+        void submit(const resources::Mesh *mesh, const resources::Shader *shader, const glm::mat4 &transform,
+                    uint32_t lod = 0);
+
+        /**
+        * @brief Submits all the meshes of the `model` to the @ref RenderQueue, see @ref GraphicsController::submit,
+        * at the level of detail for its size on the screen with the current camera and perspective params,
+        * see @ref resources::Model::select_lod.
+        */
+        void draw_model(const resources::Model *model, const resources::Shader *shader, const glm::mat4 &transform);
+
+        /**
+        * @brief Draws the meshes submitted to the @ref RenderQueue so far.
+        * Call it before drawing directly with OpenGL on top of the submitted meshes.
+        */
+        void flush_render_queue();
+
+        /**
+        * @brief Writes the projection and the view matrix and the position of the camera into the `Camera` uniform block,
+        * see @ref CameraBlock. Called in @ref GraphicsController::begin_draw; call it again if the camera moves while drawing.
+        */
+        void update_camera_uniforms();
+
+        /**
+        * @brief Writes the `transform` of a direct draw into the `Object` uniform block, see @ref ObjectBlock,
+        * or into the `model` uniform of shaders without the block. Called by @ref resources::Model::draw;
+        * the meshes submitted to the @ref RenderQueue get their ranges of the block bound by the queue.
+        */
+        void set_object_uniforms(const resources::Shader *shader, const glm::mat4 &transform);
+
+        /**
+        * @brief Returns the view frustum of the camera, in world space.
+        */
+        Frustum frustum() const {
+            return Frustum::from_matrix(projection_matrix() * m_camera.view_matrix());
+        }
+
+        /**
+        * @brief Enables or disables dropping the submitted meshes outside of the view frustum. Enabled by default.
+        */
+        void set_frustum_culling(bool enabled) {
+            m_frustum_culling = enabled;
+        }
+
+        bool frustum_culling() const {
+            return m_frustum_culling;
+        }
+
+        /**
+        * @brief Returns the @ref RenderStats of the last drawn frame.
+        */
+        const RenderStats &render_stats() const {
+            return m_render_stats;
+        }
+
+        /**
+        * @brief Returns the state changes made and skipped by the OpenGL state shadow in the last drawn frame,
+        * see @ref OpenGL::StateStats.
+        */
+        const OpenGL::StateStats &state_stats() const {
+            return m_state_stats;
+        }
+
+        /**
+        * @brief Flushes the @ref RenderQueue and reads the pixels drawn so far in the current frame, top row first.
+        * Waits for the GPU. In the headless mode, the offscreen framebuffer keeps the last frame until the next one begins,
+        * so this also works after @ref GraphicsController::end_draw.
+        * @code
+        * graphics->read_framebuffer().save_ppm("frame.ppm");
+        * @endcode
+        */
+        resources::Image read_framebuffer();
+
         Camera *camera() {
             return &m_camera;
         }
@@ -157,6 +250,16 @@ namespace engine::graphics {
         */
         void initialize() override;
 
+        /**
+        * @brief Updates the `Camera` uniform block for the frame.
+        */
+        void begin_draw() override;
+
+        /**
+        * @brief Flushes the @ref RenderQueue and records the @ref RenderStats of the frame.
+        */
+        void end_draw() override;
+
         void terminate();
 
         PerspectiveMatrixParams m_perspective_params{};
@@ -165,6 +268,23 @@ namespace engine::graphics {
         glm::mat4 m_projection_matrix{};
         Camera m_camera{};
         ImGuiContext *m_imgui_context{};
+
+        RenderQueue m_render_queue;
+        /**
+        * @brief The uniform buffer of the `Camera` block, see @ref GraphicsController::update_camera_uniforms.
+        */
+        uint32_t m_camera_buffer{0};
+        /**
+        * @brief The uniform buffer of the `Object` block of the direct draws, see @ref GraphicsController::set_object_uniforms.
+        */
+        uint32_t m_object_buffer{0};
+        RenderStats m_render_stats{};
+        OpenGL::StateStats m_state_stats{};
+        bool m_frustum_culling{true};
+        /**
+        * @brief The framebuffer drawn into in the headless mode, see @ref platform::PlatformController::headless.
+        */
+        OpenGL::Framebuffer m_offscreen{};
     };
 
     /**
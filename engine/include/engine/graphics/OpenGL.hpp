@@ -5,8 +5,14 @@
 
 #ifndef OPENGL_HPP
 #define OPENGL_HPP
+#include <array>
 #include <cstdint>
 #include <filesystem>
+#include <span>
+#include <engine/graphics/UniformBlocks.hpp>
+#include <engine/resources/BakedTexture.hpp>
+#include <engine/resources/CompressedImage.hpp>
+#include <engine/resources/Image.hpp>
 #include <engine/resources/Shader.hpp>
 
 namespace engine::resources {
@@ -32,11 +38,77 @@ namespace engine::graphics {
     * @brief This class serves as the OpenGL interface for your app, since the engine doesn't directly link OpenGL to the app executable.
     *
     * Any OpenGL additional direct OpenGL calls you need should be added here.
+    *
+    * The bound program, vertex array, textures per unit, uniform buffer ranges, depth function and the common enable flags are shadowed
+    * on the CPU. The functions that set them, like @ref OpenGL::use_program and @ref OpenGL::bind_texture,
+    * skip the OpenGL call when the state is already set, and count the made and the skipped calls in @ref OpenGL::StateStats.
+    * If you change that state with direct OpenGL calls, call @ref OpenGL::invalidate_state afterwards.
     */
     class OpenGL {
     public:
         using ShaderProgramId = uint32_t;
 
+        /**
+        * @struct StateStats
+        * @brief Counts of the state changes made and skipped by the state shadow, see @ref OpenGL.
+        */
+        struct StateStats {
+            uint32_t program_binds{0};
+            uint32_t program_binds_elided{0};
+            uint32_t vao_binds{0};
+            uint32_t vao_binds_elided{0};
+            uint32_t texture_binds{0};
+            uint32_t texture_binds_elided{0};
+            uint32_t uniform_buffer_binds{0};
+            uint32_t uniform_buffer_binds_elided{0};
+            uint32_t active_unit_changes{0};
+            uint32_t active_unit_changes_elided{0};
+            uint32_t depth_func_changes{0};
+            uint32_t depth_func_changes_elided{0};
+            uint32_t capability_changes{0};
+            uint32_t capability_changes_elided{0};
+
+            uint32_t elided() const {
+                return program_binds_elided + vao_binds_elided + texture_binds_elided + uniform_buffer_binds_elided +
+                       active_unit_changes_elided + depth_func_changes_elided + capability_changes_elided;
+            }
+        };
+
+        /**
+        * @struct Framebuffer
+        * @brief An offscreen framebuffer with an RGBA8 color attachment and a depth-stencil attachment.
+        */
+        struct Framebuffer {
+            uint32_t fbo{0};
+            uint32_t color{0};
+            uint32_t depth_stencil{0};
+            int32_t width{0};
+            int32_t height{0};
+        };
+
+        /**
+        * @struct TextureBuffer
+        * @brief A buffer and the `GL_TEXTURE_BUFFER` texture through which shaders read it as a `samplerBuffer`.
+        */
+        struct TextureBuffer {
+            uint32_t buffer{0};
+            uint32_t texture{0};
+        };
+
+        /**
+        * @struct DrawElementsIndirectCommand
+        * @brief The layout of a command in the `GL_DRAW_INDIRECT_BUFFER`, see @ref OpenGL::multi_draw_elements_indirect.
+        */
+        struct DrawElementsIndirectCommand {
+            uint32_t count{0};
+            uint32_t instance_count{0};
+            uint32_t first_index{0};
+            int32_t base_vertex{0};
+            uint32_t base_instance{0};
+        };
+
+        static_assert(sizeof(DrawElementsIndirectCommand) == 20);
+
         /**
         * @brief Performs a checked OpenGL call. If the OpenGL call fails, it throws @ref util::OpenGLError.
 
@@ -64,6 +136,62 @@ namespace engine::graphics {
             // @formatter:on
         }
 
+        /**
+        * @brief Binds the program, unless it's already bound.
+        * @returns true if the program was bound, false if the call was skipped.
+        */
+        static bool use_program(uint32_t program);
+
+        /**
+        * @brief Binds the vertex array, unless it's already bound.
+        * @returns true if the vertex array was bound, false if the call was skipped.
+        */
+        static bool bind_vertex_array(uint32_t vao);
+
+        /**
+        * @brief Binds the texture to the `target` of the texture unit, unless it's already bound there.
+        * Activates the unit first, when needed.
+        * @param unit Texture unit index, 0 for GL_TEXTURE0.
+        * @param target GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, ...
+        * @returns true if the texture was bound, false if the call was skipped.
+        */
+        static bool bind_texture(uint32_t unit, uint32_t target, uint32_t texture);
+
+        /**
+        * @brief Binds the range of the uniform buffer to the binding point, unless that range is already bound there.
+        * @param binding The uniform block binding point.
+        * @param buffer The uniform buffer.
+        * @param offset Offset of the range in bytes, a multiple of @ref OpenGL::uniform_buffer_offset_alignment.
+        * @param size Size of the range in bytes.
+        * @returns true if the range was bound, false if the call was skipped.
+        */
+        static bool bind_uniform_buffer(UniformBinding binding, uint32_t buffer, std::size_t offset, std::size_t size);
+
+        /**
+        * @brief Sets the depth comparison function, unless it's already set.
+        * @returns true if the function was set, false if the call was skipped.
+        */
+        static bool set_depth_func(uint32_t func);
+
+        /**
+        * @brief Enables or disables an OpenGL capability, like GL_DEPTH_TEST or GL_BLEND, unless it's already in that state.
+        * @returns true if the capability was changed, false if the call was skipped.
+        */
+        static bool set_capability(uint32_t capability, bool enabled);
+
+        /**
+        * @brief Forgets the shadowed state, so that the next calls set it again. Call it after the OpenGL state was
+        * changed behind the shadow's back, by direct OpenGL calls or by a library, and after deleting a bound object.
+        */
+        static void invalidate_state();
+
+        /**
+        * @brief Returns the state changes counted since the last @ref OpenGL::reset_state_stats.
+        */
+        static const StateStats &state_stats();
+
+        static void reset_state_stats();
+
         /**
         * @brief Converts @ref resources::ShaderType to the OpenGL shader type enum.
         * @returns GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER
@@ -79,6 +207,46 @@ namespace engine::graphics {
         */
         static uint32_t generate_texture(const std::filesystem::path &path, bool flip_uvs);
 
+        /**
+        * @brief Uploads an already decoded image into the OpenGL context and generates its mipmaps.
+        *
+        * @param image decoded pixels, see @ref resources::Image::load.
+        * @returns OpenGL id of a texture object.
+        */
+        static uint32_t generate_texture(const resources::Image &image);
+
+        /**
+        * @brief Uploads a block-compressed image with its mip chain into the OpenGL context. The mipmaps aren't generated,
+        * and a chain that stops before 1x1 is sampled down to its last level.
+        *
+        * @param image compressed blocks, see @ref resources::CompressedImage::load. Its format has to be
+        * in @ref OpenGL::supported_block_formats.
+        * @returns OpenGL id of a texture object.
+        */
+        static uint32_t generate_texture(const resources::CompressedImage &image);
+
+        /**
+        * @brief Uploads a baked texture with its mip chain into the OpenGL context, straight from the memory
+        * the texture was read or mapped into. The mipmaps were built at bake time and aren't generated.
+        *
+        * @param texture raw or compressed levels, see @ref resources::BakedTexture::open. A compressed format has to be
+        * in @ref OpenGL::supported_block_formats.
+        * @returns OpenGL id of a texture object.
+        */
+        static uint32_t generate_texture(const resources::BakedTexture &texture);
+
+        /**
+        * @brief Returns the block formats the context can sample, as a mask with the bit `1 << BlockFormat` set
+        * for each of them. BC4 and BC5 are core in OpenGL 3.3, BC1 and BC3 need `GL_EXT_texture_compression_s3tc`,
+        * and BC7 OpenGL 4.2 or `GL_ARB_texture_compression_bptc`. Queried on the first call.
+        */
+        static uint32_t supported_block_formats();
+
+        /**
+        * @brief Returns the OpenGL internal format of the blocks of the `format`, e.g. `GL_COMPRESSED_RG_RGTC2` for BC5.
+        */
+        static uint32_t compressed_texture_format(resources::BlockFormat format);
+
         /**
         * @brief Get texture format for a `number_of_channels`.
         * @param number_of_channels that the texture has.
@@ -107,6 +275,114 @@ namespace engine::graphics {
         static uint32_t compile_shader(const std::string &shader_source,
                                        resources::ShaderType shader_type);
 
+        /**
+        * @brief Check if the shader program with the `program_id` linked successfully.
+        * @returns true if the shader program linking succeeded, false otherwise.
+        */
+        static bool shader_program_linked_successfully(ShaderProgramId program_id);
+
+        /**
+        * @brief Retrieve the shader program link error log message.
+        * @param program_id Shader program id for which the linking failed.
+        * @returns shader program link error message.
+        */
+        static std::string get_link_error_message(ShaderProgramId program_id);
+
+        /**
+        * @brief Enumerates the active uniforms of a linked shader program and their locations.
+        * Every element of a uniform array is listed by its full name, `lights[3]`, and the array itself by its base name, `lights`.
+        * Uniforms in uniform blocks don't have a location and are skipped.
+        * @param program_id Linked shader program id.
+        * @returns Active uniform names mapped to their locations.
+        */
+        static resources::UniformLocations get_active_uniforms(ShaderProgramId program_id);
+
+        /**
+        * @brief Assigns every active sampler uniform of a linked shader program its own texture unit, in the order
+        * OpenGL lists them, and sets the sampler uniforms to those units. The units never change afterwards,
+        * so drawing only has to bind the textures. Every element of a sampler array gets its own unit.
+        * @param program_id Linked shader program id.
+        * @returns Active sampler names, like `texture_diffuse1` or `shadow_maps[2]`, mapped to their texture units.
+        */
+        static resources::SamplerUnits assign_sampler_units(ShaderProgramId program_id);
+
+        /**
+        * @brief Binds the uniform blocks of a linked shader program named as in @ref UNIFORM_BLOCK_NAMES
+        * to their @ref UniformBinding points. Other blocks are left alone.
+        * @param program_id Linked shader program id.
+        * @returns A mask with the bit `1 << binding` set for every block the program uses.
+        */
+        static uint32_t bind_uniform_blocks(ShaderProgramId program_id);
+
+        /**
+        * @brief Returns the alignment of the uniform buffer range offsets, `GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT`.
+        */
+        static std::size_t uniform_buffer_offset_alignment();
+
+        /**
+        * @brief Creates a uniform buffer of `size` bytes, filled with `data` if it isn't empty.
+        * @param size Size of the buffer in bytes.
+        * @param data Initial contents, at most `size` bytes.
+        * @returns OpenGL id of the buffer.
+        */
+        static uint32_t create_uniform_buffer(std::size_t size, std::span<const std::byte> data = {});
+
+        /**
+        * @brief Writes `data` into the uniform buffer at `offset`.
+        */
+        static void update_uniform_buffer(uint32_t buffer, std::span<const std::byte> data, std::size_t offset = 0);
+
+        /**
+        * @brief Replaces the whole storage of the uniform buffer with `data`. The old storage is orphaned,
+        * so the upload doesn't wait for the draws still reading it.
+        */
+        static void stream_uniform_buffer(uint32_t buffer, std::span<const std::byte> data);
+
+        /**
+        * @brief Deletes the buffer.
+        */
+        static void delete_buffer(uint32_t buffer);
+
+        /**
+        * @brief Creates an empty buffer and a buffer texture that reads it as `internal_format` texels, e.g. `GL_RGBA32F`.
+        */
+        static TextureBuffer create_texture_buffer(uint32_t internal_format);
+
+        /**
+        * @brief Replaces the whole storage of the texture buffer with `data`, orphaning the old storage.
+        */
+        static void stream_texture_buffer(const TextureBuffer &texture_buffer, std::span<const std::byte> data);
+
+        /**
+        * @brief Deletes the buffer texture and its buffer.
+        */
+        static void delete_texture_buffer(TextureBuffer &texture_buffer);
+
+        /**
+        * @brief Loads `glMultiDrawElementsIndirect` if the context is OpenGL 4.3 or newer. The engine asks for a 3.3 core
+        * context, which most drivers create at the newest core version they support, so the function is often there anyway.
+        * @param loader The function that returns the address of an OpenGL function, e.g. `glfwGetProcAddress`.
+        * @returns True if @ref OpenGL::multi_draw_elements_indirect can be used.
+        */
+        static bool load_multi_draw_indirect(void *(*loader)(const char *name));
+
+        /**
+        * @brief Returns true if @ref OpenGL::load_multi_draw_indirect loaded `glMultiDrawElementsIndirect`.
+        */
+        static bool multi_draw_indirect_supported();
+
+        /**
+        * @brief Replaces the whole storage of the indirect draw buffer with the `commands`, orphaning the old storage.
+        */
+        static void stream_indirect_buffer(uint32_t buffer, std::span<const DrawElementsIndirectCommand> commands);
+
+        /**
+        * @brief Draws `command_count` commands of the indirect `buffer`, starting from the `first_command`,
+        * with one `glMultiDrawElementsIndirect` call. The indices are `GL_UNSIGNED_INT` triangles of the bound vertex array.
+        * Requires @ref OpenGL::multi_draw_indirect_supported.
+        */
+        static void multi_draw_elements_indirect(uint32_t buffer, std::size_t first_command, uint32_t command_count);
+
         /**
         * @brief Loads the skybox textures from the `path`.
         * Make sure that images are named: front.jpg, back.jpg, up.jpg, down.jpg, left.jpg, down.jpg.
@@ -118,6 +394,23 @@ namespace engine::graphics {
         */
         static uint32_t load_skybox_textures(const std::filesystem::path &path, bool flip_uvs = false);
 
+        /**
+        * @brief Decodes the six skybox face images from the `path` in the cubemap face order: right, left, top, bottom, front, back.
+        * Doesn't touch the OpenGL context, so it's safe to call from any thread.
+        * @param path directory in which cubemap textures are located.
+        * @param flip_uvs wheater to flip_uvs on texture loading.
+        * @returns Decoded face images.
+        */
+        static std::array<resources::Image, 6> decode_skybox_faces(const std::filesystem::path &path,
+                                                                  bool flip_uvs = false);
+
+        /**
+        * @brief Uploads decoded skybox faces into a cubemap texture.
+        * @param faces images in the cubemap face order, see @ref OpenGL::decode_skybox_faces.
+        * @returns OpenGL id to the cubemap texture
+        */
+        static uint32_t generate_cubemap(const std::array<resources::Image, 6> &faces);
+
         /**
         * @brief Enables depth testing.
         */
@@ -133,6 +426,65 @@ namespace engine::graphics {
         */
         static void clear_buffers();
 
+        /**
+        * @brief Waits until the GPU executes all the issued commands.
+        */
+        static void finish();
+
+        /**
+        * @brief Creates a complete offscreen framebuffer of the given size.
+        * Throws @ref util::EngineError::Type::OpenGLError if the framebuffer is incomplete.
+        */
+        static Framebuffer create_framebuffer(int32_t width, int32_t height);
+
+        /**
+        * @brief Deletes the framebuffer and its attachments.
+        */
+        static void delete_framebuffer(Framebuffer &framebuffer);
+
+        /**
+        * @brief Reads the color attachment of the currently bound framebuffer into an RGBA image, top row first.
+        * Waits for the GPU to finish drawing.
+        */
+        static resources::Image read_pixels(int32_t width, int32_t height);
+
+        /**
+        * @brief Returns the number of bits of the GPU timestamp counter. Zero means the timestamp queries
+        * return no useful data, which is allowed by the specification and happens on some software renderers.
+        */
+        static int32_t timestamp_query_bits();
+
+        /**
+        * @brief Generates `queries.size()` query objects into `queries`.
+        */
+        static void generate_queries(std::span<uint32_t> queries);
+
+        /**
+        * @brief Deletes the query objects.
+        */
+        static void delete_queries(std::span<const uint32_t> queries);
+
+        /**
+        * @brief Records the GPU time into the query once all the previously issued commands are done.
+        */
+        static void query_timestamp(uint32_t query);
+
+        /**
+        * @brief Checks if the result of the query can be read without waiting for the GPU.
+        */
+        static bool query_result_available(uint32_t query);
+
+        /**
+        * @brief Reads the result of the query. Waits for the GPU if the result isn't available yet,
+        * see @ref OpenGL::query_result_available.
+        */
+        static uint64_t query_result(uint32_t query);
+
+        /**
+        * @brief Returns the current GPU time in nanoseconds, in the same time domain as @ref OpenGL::query_timestamp.
+        */
+        static uint64_t gpu_timestamp_ns();
+
         /**
         * @brief Retrieve the shader compilation error log message.
         * @param shader_id Shader id for which the compilation failed.
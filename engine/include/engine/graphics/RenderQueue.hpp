@@ -0,0 +1,245 @@
+/**
+ * @file RenderQueue.hpp
+ * @brief Defines the RenderQueue class that sorts draw submissions to minimize OpenGL state changes.
+ */
+
+#ifndef MATF_RG_PROJECT_RENDER_QUEUE_HPP
+#define MATF_RG_PROJECT_RENDER_QUEUE_HPP
+
+#include <glm/glm.hpp>
+#include <engine/graphics/Frustum.hpp>
+#include <engine/graphics/OpenGL.hpp>
+#include <engine/graphics/UniformBlocks.hpp>
+#include <cstddef>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace engine::resources {
+    class Mesh;
+    class Shader;
+}
+
+namespace engine::graphics {
+    /**
+    * @struct RenderStats
+    * @brief Counts of the state changes made and avoided by the @ref RenderQueue.
+    * A bind is elided when the state it would set is already current.
+    */
+    struct RenderStats {
+        uint32_t submitted{0};
+        uint32_t culled{0};
+        uint32_t draw_calls{0};
+        uint32_t triangles{0};
+        uint32_t program_binds{0};
+        uint32_t program_binds_elided{0};
+        uint32_t texture_binds{0};
+        uint32_t texture_binds_elided{0};
+        uint32_t vao_binds{0};
+        uint32_t vao_binds_elided{0};
+        uint32_t uniform_buffer_binds{0};
+        uint32_t uniform_buffer_binds_elided{0};
+        /**
+        * @brief The number of the multi-draw batches, and of the meshes drawn in them.
+        */
+        uint32_t batches{0};
+        uint32_t batched_draws{0};
+    };
+
+    /**
+    * @class RenderQueue
+    * @brief Collects the meshes submitted during a frame and draws them sorted by a packed 64-bit key,
+    * so that the draws sharing a shader, material and vertex array are issued back to back.
+    *
+    * The key is laid out from the most to the least significant bits as:
+    * | shader (12 bits) | material (20 bits) | vertex array (16 bits) | depth (16 bits) |
+    * Within the same state the draws go front to back, which helps the early depth test.
+    * Equal keys are drawn in the submission order.
+    *
+    * Before sorting, the world space bounding spheres of all the submitted meshes are tested against the frustum
+    * in one batch (see @ref Frustum::cull), and the meshes outside of it are dropped.
+    *
+    * The queue only sets the per-draw state: the program, the material textures bound to the units the shader
+    * assigned to their samplers (see @ref resources::Shader::texture_units), the material uniform buffer,
+    * the vertex array and the transform. The transforms of all the draws are uploaded at once into a uniform buffer,
+    * and every draw binds its range to the `Object` block (see @ref UniformBinding), so a draw uploads no uniforms.
+    * Shaders without the `Object` block get the transform in the `model` uniform instead.
+    * The `Camera` block is updated once per frame by the @ref GraphicsController.
+    *
+    * Shaders with the @ref RenderQueue::DRAW_TRANSFORMS_SAMPLER `samplerBuffer` are drawn in batches instead:
+    * consecutive draws with the same shader, material and vertex array become one `glMultiDrawElementsIndirect`
+    * of the commands built for the whole flush. Each draw reads its transform from the buffer texture at its draw id,
+    * which comes in the @ref GeometryArena::DRAW_ID_LOCATION attribute:
+    * @code
+    * layout (location = 9) in uint aDrawId;
+    * uniform samplerBuffer draw_transforms;
+    * ...
+    * int base = int(aDrawId) * 4;
+    * mat4 model = mat4(texelFetch(draw_transforms, base), texelFetch(draw_transforms, base + 1),
+    *                   texelFetch(draw_transforms, base + 2), texelFetch(draw_transforms, base + 3));
+    * @endcode
+    * Without OpenGL 4.3 the batch issues the same commands one `glDrawElementsBaseVertex` at a time,
+    * setting the draw id as a constant vertex attribute, so it still makes no other state changes between the draws.
+    *
+    * Batched shaders that also declare the @ref RenderQueue::DRAW_MATERIALS_SAMPLER `samplerBuffer` read the material
+    * constants of each draw from it too, @ref RenderQueue::MATERIAL_TEXELS texels per draw: the diffuse color,
+    * the specular color, and the shininess with the layer of the packed material (see @ref resources::TexturePack):
+    * @code
+    * uniform samplerBuffer draw_materials;
+    * ...
+    * vec4 params = texelFetch(draw_materials, int(aDrawId) * 3 + 2);
+    * int layer = int(params.y);
+    * @endcode
+    * Their batches then span all the meshes of the same shader and vertex array whose materials are packed into
+    * the same @ref resources::TexturePack. Packed materials drawn without a batch get their layer in the
+    * @ref resources::Material::LAYER_UNIFORM instead.
+    */
+    class RenderQueue {
+    public:
+        /**
+        * @brief The name of the buffer texture with the transforms of the batched draws.
+        */
+        static constexpr std::string_view DRAW_TRANSFORMS_SAMPLER = "draw_transforms";
+
+        /**
+        * @brief The name of the buffer texture with the material constants and the texture layers of the batched draws.
+        */
+        static constexpr std::string_view DRAW_MATERIALS_SAMPLER = "draw_materials";
+
+        /**
+        * @brief The number of `vec4` texels of a draw in the @ref RenderQueue::DRAW_MATERIALS_SAMPLER buffer.
+        */
+        static constexpr std::size_t MATERIAL_TEXELS = 3;
+
+        /**
+        * @brief Queues with fewer draws build their draw data on the calling thread, without the @ref util::JobSystem.
+        */
+        static constexpr std::size_t PARALLEL_BUILD_GRAIN = 1024;
+
+        /**
+        * @brief Packs the sort key of a draw.
+        * @param shader The shader to draw with.
+        * @param mesh The mesh to draw.
+        * @param depth Normalized distance from the camera, in [0, 1].
+        */
+        static uint64_t sort_key(const resources::Shader *shader, const resources::Mesh *mesh, float depth);
+
+        /**
+        * @brief Adds a mesh to the queue. The mesh is drawn on the next @ref RenderQueue::flush.
+        * @param mesh The mesh to draw.
+        * @param shader The shader to draw with.
+        * @param transform The model matrix, see @ref ObjectBlock.
+        * @param world_sphere The mesh bounding sphere transformed by the `transform`, used for culling.
+        * @param depth Normalized distance from the camera, in [0, 1].
+        * @param lod The level of detail of the mesh to draw, see @ref resources::Mesh::lod.
+        * @param screen_pixels The projected diameter of the mesh, in pixels, reported to the @ref TextureStreamer
+        * for the textures of its material. Infinity streams them at the full resolution.
+        */
+        void submit(const resources::Mesh *mesh, const resources::Shader *shader, const glm::mat4 &transform,
+                    const BoundingSphere &world_sphere, float depth, uint32_t lod = 0,
+                    float screen_pixels = std::numeric_limits<float>::infinity());
+
+        /**
+        * @brief Culls, sorts and draws all the submitted meshes, and clears the queue.
+        * @param frustum The view frustum in world space, or nullptr to draw all the meshes without culling.
+        */
+        void flush(const Frustum *frustum);
+
+        /**
+        * @brief Deletes the buffers of the per-draw data. Requires the OpenGL context.
+        */
+        void destroy();
+
+        /**
+        * @returns The number of the submitted meshes waiting for the @ref RenderQueue::flush.
+        */
+        std::size_t size() const {
+            return m_items.size();
+        }
+
+        /**
+        * @returns The stats accumulated since the last @ref RenderQueue::reset_stats.
+        */
+        const RenderStats &stats() const {
+            return m_stats;
+        }
+
+        void reset_stats() {
+            m_stats = RenderStats{};
+        }
+
+    private:
+        /**
+        * @brief Writes the @ref ObjectBlock, the transform and the indirect command of every draw, in the draw order,
+        * in parallel for large queues, and uploads each kind into its buffer with one upload.
+        */
+        void upload_draws();
+
+        /**
+        * @brief Returns the number of the draws from the `first` on that share its shader, material and vertex array.
+        * With a `per_draw_material`, the draws of the materials of the same @ref resources::TexturePack count as sharing it.
+        */
+        std::size_t batch_size(std::size_t first, bool per_draw_material) const;
+
+        /**
+        * @brief Draws the `count` draws from the `first` on with their commands in the indirect buffer.
+        * The state of the first draw is already bound.
+        */
+        void draw_batch(std::size_t first, std::size_t count);
+
+        struct Item {
+            const resources::Mesh *mesh;
+            const resources::Shader *shader;
+            glm::mat4 transform;
+            uint32_t lod;
+            float screen_pixels;
+        };
+
+        std::vector<Item> m_items;
+        /**
+        * @brief Sort keys paired with the index of the item in the `m_items`. Sorting the pairs instead of the items
+        * keeps the swaps cheap, and the index breaks the ties in the submission order.
+        */
+        std::vector<std::pair<uint64_t, uint32_t> > m_keys;
+        /**
+        * @brief World space bounding spheres of the `m_items`, in the same order.
+        */
+        SphereBatch m_spheres;
+        std::vector<uint8_t> m_visible;
+        RenderStats m_stats{};
+
+        /**
+        * @brief The @ref ObjectBlock of each draw of the flush, `m_object_stride` bytes apart.
+        */
+        std::vector<std::byte> m_objects;
+        uint32_t m_object_buffer{0};
+        /**
+        * @brief `sizeof(ObjectBlock)` rounded up to the uniform buffer offset alignment.
+        */
+        std::size_t m_object_stride{0};
+
+        /**
+        * @brief The transform and the indirect draw command of each draw of the flush, for the batched shaders.
+        * The draw id of a draw is its index in the flush; it's the base instance of its command.
+        */
+        std::vector<glm::mat4> m_transforms;
+        std::vector<OpenGL::DrawElementsIndirectCommand> m_commands;
+        OpenGL::TextureBuffer m_transform_buffer;
+        /**
+        * @brief The material constants and the texture layer of each draw of the flush, see @ref RenderQueue::MATERIAL_TEXELS.
+        */
+        std::vector<glm::vec4> m_materials;
+        OpenGL::TextureBuffer m_material_buffer;
+        uint32_t m_indirect_buffer{0};
+        /**
+        * @brief Consecutive draw ids, read by the draw id attribute once per instance, see @ref GeometryArena::attach_draw_id_buffer.
+        */
+        uint32_t m_draw_id_buffer{0};
+        std::size_t m_draw_id_capacity{0};
+    };
+} // namespace engine::graphics
+
+#endif//MATF_RG_PROJECT_RENDER_QUEUE_HPP
@@ -0,0 +1,211 @@
+/**
+ * @file TextureStreamer.hpp
+ * @brief Defines the TextureStreamer class that keeps only the mip levels of the textures the draws need in VRAM.
+ */
+
+#ifndef MATF_RG_PROJECT_TEXTURE_STREAMER_HPP
+#define MATF_RG_PROJECT_TEXTURE_STREAMER_HPP
+
+#include <engine/graphics/TextureUploader.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace engine::graphics {
+    /**
+    * @struct TextureStreaming
+    * @brief How the textures are streamed, see `resources.texture_streaming` in the config.json.
+    */
+    struct TextureStreaming {
+        bool enabled{false};
+        /**
+        * @brief VRAM the streamed textures may take, in bytes.
+        */
+        std::size_t budget_bytes{256u << 20};
+        /**
+        * @brief The levels up to this size, in pixels along the longer side, are loaded first and never evicted.
+        */
+        int32_t initial_size{64};
+        /**
+        * @brief Added to the required mip level; positive values load coarser levels and save VRAM.
+        */
+        float mip_bias{0.0f};
+    };
+
+    /**
+    * @class TextureStreamer
+    * @brief Streams the mip levels of the textures in and out of VRAM by how large they're drawn, under a VRAM budget.
+    *
+    * A texture whose whole mip chain is on the CPU, a @ref resources::BakedTexture or a @ref resources::CompressedImage,
+    * is created with its coarse levels only, up to @ref TextureStreaming::initial_size, which are uploaded first.
+    * The @ref RenderQueue reports the projected size of every drawn mesh with @ref TextureStreamer::request, and
+    * @ref TextureStreamer::end_frame turns it into the required level of each texture: the level whose size matches the
+    * pixels the mesh covers, assuming the texture is mapped over the mesh once. The finer levels are then uploaded
+    * one at a time through the @ref TextureUploader, and become visible by lowering `GL_TEXTURE_BASE_LEVEL`.
+    *
+    * When a level doesn't fit the budget, the finest levels of the least recently drawn textures are evicted first;
+    * the textures drawn in the frame give up only the levels finer than they need. An evicted level is dropped by
+    * redefining it as empty. The CPU copy of the chain stays, memory-mapped for the baked textures, so the level
+    * can be streamed in again later. Draws outside the render queue have no projected size and request the full level.
+    *
+    * The @ref resources::ResourcesController initializes the streamer and hands it the textures,
+    * and the @ref GraphicsController ends its frame in @ref GraphicsController::end_draw.
+    * Use @ref TextureStreamer::stats to size the budget: @ref Stats::peak_required_bytes is what the scene needed at most.
+    */
+    class TextureStreamer {
+    public:
+        /**
+        * @brief Residency of the streamed textures.
+        */
+        struct Stats {
+            uint32_t textures{0};
+            /**
+            * @brief Textures with a level being uploaded.
+            */
+            uint32_t loading{0};
+            /**
+            * @brief Textures with a level finer than their coarse ones being uploaded. Each is one of the
+            * @ref TextureUploader::Stats::pending_textures, which aren't part of loading the resources.
+            */
+            uint32_t streaming_in{0};
+            /**
+            * @brief Textures with all the levels they need resident.
+            */
+            uint32_t fully_resident{0};
+            /**
+            * @brief VRAM taken by the resident levels and the ones being uploaded.
+            */
+            std::size_t resident_bytes{0};
+            /**
+            * @brief VRAM the textures would take at the levels they last needed.
+            */
+            std::size_t required_bytes{0};
+            std::size_t peak_required_bytes{0};
+            /**
+            * @brief VRAM the textures would take with all their levels.
+            */
+            std::size_t full_bytes{0};
+            std::size_t budget_bytes{0};
+            uint64_t levels_loaded{0};
+            uint64_t levels_evicted{0};
+            /**
+            * @brief Levels that were needed but didn't fit the budget, counted once per frame.
+            */
+            uint64_t budget_misses{0};
+        };
+
+        /**
+        * @brief Get the instance of the @ref TextureStreamer class.
+        */
+        static TextureStreamer *instance();
+
+        void initialize(const TextureStreaming &settings);
+
+        /**
+        * @brief Forgets the streamed textures. The textures themselves are owned by the @ref resources::Texture objects.
+        */
+        void terminate();
+
+        bool enabled() const {
+            return m_settings.enabled;
+        }
+
+        /**
+        * @brief Creates the texture with its coarse levels and streams the rest on demand. `on_ready` gets the texture
+        * id once the coarse levels are uploaded. A texture with a single level isn't streamed, just uploaded.
+        */
+        void add(resources::BakedTexture texture, TextureUploader::OnReady on_ready);
+
+        /**
+        * @brief Like the @ref resources::BakedTexture overload, for a compressed mip chain.
+        */
+        void add(resources::CompressedImage image, TextureUploader::OnReady on_ready);
+
+        /**
+        * @brief Forgets the streamed `texture` and cancels its uploads. Call it before deleting the texture.
+        */
+        void remove(uint32_t texture);
+
+        /**
+        * @brief Records that the `texture` is drawn over `screen_pixels` pixels, the projected diameter of the mesh,
+        * or infinity for the full resolution. Ignores the textures that aren't streamed.
+        */
+        void request(uint32_t texture, float screen_pixels);
+
+        /**
+        * @brief Updates the required levels from the requests of the frame, evicts levels over the budget and queues
+        * the uploads of the levels the textures drawn in the frame miss. Called by @ref GraphicsController::end_draw.
+        */
+        void end_frame();
+
+        Stats stats() const;
+
+    private:
+        struct Entry {
+            uint32_t compressed_format{0};
+            std::vector<TextureUploader::Level> levels;
+            std::shared_ptr<const void> source;
+            /**
+            * @brief The finest resident level, the `GL_TEXTURE_BASE_LEVEL` of the texture.
+            */
+            int32_t resident_level{0};
+            /**
+            * @brief The finest of the levels loaded first, which stay resident.
+            */
+            int32_t coarse_level{0};
+            /**
+            * @brief The level being uploaded, or -1.
+            */
+            int32_t loading_level{-1};
+            int32_t required_level{0};
+            /**
+            * @brief The largest size the texture was requested at in the current frame.
+            */
+            float screen_pixels{0.0f};
+            uint64_t last_used_frame{0};
+        };
+
+        TextureStreamer() = default;
+
+        /**
+        * @brief Creates the texture of the `entry`, whose levels are set, and queues its coarse levels.
+        */
+        void start(Entry entry, TextureUploader::OnReady on_ready);
+
+        /**
+        * @brief Makes the level being uploaded into the `texture` visible.
+        */
+        void on_loaded(uint32_t texture);
+
+        /**
+        * @brief Returns the level of the `entry` that matches `screen_pixels`, at most its coarse level.
+        */
+        int32_t required_level(const Entry &entry, float screen_pixels) const;
+
+        /**
+        * @brief Evicts levels of the other textures until `bytes` more fit the budget.
+        * @returns false if they can't be made to fit.
+        */
+        bool make_room(std::size_t bytes, uint32_t texture);
+
+        /**
+        * @brief Drops the finest resident level of the `texture`.
+        */
+        void evict(uint32_t texture, Entry &entry);
+
+        /**
+        * @brief Returns the size of the levels of the `entry` from `first_level` to the last one, in bytes.
+        */
+        static std::size_t level_bytes(const Entry &entry, int32_t first_level);
+
+        TextureStreaming m_settings;
+        std::unordered_map<uint32_t, Entry> m_entries;
+        std::size_t m_resident_bytes{0};
+        uint64_t m_frame{1};
+        Stats m_stats;
+    };
+} // namespace engine::graphics
+
+#endif//MATF_RG_PROJECT_TEXTURE_STREAMER_HPP
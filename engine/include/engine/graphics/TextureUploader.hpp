@@ -0,0 +1,233 @@
+/**
+ * @file TextureUploader.hpp
+ * @brief Defines the TextureUploader class that streams texture data to the GPU through a ring of pixel buffer objects.
+ */
+
+#ifndef MATF_RG_PROJECT_TEXTURE_UPLOADER_HPP
+#define MATF_RG_PROJECT_TEXTURE_UPLOADER_HPP
+
+#include <engine/resources/BakedTexture.hpp>
+#include <engine/resources/CompressedImage.hpp>
+#include <engine/resources/Image.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace engine::graphics {
+    /**
+    * @class TextureUploader
+    * @brief Uploads textures over several frames through a staging ring of `GL_PIXEL_UNPACK_BUFFER` memory, so that
+    * a large texture doesn't stall the frame that created it.
+    *
+    * The ring is split into @ref TextureUploader::FRAMES_IN_FLIGHT segments of the frame budget. Every
+    * @ref TextureUploader::update copies the next rows of the queued textures into one segment, starts their
+    * `glTexSubImage2D` from the buffer, and puts a fence after them. The GPU copies the rows while the frame goes on;
+    * the segment is written again only after its fence is signaled, and the fence is never waited for:
+    * if it's still pending, that frame uploads nothing and is counted in @ref Stats::stalled_frames.
+    *
+    * The texture object is created with all its levels when it's queued, and handed to the `on_ready` callback once
+    * its last rows are uploaded, so an incomplete texture is never sampled. The queued images are owned by the uploader
+    * until then. The @ref GraphicsController initializes the uploader, and the @ref resources::ResourcesController
+    * queues the textures it loads asynchronously and updates the uploader in its `poll_events`.
+    * Configured in the config.json; when disabled the textures are uploaded directly when they're queued:
+    * @code
+    * "graphics": {
+    *   "texture_upload": { "enabled": true, "frame_budget_mb": 8 }
+    * }
+    * @endcode
+    */
+    class TextureUploader {
+    public:
+        /**
+        * @brief Number of frames whose uploads may be in flight, and the number of segments of the ring.
+        */
+        static constexpr uint32_t FRAMES_IN_FLIGHT = 3;
+
+        /**
+        * @brief Called with the OpenGL id of the texture once it's uploaded.
+        */
+        using OnReady = std::function<void(uint32_t texture_id)>;
+
+        /**
+        * @brief A level, or a cube map face, of a texture to upload.
+        */
+        struct Level {
+            uint32_t target;
+            int32_t level;
+            int32_t width;
+            int32_t height;
+            /**
+            * @brief Number of 8-bit channels of the pixels, 0 for compressed blocks.
+            */
+            int32_t channels;
+            std::span<const std::byte> data;
+        };
+
+        /**
+        * @brief Progress of the uploads.
+        */
+        struct Stats {
+            /**
+            * @brief Textures queued and not uploaded yet.
+            */
+            uint32_t pending_textures{0};
+            std::size_t pending_bytes{0};
+            uint64_t uploaded_textures{0};
+            uint64_t uploaded_bytes{0};
+            /**
+            * @brief Frames that had something to upload but found their segment still in use by the GPU.
+            */
+            uint64_t stalled_frames{0};
+            /**
+            * @brief Size of the ring of staging memory, in bytes.
+            */
+            std::size_t staging_bytes{0};
+        };
+
+        /**
+        * @brief Get the instance of the @ref TextureUploader class.
+        */
+        static TextureUploader *instance();
+
+        /**
+        * @brief Creates the staging ring. Requires the OpenGL context.
+        * @param enabled If false, the textures are uploaded directly when they're queued.
+        * @param frame_budget_bytes How many bytes a frame uploads at most; the ring is @ref TextureUploader::FRAMES_IN_FLIGHT times larger.
+        */
+        void initialize(bool enabled, std::size_t frame_budget_bytes);
+
+        /**
+        * @brief Deletes the staging ring, and the textures that are still queued, without calling their callbacks.
+        */
+        void terminate();
+
+        /**
+        * @brief Queues the `image` and its mipmaps, generated on the GPU after the last row of the image is uploaded.
+        */
+        void upload(resources::Image image, OnReady on_ready);
+
+        /**
+        * @brief Queues the compressed mip chain of the `image`. Its format has to be in @ref OpenGL::supported_block_formats.
+        */
+        void upload(resources::CompressedImage image, OnReady on_ready);
+
+        /**
+        * @brief Queues the mip chain of the baked `texture`, which is copied into the staging ring straight from its mapping.
+        */
+        void upload(resources::BakedTexture texture, OnReady on_ready);
+
+        /**
+        * @brief Queues the faces of a cube map, in the order of @ref OpenGL::generate_cubemap.
+        */
+        void upload_cubemap(std::array<resources::Image, 6> faces, OnReady on_ready);
+
+        /**
+        * @brief Queues more levels of the existing 2D `texture`. Their storage is allocated now, and their rows are
+        * uploaded like those of a new texture; the sampling parameters are left as they are.
+        * @param compressed_format The OpenGL compressed format of the levels, or 0 for 8-bit pixels.
+        * @param source Keeps the memory of the `levels` alive until they're uploaded.
+        */
+        void upload_levels(uint32_t texture, uint32_t compressed_format, std::vector<Level> levels,
+                           std::shared_ptr<const void> source, OnReady on_ready);
+
+        /**
+        * @brief Drops the queued uploads into the `texture`, without calling their callbacks. Call it before deleting
+        * a texture whose levels may still be queued.
+        */
+        void cancel(uint32_t texture);
+
+        /**
+        * @brief Copies the next rows of the queued textures, up to the frame budget, into the staging ring and starts their upload.
+        * Calls the `on_ready` of the textures whose last rows were uploaded. Called once per frame, on the main thread.
+        */
+        void update();
+
+        /**
+        * @brief Uploads everything that is still queued directly, ignoring the frame budget, and calls the callbacks.
+        */
+        void flush();
+
+        Stats stats() const;
+
+    private:
+        /**
+        * @brief A queued texture and how far its upload got.
+        */
+        struct Upload {
+            uint32_t texture{0};
+            uint32_t target{0};
+            /**
+            * @brief The OpenGL compressed format of the blocks, or 0 for 8-bit pixels.
+            */
+            uint32_t compressed_format{0};
+            bool generate_mipmaps{false};
+            std::vector<Level> levels;
+            /**
+            * @brief Keeps the memory of the `levels` alive.
+            */
+            std::shared_ptr<const void> source;
+            OnReady on_ready;
+            std::size_t next_level{0};
+            /**
+            * @brief The first row of the `next_level` that isn't uploaded yet, in rows of pixels or of blocks.
+            */
+            int32_t next_row{0};
+        };
+
+        /**
+        * @brief Rows copied into the staging ring and waiting for their `glTexSubImage2D`.
+        */
+        struct Copy {
+            std::size_t upload;
+            std::size_t level;
+            int32_t first_row;
+            int32_t row_count;
+            std::size_t offset;
+        };
+
+        TextureUploader() = default;
+
+        /**
+        * @brief Allocates the storage of all the levels of the `upload` and queues it. A new texture object is created,
+        * with its sampling parameters, unless the `upload` has one. Uploads it directly instead if the uploader isn't available.
+        */
+        void enqueue(Upload upload);
+
+        /**
+        * @brief Returns the number of rows of the `level` the upload goes by: pixel rows, or rows of 4x4 blocks.
+        */
+        static int32_t row_count(const Upload &upload, const Level &level);
+
+        /**
+        * @brief Returns the size of a row of the `level`, as @ref TextureUploader::row_count counts them, in bytes.
+        */
+        static std::size_t row_size(const Upload &upload, const Level &level);
+
+        /**
+        * @brief Calls `glTexSubImage2D` or `glCompressedTexSubImage2D` for the rows of the `level`, read from `data`,
+        * which is a client pointer, or an offset into the bound pixel unpack buffer.
+        */
+        static void upload_rows(const Upload &upload, const Level &level, int32_t first_row, int32_t row_count,
+                                const void *data);
+
+        /**
+        * @brief Generates the mipmaps of the uploaded texture if it needs them, and hands it to `on_ready`.
+        */
+        void finish(Upload upload);
+
+        std::deque<Upload> m_queue;
+        uint32_t m_buffer{0};
+        std::size_t m_segment_size{0};
+        std::array<void *, FRAMES_IN_FLIGHT> m_fences{};
+        uint32_t m_current_segment{0};
+        Stats m_stats;
+        bool m_available{false};
+    };
+} // namespace engine::graphics
+
+#endif//MATF_RG_PROJECT_TEXTURE_UPLOADER_HPP
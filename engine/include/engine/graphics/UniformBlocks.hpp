@@ -0,0 +1,92 @@
+/**
+ * @file UniformBlocks.hpp
+ * @brief Defines the uniform blocks the engine fills, their binding points and their std140 layouts.
+ */
+
+#ifndef MATF_RG_PROJECT_UNIFORM_BLOCKS_HPP
+#define MATF_RG_PROJECT_UNIFORM_BLOCKS_HPP
+
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace engine::graphics {
+    /**
+    * @brief The binding points of the uniform blocks the engine fills.
+    *
+    * The blocks are matched by name when a shader program is linked, see @ref OpenGL::bind_uniform_blocks,
+    * so shaders only declare them, without a `binding` layout qualifier:
+    * @code
+    * layout (std140) uniform Camera {
+    *     mat4 projection;
+    *     mat4 view;
+    *     vec4 camera_position;
+    * };
+    *
+    * layout (std140) uniform Material {
+    *     vec4 diffuse_color;
+    *     vec4 specular_color;
+    *     float shininess;
+    * };
+    *
+    * layout (std140) uniform Object {
+    *     mat4 model;
+    * };
+    * @endcode
+    */
+    enum class UniformBinding : uint32_t {
+        /**
+        * @brief @ref CameraBlock, updated once per frame by the @ref GraphicsController.
+        */
+        Camera = 0,
+        /**
+        * @brief @ref MaterialBlock, one buffer per @ref resources::Material.
+        */
+        Material = 1,
+        /**
+        * @brief @ref ObjectBlock, one range per draw of the @ref RenderQueue.
+        */
+        Object = 2,
+    };
+
+    /**
+    * @brief The uniform block names, indexed by the @ref UniformBinding.
+    */
+    inline constexpr std::array<std::string_view, 3> UNIFORM_BLOCK_NAMES = {"Camera", "Material", "Object"};
+
+    /**
+    * @brief The std140 layout of the `Camera` uniform block.
+    */
+    struct CameraBlock {
+        glm::mat4 projection{1.0f};
+        glm::mat4 view{1.0f};
+        /**
+        * @brief The camera position in world space, `w` is 1.
+        */
+        glm::vec4 position{0.0f, 0.0f, 0.0f, 1.0f};
+    };
+
+    /**
+    * @brief The std140 layout of the `Material` uniform block.
+    */
+    struct MaterialBlock {
+        glm::vec4 diffuse{1.0f};
+        glm::vec4 specular{0.0f, 0.0f, 0.0f, 1.0f};
+        float shininess{32.0f};
+        float padding[3]{};
+    };
+
+    /**
+    * @brief The std140 layout of the `Object` uniform block.
+    */
+    struct ObjectBlock {
+        glm::mat4 model{1.0f};
+    };
+
+    static_assert(sizeof(CameraBlock) == 144);
+    static_assert(sizeof(MaterialBlock) == 48);
+    static_assert(sizeof(ObjectBlock) == 64);
+} // namespace engine::graphics
+
+#endif//MATF_RG_PROJECT_UNIFORM_BLOCKS_HPP
@@ -0,0 +1,104 @@
+/**
+ * @file VertexFormat.hpp
+ * @brief Defines the vertex layouts meshes are stored in on the GPU, and the encoding of the imported vertices into them.
+ */
+
+#ifndef MATF_RG_PROJECT_VERTEX_FORMAT_HPP
+#define MATF_RG_PROJECT_VERTEX_FORMAT_HPP
+
+#include <engine/graphics/Bounds.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace engine::resources {
+    struct Vertex;
+}
+
+namespace engine::graphics {
+    /**
+    * @brief The layouts of the vertices on the GPU. Meshes with the same format share the vertex arrays of the @ref GeometryArena.
+    *
+    * All the formats feed the same attribute locations, so the shaders don't depend on the format:
+    * | location | attribute | Standard | Compact | CompactHalfPosition |
+    * |----------|-----------|----------|---------|---------------------|
+    * | 0 | position | 3 x float | 3 x float | 3 x half float |
+    * | 1 | normal | 3 x float | `GL_INT_2_10_10_10_REV` snorm | `GL_INT_2_10_10_10_REV` snorm |
+    * | 2 | uvs | 2 x float | 2 x half float | 2 x half float |
+    * | 3 | tangent | 3 x float | `GL_INT_2_10_10_10_REV` snorm, `w` is the bitangent sign | same as Compact |
+    * | 4 | bitangent | 3 x float | not stored | not stored |
+    *
+    * The compact formats don't store the bitangent; shaders that need it derive it as
+    * `cross(normal, tangent.xyz) * tangent.w`. Declaring the tangent as a `vec4` works for all the formats,
+    * since an attribute with three components reads `w` as 1.
+    */
+    enum class VertexFormat : uint32_t {
+        /**
+        * @brief @ref resources::Vertex as is, 56 bytes.
+        */
+        Standard,
+        /**
+        * @brief Float positions, packed normals and tangents, half float uvs, 24 bytes.
+        */
+        Compact,
+        /**
+        * @brief Like @ref VertexFormat::Compact with half float positions, 20 bytes.
+        */
+        CompactHalfPosition,
+    };
+
+    /**
+    * @brief Returns the size of a vertex in the `format`, in bytes.
+    */
+    uint32_t vertex_size(VertexFormat format);
+
+    std::string_view vertex_format_name(VertexFormat format);
+
+    /**
+    * @brief Sets up the attributes of the `format` in the bound vertex array, reading from the bound `GL_ARRAY_BUFFER`.
+    */
+    void set_vertex_attributes(VertexFormat format);
+
+    /**
+    * @brief Encodes the `vertices` into the `format`.
+    * @param out At least `vertices.size() * vertex_size(format)` bytes.
+    */
+    void encode_vertices(VertexFormat format, std::span<const resources::Vertex> vertices, std::span<std::byte> out);
+
+    /**
+    * @struct VertexCompression
+    * @brief The settings the importer chooses the @ref VertexFormat of a mesh with, from `resources.vertex_compression` in the config.json.
+    */
+    struct VertexCompression {
+        /**
+        * @brief Use the compact formats. Off, every mesh is @ref VertexFormat::Standard.
+        */
+        bool enabled{true};
+        /**
+        * @brief Allow @ref VertexFormat::CompactHalfPosition for the meshes whose positions fit it.
+        */
+        bool half_positions{false};
+        /**
+        * @brief The largest position error of the half float positions, relative to the diagonal of the mesh bounding box.
+        */
+        float position_tolerance{0.0005f};
+
+        /**
+        * @brief Identifies the settings in the key of the baked models, so that changing them re-imports the models.
+        */
+        uint32_t key() const;
+    };
+
+    /**
+    * @brief Chooses the smallest @ref VertexFormat that holds the `vertices` within the `compression` settings.
+    * Meshes with uvs out of the half float precision range stay @ref VertexFormat::Standard.
+    * @param vertices The vertices of the mesh.
+    * @param bounds The bounds of the `vertices`.
+    * @param compression The settings.
+    */
+    VertexFormat choose_vertex_format(std::span<const resources::Vertex> vertices, const Bounds &bounds,
+                                      const VertexCompression &compression);
+} // namespace engine::graphics
+
+#endif//MATF_RG_PROJECT_VERTEX_FORMAT_HPP
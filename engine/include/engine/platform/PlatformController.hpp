@@ -41,6 +41,10 @@ namespace engine::platform {
     * @class PlatformController
     * @brief Registers Platform events such as mouse movement, key press, window events...
     *
+    * Pass `--headless` to the app, or set `"window": { "headless": true }` in the config.json, to run without a display.
+    * The window is then an invisible window on the GLFW null platform, with a surfaceless EGL or an OSMesa context,
+    * and the @ref graphics::GraphicsController draws into an offscreen framebuffer. The @ref Window, @ref FrameTime and
+    * input APIs work the same, the keys just never get pressed. Pass `--frames N` to exit after N frames.
     */
     class PlatformController final : public core::Controller {
         friend class ControllerManager;
@@ -65,6 +69,13 @@ namespace engine::platform {
         */
         std::string_view name() const override;
 
+        /**
+        * @brief Checks if the platform runs without a display. See @ref PlatformController.
+        */
+        bool headless() const {
+            return m_headless;
+        }
+
         /**
         * @brief Get the window
         * @returns @ref Window
@@ -95,6 +106,18 @@ namespace engine::platform {
             return m_frame_time.dt;
         }
 
+        /**
+        * @brief Makes every frame advance the @ref FrameTime by exactly `seconds`, instead of the measured time,
+        * so that the frames are reproducible. Pass 0 to go back to the measured time.
+        */
+        void set_fixed_dt(float seconds) {
+            m_fixed_dt = seconds;
+        }
+
+        float fixed_dt() const {
+            return m_fixed_dt;
+        }
+
         /**
         *  @brief Enables/disabled the visibility of the cursor on screen.
         */
@@ -153,8 +176,15 @@ namespace engine::platform {
 
         void update_key(Key &key_data) const;
 
-        FrameTime m_frame_time;
+        FrameTime m_frame_time{};
         Window m_window;
+        bool m_headless{false};
+        /**
+        * @brief Number of frames after which @ref PlatformController::loop ends the app, 0 for no limit.
+        */
+        int m_frame_limit{0};
+        int m_frame_count{0};
+        float m_fixed_dt{0.0f};
         std::vector<Key> m_keys;
         std::vector<std::unique_ptr<PlatformEventObserver> > m_platform_event_observers;
     };
@@ -0,0 +1,173 @@
+/**
+ * @file BakedModel.hpp
+ * @brief Defines the BakedModel class, the engine-native binary format of imported models.
+ */
+
+#ifndef MATF_RG_PROJECT_BAKED_MODEL_HPP
+#define MATF_RG_PROJECT_BAKED_MODEL_HPP
+
+#include <engine/graphics/VertexFormat.hpp>
+#include <engine/resources/Mesh.hpp>
+#include <engine/resources/MeshOptimizer.hpp>
+#include <engine/resources/MeshSimplifier.hpp>
+#include <engine/util/MappedFile.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace engine::resources {
+    /**
+    * @struct MeshView
+    * @brief Non-owning view of the data needed to create a @ref Mesh in the OpenGL context.
+    */
+    struct MeshView {
+        /**
+        * @brief The vertices encoded in the `vertex_format`, see @ref graphics::encode_vertices.
+        */
+        std::span<const std::byte> vertices;
+        graphics::VertexFormat vertex_format;
+        std::span<const uint32_t> indices;
+        std::span<const TextureReference> textures;
+        graphics::Bounds bounds;
+        uint32_t material_index;
+        graphics::MaterialBlock material;
+        /**
+        * @brief The levels of detail in the `indices`; empty for a single level.
+        */
+        std::span<const MeshLod> lods;
+    };
+
+    /**
+    * @struct ImportSettings
+    * @brief Everything that decides what importing a model file produces, see @ref ResourcesController::import_model.
+    */
+    struct ImportSettings {
+        /**
+        * @brief Assimp post-processing flags.
+        */
+        uint32_t flags{0};
+        /**
+        * @brief The settings the vertex format of each mesh is chosen with.
+        */
+        graphics::VertexCompression vertex_compression;
+        /**
+        * @brief The settings the vertices and triangles of each mesh are reordered with.
+        */
+        MeshOptimization mesh_optimization;
+        /**
+        * @brief The levels of detail generated for each mesh.
+        */
+        LodGeneration lods;
+    };
+
+    /**
+    * @struct BakedModelKey
+    * @brief Identifies the import a baked model was produced by. A baked model is only used if its key matches.
+    */
+    struct BakedModelKey {
+        std::filesystem::path source_path;
+        /**
+        * @brief Last write time of the source model file, in ticks of the filesystem clock.
+        */
+        int64_t source_mtime;
+        /**
+        * @brief Assimp post-processing flags the model was imported with.
+        */
+        uint32_t import_flags;
+        /**
+        * @brief The @ref graphics::VertexCompression::key of the settings the vertex formats were chosen with.
+        */
+        uint32_t vertex_compression;
+        /**
+        * @brief The @ref MeshOptimization::key of the settings the meshes were optimized with.
+        */
+        uint32_t mesh_optimization;
+        /**
+        * @brief The @ref LodGeneration::key of the settings the levels of detail were generated with.
+        */
+        uint32_t mesh_lods;
+
+        /**
+        * @brief Builds the key for the current state of the model file at `source_path` imported with the `settings`.
+        */
+        static BakedModelKey of(const std::filesystem::path &source_path, const ImportSettings &settings);
+    };
+
+    /**
+    * @class BakedModel
+    * @brief A model in the engine-native binary format: interleaved vertex arrays, `uint32_t` indices
+    * and the material constants, levels of detail and texture references of all the meshes, laid out so that the file can be memory-mapped and used in place.
+    *
+    * The layout is a header followed by 16-byte aligned sections: mesh records, vertices, indices,
+    * texture records, level of detail records and a string table. Vertices and indices are uploaded to OpenGL straight from the mapping,
+    * without parsing. The vertices of each mesh are stored already encoded in its @ref graphics::VertexFormat.
+    * The format is native-endian; any change to the layout or to the vertex formats bumps @ref BakedModel::VERSION,
+    * which invalidates the previously baked files.
+    */
+    class BakedModel {
+    public:
+        static constexpr uint32_t VERSION = 6;
+
+        /**
+        * @brief Serializes the imported meshes into the baked format, keeping the bytes in memory.
+        * The vertices are encoded in the @ref MeshData::vertex_format of their mesh.
+        * @param key The import that produced the `meshes`.
+        * @param meshes Imported meshes, see @ref ResourcesController::import_model.
+        * @returns The baked model.
+        */
+        static BakedModel bake(const BakedModelKey &key, const std::vector<MeshData> &meshes);
+
+        /**
+        * @brief Maps a baked model file into memory and validates it against the `key`.
+        * @param path The baked model file.
+        * @param key The expected import; a file baked from a different source, modification time, flags,
+        * vertex compression, mesh optimization or levels of detail is rejected.
+        * @returns The baked model, or std::nullopt if the file doesn't exist, is stale or malformed.
+        */
+        static std::optional<BakedModel> open(const std::filesystem::path &path, const BakedModelKey &key);
+
+        /**
+        * @brief Writes the baked bytes to the `path`, creating the parent directories.
+        * The file is first written next to the `path` and then renamed, so readers never see a partial file.
+        * @returns true if the file was written.
+        */
+        bool write(const std::filesystem::path &path) const;
+
+        /**
+        * @returns The views of all the meshes, in import order.
+        */
+        std::vector<MeshView> meshes() const;
+
+        /**
+        * @returns The serialized bytes.
+        */
+        std::span<const std::byte> bytes() const {
+            return m_bytes;
+        }
+
+        /**
+        * @brief Returns the baked model file name for a model import. The name depends on the path and flags only,
+        * so a re-import of a modified source overwrites the stale file.
+        */
+        static std::filesystem::path file_name(const std::filesystem::path &source_path, uint32_t import_flags);
+
+    private:
+        BakedModel() = default;
+
+        /**
+        * @brief Validates the layout of `m_bytes` and decodes the texture references.
+        * @returns false if the bytes are malformed.
+        */
+        bool parse(const BakedModelKey *expected_key);
+
+        util::MappedFile m_file;
+        std::vector<std::byte> m_buffer;
+        std::span<const std::byte> m_bytes;
+        std::vector<TextureReference> m_textures;
+    };
+} // namespace engine::resources
+
+#endif//MATF_RG_PROJECT_BAKED_MODEL_HPP
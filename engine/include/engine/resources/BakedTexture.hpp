@@ -0,0 +1,151 @@
+/**
+ * @file BakedTexture.hpp
+ * @brief Defines the BakedTexture class, the engine-native binary format of decoded and mipmapped textures.
+ */
+
+#ifndef MATF_RG_PROJECT_BAKED_TEXTURE_HPP
+#define MATF_RG_PROJECT_BAKED_TEXTURE_HPP
+
+#include <engine/resources/CompressedImage.hpp>
+#include <engine/resources/Image.hpp>
+#include <engine/resources/Texture.hpp>
+#include <engine/util/MappedFile.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace engine::resources {
+    /**
+    * @struct BakedTextureKey
+    * @brief Identifies the source image and the settings a baked texture was produced from.
+    * A baked texture is only used if its key matches.
+    */
+    struct BakedTextureKey {
+        std::filesystem::path source_path;
+        /**
+        * @brief Last write time of the source image file, in ticks of the filesystem clock.
+        */
+        int64_t source_mtime;
+        uint64_t source_size;
+        /**
+        * @brief Everything besides the source that decides the baked texture, see @ref TextureCompressor::settings_key.
+        */
+        uint64_t settings;
+
+        /**
+        * @brief Builds the key for the current state of the image file at `source_path` loaded with the `settings`.
+        */
+        static BakedTextureKey of(const std::filesystem::path &source_path, uint64_t settings);
+
+        /**
+        * @brief Hashes the contents of the file at `path` with 64-bit FNV-1a.
+        * @returns The hash, or 0 if the file can't be read.
+        */
+        static uint64_t content_hash(const std::filesystem::path &path);
+    };
+
+    /**
+    * @class BakedTexture
+    * @brief A texture in the engine-native binary format: its whole mip chain, either as raw 8-bit pixels or as
+    * compressed blocks, laid out so that the file can be memory-mapped and uploaded in place.
+    *
+    * The layout is a header, the level records and the 16-byte aligned levels, the full size first. Nothing has to be
+    * decoded or mipmapped on load: @ref graphics::OpenGL::generate_texture uploads the levels straight from the mapping.
+    * The source image is matched by its size and modification time; when only the time changed, e.g. after a checkout,
+    * the contents are hashed and compared with the hash stored at bake time, so that the texture isn't baked again.
+    * The format is native-endian; any change to the layout bumps @ref BakedTexture::VERSION.
+    */
+    class BakedTexture {
+    public:
+        static constexpr uint32_t VERSION = 1;
+
+        /**
+        * @struct Level
+        * @brief A mip level of the texture.
+        */
+        struct Level {
+            int32_t width;
+            int32_t height;
+            std::span<const std::byte> data;
+        };
+
+        /**
+        * @brief Builds the mip chain of the decoded `image`, down to 1x1, see @ref Image::next_mip_level,
+        * and serializes it into the baked format, keeping the bytes in memory.
+        */
+        static BakedTexture bake(const BakedTextureKey &key, const Image &image);
+
+        /**
+        * @brief Serializes the compressed mip chain into the baked format, keeping the bytes in memory.
+        */
+        static BakedTexture bake(const BakedTextureKey &key, const CompressedImage &image);
+
+        /**
+        * @brief Maps a baked texture file into memory and validates it against the `key`.
+        * @param path The baked texture file.
+        * @param key The expected source and settings; a file baked from a different source, contents or settings is rejected.
+        * @returns The baked texture, or std::nullopt if the file doesn't exist, is stale or malformed.
+        */
+        static std::optional<BakedTexture> open(const std::filesystem::path &path, const BakedTextureKey &key);
+
+        /**
+        * @brief Writes the baked bytes to the `path`, creating the parent directories.
+        * The file is first written next to the `path` and then renamed, so readers never see a partial file.
+        * @returns true if the file was written.
+        */
+        bool write(const std::filesystem::path &path) const;
+
+        /**
+        * @brief Returns the baked texture file name for a texture. The name depends on the path, the type and
+        * the flip only, so baking a modified source overwrites the stale file.
+        */
+        static std::filesystem::path file_name(const std::filesystem::path &source_path, TextureType type,
+                                               bool flip_vertically);
+
+        /**
+        * @returns The block format of the compressed levels, or std::nullopt for raw pixels.
+        */
+        std::optional<BlockFormat> block_format() const;
+
+        /**
+        * @returns The number of 8-bit channels of the raw pixels: 1, 3 or 4. 0 for compressed levels.
+        */
+        int32_t channels() const;
+
+        uint32_t level_count() const;
+
+        Level level(uint32_t index) const;
+
+        /**
+        * @returns The serialized bytes.
+        */
+        std::span<const std::byte> bytes() const {
+            return m_bytes;
+        }
+
+    private:
+        BakedTexture() = default;
+
+        /**
+        * @brief Lays out the header and the levels, which the `fill` writes into the returned texture.
+        */
+        static BakedTexture layout(const BakedTextureKey &key, uint32_t format, uint32_t channels,
+                                   const std::vector<std::pair<int32_t, int32_t> > &level_sizes,
+                                   const std::function<void(uint32_t level, std::span<std::byte> data)> &fill);
+
+        /**
+        * @brief Validates the layout of `m_bytes`.
+        * @returns false if the bytes are malformed.
+        */
+        bool parse();
+
+        util::MappedFile m_file;
+        std::vector<std::byte> m_buffer;
+        std::span<const std::byte> m_bytes;
+    };
+} // namespace engine::resources
+
+#endif//MATF_RG_PROJECT_BAKED_TEXTURE_HPP
@@ -0,0 +1,137 @@
+/**
+ * @file CompressedImage.hpp
+ * @brief Defines the CompressedImage struct that holds the block-compressed mip chain of a texture in CPU memory.
+ */
+
+#ifndef MATF_RG_PROJECT_COMPRESSED_IMAGE_HPP
+#define MATF_RG_PROJECT_COMPRESSED_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace engine::resources {
+    /**
+    * @enum BlockFormat
+    * @brief The GPU block compression formats the engine reads and writes. Each block holds 4x4 pixels.
+    */
+    enum class BlockFormat : uint32_t {
+        /**
+        * @brief RGB with 1-bit alpha, 8 bytes per block. Needs `GL_EXT_texture_compression_s3tc`.
+        */
+        BC1,
+        /**
+        * @brief RGBA, BC1 color with a BC4 alpha, 16 bytes per block. Needs `GL_EXT_texture_compression_s3tc`.
+        */
+        BC3,
+        /**
+        * @brief One channel, 8 bytes per block. Core since OpenGL 3.0.
+        */
+        BC4,
+        /**
+        * @brief Two BC4 channels, 16 bytes per block, for tangent space normal maps. Core since OpenGL 3.0.
+        */
+        BC5,
+        /**
+        * @brief RGBA with better quality than BC1 and BC3, 16 bytes per block. Needs OpenGL 4.2 or `GL_ARB_texture_compression_bptc`.
+        */
+        BC7,
+    };
+
+    /**
+    * @brief Returns the name of the `format`, like "BC5", for logs.
+    */
+    std::string_view block_format_name(BlockFormat format);
+
+    /**
+    * @brief Returns the size of a 4x4 block of the `format` in bytes.
+    */
+    std::size_t block_size(BlockFormat format);
+
+    /**
+    * @struct CompressedImage
+    * @brief The mip chain of a block-compressed texture, rows stored top to bottom like in the file it was read from.
+    *
+    * Read from DDS or KTX2 files with @ref CompressedImage::load, or produced from an @ref Image by
+    * @ref TextureCompressor::compress. Like @ref Image, it touches no OpenGL state, so it can be read on any thread
+    * and uploaded on the main thread with @ref graphics::OpenGL::generate_texture.
+    */
+    struct CompressedImage {
+        /**
+        * @struct Level
+        * @brief Where a mip level is in the `data`.
+        */
+        struct Level {
+            int32_t width{0};
+            int32_t height{0};
+            std::size_t offset{0};
+            std::size_t size{0};
+        };
+
+        BlockFormat format{BlockFormat::BC1};
+        /**
+        * @brief The mip levels, the full size first. Files may stop the chain before 1x1.
+        */
+        std::vector<Level> levels;
+        std::vector<uint8_t> data;
+
+        int32_t width() const {
+            return levels.empty() ? 0 : levels.front().width;
+        }
+
+        int32_t height() const {
+            return levels.empty() ? 0 : levels.front().height;
+        }
+
+        /**
+        * @returns The blocks of the mip `level`.
+        */
+        std::span<const uint8_t> level_data(std::size_t level) const {
+            return std::span(data).subspan(levels[level].offset, levels[level].size);
+        }
+
+        /**
+        * @brief Appends an empty mip level of `width` by `height` pixels and returns its blocks to fill.
+        */
+        std::span<uint8_t> add_level(int32_t width, int32_t height);
+
+        /**
+        * @brief Returns the size of the blocks of a `width` by `height` pixel level of the `format` in bytes.
+        */
+        static std::size_t level_size(BlockFormat format, int32_t width, int32_t height);
+
+        /**
+        * @brief Returns true if the `path` has the extension of a compressed texture container, ".dds" or ".ktx2".
+        */
+        static bool is_container(const std::filesystem::path &path);
+
+        /**
+        * @brief Reads a DDS or KTX2 file. Safe to call from any thread.
+        *
+        * Only 2D textures in the @ref BlockFormat formats are read; KTX2 files have to be without supercompression.
+        * @param path path to the ".dds" or ".ktx2" file.
+        * @returns The image. Throws @ref util::EngineError::Type::AssetLoadingError if the file can't be read.
+        */
+        static CompressedImage load(const std::filesystem::path &path);
+
+        /**
+        * @brief Writes the image as a DDS file. BC7 is written with the DX10 header extension, the other formats
+        * with their FourCC, which the older tools read too.
+        * @returns true if the file was written.
+        */
+        bool save_dds(const std::filesystem::path &path) const;
+
+        /**
+        * @brief Flips the rows of every level in place, by reversing the block rows and the pixel rows inside
+        * the blocks, so that the first row is the bottom of the image. The blocks are never decoded.
+        * @returns false, leaving the image as it is, for BC7, whose partitions don't flip by moving bits,
+        * and for the levels whose height is neither a multiple of 4 nor under 4.
+        */
+        bool flip_vertically();
+    };
+} // namespace engine::resources
+
+#endif//MATF_RG_PROJECT_COMPRESSED_IMAGE_HPP
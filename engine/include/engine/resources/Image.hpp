@@ -0,0 +1,54 @@
+/**
+ * @file Image.hpp
+ * @brief Defines the Image struct that holds decoded pixels of an image file in CPU memory.
+ */
+
+#ifndef MATF_RG_PROJECT_IMAGE_HPP
+#define MATF_RG_PROJECT_IMAGE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace engine::resources {
+    /**
+    * @struct Image
+    * @brief Decoded 8-bit pixels of an image file, rows stored top to bottom unless flipped on load.
+    *
+    * Decoding touches no OpenGL state, so images can be decoded on any thread and uploaded on the main thread
+    * with @ref graphics::OpenGL::generate_texture.
+    */
+    struct Image {
+        int32_t width{0};
+        int32_t height{0};
+        /**
+        * @brief Number of 8-bit channels per pixel: 1, 3 or 4.
+        */
+        int32_t channels{0};
+        std::vector<uint8_t> pixels;
+
+        /**
+        * @brief Decodes the image file. Safe to call from any thread.
+        * @param path path to the image file.
+        * @param flip_vertically flip the rows so that the first row is the bottom of the image.
+        * @returns The decoded image. Throws @ref util::EngineError::Type::AssetLoadingError if the file can't be decoded.
+        */
+        static Image load(const std::filesystem::path &path, bool flip_vertically);
+
+        /**
+        * @brief Averages every 2x2 pixels into one, like `glGenerateMipmap`, for the next level of a mip chain.
+        * The last row and column of the odd sizes are averaged with themselves.
+        * @returns The image of half the size, at least 1x1.
+        */
+        Image next_mip_level() const;
+
+        /**
+        * @brief Writes the RGB channels of the image as a binary PPM file, which needs no encoder and is easy to diff.
+        * Grayscale images are written as gray RGB, and the alpha channel is dropped.
+        * @returns true if the file was written.
+        */
+        bool save_ppm(const std::filesystem::path &path) const;
+    };
+} // namespace engine::resources
+
+#endif//MATF_RG_PROJECT_IMAGE_HPP
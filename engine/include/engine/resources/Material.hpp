@@ -0,0 +1,154 @@
+/**
+ * @file Material.hpp
+ * @brief Defines the Material class that groups the textures and the constants a mesh is drawn with.
+ */
+
+#ifndef MATF_RG_PROJECT_MATERIAL_HPP
+#define MATF_RG_PROJECT_MATERIAL_HPP
+
+#include <engine/graphics/UniformBlocks.hpp>
+#include <engine/resources/Texture.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace engine::resources {
+    class Shader;
+    class TexturePack;
+
+    /**
+    * @class Material
+    * @brief The textures and the constants of a surface, shared by all the meshes drawn with it.
+    *
+    * The constants live in a uniform buffer owned by the material, bound to the `Material` uniform block
+    * (see @ref graphics::UniformBinding) before the meshes are drawn, so drawing a mesh doesn't upload them.
+    * The buffer is only written when the constants change, with @ref Material::set_constants.
+    *
+    * Models create a material per Assimp material, named `<model name>/<material index>`.
+    * Other materials can be created with @ref ResourcesController::material.
+    *
+    * The materials of the models that pack their textures have no textures of their own: they bind the array textures
+    * of their @ref TexturePack, and the shaders read their layer from the @ref Material::LAYER_UNIFORM,
+    * or from the per-draw data of the @ref graphics::RenderQueue. Their samplers are `sampler2DArray`s.
+    */
+    class Material {
+        friend class ResourcesController;
+
+    public:
+        /**
+        * @brief The name of the `int` uniform the layer of a packed material is set to, see @ref Material::texture_layer.
+        */
+        static constexpr std::string_view LAYER_UNIFORM = "texture_layer";
+
+        /**
+        * @brief Binds the material textures to the texture units the `shader` assigned to their samplers,
+        * and the constants to the `Material` uniform block. A packed material binds the arrays of its pack instead,
+        * and sets its layer to the @ref Material::LAYER_UNIFORM.
+        */
+        void bind(const Shader *shader) const;
+
+        /**
+        * @brief Replaces the constants and writes them to the uniform buffer.
+        */
+        void set_constants(const graphics::MaterialBlock &constants);
+
+        const graphics::MaterialBlock &constants() const {
+            return m_constants;
+        }
+
+        /**
+        * @brief Returns the textures of the material; empty for a packed material.
+        */
+        const std::vector<Texture *> &textures() const {
+            return m_textures;
+        }
+
+        /**
+        * @brief Returns the types of the textures the material is drawn with: those of the @ref Material::textures,
+        * or of the arrays of its @ref TexturePack.
+        */
+        const std::vector<TextureType> &texture_types() const {
+            return m_texture_types;
+        }
+
+        /**
+        * @brief Returns the pack with the textures of the material, or nullptr if the material isn't packed.
+        */
+        const TexturePack *texture_pack() const {
+            return m_texture_pack;
+        }
+
+        /**
+        * @brief Returns the layer of the arrays of the @ref Material::texture_pack with the textures of the material.
+        */
+        uint32_t texture_layer() const {
+            return m_texture_layer;
+        }
+
+        /**
+        * @brief Returns the names of the sampler uniforms that read the material textures, in the order of @ref Material::texture_types:
+        * the @ref Texture::uniform_name_convention followed by the index among the textures of the same type, e.g. `texture_diffuse1`.
+        * Allocates, so it's meant for building the tables of @ref Shader::texture_units, not for drawing.
+        */
+        std::vector<std::string> sampler_uniform_names() const;
+
+        /**
+        * @brief Identifies the sequence of texture types of the material. Materials with the same sampler layout
+        * have the same @ref Material::sampler_uniform_names, and so share the @ref Shader::texture_units table.
+        */
+        uint64_t sampler_layout() const {
+            return m_sampler_layout;
+        }
+
+        /**
+        * @brief Returns the OpenGL id of the uniform buffer with the constants.
+        */
+        uint32_t uniform_buffer() const {
+            return m_uniform_buffer;
+        }
+
+        /**
+        * @brief Returns the name of the material by which it can be referenced using the @ref ResourcesController::material function.
+        */
+        const std::string &name() const {
+            return m_name;
+        }
+
+        /**
+        * @brief Destroys the uniform buffer in the OpenGL context. The textures are owned by the @ref ResourcesController.
+        */
+        void destroy();
+
+    private:
+        /**
+        * @brief Constructs a Material object and creates its uniform buffer. Requires the OpenGL context.
+        * @param name The name of the material.
+        * @param textures The textures of the material.
+        * @param constants The initial constants.
+        */
+        Material(std::string name, std::vector<Texture *> textures, const graphics::MaterialBlock &constants);
+
+        /**
+        * @brief Constructs a Material object drawn with the `layer` of the `pack`, and creates its uniform buffer.
+        * Requires the OpenGL context.
+        */
+        Material(std::string name, const TexturePack *pack, uint32_t layer, const graphics::MaterialBlock &constants);
+
+        /**
+        * @brief Computes the sampler layout and creates the uniform buffer.
+        */
+        void initialize();
+
+        std::string m_name;
+        std::vector<Texture *> m_textures;
+        std::vector<TextureType> m_texture_types;
+        const TexturePack *m_texture_pack{nullptr};
+        uint32_t m_texture_layer{0};
+        graphics::MaterialBlock m_constants;
+        uint64_t m_sampler_layout{0};
+        uint32_t m_uniform_buffer{0};
+    };
+} // namespace engine::resources
+
+#endif//MATF_RG_PROJECT_MATERIAL_HPP
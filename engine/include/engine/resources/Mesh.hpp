@@ -7,7 +7,12 @@
 #define MATF_RG_PROJECT_MESH_HPP
 
 #include <glm/glm.hpp>
+#include <engine/graphics/Bounds.hpp>
+#include <engine/graphics/GeometryArena.hpp>
+#include <algorithm>
+#include <span>
 #include <vector>
+#include <engine/resources/Material.hpp>
 #include <engine/resources/Texture.hpp>
 
 namespace engine::resources {
@@ -24,38 +29,202 @@ namespace engine::resources {
         glm::vec3 Bitangent;
     };
 
+    /**
+    * @struct TextureReference
+    * @brief A texture file referenced by a mesh material.
+    */
+    struct TextureReference {
+        std::filesystem::path path;
+        TextureType type;
+    };
+
+    /**
+    * @struct MeshLod
+    * @brief A level of detail of a mesh: a range of its indices that draws a simplified version of it with the same vertices.
+    * Level 0 is the full mesh.
+    */
+    struct MeshLod {
+        /**
+        * @brief The first index of the level, relative to the first index of the mesh.
+        */
+        uint32_t first_index{0};
+        uint32_t index_count{0};
+        /**
+        * @brief The largest distance of the simplified surface from the full mesh, relative to the radius of its bounding sphere.
+        */
+        float error{0.0f};
+    };
+
+    /**
+    * @struct MeshData
+    * @brief CPU-side mesh data produced by the model importer, before the mesh is created in the OpenGL context.
+    *
+    * Producing it doesn't touch the OpenGL context, so models can be imported on a worker thread.
+    */
+    struct MeshData {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<TextureReference> textures;
+        graphics::Bounds bounds;
+        /**
+        * @brief Index of the material in the imported scene. Meshes of a model with the same index share a @ref Material.
+        */
+        uint32_t material_index{0};
+        graphics::MaterialBlock material;
+        /**
+        * @brief The layout the vertices are stored in on the GPU, chosen by the importer, see @ref graphics::choose_vertex_format.
+        */
+        graphics::VertexFormat vertex_format{graphics::VertexFormat::Standard};
+        /**
+        * @brief The levels of detail, see @ref MeshSimplifier::generate_lods. Their indices follow one another in the `indices`.
+        * Empty means a single level with all the `indices`.
+        */
+        std::vector<MeshLod> lods;
+    };
+
     /**
     * @class Mesh
     * @brief Represents a mesh in the model in the OpenGL context.
+    *
+    * The vertices and the indices live in the @ref graphics::GeometryArena, so meshes with the same vertex format
+    * share a vertex array and are drawn with `glDrawElementsBaseVertex` at their @ref Mesh::base_vertex and @ref Mesh::first_index.
+    * The indices of the levels of detail follow the full mesh in the same range, see @ref Mesh::lod.
     */
     class Mesh {
-        friend class AssimpSceneProcessor;
+        friend class ResourcesController;
     public:
 
         /**
         * @brief Draws the mesh using a given shader. Called by the @ref Model::draw function to draw all the meshes in the model.
         * @param shader The shader to use for drawing.
+        * @param lod The level of detail to draw, see @ref Mesh::lod.
+        */
+        void draw(const Shader *shader, uint32_t lod = 0);
+
+        /**
+        * @brief Draws `instance_count` instances of the mesh with one draw call. Called by the @ref Model::draw_instanced
+        * after it uploaded the instance transforms into the buffer attached with @ref Mesh::attach_instance_buffer.
+        * @param shader The shader to use for drawing.
+        * @param instance_count The number of instances to draw.
+        * @param lod The level of detail to draw, see @ref Mesh::lod.
+        */
+        void draw_instanced(const Shader *shader, uint32_t instance_count, uint32_t lod = 0);
+
+        /**
+        * @brief Attaches a buffer of per-instance `glm::mat4` transforms to the mesh vertex array, as the attribute locations
+        * @ref Mesh::INSTANCE_TRANSFORM_LOCATION to @ref Mesh::INSTANCE_TRANSFORM_LOCATION + 3, advancing once per instance.
+        * The vertex array is shared with the other meshes in the same arena block, so attach the buffer before every
+        * @ref Mesh::draw_instanced; it's a no-op when the buffer is already attached.
+        * @param instance_vbo The buffer with the instance transforms.
         */
-        void draw(const Shader *shader);
+        void attach_instance_buffer(uint32_t instance_vbo);
 
         /**
-        * @brief Destroys the mesh in the OpenGL context.
+        * @brief The first attribute location of the per-instance model matrix, see @ref Mesh::attach_instance_buffer.
+        * In the vertex shader: `layout (location = 5) in mat4 aInstanceModel;`
+        */
+        static constexpr uint32_t INSTANCE_TRANSFORM_LOCATION = 5;
+
+        /**
+        * @brief Returns the vertices and the indices of the mesh to the @ref graphics::GeometryArena.
         */
         void destroy();
 
+        /**
+        * @brief Returns the vertex array of the mesh, shared with the other meshes in its @ref graphics::GeometryArena block.
+        */
+        uint32_t vao() const {
+            return m_geometry.vao;
+        }
+
+        /**
+        * @brief Returns the number of the indices of the full mesh, the level of detail 0.
+        */
+        uint32_t num_indices() const {
+            return m_lods.front().index_count;
+        }
+
+        uint32_t lod_count() const {
+            return static_cast<uint32_t>(m_lods.size());
+        }
+
+        /**
+        * @brief Returns the level of detail `level`, or the coarsest one if the mesh has fewer levels.
+        * Its first index in the index buffer is @ref Mesh::first_index + `lod.first_index`.
+        */
+        const MeshLod &lod(uint32_t level) const {
+            return m_lods[std::min<std::size_t>(level, m_lods.size() - 1)];
+        }
+
+        /**
+        * @brief Returns the index of the first vertex of the mesh in the vertex buffer, the `basevertex` of the draw calls.
+        */
+        int32_t base_vertex() const {
+            return m_geometry.base_vertex;
+        }
+
+        /**
+        * @brief Returns the index of the first index of the mesh in the index buffer.
+        */
+        uint32_t first_index() const {
+            return m_geometry.first_index;
+        }
+
+        graphics::VertexFormat vertex_format() const {
+            return m_geometry.format;
+        }
+
+        /**
+        * @brief Returns the range of the mesh in the @ref graphics::GeometryArena. Its indices are those of all the levels of detail.
+        */
+        const graphics::GeometryRange &geometry() const {
+            return m_geometry;
+        }
+
+        /**
+        * @brief Returns the material the mesh is drawn with. Never null.
+        */
+        const Material *material() const {
+            return m_material;
+        }
+
+        /**
+        * @brief Returns the bounds of the mesh vertices, in model space.
+        */
+        const graphics::Bounds &bounds() const {
+            return m_bounds;
+        }
+
+        /**
+        * @brief Computes the bounding box and a bounding sphere centered in the box of the `vertices`.
+        */
+        static graphics::Bounds compute_bounds(std::span<const Vertex> vertices);
+
     private:
         /**
-        * @brief Constructs a Mesh object.
-        * @param vertices The vertices in the mesh.
-        * @param indices The indices in the mesh.
-        * @param textures The textures in the mesh.
+        * @brief Constructs a Mesh object and copies the vertices and the indices into the @ref graphics::GeometryArena.
+        * @param format The layout of the `vertices`.
+        * @param vertices The vertices in the mesh, encoded with @ref graphics::encode_vertices.
+        * @param indices The indices in the mesh, of all the `lods`.
+        * @param material The material of the mesh.
+        * @param bounds The bounds of the vertices, see @ref Mesh::compute_bounds.
+        * @param lods The levels of detail in the `indices`; empty for a single level with all of them.
          */
-        Mesh(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices,
-             std::vector<Texture *> textures);
+        Mesh(graphics::VertexFormat format, std::span<const std::byte> vertices, std::span<const uint32_t> indices,
+             const Material *material, const graphics::Bounds &bounds, std::span<const MeshLod> lods = {});
+
+        /**
+        * @brief Returns the offset of the first index of the `level` in the index buffer, in the form `glDrawElements*` take it.
+        */
+        const void *index_offset(const MeshLod &level) const;
 
-        uint32_t m_vao{0};
-        uint32_t m_num_indices{0};
-        std::vector<Texture *> m_textures;
+        graphics::GeometryRange m_geometry;
+        /**
+        * @brief The levels of detail, at least one.
+        */
+        std::vector<MeshLod> m_lods;
+        const Material *m_material{nullptr};
+        graphics::Bounds m_bounds;
     };
 } // namespace engine
 
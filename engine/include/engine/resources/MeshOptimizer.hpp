@@ -0,0 +1,134 @@
+/**
+ * @file MeshOptimizer.hpp
+ * @brief Defines the MeshOptimizer class that reorders the imported meshes for the GPU vertex cache, overdraw and vertex fetch.
+ */
+
+#ifndef MATF_RG_PROJECT_MESH_OPTIMIZER_HPP
+#define MATF_RG_PROJECT_MESH_OPTIMIZER_HPP
+
+#include <engine/resources/Mesh.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace engine::resources {
+    /**
+    * @struct MeshOptimization
+    * @brief The settings of the import-time mesh optimization, from `resources.mesh_optimization` in the config.json.
+    */
+    struct MeshOptimization {
+        /**
+        * @brief Run the optimization. Off, the meshes keep the vertex and triangle order of the model file.
+        */
+        bool enabled{true};
+        /**
+        * @brief How much worse than the vertex cache order the average cache miss ratio may get for the overdraw order.
+        * 1 keeps the vertex cache order, larger values allow more triangle clusters to be sorted front to back.
+        */
+        float overdraw_threshold{1.05f};
+
+        /**
+        * @brief Identifies the settings in the key of the baked models, so that changing them re-imports the models.
+        */
+        uint32_t key() const;
+    };
+
+    /**
+    * @struct VertexCacheStats
+    * @brief The efficiency of an index buffer for a simulated FIFO post-transform vertex cache.
+    */
+    struct VertexCacheStats {
+        uint32_t triangles{0};
+        /**
+        * @brief The number of different vertices the triangles use.
+        */
+        uint32_t referenced{0};
+        /**
+        * @brief The number of vertices the vertex shader runs for.
+        */
+        uint32_t transformed{0};
+        /**
+        * @brief Average cache miss ratio, transformed vertices per triangle. 0.5 is the ideal for large regular meshes, 3 the worst.
+        */
+        float acmr{0.0f};
+        /**
+        * @brief Average transform to vertex ratio, transformed vertices per referenced vertex. 1 is the ideal.
+        */
+        float atvr{0.0f};
+    };
+
+    /**
+    * @struct MeshOptimizationStats
+    * @brief What @ref MeshOptimizer::optimize did to a mesh.
+    */
+    struct MeshOptimizationStats {
+        uint32_t vertices_before{0};
+        uint32_t vertices_after{0};
+        VertexCacheStats before;
+        VertexCacheStats after;
+    };
+
+    /**
+    * @class MeshOptimizer
+    * @brief Reorders the vertices and the triangles of an imported mesh so that the GPU draws it with less work.
+    *
+    * @ref MeshOptimizer::optimize runs the stages in order:
+    * 1. @ref MeshOptimizer::deduplicate_vertices merges the vertices with identical attributes, since Assimp emits
+    *    one vertex per face corner for most formats.
+    * 2. @ref MeshOptimizer::optimize_vertex_cache reorders the triangles so that they reuse the recently transformed vertices.
+    * 3. @ref MeshOptimizer::optimize_overdraw sorts clusters of triangles so that the outward facing ones are drawn first
+    *    and occlude the rest, within @ref MeshOptimization::overdraw_threshold of the vertex cache order.
+    * 4. @ref MeshOptimizer::optimize_vertex_fetch renumbers the vertices in the order the triangles first use them.
+    *
+    * The stages only change the order of the triangles, not their winding or what they cover. None of them touches
+    * the OpenGL context, so they run on the import thread and their output is baked with the model.
+    */
+    class MeshOptimizer {
+    public:
+        /**
+        * @brief The size of the FIFO cache the stats and the overdraw clusters are computed for. Older GPUs have
+        * 16 to 32 entries and newer ones batch vertices differently, but the reuse a FIFO of this size measures carries over.
+        */
+        static constexpr uint32_t CACHE_SIZE = 16;
+
+        /**
+        * @brief Runs all the stages on the `vertices` and the triangle list `indices` in place.
+        * @returns The vertex counts and the vertex cache stats before and after.
+        */
+        static MeshOptimizationStats optimize(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices,
+                                              const MeshOptimization &settings);
+
+        /**
+        * @brief Merges the bitwise identical vertices and points the indices to the remaining copy.
+        * @returns The number of the vertices left.
+        */
+        static uint32_t deduplicate_vertices(std::vector<Vertex> &vertices, std::span<uint32_t> indices);
+
+        /**
+        * @brief Reorders the triangles for the post-transform vertex cache, with the linear-speed greedy algorithm
+        * of Tom Forsyth: the next triangle is the one whose vertices score highest by their position in a simulated
+        * LRU cache and by how few triangles still use them.
+        */
+        static void optimize_vertex_cache(std::span<uint32_t> indices, uint32_t vertex_count);
+
+        /**
+        * @brief Splits the triangles, in vertex cache order, into clusters that start where the cache is cold anyway,
+        * and sorts the clusters by how much they face away from the center of the mesh, outermost first.
+        */
+        static void optimize_overdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices, float threshold);
+
+        /**
+        * @brief Renumbers the vertices in the order of their first use in the `indices` and drops the unused ones.
+        * @returns The number of the vertices left.
+        */
+        static uint32_t optimize_vertex_fetch(std::vector<Vertex> &vertices, std::span<uint32_t> indices);
+
+        /**
+        * @brief Simulates a FIFO vertex cache of `cache_size` entries drawing the triangle list `indices`.
+        */
+        static VertexCacheStats analyze_vertex_cache(std::span<const uint32_t> indices, uint32_t vertex_count,
+                                                     uint32_t cache_size = CACHE_SIZE);
+    };
+} // namespace engine::resources
+
+#endif//MATF_RG_PROJECT_MESH_OPTIMIZER_HPP
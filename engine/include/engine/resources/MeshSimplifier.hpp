@@ -0,0 +1,91 @@
+/**
+ * @file MeshSimplifier.hpp
+ * @brief Defines the MeshSimplifier class that generates the levels of detail of the imported meshes.
+ */
+
+#ifndef MATF_RG_PROJECT_MESH_SIMPLIFIER_HPP
+#define MATF_RG_PROJECT_MESH_SIMPLIFIER_HPP
+
+#include <engine/resources/Mesh.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace engine::resources {
+    /**
+    * @struct LodGeneration
+    * @brief How many levels of detail the importer generates for the meshes of a model, from the `lods` of the model
+    * in `resources.models` in the config.json.
+    */
+    struct LodGeneration {
+        /**
+        * @brief The most levels a mesh can have after the full mesh; the @ref LodGeneration::key has 4 bits for them.
+        */
+        static constexpr uint32_t MAX_LEVELS = 15;
+
+        /**
+        * @brief The number of the levels after the full mesh, at most @ref LodGeneration::MAX_LEVELS. 0 generates none.
+        */
+        uint32_t levels{0};
+        /**
+        * @brief The fraction of the triangles of the full mesh each level keeps relative to the previous one.
+        */
+        float reduction{0.5f};
+        /**
+        * @brief The largest distance of a level from the full mesh, relative to the radius of the mesh bounding sphere.
+        * A level stops simplifying when it would go over it, so it may keep more triangles than the `reduction` asks for.
+        */
+        float max_error{0.02f};
+
+        /**
+        * @brief Identifies the settings in the key of the baked models, so that changing them re-imports the models.
+        */
+        uint32_t key() const;
+    };
+
+    /**
+    * @class MeshSimplifier
+    * @brief Simplifies triangle meshes by collapsing edges in the order of their quadric error (Garland and Heckbert).
+    *
+    * The simplification only rewrites the indices: an edge collapses into one of its two vertices, so every level of
+    * detail draws with the vertex buffer of the full mesh, and a mesh needs one vertex range in the
+    * @ref graphics::GeometryArena for all its levels.
+    *
+    * The vertices on the attribute seams, where a position has vertices with different normals or uvs, and the vertices
+    * where the mesh isn't manifold stay in place, so the simplified mesh doesn't tear its textures. The vertices on the
+    * open borders only collapse along the border.
+    */
+    class MeshSimplifier {
+    public:
+        /**
+        * @brief Simplifies the triangle list `indices` towards `target_index_count` indices.
+        * @param vertices The vertices the `indices` point to.
+        * @param indices The triangle list to simplify.
+        * @param target_index_count The number of the indices to stop at.
+        * @param target_error The largest distance of the simplified surface from the original, in model units.
+        * The simplification stops before it, even if it has more indices than the `target_index_count` left.
+        * @param result_error If not null, receives the distance the result reached.
+        * @returns The simplified triangle list, pointing to a subset of the `vertices`.
+        */
+        static std::vector<uint32_t> simplify(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+                                              std::size_t target_index_count, float target_error,
+                                              float *result_error = nullptr);
+
+        /**
+        * @brief Simplifies the full mesh in `indices` into the levels of the `settings`, appends the indices of each level
+        * to the `indices`, and reorders them for the vertex cache, see @ref MeshOptimizer::optimize_vertex_cache.
+        * Stops early when a level would drop fewer than 5% of the triangles of the previous one.
+        * @param vertices The vertices of the mesh; with a vertex per face corner nothing simplifies,
+        * see @ref MeshOptimizer::deduplicate_vertices.
+        * @param indices The triangle list of the full mesh.
+        * @param radius The radius of the mesh bounding sphere.
+        * @param settings How many levels to generate.
+        * @returns The levels, the full mesh first.
+        */
+        static std::vector<MeshLod> generate_lods(std::span<const Vertex> vertices, std::vector<uint32_t> &indices,
+                                                  float radius, const LodGeneration &settings);
+    };
+} // namespace engine::resources
+
+#endif//MATF_RG_PROJECT_MESH_SIMPLIFIER_HPP
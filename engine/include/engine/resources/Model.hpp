@@ -7,8 +7,13 @@
 #define MATF_RG_PROJECT_MODEL_HPP
 #include <engine/resources/Mesh.hpp>
 #include <algorithm>
+#include <span>
 #include <utility>
 
+namespace engine::graphics {
+    struct PerspectiveMatrixParams;
+}
+
 namespace engine::resources {
     /**
     * @class Model
@@ -20,15 +25,89 @@ namespace engine::resources {
     public:
         /**
         * @brief Draws the model using a given shader by drawing all the meshes in the model.
+        * The caller sets the shader uniforms, including the model matrix, or binds the `Object` uniform block.
         * @param shader The shader to use for drawing.
         */  
         void draw(const Shader *shader);
 
+        /**
+        * @brief Draws the model with the `transform` as its model matrix. The transform is written into the `Object`
+        * uniform block of the shader, or into its `model` uniform if the shader doesn't declare the block,
+        * see @ref graphics::GraphicsController::set_object_uniforms.
+        * @code
+        * backpack->draw(shader, glm::scale(glm::mat4(1.0f), glm::vec3(0.5f)));
+        * @endcode
+        * @param shader The shader to use for drawing.
+        * @param transform The model matrix the model is drawn with.
+        */
+        void draw(const Shader *shader, const glm::mat4 &transform);
+
+        /**
+        * @brief Draws the level of detail of the model that fits its size on the screen, see @ref Model::select_lod.
+        * Like @ref Model::draw, the `transform` is written into the `Object` uniform block or the `model` uniform.
+        * @code
+        * auto graphics = engine::core::Controller::get<engine::graphics::GraphicsController>();
+        * backpack->draw(shader, transform, graphics->camera()->Position, graphics->perspective_params());
+        * @endcode
+        * @param shader The shader to use for drawing.
+        * @param transform The model matrix the model is drawn with.
+        * @param camera_position The position of the camera, in world space.
+        * @param perspective The projection the model is drawn with.
+        */
+        void draw(const Shader *shader, const glm::mat4 &transform, const glm::vec3 &camera_position,
+                  const graphics::PerspectiveMatrixParams &perspective);
+
+        /**
+        * @brief Returns the height of the bounding sphere of the model on the screen, as a fraction of the viewport height.
+        * Greater than 1 when the sphere covers the whole viewport, and infinite when the camera is inside it.
+        * @param transform The model matrix the model is drawn with.
+        * @param camera_position The position of the camera, in world space.
+        * @param perspective The projection the model is drawn with.
+        */
+        float screen_size(const glm::mat4 &transform, const glm::vec3 &camera_position,
+                          const graphics::PerspectiveMatrixParams &perspective) const;
+
+        /**
+        * @brief Returns the level of detail for the @ref Model::screen_size: the number of the `lods.screen_sizes`
+        * thresholds of the model in the config.json that are above it. Meshes with fewer levels draw their coarsest one.
+        */
+        uint32_t select_lod(float screen_size) const;
+
+        /**
+        * @brief Returns the number of the levels of detail of the model, the most any of its meshes has.
+        */
+        uint32_t lod_count() const;
+
+        /**
+        * @brief Draws one instance of the model per transform, with one draw call per mesh.
+        *
+        * The transforms are streamed into an instance buffer shared by all the meshes of the model, and read in
+        * the vertex shader from the attribute locations 5 to 8 instead of the `model` uniform:
+        * @code
+        * layout (location = 5) in mat4 aInstanceModel;
+        * ...
+        * gl_Position = projection * view * aInstanceModel * vec4(aPos, 1.0);
+        * @endcode
+        * @param shader The shader to use for drawing.
+        * @param transforms The model matrix of each instance.
+        */
+        void draw_instanced(const Shader *shader, std::span<const glm::mat4> transforms);
+
         /**
         * @brief Destroys the model in the OpenGL context.
         */  
         void destroy();
 
+        /**
+        * @brief Returns whether the model finished loading. With asynchronous loading enabled
+        * the @ref ResourcesController returns the model before its meshes are created; until then
+        * the model has no meshes and drawing it draws nothing.
+        * @returns true if the meshes of the model are created in the OpenGL context.
+        */
+        bool is_ready() const {
+            return m_ready;
+        }
+
         /**
         * @brief Returns the meshes in the model.
         * @returns The meshes in the model.
@@ -37,6 +116,13 @@ namespace engine::resources {
             return m_meshes;
         }
 
+        /**
+        * @brief Returns the bounds enclosing all the meshes of the model, in model space.
+        */
+        const graphics::Bounds &bounds() const {
+            return m_bounds;
+        }
+
         /**
         * @brief Returns the path to the model file from which the model was loaded.
         * @returns The path to the model.
@@ -59,6 +145,10 @@ namespace engine::resources {
         */                      
         std::vector<Mesh> m_meshes;
         /**
+        * @brief The bounds enclosing all the meshes.
+        */
+        graphics::Bounds m_bounds;
+        /**
         * @brief The path to the model file from which the model was loaded.
         */  
         std::filesystem::path m_path;
@@ -66,6 +156,22 @@ namespace engine::resources {
         * @brief The name of the model by which it can be referenced using the @ref engine::resources::ResourcesController::model function.
         */  
         std::string m_name;
+        /**
+        * @brief The screen sizes below which the next level of detail is drawn, in descending order, see @ref Model::select_lod.
+        */
+        std::vector<float> m_lod_screen_sizes;
+        /**
+        * @brief Set once the meshes of the model are created in the OpenGL context.
+        */
+        bool m_ready{false};
+        /**
+        * @brief The buffer of the instance transforms, created on the first @ref Model::draw_instanced.
+        */
+        uint32_t m_instance_vbo{0};
+        /**
+        * @brief The number of transforms the instance buffer can hold without reallocating.
+        */
+        std::size_t m_instance_capacity{0};
 
         Model() = default;
 
@@ -78,7 +184,11 @@ namespace engine::resources {
         Model(std::vector<Mesh> meshes, std::filesystem::path path,
               std::string name) : m_meshes(std::move(meshes))
                               , m_path(std::move(path))
-                              , m_name(std::move(name)) {
+                              , m_name(std::move(name))
+                              , m_ready(true) {
+            for (const auto &mesh: m_meshes) {
+                m_bounds = graphics::Bounds::merge(m_bounds, mesh.bounds());
+            }
         }
     };
 } // namespace engine
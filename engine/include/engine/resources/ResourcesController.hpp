@@ -7,16 +7,58 @@
 #define MATF_RG_PROJECT_RESOURCES_CONTROLLER_HPP
 
 #include <engine/core/Controller.hpp>
+#include <engine/graphics/VertexFormat.hpp>
+#include <engine/resources/BakedModel.hpp>
+#include <engine/resources/BakedTexture.hpp>
 #include <engine/resources/Model.hpp>
 #include <engine/resources/Texture.hpp>
+#include <engine/resources/TextureCompressor.hpp>
+#include <engine/resources/TexturePack.hpp>
 #include <engine/resources/Shader.hpp>
 #include <engine/resources/Skybox.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <unordered_map>
+#include <variant>
 
 namespace engine::resources {
     /**
     * @class ResourcesController
     * @brief Manages app resources: @ref Model, @ref Texture, @ref Shader, and @ref Skybox.
+    *
+    * When `resources.async_loading` is set in the config.json, models, textures and skyboxes are decoded
+    * in @ref util::JobSystem jobs, and only the OpenGL objects are created on the main thread,
+    * during @ref ResourcesController::poll_events. The returned pointers are valid immediately and become ready later,
+    * see @ref Model::is_ready, @ref Texture::is_ready and @ref Skybox::is_ready. The pixels of the textures and skyboxes
+    * are streamed to the GPU over the following frames by the @ref graphics::TextureUploader.
+    * Shaders are always compiled synchronously.
+    *
+    * Imported models are baked into the @ref BakedModel format under "resources/.cache/models". On the following runs
+    * the baked file is memory-mapped and uploaded directly, without running Assimp, as long as the source model file
+    * and its @ref ImportSettings didn't change. Set `resources.model_cache` to false to always import with Assimp.
+    *
+    * Textures are uploaded block-compressed when they can be, see @ref ResourcesController::texture and
+    * `resources.texture_compression`. Decoded and transcoded textures are baked with their mip chains into
+    * the @ref BakedTexture format under "resources/.cache/textures", and later runs upload them straight from
+    * the mapped file. Set `resources.texture_cache` to false to always decode the source images.
+    *
+    * The models with `pack_textures` set decode their textures together with the meshes, and the materials whose
+    * textures are all small enough take a layer of a @ref TexturePack instead of textures of their own,
+    * see `resources.texture_packing`.
+    * @code
+    * "resources": {
+    *   "async_loading": true,
+    *   "model_cache": true,
+    *   "texture_cache": true,
+    *   "texture_compression": { "enabled": true, "bc7": false },
+    *   "texture_packing": { "max_size": 512, "layers": 16 },
+    *   "models": { "crate": { "path": "crate/crate.obj", "pack_textures": true }, ... }
+    * }
+    * @endcode
     */
     class ResourcesController final : public core::Controller {
     public:
@@ -36,6 +78,18 @@ namespace engine::resources {
         *
         * Other params, except name, are optional. If not provided the function will search for a texture
         * in the: "resources/textures".
+        *
+        * The texture is uploaded block-compressed, with its mip chain, from the first of:
+        * 1. The `path` itself, if it's a ".dds" or ".ktx2" file.
+        * 2. A ".ktx2" or ".dds" file next to the `path` with the same name, e.g. written by an offline encoder.
+        * 3. The @ref BakedTexture the image was baked to on an earlier run, in "resources/.cache/textures",
+        * unless the source, the flip or the compression settings changed since.
+        * 4. The image transcoded now by @ref TextureCompressor, unless `resources.texture_compression.enabled` is false.
+        *
+        * Otherwise, or if the context doesn't support the format, the decoded pixels are uploaded with their mip chain.
+        * Unless `resources.texture_cache` is false, the result of 4. or the decoded pixels are baked for the next run.
+        * Normal maps are compressed to BC5, which stores only the x and y of the normals; shaders sampling them
+        * reconstruct z as `sqrt(1 - dot(xy, xy))`.
         * @param name of the texture without the extension.
         * @param path form which to load the texture.
         * @param texture_type
@@ -62,6 +116,20 @@ namespace engine::resources {
                        const std::filesystem::path &path = ""
                      , bool flip_uvs                     = false);
 
+        /**
+        * @brief Retrieves the @ref Material with a given name. You are not supposed to call `delete` on this pointer.
+        *
+        * The material is created from the `textures` and the `constants` on the first call with the `name`;
+        * later calls return it as it is. The materials of a model are named `<model name>/<material index>`.
+        * Requires the OpenGL context.
+        * @param name of the material.
+        * @param textures of the material, bound to the samplers named by @ref Material::sampler_uniform_names.
+        * @param constants of the material, see @ref graphics::MaterialBlock.
+        * @returns The pointer to the @ref Material associated with the `name`.
+        */
+        Material *material(const std::string &name, std::vector<Texture *> textures = {},
+                           const graphics::MaterialBlock &constants = {});
+
         /**
         * @brief Retrieves the @ref Shader with a given name. You are not supposed to call `delete` on this pointer.
         * @param path to the shader.glsl file that contains shader source code.
@@ -69,12 +137,171 @@ namespace engine::resources {
         */
         Shader *shader(const std::string &name, const std::filesystem::path &path = "");
 
+        /**
+        * @brief Returns whether the resources are loaded asynchronously, see `resources.async_loading` in the config.json.
+        */
+        bool async_loading() const {
+            return m_async_loading;
+        }
+
+        /**
+        * @brief Returns the number of resources that are still being loaded asynchronously,
+        * including the textures whose upload through the @ref graphics::TextureUploader didn't finish yet.
+        * The finer levels the @ref graphics::TextureStreamer uploads later, as the textures are drawn, don't count.
+        */
+        std::size_t pending_count() const;
+
+        /**
+        * @brief Blocks until all the resources requested so far are loaded and ready for drawing.
+        * The textures still queued for upload are uploaded at once, ignoring the frame budget.
+        * Does nothing when the resources are loaded synchronously.
+        */
+        void finish_loading();
+
+        /**
+        * @brief Returns how long it took to load the resources from the config.json, in milliseconds,
+        * from @ref ResourcesController::initialize until the last of them was ready for drawing.
+        * Negative while they're still loading asynchronously.
+        */
+        double load_time_ms() const {
+            return m_load_time_ms;
+        }
+
+        /**
+        * @brief Imports a model file with Assimp into CPU-side mesh data. Doesn't touch the OpenGL context,
+        * so it's safe to call from any thread.
+        * @param model_path path to the model file.
+        * @param settings The Assimp flags, and how the meshes are optimized and compressed.
+        * @returns The meshes of the model with the texture files they reference.
+        */
+        static std::vector<MeshData> import_model(const std::filesystem::path &model_path,
+                                                  const ImportSettings &settings);
+
     private:
         /**
         * @brief Loads all the resources from the "resources/" directory.
         */
         void initialize() override;
 
+        /**
+        * @brief Creates the OpenGL objects for the resources that finished decoding on the worker threads.
+        */
+        void poll_events() override;
+
+        /**
+        * @brief Drops the resources that finished decoding but weren't created yet.
+        */
+        void terminate() override;
+
+        /**
+        * @brief Decoded pixels, the compressed blocks or the baked mip chain of a texture, ready for
+        * @ref graphics::OpenGL::generate_texture.
+        */
+        using DecodedTexture = std::variant<Image, CompressedImage, BakedTexture>;
+
+        /**
+        * @brief A model with the textures of its meshes, decoded together when the model packs its textures.
+        */
+        struct DecodedModel {
+            BakedModel model;
+            /**
+            * @brief The decoded textures by their path; empty unless the model packs its textures.
+            */
+            std::unordered_map<std::string, DecodedTexture> textures;
+        };
+
+        /**
+        * @brief Creates the meshes of the `model` in the OpenGL context and resolves their materials and textures. Called on the main thread.
+        * @param textures The decoded textures of the model if it packs them, see @ref ResourcesController::pack_material,
+        * or nullptr to load the textures one by one with @ref ResourcesController::texture. The model packs all its
+        * materials, or none if one of them can't be packed, which is logged.
+        */
+        void create_meshes(Model *model, const BakedModel &baked_model,
+                           std::unordered_map<std::string, DecodedTexture> *textures = nullptr);
+
+        /**
+        * @brief Returns why the material with the textures of the `references` can't be packed, like "has no textures",
+        * or an empty string if it can: all its textures are decoded in the `textures`, fit the packing and have a mip chain.
+        */
+        std::string unpackable_reason(std::span<const TextureReference> references,
+                                      const std::unordered_map<std::string, DecodedTexture> &textures) const;
+
+        /**
+        * @brief Creates the material `name` in a layer of a @ref TexturePack with the same texture types and classes,
+        * creating the pack if there's none with a free layer.
+        * @param references The textures of the material, decoded in the `textures`.
+        * @returns The material, or nullptr if it can't be packed, see @ref ResourcesController::unpackable_reason.
+        */
+        Material *pack_material(const std::string &name, std::span<const TextureReference> references,
+                                const std::unordered_map<std::string, DecodedTexture> &textures,
+                                const graphics::MaterialBlock &constants);
+
+        /**
+        * @brief Returns the texture of the `reference` for a model whose textures are decoded but not packed:
+        * the existing texture, or a new one created from the decoded texture in the `textures`, which is moved out.
+        * Loads it with @ref ResourcesController::texture if it isn't decoded.
+        */
+        Texture *model_texture(const TextureReference &reference,
+                               std::unordered_map<std::string, DecodedTexture> &textures);
+
+        /**
+        * @brief Maps the baked model from the `cache_directory` if it's up to date, otherwise imports the model with Assimp
+        * and bakes it. Doesn't touch the OpenGL context, so it's safe to call from any thread.
+        * @param model_path path to the model file.
+        * @param settings The Assimp flags, and how the meshes are optimized and compressed.
+        * @param cache_directory directory of the baked models, or empty to skip the cache.
+        */
+        static BakedModel load_baked_model(const std::filesystem::path &model_path, const ImportSettings &settings,
+                                           const std::filesystem::path &cache_directory);
+
+        /**
+        * @brief Reads the compressed variant of the texture at `path` if there is one, otherwise decodes the image and
+        * bakes it into the `cache_directory`. See @ref ResourcesController::texture for the order.
+        * Doesn't touch the OpenGL context, so it's safe to call from any thread.
+        * @param path path to the texture file.
+        * @param type The type of the texture, which decides its block format.
+        * @param flip_uvs flip the rows on load.
+        * @param settings How the texture is transcoded.
+        * @param block_formats The formats the context supports, see @ref graphics::OpenGL::supported_block_formats.
+        * @param cache_directory directory of the baked textures, or empty to skip the cache.
+        */
+        static DecodedTexture decode_texture(const std::filesystem::path &path, TextureType type, bool flip_uvs,
+                                             const TextureCompression &settings, uint32_t block_formats,
+                                             const std::filesystem::path &cache_directory);
+
+        /**
+        * @brief Decodes the textures of the meshes of the `baked_model`, see @ref ResourcesController::decode_texture.
+        * The pixels of the images that fit the `packing` are baked into a mip chain in memory, so they can be packed.
+        * Doesn't touch the OpenGL context, so it's safe to call from any thread.
+        */
+        static std::unordered_map<std::string, DecodedTexture> decode_model_textures(
+                const BakedModel &baked_model, const TexturePacking &packing, const TextureCompression &settings,
+                uint32_t block_formats, const std::filesystem::path &cache_directory);
+
+        /**
+        * @brief Returns the class and the mip chain of the `decoded` texture, or std::nullopt if it has no mip chain
+        * on the CPU to pack.
+        */
+        static std::optional<std::pair<TextureClass, std::vector<BakedTexture::Level> > > packable_texture(
+                const DecodedTexture &decoded);
+
+        /**
+        * @brief Queues the `decoded` texture in the @ref graphics::TextureUploader, through the
+        * @ref graphics::TextureStreamer when it has a mip chain on the CPU, and sets the id of the `texture` once it's ready.
+        */
+        static void upload_texture(Texture *texture, DecodedTexture decoded);
+
+        /**
+        * @brief Runs `decode` in a @ref util::JobSystem job, and then `create` with its result on the main thread.
+        */
+        template<typename TDecoded>
+        void load_async(std::function<TDecoded()> decode, std::function<void(TDecoded)> create);
+
+        /**
+        * @brief Runs the tasks the worker threads queued for the main thread.
+        */
+        void run_main_thread_tasks();
+
         /**
         * @brief Loads all the models from the "resources/models" directory based on the provided configuration. Called during @ref ResourcesController::initialize.
         */
@@ -104,6 +331,10 @@ namespace engine::resources {
         */
         std::unordered_map<std::string, std::unique_ptr<Texture> > m_textures;
         /**
+        * @brief A hashmap of all the created @ref Material.
+        */
+        std::unordered_map<std::string, std::unique_ptr<Material> > m_materials;
+        /**
         * @brief A hashmap of all the loaded @ref Skybox.
         */
         std::unordered_map<std::string, std::unique_ptr<Skybox> > m_sky_boxes;
@@ -112,10 +343,68 @@ namespace engine::resources {
         */
         std::unordered_map<std::string, std::unique_ptr<Shader> > m_shaders;
 
+        /**
+        * @brief Whether resources are decoded in the background, see `resources.async_loading` in the config.json.
+        */
+        bool m_async_loading{false};
+
+        /**
+        * @brief Tasks queued by the worker threads that have to run on the main thread, which owns the OpenGL context.
+        */
+        std::vector<std::function<void()> > m_main_thread_tasks;
+        std::mutex m_main_thread_tasks_mutex;
+        std::condition_variable m_main_thread_task_queued;
+        std::size_t m_pending_count{0};
+
+        std::chrono::steady_clock::time_point m_load_begin;
+        double m_load_time_ms{-1.0};
+
+        /**
+        * @brief Records @ref ResourcesController::load_time_ms once nothing is pending anymore.
+        */
+        void record_load_time();
+
         const std::filesystem::path m_models_path   = "resources/models";
         const std::filesystem::path m_textures_path = "resources/textures";
         const std::filesystem::path m_shaders_path  = "resources/shaders";
         const std::filesystem::path m_skyboxes_path = "resources/skyboxes";
+        const std::filesystem::path m_cache_path    = "resources/.cache";
+
+        /**
+        * @brief Whether imported models are baked and loaded from the cache, see `resources.model_cache` in the config.json.
+        */
+        bool m_model_cache{true};
+
+        /**
+        * @brief Whether decoded textures are baked and loaded from the cache, see `resources.texture_cache` in the config.json.
+        */
+        bool m_texture_cache{true};
+
+        /**
+        * @brief The settings all the models are imported with, see `resources.vertex_compression` and
+        * `resources.mesh_optimization` in the config.json. The models add their own flags, like `flip_uvs`.
+        */
+        ImportSettings m_import_settings;
+
+        /**
+        * @brief How the textures are transcoded, see `resources.texture_compression` in the config.json.
+        */
+        TextureCompression m_texture_compression;
+
+        /**
+        * @brief Which textures the models with `pack_textures` pack, see `resources.texture_packing` in the config.json.
+        */
+        TexturePacking m_texture_packing;
+
+        /**
+        * @brief The packs of the packed materials; a pack is shared by the models.
+        */
+        std::vector<std::unique_ptr<TexturePack> > m_texture_packs;
+
+        /**
+        * @brief The block formats the OpenGL context supports, queried on the main thread for the decoding jobs.
+        */
+        uint32_t m_block_formats{0};
     };
 } // namespace engine
 
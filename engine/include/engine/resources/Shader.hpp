@@ -5,8 +5,15 @@
 
 #ifndef MATF_RG_PROJECT_SHADER_HPP
 #define MATF_RG_PROJECT_SHADER_HPP
+#include <engine/graphics/UniformBlocks.hpp>
 #include <engine/util/Utils.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include <glm/glm.hpp>
 
 namespace engine::resources {
@@ -25,6 +32,44 @@ namespace engine::resources {
     */
     std::string_view to_string(ShaderType type);
 
+    /**
+    * @brief Maps active uniform names of a linked shader program to their locations.
+    * Supports lookup by `std::string_view` without allocating, see @ref util::ds::StringHash.
+    */
+    using UniformLocations = std::unordered_map<std::string, int32_t, util::ds::StringHash, std::equal_to<> >;
+
+    /**
+    * @brief Maps sampler uniform names of a linked shader program to the texture units assigned to them at link time.
+    */
+    using SamplerUnits = std::unordered_map<std::string, int32_t, util::ds::StringHash, std::equal_to<> >;
+
+    class Material;
+
+    /**
+    * @struct UniformHandle
+    * @brief A resolved uniform location. Resolve it once with @ref Shader::uniform and reuse it on every draw;
+    * setting a uniform through a handle does no string hashing and no OpenGL queries.
+    * @code
+    * // initialize
+    * m_model_uniform = shader->uniform("model");
+    * // draw
+    * shader->set_mat4(m_model_uniform, model_matrix);
+    * @endcode
+    */
+    struct UniformHandle {
+        /**
+        * @brief The uniform location in the shader program; -1 if the uniform isn't active in the program.
+        */
+        int32_t location{-1};
+
+        /**
+        * @returns true if the uniform is active in the shader program.
+        */
+        bool valid() const {
+            return location != -1;
+        }
+    };
+
     /**
     * @class Shader
     * @brief Represents a linked shader program object within the OpenGL context.
@@ -44,6 +89,45 @@ namespace engine::resources {
         */
         unsigned id() const;
 
+        /**
+        * @brief Resolves the location of a uniform. Active uniforms are reflected once when the program is linked,
+        * so this is a hash lookup and not an OpenGL query.
+        * @param name The name of the uniform.
+        * @returns The @ref UniformHandle for the uniform; invalid if the uniform isn't active in the program.
+        */
+        UniformHandle uniform(std::string_view name) const;
+
+        /**
+        * @brief Returns all the active uniforms of the shader program reflected at link time.
+        * @returns The active uniform names mapped to their locations.
+        */
+        const UniformLocations &uniforms() const {
+            return m_uniforms;
+        }
+
+        /**
+        * @brief Returns the texture unit assigned to a sampler uniform when the program was linked,
+        * see @ref graphics::OpenGL::assign_sampler_units. Bind the texture the sampler reads to that unit.
+        * @param name The name of the sampler uniform.
+        * @returns The texture unit, or -1 if the sampler isn't active in the program.
+        */
+        int32_t sampler_unit(std::string_view name) const;
+
+        /**
+        * @brief Returns the texture unit of each texture of the `material`, in the order of @ref Material::texture_types,
+        * or -1 for the textures the shader doesn't sample. The table is built on the first call for a
+        * @ref Material::sampler_layout and then reused for all the materials with the same layout; the lookup allocates nothing.
+        */
+        std::span<const int8_t> texture_units(const Material &material) const;
+
+        /**
+        * @brief Returns whether the shader program declares the uniform block of the `binding`,
+        * see @ref graphics::UniformBinding.
+        */
+        bool uses_uniform_block(graphics::UniformBinding binding) const {
+            return (m_uniform_blocks & (1u << static_cast<uint32_t>(binding))) != 0;
+        }
+
         /**
         * @brief Sets a boolean uniform value.
         * @param name The name of the uniform.
@@ -51,6 +135,13 @@ namespace engine::resources {
         */
         void set_bool(const std::string &name, bool value) const;
 
+        /**
+        * @brief Sets a boolean uniform value through a resolved @ref UniformHandle.
+        * @param uniform The handle returned by @ref Shader::uniform.
+        * @param value The value to set.
+        */
+        void set_bool(UniformHandle uniform, bool value) const;
+
         /**
         * @brief Sets an integer uniform value.
         * @param name The name of the uniform.
@@ -58,6 +149,13 @@ namespace engine::resources {
         */
         void set_int(const std::string &name, int value) const;
 
+        /**
+        * @brief Sets a integer uniform value through a resolved @ref UniformHandle.
+        * @param uniform The handle returned by @ref Shader::uniform.
+        * @param value The value to set.
+        */
+        void set_int(UniformHandle uniform, int value) const;
+
         /**
         * @brief Sets a float uniform value.
         * @param name The name of the uniform.
@@ -65,6 +163,13 @@ namespace engine::resources {
         */
         void set_float(const std::string &name, float value) const;
 
+        /**
+        * @brief Sets a float uniform value through a resolved @ref UniformHandle.
+        * @param uniform The handle returned by @ref Shader::uniform.
+        * @param value The value to set.
+        */
+        void set_float(UniformHandle uniform, float value) const;
+
         /**
         * @brief Sets a 2D vector uniform value.
         * @param name The name of the uniform.
@@ -72,6 +177,13 @@ namespace engine::resources {
         */
         void set_vec2(const std::string &name, const glm::vec2 &value) const;
 
+        /**
+        * @brief Sets a 2D vector uniform value through a resolved @ref UniformHandle.
+        * @param uniform The handle returned by @ref Shader::uniform.
+        * @param value The value to set.
+        */
+        void set_vec2(UniformHandle uniform, const glm::vec2 &value) const;
+
         /**
         * @brief Sets a 3D vector uniform value.
         * @param name The name of the uniform.
@@ -79,6 +191,13 @@ namespace engine::resources {
         */
         void set_vec3(const std::string &name, const glm::vec3 &value) const;
 
+        /**
+        * @brief Sets a 3D vector uniform value through a resolved @ref UniformHandle.
+        * @param uniform The handle returned by @ref Shader::uniform.
+        * @param value The value to set.
+        */
+        void set_vec3(UniformHandle uniform, const glm::vec3 &value) const;
+
         /**
         * @brief Sets a 4D vector uniform value.
         * @param name The name of the uniform.
@@ -86,6 +205,13 @@ namespace engine::resources {
         */
         void set_vec4(const std::string &name, const glm::vec4 &value) const;
 
+        /**
+        * @brief Sets a 4D vector uniform value through a resolved @ref UniformHandle.
+        * @param uniform The handle returned by @ref Shader::uniform.
+        * @param value The value to set.
+        */
+        void set_vec4(UniformHandle uniform, const glm::vec4 &value) const;
+
         /**
         * @brief Sets a 2x2 matrix uniform value.
         * @param name The name of the uniform.
@@ -93,6 +219,13 @@ namespace engine::resources {
         */
         void set_mat2(const std::string &name, const glm::mat2 &mat) const;
 
+        /**
+        * @brief Sets a 2x2 matrix uniform value through a resolved @ref UniformHandle.
+        * @param uniform The handle returned by @ref Shader::uniform.
+        * @param mat The value to set.
+        */
+        void set_mat2(UniformHandle uniform, const glm::mat2 &mat) const;
+
         /**
         * @brief Sets a 3x3 matrix uniform value.
         * @param name The name of the uniform.
@@ -100,6 +233,13 @@ namespace engine::resources {
         */
         void set_mat3(const std::string &name, const glm::mat3 &mat) const;
 
+        /**
+        * @brief Sets a 3x3 matrix uniform value through a resolved @ref UniformHandle.
+        * @param uniform The handle returned by @ref Shader::uniform.
+        * @param mat The value to set.
+        */
+        void set_mat3(UniformHandle uniform, const glm::mat3 &mat) const;
+
         /**
         * @brief Sets a 4x4 matrix uniform value.
         * @param name The name of the uniform.
@@ -107,6 +247,13 @@ namespace engine::resources {
         */
         void set_mat4(const std::string &name, const glm::mat4 &mat) const;
 
+        /**
+        * @brief Sets a 4x4 matrix uniform value through a resolved @ref UniformHandle.
+        * @param uniform The handle returned by @ref Shader::uniform.
+        * @param mat The value to set.
+        */
+        void set_mat4(UniformHandle uniform, const glm::mat4 &mat) const;
+
         /**
         * @brief Returns the name of the shader program by which it can be referenced using the @ref engine::resources::ResourcesController::shader function.
         * @returns The name of the shader.
@@ -132,9 +279,13 @@ namespace engine::resources {
         * @param name The name of the shader program.
         * @param source The source code of the shader program.
         * @param source_path The path to the source file from which the shader program was compiled.
+        * @param uniforms The active uniforms of the shader program reflected at link time.
+        * @param sampler_units The texture units assigned to the sampler uniforms at link time.
+        * @param uniform_blocks The mask of the engine uniform blocks the program declares, see @ref graphics::OpenGL::bind_uniform_blocks.
         */
         Shader(unsigned shader_id, std::string name, std::string source,
-               std::filesystem::path source_path = "");
+               std::filesystem::path source_path = "", UniformLocations uniforms = {}, SamplerUnits sampler_units = {},
+               uint32_t uniform_blocks = 0);
 
         /**
         * @brief Destroys the shader program in the OpenGL context.
@@ -152,6 +303,25 @@ namespace engine::resources {
         std::string m_name;
         std::string m_source;
         std::filesystem::path m_source_path;
+
+        /**
+        * @brief Uniform locations reflected at link time. Every element of a uniform array is listed, so a name
+        * missing from the table isn't active in the program.
+        */
+        UniformLocations m_uniforms;
+        SamplerUnits m_sampler_units;
+        uint32_t m_uniform_blocks{0};
+
+        /**
+        * @brief The texture units for the materials with the given @ref Material::sampler_layout, see @ref Shader::texture_units.
+        * A shader sees a handful of layouts, so a linear search beats hashing.
+        */
+        struct TextureBindings {
+            uint64_t sampler_layout;
+            std::vector<int8_t> units;
+        };
+
+        mutable std::vector<TextureBindings> m_texture_bindings;
     };
 } // namespace engine
 
@@ -72,6 +72,7 @@ namespace engine::resources {
 	private:
 		/**
 		* @brief Compile shader sources into a OpenGL shader program.
+		* After linking, the active uniforms are reflected into @ref ShaderCompiler::m_uniforms.
 		* @returns A @ref graphics::OpenGL::ShaderProgramId referencing OpenGL shader program.
 		*/
 		graphics::OpenGL::ShaderProgramId compile(const ShaderParsingResult &shader_sources);
@@ -98,6 +99,21 @@ namespace engine::resources {
 
 		std::string m_shader_name;
 		std::string m_sources;
+
+		/**
+		* @brief Active uniforms of the last program linked by @ref ShaderCompiler::compile.
+		*/
+		UniformLocations m_uniforms;
+
+		/**
+		* @brief Texture units assigned to the samplers of the last program linked by @ref ShaderCompiler::compile.
+		*/
+		SamplerUnits m_sampler_units;
+
+		/**
+		* @brief Mask of the engine uniform blocks the last program linked by @ref ShaderCompiler::compile declares.
+		*/
+		uint32_t m_uniform_blocks{0};
 	};
 }
 #endif //SHADER_COMPILER_HPP
@@ -34,6 +34,15 @@ namespace engine::resources {
             return m_texture_id;
         }
 
+        /**
+        * @brief Returns whether the skybox cubemap is uploaded to the OpenGL context.
+        * With asynchronous loading enabled the @ref ResourcesController returns the skybox before its faces are decoded.
+        * @returns true if the skybox texture is created in the OpenGL context.
+        */
+        bool is_ready() const {
+            return m_texture_id != 0;
+        }
+
         /**
         * @brief Destroys the skybox object in the OpenGL context.
         */
@@ -68,6 +68,15 @@ namespace engine::resources {
             return m_id;
         }
 
+        /**
+        * @brief Returns whether the texture is uploaded to the OpenGL context. With asynchronous loading enabled
+        * the @ref ResourcesController returns the texture before it's decoded; until then its id is 0.
+        * @returns true if the texture is created in the OpenGL context.
+        */
+        bool is_ready() const {
+            return m_id != 0;
+        }
+
         /**
         * @brief Binds the texture to a given sampler.
         * @param sampler The sampler to bind the texture to.
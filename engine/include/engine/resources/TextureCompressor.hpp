@@ -0,0 +1,81 @@
+/**
+ * @file TextureCompressor.hpp
+ * @brief Defines the TextureCompressor class that transcodes decoded images into block-compressed mip chains.
+ */
+
+#ifndef MATF_RG_PROJECT_TEXTURE_COMPRESSOR_HPP
+#define MATF_RG_PROJECT_TEXTURE_COMPRESSOR_HPP
+
+#include <engine/resources/CompressedImage.hpp>
+#include <engine/resources/Image.hpp>
+#include <engine/resources/Texture.hpp>
+#include <cstdint>
+#include <optional>
+
+namespace engine::resources {
+    /**
+    * @struct TextureCompression
+    * @brief The settings of the texture transcoding, from `resources.texture_compression` in the config.json.
+    */
+    struct TextureCompression {
+        /**
+        * @brief Transcode the textures without a pre-compressed variant on their first load. Off, they're uploaded
+        * uncompressed. The pre-compressed variants are used either way.
+        */
+        bool enabled{true};
+        /**
+        * @brief Transcode the color textures to BC7 instead of BC1 and BC3, when the OpenGL context supports it.
+        * Better quality, but twice the size of BC1 for the opaque textures.
+        */
+        bool bc7{false};
+    };
+
+    /**
+    * @class TextureCompressor
+    * @brief Builds the mip chain of a decoded @ref Image and encodes every level into GPU blocks, see @ref BlockFormat.
+    *
+    * The encoders fit each 4x4 block to the principal axis of its colors:
+    * - BC1 takes the endpoints from the extent of the colors along the axis and refines them by least squares.
+    * - BC4, and the alpha of BC3 and the channels of BC5, use the range of the channel with 8 interpolated values.
+    * - BC7 writes every block in mode 6, a single RGBA line with 16 interpolated values.
+    *
+    * That's faster and a bit worse than the offline encoders with partitions, which can write the DDS or KTX2 files
+    * the @ref ResourcesController prefers over the transcoded ones.
+    */
+    class TextureCompressor {
+    public:
+        /**
+        * @brief The version of the encoders. Changing it transcodes the cached textures again.
+        */
+        static constexpr uint32_t VERSION = 1;
+
+        /**
+        * @brief Chooses the block format of the `image` for its texture `type`: BC5 for normal maps, BC4 for one channel,
+        * and BC1, BC3 or BC7 for colors, depending on the alpha and the `settings`.
+        * @param supported_formats A mask with the bit `1 << BlockFormat` set for every format the OpenGL context supports,
+        * see @ref graphics::OpenGL::supported_block_formats.
+        * @returns The format, or std::nullopt if none of the suitable formats is supported.
+        */
+        static std::optional<BlockFormat> choose_format(const Image &image, TextureType type,
+                                                        uint32_t supported_formats,
+                                                        const TextureCompression &settings);
+
+        /**
+        * @brief Builds the full mip chain of the `image`, down to 1x1, with a box filter, and encodes every level.
+        * @param image The decoded image, with 1 to 4 channels.
+        * @param format The block format to encode to.
+        * @param normal_map Renormalize the averaged normals of the mip levels, and store their x and y in BC5.
+        * @returns The compressed mip chain. Doesn't touch the OpenGL context, so it's safe to call from any thread.
+        */
+        static CompressedImage compress(const Image &image, BlockFormat format, bool normal_map);
+
+        /**
+        * @brief Identifies everything besides the source image that decides what loading a texture produces,
+        * for the key of the baked textures, see @ref BakedTextureKey. Includes the @ref TextureCompressor::VERSION.
+        */
+        static uint64_t settings_key(TextureType type, bool flip_vertically, uint32_t supported_formats,
+                                     const TextureCompression &settings);
+    };
+} // namespace engine::resources
+
+#endif//MATF_RG_PROJECT_TEXTURE_COMPRESSOR_HPP
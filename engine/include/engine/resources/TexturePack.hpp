@@ -0,0 +1,140 @@
+/**
+ * @file TexturePack.hpp
+ * @brief Defines the TexturePack class that packs the textures of many materials into the layers of array textures.
+ */
+
+#ifndef MATF_RG_PROJECT_TEXTURE_PACK_HPP
+#define MATF_RG_PROJECT_TEXTURE_PACK_HPP
+
+#include <engine/resources/BakedTexture.hpp>
+#include <engine/resources/Texture.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine::resources {
+    /**
+    * @struct TextureClass
+    * @brief The size and the format of a texture. Only textures of the same class fit the layers of one array texture.
+    */
+    struct TextureClass {
+        int32_t width{0};
+        int32_t height{0};
+        uint32_t level_count{0};
+        /**
+        * @brief The OpenGL compressed format of the blocks, or 0 for 8-bit pixels.
+        */
+        uint32_t compressed_format{0};
+        /**
+        * @brief Number of 8-bit channels of the pixels, 0 for compressed blocks.
+        */
+        int32_t channels{0};
+
+        bool operator==(const TextureClass &other) const = default;
+    };
+
+    /**
+    * @struct TexturePacking
+    * @brief Which textures are packed and into how large packs, see `resources.texture_packing` in the config.json.
+    */
+    struct TexturePacking {
+        /**
+        * @brief Textures larger than this, in pixels along the longer side, keep a texture of their own.
+        */
+        int32_t max_size{512};
+        /**
+        * @brief The number of layers a pack is allocated with.
+        */
+        uint32_t layers{16};
+    };
+
+    /**
+    * @class TexturePack
+    * @brief The textures of the materials with the same texture types and classes, packed into `GL_TEXTURE_2D_ARRAY`s.
+    *
+    * The pack has an array texture for every texture of its materials, in the order of @ref Material::texture_types,
+    * and every packed material takes one layer of all of them: its diffuse texture is at the same layer of the first
+    * array as its specular texture of the second one. A packed @ref Material binds the arrays instead of its own
+    * textures, and its layer is all that's left to tell it apart from the other materials of the pack, so the
+    * @ref graphics::RenderQueue can draw meshes with different packed materials in one batch.
+    *
+    * The arrays are allocated for all the layers up front, since OpenGL 3.3 can't grow them without copying every
+    * layer back; a full pack is followed by a new one of the same classes. The layers are uploaded with all their levels
+    * when the material is packed. Packs are created by the @ref ResourcesController for the models with
+    * `pack_textures` set in the config.json, and destroyed when it terminates.
+    */
+    class TexturePack {
+        friend class ResourcesController;
+
+    public:
+        /**
+        * @brief Returns the type of the texture in each array, in the order of @ref TexturePack::textures.
+        */
+        const std::vector<TextureType> &types() const {
+            return m_types;
+        }
+
+        /**
+        * @brief Returns the class of the layers of each array, in the order of @ref TexturePack::textures.
+        */
+        const std::vector<TextureClass> &classes() const {
+            return m_classes;
+        }
+
+        /**
+        * @brief Returns the OpenGL ids of the array textures.
+        */
+        const std::vector<uint32_t> &textures() const {
+            return m_textures;
+        }
+
+        uint32_t layer_count() const {
+            return m_layer_count;
+        }
+
+        uint32_t capacity() const {
+            return m_capacity;
+        }
+
+        bool full() const {
+            return m_layer_count == m_capacity;
+        }
+
+        /**
+        * @brief Returns the VRAM taken by the arrays, with the layers that are still free, in bytes.
+        */
+        std::size_t size_bytes() const;
+
+        /**
+        * @brief Destroys the array textures in the OpenGL context.
+        */
+        void destroy();
+
+    private:
+        /**
+        * @brief Allocates the array textures for `capacity` layers, with levels of the size of those of the `textures`,
+        * which are then added with @ref TexturePack::add. Requires the OpenGL context.
+        */
+        TexturePack(std::vector<TextureType> types, std::vector<TextureClass> classes,
+                    const std::vector<std::vector<BakedTexture::Level> > &textures, uint32_t capacity);
+
+        /**
+        * @brief Uploads the `textures` of a material, one mip chain per array, into the next free layer.
+        * Their levels have to match the @ref TexturePack::classes.
+        * @returns The layer of the material.
+        */
+        uint32_t add(const std::vector<std::vector<BakedTexture::Level> > &textures);
+
+        std::vector<TextureType> m_types;
+        std::vector<TextureClass> m_classes;
+        std::vector<uint32_t> m_textures;
+        /**
+        * @brief The size of a layer of each level of each array, in bytes.
+        */
+        std::vector<std::vector<std::size_t> > m_level_sizes;
+        uint32_t m_layer_count{0};
+        uint32_t m_capacity{0};
+    };
+} // namespace engine::resources
+
+#endif//MATF_RG_PROJECT_TEXTURE_PACK_HPP
@@ -50,6 +50,13 @@ namespace engine::util {
             }
         }
 
+        /**
+        * @brief Checks if a flag without a value, like `--headless`, was passed.
+        * @param name The name of the flag.
+        * @returns True if the flag is present.
+        */
+        bool flag(std::string_view name) const;
+
         /**
         * @brief Initialize the ArgParser with the command line arguments.
         * @param argc The number of command line arguments.
@@ -0,0 +1,242 @@
+/**
+ * @file JobSystem.hpp
+ * @brief Defines the JobSystem class, the engine-wide work-stealing job scheduler, and the JobCounter used to wait for jobs.
+ */
+
+#ifndef MATF_RG_PROJECT_JOB_SYSTEM_HPP
+#define MATF_RG_PROJECT_JOB_SYSTEM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace engine::util {
+    class JobSystem;
+
+    /**
+    * @class JobCounter
+    * @brief Counts the unfinished jobs started with it. Waiting on a counter waits for all of them.
+    *
+    * A job can start child jobs with the same counter, so the counter reaches zero only after the parent and all
+    * of its children finished. Jobs that depend on the counter are started with @ref JobSystem::run_after.
+    * The first exception thrown by a job of the counter is stored and rethrown by @ref JobSystem::wait.
+    */
+    class JobCounter {
+        friend class JobSystem;
+
+    public:
+        JobCounter() = default;
+
+        JobCounter(const JobCounter &) = delete;
+
+        JobCounter &operator=(const JobCounter &) = delete;
+
+        /**
+        * @returns true if all the jobs started with the counter finished.
+        */
+        bool done() const {
+            return m_pending.load(std::memory_order_acquire) == 0;
+        }
+
+    private:
+        std::atomic<uint32_t> m_pending{0};
+        std::mutex m_mutex;
+        /**
+        * @brief Jobs started with @ref JobSystem::run_after, submitted when the counter reaches zero.
+        */
+        std::vector<std::function<void()> > m_continuations;
+        std::exception_ptr m_exception;
+    };
+
+    /**
+    * @class JobSystem
+    * @brief Runs short jobs on a fixed set of worker threads with work stealing.
+    *
+    * Every worker, and the main thread, owns a deque of jobs. A thread pushes the jobs it starts to its own deque
+    * and takes them back from the same end (LIFO, so the data it just touched is still in cache). A thread
+    * with an empty deque steals the oldest job from the deque of another thread. Threads waiting on a @ref JobCounter
+    * run jobs instead of blocking.
+    *
+    * The @ref core::App starts the job system in `engine_setup` and shuts it down in `terminate`. The number
+    * of worker threads is configured in the config.json, and defaults to the number of cores minus one:
+    * @code
+    * "jobs": {
+    *   "workers": 7
+    * }
+    * @endcode
+    * Before @ref JobSystem::initialize and after @ref JobSystem::shutdown, jobs run immediately on the calling thread.
+    */
+    class JobSystem {
+    public:
+        using Job = std::function<void()>;
+
+        /**
+        * @brief Get the instance of the @ref JobSystem class.
+        */
+        static JobSystem *instance();
+
+        /**
+        * @brief Starts the worker threads.
+        * @param worker_count Number of worker threads, at least one is always started.
+        */
+        void initialize(uint32_t worker_count);
+
+        /**
+        * @brief Stops the worker threads after they finish their current jobs. Jobs that didn't start are dropped.
+        */
+        void shutdown();
+
+        /**
+        * @returns true between @ref JobSystem::initialize and @ref JobSystem::shutdown.
+        */
+        bool is_running() const {
+            return m_running.load(std::memory_order_acquire);
+        }
+
+        /**
+        * @returns The number of worker threads, not counting the main thread.
+        */
+        uint32_t worker_count() const {
+            return static_cast<uint32_t>(m_workers.size());
+        }
+
+        /**
+        * @brief Starts a job.
+        * @param job The job to run.
+        * @param counter Incremented now and decremented when the job finishes, or nullptr for fire-and-forget jobs.
+        */
+        void run(Job job, JobCounter *counter = nullptr);
+
+        /**
+        * @brief Starts a job after all the jobs of the `dependency` finished.
+        * @param dependency The counter the job depends on. It must stay alive until the job starts.
+        * @param job The job to run.
+        * @param counter Incremented now and decremented when the job finishes, or nullptr.
+        */
+        void run_after(JobCounter &dependency, Job job, JobCounter *counter = nullptr);
+
+        /**
+        * @brief Runs other jobs on the calling thread until all the jobs of the `counter` finished.
+        * Rethrows the first exception thrown by a job of the counter.
+        */
+        void wait(JobCounter &counter);
+
+        /**
+        * @brief Calls `body(i)` for every `i` in [`begin`, `end`), split in chunks across the workers and the calling thread.
+        * Returns after all the calls finished.
+        * @param begin First index.
+        * @param end One past the last index.
+        * @param body The loop body, called concurrently from several threads.
+        * @param grain Minimum number of indices per job, 0 picks a chunk size from the range size and the worker count.
+        */
+        template<typename Index, typename Body>
+        void parallel_for(Index begin, Index end, Body body, Index grain = 0) {
+            if (begin >= end) {
+                return;
+            }
+            const auto count = static_cast<std::size_t>(end - begin);
+            std::size_t chunk_size = grain > 0 ? static_cast<std::size_t>(grain) : 0;
+            if (chunk_size == 0) {
+                // A few chunks per thread, so a slow chunk doesn't leave the other threads idle.
+                const std::size_t chunks = (static_cast<std::size_t>(worker_count()) + 1) * 4;
+                chunk_size               = std::max<std::size_t>(1, (count + chunks - 1) / chunks);
+            }
+            if (chunk_size >= count || !is_running()) {
+                for (Index i = begin; i < end; ++i) {
+                    body(i);
+                }
+                return;
+            }
+            JobCounter counter;
+            for (std::size_t first = chunk_size; first < count; first += chunk_size) {
+                const Index chunk_begin = begin + static_cast<Index>(first);
+                const Index chunk_end   = begin + static_cast<Index>(std::min(first + chunk_size, count));
+                run([chunk_begin, chunk_end, &body] {
+                    for (Index i = chunk_begin; i < chunk_end; ++i) {
+                        body(i);
+                    }
+                }, &counter);
+            }
+            // The calling thread takes the first chunk itself.
+            JobCounter first_chunk;
+            first_chunk.m_pending = 1;
+            execute(QueuedJob{[begin, chunk_size, &body] {
+                for (Index i = begin; i < begin + static_cast<Index>(chunk_size); ++i) {
+                    body(i);
+                }
+            }, &first_chunk});
+            wait(counter);
+            wait(first_chunk);
+        }
+
+        /**
+        * @returns The index of the calling thread: 0 for the main thread and the threads the job system doesn't own,
+        * 1 to @ref JobSystem::worker_count for the workers.
+        */
+        static uint32_t thread_index();
+
+    private:
+        struct QueuedJob {
+            Job job;
+            JobCounter *counter;
+        };
+
+        /**
+        * @brief A deque of jobs owned by one thread. The owner pushes and pops at the back, the thieves steal from the front.
+        */
+        struct JobQueue {
+            std::mutex mutex;
+            std::deque<QueuedJob> jobs;
+        };
+
+        JobSystem() = default;
+
+        void worker_loop(std::stop_token stop_token, uint32_t index);
+
+        void push(QueuedJob job);
+
+        /**
+        * @brief Pushes the job when the workers run, otherwise runs it on the calling thread.
+        */
+        void push_or_execute(QueuedJob job);
+
+        /**
+        * @brief Pops a job from the deque of the thread `index`, or steals one from another thread.
+        */
+        std::optional<QueuedJob> find_job(uint32_t index);
+
+        /**
+        * @brief Runs the job, and finishes it on its counter.
+        */
+        void execute(QueuedJob job);
+
+        /**
+        * @brief Decrements the counter, and starts its continuations if it reached zero.
+        */
+        void finish(JobCounter *counter);
+
+        /**
+        * @brief One queue per thread: the main thread at index 0 and the workers from index 1.
+        */
+        std::vector<std::unique_ptr<JobQueue> > m_queues;
+        std::vector<std::jthread> m_workers;
+        std::atomic<bool> m_running{false};
+        /**
+        * @brief Number of jobs in all the queues; the idle workers sleep while it's zero.
+        */
+        std::atomic<uint32_t> m_queued{0};
+        std::mutex m_sleep_mutex;
+        std::condition_variable_any m_job_available;
+    };
+} // namespace engine::util
+
+#endif//MATF_RG_PROJECT_JOB_SYSTEM_HPP
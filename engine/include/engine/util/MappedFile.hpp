@@ -0,0 +1,63 @@
+/**
+ * @file MappedFile.hpp
+ * @brief Defines the MappedFile class that maps a file into memory for reading.
+ */
+
+#ifndef MATF_RG_PROJECT_MAPPED_FILE_HPP
+#define MATF_RG_PROJECT_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace engine::util {
+    /**
+    * @class MappedFile
+    * @brief A read-only memory mapping of a whole file. The mapping is released when the object is destroyed.
+    *
+    * Pages are loaded lazily by the OS, so opening a large file costs almost nothing until its bytes are read.
+    * On platforms without `mmap` the file is read into memory instead.
+    */
+    class MappedFile {
+    public:
+        /**
+        * @brief Maps the file at `path` into memory.
+        * @param path The file to map.
+        * @returns The mapped file, or std::nullopt if the file doesn't exist or can't be mapped.
+        */
+        static std::optional<MappedFile> open(const std::filesystem::path &path);
+
+        /**
+        * @returns The contents of the file.
+        */
+        std::span<const std::byte> bytes() const {
+            return {m_data, m_size};
+        }
+
+        MappedFile() = default;
+
+        MappedFile(MappedFile &&other) noexcept;
+
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        MappedFile(const MappedFile &) = delete;
+
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        ~MappedFile();
+
+    private:
+        void release();
+
+        const std::byte *m_data{nullptr};
+        std::size_t m_size{0};
+        /**
+        * @brief Holds the file contents on platforms without `mmap`.
+        */
+        std::vector<std::byte> m_buffer;
+    };
+} // namespace engine::util
+
+#endif//MATF_RG_PROJECT_MAPPED_FILE_HPP
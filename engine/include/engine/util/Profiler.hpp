@@ -0,0 +1,257 @@
+/**
+ * @file Profiler.hpp
+ * @brief Defines the Profiler class, a low-overhead scoped-zone CPU profiler, and the RG_PROFILE_ZONE macro.
+ */
+
+#ifndef MATF_RG_PROJECT_PROFILER_HPP
+#define MATF_RG_PROJECT_PROFILER_HPP
+
+#include <engine/util/Utils.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+* @brief Profiles the enclosing scope as a zone with the given name.
+* The name must outlive the profiler; string literals are the common case.
+* @code
+* void CrowdController::update() {
+*     RG_PROFILE_ZONE("Crowd::animate");
+*     ...
+* }
+* @endcode
+*/
+#define RG_PROFILE_ZONE(name) engine::util::ProfileZone CONCAT(rg_profile_zone_, __LINE__)(name)
+
+/**
+* @brief Profiles the enclosing function as a zone named after the function.
+*/
+#define RG_PROFILE_FUNCTION() RG_PROFILE_ZONE(std::source_location::current().function_name())
+
+namespace engine::util {
+    /**
+    * @struct ProfileEvent
+    * @brief One finished zone: its name and the begin and end timestamps in nanoseconds.
+    */
+    struct ProfileEvent {
+        std::string_view name;
+        uint64_t begin_ns;
+        uint64_t end_ns;
+    };
+
+    /**
+    * @struct ZoneStats
+    * @brief Rolling statistics of a zone over the last @ref Profiler::HISTORY_SIZE samples, in milliseconds.
+    */
+    struct ZoneStats {
+        std::string_view name;
+        double min_ms{0.0};
+        double avg_ms{0.0};
+        double p99_ms{0.0};
+        double last_ms{0.0};
+        std::size_t samples{0};
+    };
+
+    /**
+    * @class Profiler
+    * @brief Collects the timings of the profiled zones from all the threads.
+    *
+    * Every thread writes its finished zones to its own single-producer single-consumer ring buffer, without locks.
+    * The main thread drains the buffers at the end of every frame, in @ref Profiler::end_frame, into the rolling
+    * statistics per zone name, and into the capture when a Chrome trace capture is running.
+    * When a buffer is full, the new zones are dropped and counted in @ref Profiler::dropped_events.
+    *
+    * The @ref core::App profiles every @ref core::Controller phase automatically, as the zones
+    * named `ControllerName::phase`. The GPU zones from @ref graphics::GpuProfiler land in the same statistics,
+    * a few frames late, under the names prefixed with `GPU::`. Disable the profiler in the config.json:
+    * @code
+    * "profiler": {
+    *   "enabled": false,
+    *   "gpu": false
+    * }
+    * @endcode
+    */
+    class Profiler {
+    public:
+        /**
+        * @brief Number of the last samples of a zone the statistics are computed over.
+        */
+        static constexpr std::size_t HISTORY_SIZE = 512;
+
+        /**
+        * @brief Number of events a thread can record between two @ref Profiler::end_frame calls.
+        */
+        static constexpr uint32_t THREAD_BUFFER_SIZE = 1 << 14;
+
+        /**
+        * @brief Get the instance of the @ref Profiler class.
+        */
+        static Profiler *instance();
+
+        static uint64_t now_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        bool enabled() const {
+            return m_enabled.load(std::memory_order_relaxed);
+        }
+
+        void set_enabled(bool enabled) {
+            m_enabled.store(enabled, std::memory_order_relaxed);
+        }
+
+        /**
+        * @brief Records a finished zone on the calling thread. Use @ref RG_PROFILE_ZONE instead of calling it directly.
+        */
+        void record(std::string_view name, uint64_t begin_ns, uint64_t end_ns);
+
+        /**
+        * @brief Records a finished GPU zone, with the timestamps already converted to the @ref Profiler::now_ns time domain.
+        * The GPU zones go to their own `GPU` lane in the trace. Called by @ref graphics::GpuProfiler on the main thread.
+        */
+        void record_gpu(std::string_view name, uint64_t begin_ns, uint64_t end_ns);
+
+        /**
+        * @brief Ends the current frame: records the `Frame` zone and drains the thread buffers. Called by the @ref core::App
+        * on the main thread after drawing.
+        */
+        void end_frame();
+
+        /**
+        * @brief Returns the statistics of all the zones recorded so far, sorted by name.
+        */
+        std::vector<ZoneStats> zone_stats() const;
+
+        /**
+        * @brief Starts capturing all the zones of the next `frame_count` frames. When the capture is done,
+        * it's written to the `path` as a Chrome trace, which can be opened in chrome://tracing or https://ui.perfetto.dev.
+        */
+        void capture(uint32_t frame_count, std::filesystem::path path);
+
+        bool is_capturing() const {
+            return m_capture_frames_left > 0;
+        }
+
+        /**
+        * @brief Writes the events in the Chrome trace JSON format.
+        * @returns true if the file was written.
+        */
+        bool write_chrome_trace(const std::filesystem::path &path) const;
+
+        /**
+        * @brief Returns the number of events dropped because a thread buffer was full.
+        */
+        uint64_t dropped_events() const;
+
+        /**
+        * @brief Draws the profiler window with the zone statistics and the capture button.
+        * Call it between @ref graphics::GraphicsController::begin_gui and @ref graphics::GraphicsController::end_gui.
+        */
+        void draw_gui();
+
+    private:
+        /**
+        * @brief Single-producer single-consumer ring buffer of one thread's events.
+        */
+        struct ThreadBuffer {
+            std::array<ProfileEvent, THREAD_BUFFER_SIZE> events;
+            /**
+            * @brief Written only by the owning thread.
+            */
+            std::atomic<uint32_t> head{0};
+            /**
+            * @brief Written only by the main thread in @ref Profiler::end_frame.
+            */
+            std::atomic<uint32_t> tail{0};
+            std::atomic<uint64_t> dropped{0};
+            uint32_t thread_id{0};
+            std::string name;
+        };
+
+        struct CapturedEvent {
+            ProfileEvent event;
+            uint32_t thread_id;
+        };
+
+        /**
+        * @brief The last samples of a zone, in a circular buffer.
+        */
+        struct ZoneHistory {
+            std::array<float, HISTORY_SIZE> samples_ms{};
+            std::size_t count{0};
+            std::size_t next{0};
+        };
+
+        Profiler() = default;
+
+        /**
+        * @brief Returns the buffer of the calling thread, registering it on the first call.
+        */
+        ThreadBuffer *thread_buffer();
+
+        /**
+        * @brief Registers a new buffer under the given lane name.
+        */
+        ThreadBuffer *register_buffer(std::string name);
+
+        static void push(ThreadBuffer &buffer, const ProfileEvent &event);
+
+        void drain(ThreadBuffer &buffer);
+
+        std::atomic<bool> m_enabled{true};
+        /**
+        * @brief Guards the registration of the thread buffers.
+        */
+        mutable std::mutex m_buffers_mutex;
+        std::vector<std::unique_ptr<ThreadBuffer> > m_buffers;
+        /**
+        * @brief The lane of the GPU zones, registered on the first @ref Profiler::record_gpu.
+        */
+        ThreadBuffer *m_gpu_buffer{nullptr};
+
+        std::unordered_map<std::string, ZoneHistory, ds::StringHash, std::equal_to<> > m_zones;
+        uint64_t m_frame_begin_ns{0};
+
+        std::vector<CapturedEvent> m_capture;
+        uint32_t m_capture_frames_left{0};
+        std::filesystem::path m_capture_path;
+    };
+
+    /**
+    * @class ProfileZone
+    * @brief Records the time from its construction to its destruction as a zone. See @ref RG_PROFILE_ZONE.
+    */
+    class ProfileZone {
+    public:
+        explicit ProfileZone(std::string_view name) : m_name(name) {
+            if (Profiler::instance()->enabled()) {
+                m_begin_ns = Profiler::now_ns();
+            }
+        }
+
+        ~ProfileZone() {
+            if (m_begin_ns != 0) {
+                Profiler::instance()->record(m_name, m_begin_ns, Profiler::now_ns());
+            }
+        }
+
+        ProfileZone(const ProfileZone &) = delete;
+
+        ProfileZone &operator=(const ProfileZone &) = delete;
+
+    private:
+        std::string_view m_name;
+        uint64_t m_begin_ns{0};
+    };
+} // namespace engine::util
+
+#endif//MATF_RG_PROJECT_PROFILER_HPP
@@ -12,6 +12,8 @@
 #include <mutex>
 #include <filesystem>
 #include <functional>
+#include <string>
+#include <string_view>
 #include <unordered_set>
 #include <type_traits>
 
@@ -212,8 +214,34 @@ namespace engine::util {
         }
     } // namespace alg
 
+    /**
+    * @brief Contains data structures and their helpers.
+    */
     namespace ds {
-    }
+        /**
+        * @brief Transparent string hash. Enables heterogeneous lookup by `std::string_view` and `const char *` in
+        * unordered containers keyed by `std::string`, without constructing a temporary `std::string`.
+        * @code
+        * std::unordered_map<std::string, int, util::ds::StringHash, std::equal_to<>> locations;
+        * locations.find(std::string_view("model"));
+        * @endcode
+        */
+        struct StringHash {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view value) const noexcept {
+                return std::hash<std::string_view>{}(value);
+            }
+
+            std::size_t operator()(const std::string &value) const noexcept {
+                return std::hash<std::string_view>{}(value);
+            }
+
+            std::size_t operator()(const char *value) const noexcept {
+                return std::hash<std::string_view>{}(value);
+            }
+        };
+    } // namespace ds
 } // namespace engine
 
 #endif//MATF_RG_PROJECT_UTILS_HPP
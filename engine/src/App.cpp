@@ -6,8 +6,16 @@
 
 #include <engine/util/ArgParser.hpp>
 #include <engine/util/Configuration.hpp>
+#include <engine/util/JobSystem.hpp>
+#include <engine/util/Profiler.hpp>
 #include <engine/graphics/GraphicsController.hpp>
 #include <engine/util/Utils.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 namespace engine::core {
     int App::run(int argc, char **argv) {
@@ -19,6 +27,7 @@ namespace engine::core {
                 poll_events();
                 update();
                 draw();
+                util::Profiler::instance()->end_frame();
             }
             terminate();
         } catch (const util::Error &e) {
@@ -32,6 +41,18 @@ namespace engine::core {
         util::ArgParser::instance()->initialize(argc, argv);
         util::Configuration::instance()->initialize();
 
+        const auto &config              = util::Configuration::config();
+        const uint32_t hardware_threads = std::thread::hardware_concurrency();
+        uint32_t worker_count           = hardware_threads > 1 ? hardware_threads - 1 : 1;
+        if (config.contains("jobs")) {
+            worker_count = config["jobs"].value<uint32_t>("workers", worker_count);
+        }
+        util::JobSystem::instance()->initialize(worker_count);
+        m_parallel_update = config.contains("jobs") && config["jobs"].value<bool>("parallel_update", false);
+        if (config.contains("profiler")) {
+            util::Profiler::instance()->set_enabled(config["profiler"].value<bool>("enabled", true));
+        }
+
         // register engine controllers
         auto begin     = register_controller<EngineControllersBegin>();
         auto platform  = register_controller<platform::PlatformController>();
@@ -54,14 +75,35 @@ namespace engine::core {
                          "Please make sure that there are no cycles in the controller dependency graph.");
             util::alg::topological_sort(range(m_controllers), adjacent_controllers);
         }
+        m_controller_index.clear();
+        m_in_degree.assign(m_controllers.size(), 0);
+        for (std::size_t i = 0; i < m_controllers.size(); ++i) {
+            m_controller_index[m_controllers[i]] = i;
+        }
+        for (auto controller: m_controllers) {
+            for (auto next: controller->next()) {
+                ++m_in_degree[m_controller_index.at(next)];
+            }
+        }
+        static constexpr std::array<std::string_view, Controller::PhaseCount> phase_names = {
+                "initialize", "loop", "poll_events", "update", "begin_draw", "draw", "end_draw", "terminate"
+        };
+        for (auto controller: m_controllers) {
+            for (int phase = 0; phase < Controller::PhaseCount; ++phase) {
+                controller->m_zone_names[phase] = std::format("{}::{}", controller->name(), phase_names[phase]);
+            }
+        }
         for (auto controller: m_controllers) {
             spdlog::info("{}::initialize", controller->name());
+            RG_PROFILE_ZONE(controller->m_zone_names[Controller::Initialize]);
             controller->initialize();
         }
     }
 
     bool App::loop() {
+        RG_PROFILE_ZONE("App::loop");
         for (auto controller: m_controllers) {
+            RG_PROFILE_ZONE(controller->m_zone_names[Controller::Loop]);
             if (controller->is_enabled() && !controller->loop()) {
                 return false;
             }
@@ -70,34 +112,172 @@ namespace engine::core {
     }
 
     void App::poll_events() {
+        RG_PROFILE_ZONE("App::poll_events");
         for (auto controller: m_controllers) {
             // We don't check if the controller is enabled for poll_events because the controller may enable itself in the poll_events if it needs to.
             // For example, a GUIController may enable itself in the poll_events method if a button to enable/disable the GUI was pressed.
+            RG_PROFILE_ZONE(controller->m_zone_names[Controller::PollEvents]);
             controller->poll_events();
         }
     }
 
     void App::update() {
+        RG_PROFILE_ZONE("App::update");
+        const auto update_start = Clock::now();
+        if (m_parallel_update && util::JobSystem::instance()->is_running()) {
+            update_parallel(update_start);
+        } else {
+            update_serial(update_start);
+        }
+        mark_critical_path();
+    }
+
+    void App::update_controller(Controller *controller, Clock::time_point update_start) {
+        using Milliseconds = std::chrono::duration<double, std::milli>;
+        const auto start   = Clock::now();
+        if (controller->is_enabled()) {
+            RG_PROFILE_ZONE(controller->m_zone_names[Controller::Update]);
+            controller->update();
+        }
+        auto &timing        = controller->m_update_timing;
+        timing.start_ms     = Milliseconds(start - update_start).count();
+        timing.duration_ms  = Milliseconds(Clock::now() - start).count();
+        timing.thread_index = util::JobSystem::thread_index();
+    }
+
+    void App::update_serial(Clock::time_point update_start) {
         for (auto controller: m_controllers) {
-            if (controller->is_enabled()) {
-                controller->update();
+            update_controller(controller, update_start);
+        }
+    }
+
+    void App::update_parallel(Clock::time_point update_start) {
+        const std::size_t count = m_controllers.size();
+        std::vector<std::atomic<uint32_t> > remaining(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            remaining[i].store(m_in_degree[i], std::memory_order_relaxed);
+        }
+        // Guards the state shared with the workers: the controllers ready to update on the main thread,
+        // the number of finished controllers, and the first error.
+        std::mutex mutex;
+        std::condition_variable main_thread_wakeup;
+        std::vector<std::size_t> main_thread_ready;
+        std::size_t finished = 0;
+        std::exception_ptr error;
+
+        // Runs the update, and then schedules the controllers that were waiting only for this one.
+        // After an error the remaining updates are skipped, but the graph is still walked to the end.
+        std::function<void(std::size_t)> schedule;
+        auto run = [&](std::size_t index) {
+            bool failed;
+            {
+                std::lock_guard lock(mutex);
+                failed = error != nullptr;
+            }
+            if (!failed) {
+                try {
+                    update_controller(m_controllers[index], update_start);
+                } catch (...) {
+                    std::lock_guard lock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+            for (auto next: m_controllers[index]->next()) {
+                const std::size_t next_index = m_controller_index.at(next);
+                if (remaining[next_index].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    schedule(next_index);
+                }
+            }
+            // Notifying under the lock keeps the main thread from returning, and destroying this state,
+            // before the worker is done with it.
+            std::lock_guard lock(mutex);
+            ++finished;
+            main_thread_wakeup.notify_one();
+        };
+        schedule = [&](std::size_t index) {
+            if (m_controllers[index]->is_update_thread_safe()) {
+                util::JobSystem::instance()->run([&run, index] {
+                    run(index);
+                });
+            } else {
+                {
+                    std::lock_guard lock(mutex);
+                    main_thread_ready.push_back(index);
+                }
+                main_thread_wakeup.notify_one();
+            }
+        };
+
+        for (std::size_t i = 0; i < count; ++i) {
+            if (m_in_degree[i] == 0) {
+                schedule(i);
             }
         }
+        while (true) {
+            std::size_t index;
+            {
+                std::unique_lock lock(mutex);
+                main_thread_wakeup.wait(lock, [&] {
+                    return finished == count || !main_thread_ready.empty();
+                });
+                if (main_thread_ready.empty()) {
+                    break;
+                }
+                index = main_thread_ready.back();
+                main_thread_ready.pop_back();
+            }
+            run(index);
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void App::mark_critical_path() {
+        // Controllers are sorted topologically, so every controller is visited after all of its predecessors.
+        const std::size_t count = m_controllers.size();
+        std::vector<double> ready_ms(count, 0.0);
+        std::vector<std::size_t> critical_predecessor(count, count);
+        std::size_t last = count;
+        for (std::size_t i = 0; i < count; ++i) {
+            auto &timing              = m_controllers[i]->m_update_timing;
+            timing.critical_finish_ms = ready_ms[i] + timing.duration_ms;
+            timing.on_critical_path   = false;
+            if (last == count || timing.critical_finish_ms > m_controllers[last]->m_update_timing.critical_finish_ms) {
+                last = i;
+            }
+            for (auto next: m_controllers[i]->next()) {
+                const std::size_t next_index = m_controller_index.at(next);
+                if (timing.critical_finish_ms >= ready_ms[next_index]) {
+                    ready_ms[next_index]             = timing.critical_finish_ms;
+                    critical_predecessor[next_index] = i;
+                }
+            }
+        }
+        for (std::size_t i = last; i < count; i = critical_predecessor[i]) {
+            m_controllers[i]->m_update_timing.on_critical_path = true;
+        }
     }
 
     void App::draw() {
+        RG_PROFILE_ZONE("App::draw");
         for (auto controller: m_controllers) {
             if (controller->is_enabled()) {
+                RG_PROFILE_ZONE(controller->m_zone_names[Controller::BeginDraw]);
                 controller->begin_draw();
             }
         }
         for (auto controller: m_controllers) {
             if (controller->is_enabled()) {
+                RG_PROFILE_ZONE(controller->m_zone_names[Controller::Draw]);
                 controller->draw();
             }
         }
         for (auto controller: m_controllers) {
             if (controller->is_enabled()) {
+                RG_PROFILE_ZONE(controller->m_zone_names[Controller::EndDraw]);
                 controller->end_draw();
             }
         }
@@ -107,9 +287,11 @@ namespace engine::core {
         // We terminate controllers in reverse order of their registration to ensure that controllers that depend on other controllers are terminated last.
         for (auto it = m_controllers.rbegin(); it != m_controllers.rend(); ++it) {
             auto controller = *it;
+            RG_PROFILE_ZONE(controller->m_zone_names[Controller::Terminate]);
             controller->terminate();
             spdlog::info("{}::terminate", controller->name());
         }
+        util::JobSystem::instance()->shutdown();
     }
 
     void App::app_setup() {
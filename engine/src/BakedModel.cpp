@@ -0,0 +1,334 @@
+#include <engine/graphics/VertexFormat.hpp>
+#include <engine/resources/BakedModel.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <system_error>
+
+namespace engine::resources {
+    namespace {
+        constexpr std::array<char, 8> MAGIC = {'R', 'G', 'M', 'O', 'D', 'E', 'L', '\0'};
+        constexpr uint64_t SECTION_ALIGNMENT = 16;
+
+        struct Header {
+            std::array<char, 8> magic;
+            uint32_t version;
+            uint32_t vertex_compression;
+            uint32_t mesh_optimization;
+            uint32_t import_flags;
+            uint32_t mesh_count;
+            uint32_t mesh_lods;
+            int64_t source_mtime;
+            /**
+            * @brief The size of the vertex section; the meshes may be in different vertex formats.
+            */
+            uint64_t vertex_bytes;
+            uint64_t index_count;
+            uint64_t texture_count;
+            uint64_t lod_count;
+            uint64_t strings_size;
+            uint64_t meshes_offset;
+            uint64_t vertices_offset;
+            uint64_t indices_offset;
+            uint64_t textures_offset;
+            uint64_t lods_offset;
+            uint64_t strings_offset;
+            uint32_t source_path_offset;
+            uint32_t source_path_length;
+        };
+
+        struct MeshRecord {
+            /**
+            * @brief Offset of the first vertex in the vertex section, in bytes.
+            */
+            uint64_t vertices_offset;
+            uint64_t vertex_count;
+            uint64_t first_index;
+            uint64_t index_count;
+            uint32_t first_texture;
+            uint32_t texture_count;
+            uint32_t first_lod;
+            uint32_t lod_count;
+            std::array<float, 3> box_min;
+            std::array<float, 3> box_max;
+            std::array<float, 3> sphere_center;
+            float sphere_radius;
+            uint32_t material_index;
+            uint32_t vertex_format;
+            graphics::MaterialBlock material;
+        };
+
+        struct TextureRecord {
+            uint32_t path_offset;
+            uint32_t path_length;
+            uint32_t type;
+            uint32_t reserved;
+        };
+
+        static_assert(std::is_trivially_copyable_v<Header>);
+        static_assert(std::is_trivially_copyable_v<MeshRecord>);
+        static_assert(std::is_trivially_copyable_v<TextureRecord>);
+        static_assert(std::is_trivially_copyable_v<MeshLod>);
+        static_assert(std::is_trivially_copyable_v<Vertex>);
+
+        uint64_t align_up(uint64_t value) {
+            return (value + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+        }
+
+        bool section_in_bounds(uint64_t offset, uint64_t count, uint64_t element_size, uint64_t file_size) {
+            return offset % SECTION_ALIGNMENT == 0 && offset <= file_size &&
+                   count <= (file_size - offset) / element_size;
+        }
+
+        template<typename T>
+        const T *section(std::span<const std::byte> bytes, uint64_t offset) {
+            return reinterpret_cast<const T *>(bytes.data() + offset);
+        }
+
+        Header read_header(std::span<const std::byte> bytes) {
+            Header header;
+            std::memcpy(&header, bytes.data(), sizeof(Header));
+            return header;
+        }
+    } // namespace
+
+    BakedModelKey BakedModelKey::of(const std::filesystem::path &source_path, const ImportSettings &settings) {
+        std::error_code error;
+        auto mtime = std::filesystem::last_write_time(source_path, error);
+        return BakedModelKey{
+                source_path,
+                error ? 0 : static_cast<int64_t>(mtime.time_since_epoch().count()),
+                settings.flags,
+                settings.vertex_compression.key(),
+                settings.mesh_optimization.key(),
+                settings.lods.key()
+        };
+    }
+
+    std::filesystem::path BakedModel::file_name(const std::filesystem::path &source_path, uint32_t import_flags) {
+        const std::size_t hash = std::hash<std::string>{}(std::format("{}:{}", source_path.generic_string(),
+                                                                      import_flags));
+        return std::format("{}-{:016x}.rgmodel", source_path.stem().string(), hash);
+    }
+
+    BakedModel BakedModel::bake(const BakedModelKey &key, const std::vector<MeshData> &meshes) {
+        Header header{};
+        header.magic        = MAGIC;
+        header.version      = VERSION;
+        header.vertex_compression = key.vertex_compression;
+        header.mesh_optimization  = key.mesh_optimization;
+        header.mesh_lods          = key.mesh_lods;
+        header.import_flags = key.import_flags;
+        header.mesh_count   = static_cast<uint32_t>(meshes.size());
+        header.source_mtime = key.source_mtime;
+
+        std::string strings = key.source_path.generic_string();
+        header.source_path_offset = 0;
+        header.source_path_length = static_cast<uint32_t>(strings.size());
+
+        std::vector<MeshRecord> mesh_records;
+        std::vector<TextureRecord> texture_records;
+        std::vector<MeshLod> lod_records;
+        mesh_records.reserve(meshes.size());
+        for (const auto &mesh: meshes) {
+            const auto &bounds = mesh.bounds;
+            mesh_records.push_back(MeshRecord{
+                    header.vertex_bytes, mesh.vertices.size(),
+                    header.index_count, mesh.indices.size(),
+                    static_cast<uint32_t>(header.texture_count), static_cast<uint32_t>(mesh.textures.size()),
+                    static_cast<uint32_t>(lod_records.size()), static_cast<uint32_t>(mesh.lods.size()),
+                    {bounds.box.min.x, bounds.box.min.y, bounds.box.min.z},
+                    {bounds.box.max.x, bounds.box.max.y, bounds.box.max.z},
+                    {bounds.sphere.center.x, bounds.sphere.center.y, bounds.sphere.center.z},
+                    bounds.sphere.radius,
+                    mesh.material_index,
+                    static_cast<uint32_t>(mesh.vertex_format),
+                    mesh.material
+            });
+            for (const auto &texture: mesh.textures) {
+                std::string texture_path = texture.path.generic_string();
+                texture_records.push_back(TextureRecord{
+                        static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(texture_path.size()),
+                        static_cast<uint32_t>(texture.type), 0
+                });
+                strings.append(texture_path);
+            }
+            // Every vertex format is a multiple of 4 bytes, so the vertices of each mesh stay aligned.
+            header.vertex_bytes += mesh.vertices.size() * graphics::vertex_size(mesh.vertex_format);
+            header.index_count += mesh.indices.size();
+            header.texture_count += mesh.textures.size();
+            lod_records.insert(lod_records.end(), mesh.lods.begin(), mesh.lods.end());
+        }
+        header.lod_count    = lod_records.size();
+        header.strings_size = strings.size();
+
+        header.meshes_offset   = align_up(sizeof(Header));
+        header.vertices_offset = align_up(header.meshes_offset + mesh_records.size() * sizeof(MeshRecord));
+        header.indices_offset  = align_up(header.vertices_offset + header.vertex_bytes);
+        header.textures_offset = align_up(header.indices_offset + header.index_count * sizeof(uint32_t));
+        header.lods_offset     = align_up(header.textures_offset + texture_records.size() * sizeof(TextureRecord));
+        header.strings_offset  = align_up(header.lods_offset + lod_records.size() * sizeof(MeshLod));
+
+        BakedModel result;
+        result.m_buffer.resize(header.strings_offset + header.strings_size);
+        std::byte *out = result.m_buffer.data();
+        std::memcpy(out, &header, sizeof(Header));
+        std::memcpy(out + header.meshes_offset, mesh_records.data(), mesh_records.size() * sizeof(MeshRecord));
+        for (std::size_t i = 0; i < meshes.size(); ++i) {
+            const std::size_t vertex_bytes = meshes[i].vertices.size() * graphics::vertex_size(meshes[i].vertex_format);
+            graphics::encode_vertices(meshes[i].vertex_format, meshes[i].vertices,
+                                      std::span(out + header.vertices_offset + mesh_records[i].vertices_offset,
+                                                vertex_bytes));
+            std::memcpy(out + header.indices_offset + mesh_records[i].first_index * sizeof(uint32_t),
+                        meshes[i].indices.data(), meshes[i].indices.size() * sizeof(uint32_t));
+        }
+        std::memcpy(out + header.textures_offset, texture_records.data(),
+                    texture_records.size() * sizeof(TextureRecord));
+        std::memcpy(out + header.lods_offset, lod_records.data(), lod_records.size() * sizeof(MeshLod));
+        std::memcpy(out + header.strings_offset, strings.data(), strings.size());
+        result.m_bytes = result.m_buffer;
+        result.parse(nullptr);
+        return result;
+    }
+
+    std::optional<BakedModel> BakedModel::open(const std::filesystem::path &path, const BakedModelKey &key) {
+        auto file = util::MappedFile::open(path);
+        if (!file.has_value()) {
+            return std::nullopt;
+        }
+        BakedModel result;
+        result.m_file  = std::move(file.value());
+        result.m_bytes = result.m_file.bytes();
+        if (!result.parse(&key)) {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    bool BakedModel::parse(const BakedModelKey *expected_key) {
+        if (m_bytes.size() < sizeof(Header)) {
+            return false;
+        }
+        const Header header = read_header(m_bytes);
+        if (header.magic != MAGIC || header.version != VERSION) {
+            return false;
+        }
+        const uint64_t size = m_bytes.size();
+        if (!section_in_bounds(header.meshes_offset, header.mesh_count, sizeof(MeshRecord), size) ||
+            !section_in_bounds(header.vertices_offset, header.vertex_bytes, 1, size) ||
+            !section_in_bounds(header.indices_offset, header.index_count, sizeof(uint32_t), size) ||
+            !section_in_bounds(header.textures_offset, header.texture_count, sizeof(TextureRecord), size) ||
+            !section_in_bounds(header.lods_offset, header.lod_count, sizeof(MeshLod), size) ||
+            !section_in_bounds(header.strings_offset, header.strings_size, 1, size)) {
+            return false;
+        }
+        auto strings = reinterpret_cast<const char *>(m_bytes.data() + header.strings_offset);
+        auto string_at = [&](uint64_t offset, uint64_t length) -> std::optional<std::string_view> {
+            if (offset + length > header.strings_size) {
+                return std::nullopt;
+            }
+            return std::string_view(strings + offset, length);
+        };
+
+        auto source_path = string_at(header.source_path_offset, header.source_path_length);
+        if (!source_path.has_value()) {
+            return false;
+        }
+        if (expected_key && (header.import_flags != expected_key->import_flags ||
+                             header.vertex_compression != expected_key->vertex_compression ||
+                             header.mesh_optimization != expected_key->mesh_optimization ||
+                             header.mesh_lods != expected_key->mesh_lods ||
+                             header.source_mtime != expected_key->source_mtime ||
+                             source_path.value() != expected_key->source_path.generic_string())) {
+            return false;
+        }
+
+        const auto *mesh_records = section<MeshRecord>(m_bytes, header.meshes_offset);
+        const auto *lod_records  = section<MeshLod>(m_bytes, header.lods_offset);
+        for (uint32_t i = 0; i < header.mesh_count; ++i) {
+            const MeshRecord &mesh = mesh_records[i];
+            if (static_cast<uint64_t>(mesh.first_lod) + mesh.lod_count > header.lod_count) {
+                return false;
+            }
+            for (uint32_t lod = mesh.first_lod; lod < mesh.first_lod + mesh.lod_count; ++lod) {
+                if (static_cast<uint64_t>(lod_records[lod].first_index) + lod_records[lod].index_count >
+                    mesh.index_count) {
+                    return false;
+                }
+            }
+            if (mesh.vertex_format > static_cast<uint32_t>(graphics::VertexFormat::CompactHalfPosition) ||
+                mesh.vertices_offset + mesh.vertex_count * graphics::vertex_size(
+                        static_cast<graphics::VertexFormat>(mesh.vertex_format)) > header.vertex_bytes ||
+                mesh.first_index + mesh.index_count > header.index_count ||
+                static_cast<uint64_t>(mesh.first_texture) + mesh.texture_count > header.texture_count) {
+                return false;
+            }
+        }
+
+        const auto *texture_records = section<TextureRecord>(m_bytes, header.textures_offset);
+        m_textures.clear();
+        m_textures.reserve(header.texture_count);
+        for (uint64_t i = 0; i < header.texture_count; ++i) {
+            auto texture_path = string_at(texture_records[i].path_offset, texture_records[i].path_length);
+            if (!texture_path.has_value()) {
+                return false;
+            }
+            m_textures.push_back(TextureReference{
+                    std::filesystem::path(texture_path.value()), static_cast<TextureType>(texture_records[i].type)
+            });
+        }
+        return true;
+    }
+
+    std::vector<MeshView> BakedModel::meshes() const {
+        const Header header      = read_header(m_bytes);
+        const auto *mesh_records = section<MeshRecord>(m_bytes, header.meshes_offset);
+        const auto *vertices     = section<std::byte>(m_bytes, header.vertices_offset);
+        const auto *indices      = section<uint32_t>(m_bytes, header.indices_offset);
+        const auto *lods         = section<MeshLod>(m_bytes, header.lods_offset);
+        std::vector<MeshView> result;
+        result.reserve(header.mesh_count);
+        for (uint32_t i = 0; i < header.mesh_count; ++i) {
+            const MeshRecord &mesh = mesh_records[i];
+            graphics::Bounds bounds;
+            bounds.box.min       = glm::vec3(mesh.box_min[0], mesh.box_min[1], mesh.box_min[2]);
+            bounds.box.max       = glm::vec3(mesh.box_max[0], mesh.box_max[1], mesh.box_max[2]);
+            bounds.sphere.center = glm::vec3(mesh.sphere_center[0], mesh.sphere_center[1], mesh.sphere_center[2]);
+            bounds.sphere.radius = mesh.sphere_radius;
+            const auto format = static_cast<graphics::VertexFormat>(mesh.vertex_format);
+            result.push_back(MeshView{
+                    std::span(vertices + mesh.vertices_offset, mesh.vertex_count * graphics::vertex_size(format)),
+                    format,
+                    std::span(indices + mesh.first_index, mesh.index_count),
+                    std::span(m_textures).subspan(mesh.first_texture, mesh.texture_count),
+                    bounds,
+                    mesh.material_index,
+                    mesh.material,
+                    std::span(lods + mesh.first_lod, mesh.lod_count)
+            });
+        }
+        return result;
+    }
+
+    bool BakedModel::write(const std::filesystem::path &path) const {
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+        std::filesystem::path temporary_path = path;
+        temporary_path += ".tmp";
+        {
+            std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                return false;
+            }
+            file.write(reinterpret_cast<const char *>(m_bytes.data()), static_cast<std::streamsize>(m_bytes.size()));
+            if (!file.good()) {
+                return false;
+            }
+        }
+        std::filesystem::rename(temporary_path, path, error);
+        return !error;
+    }
+} // namespace engine::resources
@@ -0,0 +1,254 @@
+#include <engine/resources/BakedTexture.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <system_error>
+
+namespace engine::resources {
+    namespace {
+        constexpr std::array<char, 8> MAGIC = {'R', 'G', 'T', 'E', 'X', '\0', '\0', '\0'};
+        constexpr uint64_t SECTION_ALIGNMENT = 16;
+
+        struct Header {
+            std::array<char, 8> magic;
+            uint32_t version;
+            /**
+            * @brief 0 for raw pixels, otherwise the @ref BlockFormat plus 1.
+            */
+            uint32_t format;
+            uint32_t channels;
+            uint32_t level_count;
+            int64_t source_mtime;
+            uint64_t source_size;
+            uint64_t source_hash;
+            uint64_t source_path_hash;
+            uint64_t settings;
+            uint64_t levels_offset;
+        };
+
+        struct LevelRecord {
+            int32_t width;
+            int32_t height;
+            /**
+            * @brief Offset of the level from the start of the file, in bytes.
+            */
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        static_assert(std::is_trivially_copyable_v<Header>);
+        static_assert(std::is_trivially_copyable_v<LevelRecord>);
+
+        uint64_t align_up(uint64_t value) {
+            return (value + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+        }
+
+        Header read_header(std::span<const std::byte> bytes) {
+            Header header;
+            std::memcpy(&header, bytes.data(), sizeof(Header));
+            return header;
+        }
+
+        LevelRecord read_level(std::span<const std::byte> bytes, const Header &header, uint32_t index) {
+            LevelRecord level;
+            std::memcpy(&level, bytes.data() + header.levels_offset + index * sizeof(LevelRecord), sizeof(LevelRecord));
+            return level;
+        }
+
+        uint64_t path_hash(const std::filesystem::path &path) {
+            return std::hash<std::string>{}(path.generic_string());
+        }
+
+        uint64_t level_size(uint32_t format, uint32_t channels, int32_t width, int32_t height) {
+            if (format == 0) {
+                return static_cast<uint64_t>(width) * height * channels;
+            }
+            return CompressedImage::level_size(static_cast<BlockFormat>(format - 1), width, height);
+        }
+    } // namespace
+
+    BakedTextureKey BakedTextureKey::of(const std::filesystem::path &source_path, uint64_t settings) {
+        std::error_code error;
+        const auto mtime = std::filesystem::last_write_time(source_path, error);
+        const int64_t ticks = error ? 0 : static_cast<int64_t>(mtime.time_since_epoch().count());
+        const auto size  = std::filesystem::file_size(source_path, error);
+        return BakedTextureKey{source_path, ticks, error ? 0 : static_cast<uint64_t>(size), settings};
+    }
+
+    uint64_t BakedTextureKey::content_hash(const std::filesystem::path &path) {
+        auto file = util::MappedFile::open(path);
+        if (!file.has_value()) {
+            return 0;
+        }
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (const std::byte byte: file->bytes()) {
+            hash = (hash ^ static_cast<uint64_t>(byte)) * 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    std::filesystem::path BakedTexture::file_name(const std::filesystem::path &source_path, TextureType type,
+                                                  bool flip_vertically) {
+        const std::size_t hash = std::hash<std::string>{}(std::format("{}:{}:{}", source_path.generic_string(),
+                                                                      static_cast<int32_t>(type), flip_vertically));
+        return std::format("{}-{:016x}.rgtex", source_path.stem().string(), hash);
+    }
+
+    BakedTexture BakedTexture::layout(const BakedTextureKey &key, uint32_t format, uint32_t channels,
+                                      const std::vector<std::pair<int32_t, int32_t> > &level_sizes,
+                                      const std::function<void(uint32_t level, std::span<std::byte> data)> &fill) {
+        Header header{};
+        header.magic            = MAGIC;
+        header.version          = VERSION;
+        header.format           = format;
+        header.channels         = channels;
+        header.level_count      = static_cast<uint32_t>(level_sizes.size());
+        header.source_mtime     = key.source_mtime;
+        header.source_size      = key.source_size;
+        header.source_hash      = BakedTextureKey::content_hash(key.source_path);
+        header.source_path_hash = path_hash(key.source_path);
+        header.settings         = key.settings;
+        header.levels_offset    = align_up(sizeof(Header));
+
+        std::vector<LevelRecord> levels;
+        uint64_t offset = align_up(header.levels_offset + level_sizes.size() * sizeof(LevelRecord));
+        for (const auto &[width, height]: level_sizes) {
+            const uint64_t size = level_size(format, channels, width, height);
+            levels.push_back(LevelRecord{width, height, offset, size});
+            offset = align_up(offset + size);
+        }
+
+        BakedTexture result;
+        result.m_buffer.resize(offset);
+        std::byte *out = result.m_buffer.data();
+        std::memcpy(out, &header, sizeof(Header));
+        std::memcpy(out + header.levels_offset, levels.data(), levels.size() * sizeof(LevelRecord));
+        for (uint32_t i = 0; i < levels.size(); ++i) {
+            fill(i, std::span(out + levels[i].offset, levels[i].size));
+        }
+        result.m_bytes = result.m_buffer;
+        return result;
+    }
+
+    BakedTexture BakedTexture::bake(const BakedTextureKey &key, const Image &image) {
+        std::vector<std::pair<int32_t, int32_t> > level_sizes = {{image.width, image.height}};
+        while (level_sizes.back() != std::pair(1, 1)) {
+            const auto [width, height] = level_sizes.back();
+            level_sizes.emplace_back(std::max(width / 2, 1), std::max(height / 2, 1));
+        }
+        // Each level is averaged from the previous one, which has to stay alive until then.
+        Image previous;
+        return layout(key, 0, static_cast<uint32_t>(image.channels), level_sizes,
+                      [&](uint32_t level, std::span<std::byte> data) {
+                          if (level > 0) {
+                              previous = (level == 1 ? image : previous).next_mip_level();
+                          }
+                          const Image &current = level == 0 ? image : previous;
+                          std::memcpy(data.data(), current.pixels.data(), data.size());
+                      });
+    }
+
+    BakedTexture BakedTexture::bake(const BakedTextureKey &key, const CompressedImage &image) {
+        std::vector<std::pair<int32_t, int32_t> > level_sizes;
+        for (const auto &level: image.levels) {
+            level_sizes.emplace_back(level.width, level.height);
+        }
+        return layout(key, static_cast<uint32_t>(image.format) + 1, 0, level_sizes,
+                      [&](uint32_t level, std::span<std::byte> data) {
+                          std::memcpy(data.data(), image.level_data(level).data(), data.size());
+                      });
+    }
+
+    std::optional<BakedTexture> BakedTexture::open(const std::filesystem::path &path, const BakedTextureKey &key) {
+        auto file = util::MappedFile::open(path);
+        if (!file.has_value()) {
+            return std::nullopt;
+        }
+        BakedTexture result;
+        result.m_file  = std::move(file.value());
+        result.m_bytes = result.m_file.bytes();
+        if (!result.parse()) {
+            return std::nullopt;
+        }
+        const Header header = read_header(result.m_bytes);
+        if (header.settings != key.settings || header.source_size != key.source_size ||
+            header.source_path_hash != path_hash(key.source_path)) {
+            return std::nullopt;
+        }
+        // Checkouts and copies touch the files without changing them; hashing is still much cheaper than decoding.
+        if (header.source_mtime != key.source_mtime &&
+            header.source_hash != BakedTextureKey::content_hash(key.source_path)) {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    bool BakedTexture::parse() {
+        if (m_bytes.size() < sizeof(Header)) {
+            return false;
+        }
+        const Header header = read_header(m_bytes);
+        if (header.magic != MAGIC || header.version != VERSION || header.level_count == 0 ||
+            header.format > static_cast<uint32_t>(BlockFormat::BC7) + 1 ||
+            (header.format == 0 && (header.channels == 0 || header.channels > 4))) {
+            return false;
+        }
+        const uint64_t size = m_bytes.size();
+        if (header.levels_offset % SECTION_ALIGNMENT != 0 || header.levels_offset > size ||
+            header.level_count > (size - header.levels_offset) / sizeof(LevelRecord)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < header.level_count; ++i) {
+            const LevelRecord level = read_level(m_bytes, header, i);
+            if (level.width <= 0 || level.height <= 0 ||
+                level.size != level_size(header.format, header.channels, level.width, level.height) ||
+                level.offset > size || level.size > size - level.offset) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::optional<BlockFormat> BakedTexture::block_format() const {
+        const Header header = read_header(m_bytes);
+        if (header.format == 0) {
+            return std::nullopt;
+        }
+        return static_cast<BlockFormat>(header.format - 1);
+    }
+
+    int32_t BakedTexture::channels() const {
+        return static_cast<int32_t>(read_header(m_bytes).channels);
+    }
+
+    uint32_t BakedTexture::level_count() const {
+        return read_header(m_bytes).level_count;
+    }
+
+    BakedTexture::Level BakedTexture::level(uint32_t index) const {
+        const LevelRecord level = read_level(m_bytes, read_header(m_bytes), index);
+        return Level{level.width, level.height, m_bytes.subspan(level.offset, level.size)};
+    }
+
+    bool BakedTexture::write(const std::filesystem::path &path) const {
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+        std::filesystem::path temporary_path = path;
+        temporary_path += ".tmp";
+        {
+            std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                return false;
+            }
+            file.write(reinterpret_cast<const char *>(m_bytes.data()), static_cast<std::streamsize>(m_bytes.size()));
+            if (!file.good()) {
+                return false;
+            }
+        }
+        std::filesystem::rename(temporary_path, path, error);
+        return !error;
+    }
+} // namespace engine::resources
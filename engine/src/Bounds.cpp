@@ -0,0 +1,30 @@
+#include <engine/graphics/Bounds.hpp>
+#include <algorithm>
+
+namespace engine::graphics {
+
+    BoundingSphere BoundingSphere::transformed(const glm::mat4 &transform) const {
+        const float scale = std::max({
+                glm::length(glm::vec3(transform[0])),
+                glm::length(glm::vec3(transform[1])),
+                glm::length(glm::vec3(transform[2]))
+        });
+        return BoundingSphere{glm::vec3(transform * glm::vec4(center, 1.0f)), radius * scale};
+    }
+
+    Bounds Bounds::merge(const Bounds &a, const Bounds &b) {
+        if (a.box.empty()) {
+            return b;
+        }
+        if (b.box.empty()) {
+            return a;
+        }
+        Bounds result;
+        result.box = a.box;
+        result.box.expand(b.box);
+        result.sphere.center = result.box.center();
+        result.sphere.radius = std::max(glm::distance(result.sphere.center, a.sphere.center) + a.sphere.radius,
+                                        glm::distance(result.sphere.center, b.sphere.center) + b.sphere.radius);
+        return result;
+    }
+}
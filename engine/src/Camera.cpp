@@ -70,6 +70,13 @@ namespace engine::graphics {
             Zoom = 45.0f;
     }
 
+    void Camera::look_at(glm::vec3 target) {
+        const glm::vec3 direction = glm::normalize(target - Position);
+        Yaw                       = glm::degrees(atan2f(direction.z, direction.x));
+        Pitch                     = glm::clamp(glm::degrees(asinf(direction.y)), -89.0f, 89.0f);
+        update_camera_vectors();
+    }
+
     // calculates the front vector from the Camera's (updated) Euler Angles
     void Camera::update_camera_vectors() {
         // calculate the new Front vector
@@ -0,0 +1,402 @@
+#include <engine/resources/CompressedImage.hpp>
+#include <engine/util/Errors.hpp>
+#include <engine/util/MappedFile.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <system_error>
+
+namespace engine::resources {
+    namespace {
+        constexpr uint32_t four_cc(const char (&code)[5]) {
+            return static_cast<uint32_t>(code[0]) | static_cast<uint32_t>(code[1]) << 8 |
+                   static_cast<uint32_t>(code[2]) << 16 | static_cast<uint32_t>(code[3]) << 24;
+        }
+
+        constexpr uint32_t DDS_MAGIC       = four_cc("DDS ");
+        constexpr std::size_t DDS_HEADER_SIZE = 124;
+        constexpr std::size_t DX10_HEADER_SIZE = 20;
+        constexpr uint32_t DDSD_CAPS        = 0x1;
+        constexpr uint32_t DDSD_HEIGHT      = 0x2;
+        constexpr uint32_t DDSD_WIDTH       = 0x4;
+        constexpr uint32_t DDSD_PIXELFORMAT = 0x1000;
+        constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+        constexpr uint32_t DDSD_LINEARSIZE  = 0x80000;
+        constexpr uint32_t DDPF_FOURCC      = 0x4;
+        constexpr uint32_t DDSCAPS_COMPLEX  = 0x8;
+        constexpr uint32_t DDSCAPS_TEXTURE  = 0x1000;
+        constexpr uint32_t DDSCAPS_MIPMAP   = 0x400000;
+        constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200;
+        constexpr uint32_t DDSCAPS2_VOLUME  = 0x200000;
+        constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+        constexpr uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+        constexpr std::array<uint8_t, 12> KTX2_IDENTIFIER = {
+                0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+        };
+        constexpr std::size_t KTX2_HEADER_SIZE      = 80;
+        constexpr std::size_t KTX2_LEVEL_INDEX_SIZE = 24;
+        /**
+        * @brief More levels than a 2^31 pixel wide texture has mean a corrupt header.
+        */
+        constexpr uint32_t MAX_LEVELS = 32;
+        /**
+        * @brief Larger than any texture OpenGL can create, so a larger side means a corrupt header.
+        * It also keeps the block counts and the level sizes from overflowing.
+        */
+        constexpr int32_t MAX_DIMENSION = 1 << 16;
+
+        std::optional<BlockFormat> format_from_four_cc(uint32_t code) {
+            switch (code) {
+            case four_cc("DXT1"): return BlockFormat::BC1;
+            case four_cc("DXT5"): return BlockFormat::BC3;
+            case four_cc("ATI1"):
+            case four_cc("BC4U"): return BlockFormat::BC4;
+            case four_cc("ATI2"):
+            case four_cc("BC5U"): return BlockFormat::BC5;
+            default: return std::nullopt;
+            }
+        }
+
+        uint32_t four_cc_from_format(BlockFormat format) {
+            switch (format) {
+            case BlockFormat::BC1: return four_cc("DXT1");
+            case BlockFormat::BC3: return four_cc("DXT5");
+            case BlockFormat::BC4: return four_cc("ATI1");
+            case BlockFormat::BC5: return four_cc("ATI2");
+            case BlockFormat::BC7: return four_cc("DX10");
+            default: RG_SHOULD_NOT_REACH_HERE("Unknown block format {}", static_cast<uint32_t>(format));
+            }
+        }
+
+        /**
+        * @brief The DXGI_FORMAT of the DX10 header extension. The sRGB variants aren't read, the engine samples every texture as linear.
+        */
+        std::optional<BlockFormat> format_from_dxgi(uint32_t dxgi_format) {
+            switch (dxgi_format) {
+            case 71: return BlockFormat::BC1;
+            case 77: return BlockFormat::BC3;
+            case 80: return BlockFormat::BC4;
+            case 83: return BlockFormat::BC5;
+            case 98: return BlockFormat::BC7;
+            default: return std::nullopt;
+            }
+        }
+
+        constexpr uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+
+        /**
+        * @brief The VkFormat of the KTX2 header. The sRGB variants aren't read, like in the DDS files.
+        */
+        std::optional<BlockFormat> format_from_vk_format(uint32_t vk_format) {
+            switch (vk_format) {
+            case 131:
+            case 133: return BlockFormat::BC1;
+            case 137: return BlockFormat::BC3;
+            case 139: return BlockFormat::BC4;
+            case 141: return BlockFormat::BC5;
+            case 145: return BlockFormat::BC7;
+            default: return std::nullopt;
+            }
+        }
+
+        /**
+        * @brief Reads the little-endian values of a file, and fails with the name of the file when they're out of its bounds.
+        */
+        class Reader {
+        public:
+            Reader(const std::filesystem::path &path, std::span<const std::byte> bytes)
+            : m_path(path)
+          , m_bytes(bytes) {
+            }
+
+            template<typename T>
+            T read(std::size_t offset) const {
+                require(offset, sizeof(T));
+                T value;
+                std::memcpy(&value, m_bytes.data() + offset, sizeof(T));
+                return value;
+            }
+
+            void require(std::size_t offset, std::size_t size) const {
+                if (offset > m_bytes.size() || size > m_bytes.size() - offset) {
+                    fail("the file is truncated");
+                }
+            }
+
+            [[noreturn]] void fail(std::string_view reason) const {
+                throw util::EngineError(util::EngineError::Type::AssetLoadingError,
+                                        std::format("Failed to load compressed texture {}: {}.", m_path.string(),
+                                                    reason));
+            }
+
+            std::span<const std::byte> bytes() const {
+                return m_bytes;
+            }
+
+        private:
+            const std::filesystem::path &m_path;
+            std::span<const std::byte> m_bytes;
+        };
+
+        void check_dimensions(const Reader &reader, int32_t width, int32_t height) {
+            if (width <= 0 || height <= 0 || width > MAX_DIMENSION || height > MAX_DIMENSION) {
+                reader.fail(std::format("the header is corrupt, the texture is {}x{}", width, height));
+            }
+        }
+
+        void copy_level(CompressedImage &image, const Reader &reader, std::size_t offset, int32_t width,
+                        int32_t height) {
+            // The level has to be in the file before the image grows by its size, which a corrupt header can make huge.
+            reader.require(offset, CompressedImage::level_size(image.format, width, height));
+            auto level = image.add_level(width, height);
+            std::memcpy(level.data(), reader.bytes().data() + offset, level.size());
+        }
+
+        CompressedImage parse_dds(const Reader &reader) {
+            if (reader.read<uint32_t>(0) != DDS_MAGIC || reader.read<uint32_t>(4) != DDS_HEADER_SIZE) {
+                reader.fail("not a DDS file");
+            }
+            constexpr std::size_t header = 4;
+            const auto height            = reader.read<int32_t>(header + 8);
+            const auto width             = reader.read<int32_t>(header + 12);
+            const auto mip_count         = std::max(reader.read<uint32_t>(header + 24), 1u);
+            const auto pixel_flags       = reader.read<uint32_t>(header + 76);
+            const auto code              = reader.read<uint32_t>(header + 80);
+            const auto caps2             = reader.read<uint32_t>(header + 108);
+            if (!(pixel_flags & DDPF_FOURCC)) {
+                reader.fail("uncompressed DDS files aren't supported");
+            }
+            if (caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) {
+                reader.fail("only 2D textures are supported");
+            }
+            if (mip_count > MAX_LEVELS) {
+                reader.fail("the header is corrupt");
+            }
+            check_dimensions(reader, width, height);
+
+            CompressedImage image;
+            std::size_t offset = header + DDS_HEADER_SIZE;
+            std::optional<BlockFormat> format;
+            if (code == four_cc("DX10")) {
+                format = format_from_dxgi(reader.read<uint32_t>(offset));
+                if (reader.read<uint32_t>(offset + 4) != DDS_DIMENSION_TEXTURE2D ||
+                    (reader.read<uint32_t>(offset + 8) & DDS_RESOURCE_MISC_TEXTURECUBE) ||
+                    reader.read<uint32_t>(offset + 12) > 1) {
+                    reader.fail("only 2D textures are supported");
+                }
+                offset += DX10_HEADER_SIZE;
+            } else {
+                format = format_from_four_cc(code);
+            }
+            if (!format.has_value()) {
+                reader.fail("the block format isn't supported");
+            }
+            image.format = format.value();
+            for (uint32_t level = 0; level < mip_count; ++level) {
+                const int32_t level_width  = std::max(width >> level, 1);
+                const int32_t level_height = std::max(height >> level, 1);
+                copy_level(image, reader, offset, level_width, level_height);
+                offset += image.levels.back().size;
+            }
+            return image;
+        }
+
+        CompressedImage parse_ktx2(const Reader &reader) {
+            reader.require(0, KTX2_HEADER_SIZE);
+            if (std::memcmp(reader.bytes().data(), KTX2_IDENTIFIER.data(), KTX2_IDENTIFIER.size()) != 0) {
+                reader.fail("not a KTX2 file");
+            }
+            const auto format      = format_from_vk_format(reader.read<uint32_t>(12));
+            const auto width       = reader.read<int32_t>(20);
+            const auto height      = reader.read<int32_t>(24);
+            const auto depth       = reader.read<uint32_t>(28);
+            const auto layers      = reader.read<uint32_t>(32);
+            const auto faces       = reader.read<uint32_t>(36);
+            const auto level_count = std::max(reader.read<uint32_t>(40), 1u);
+            if (!format.has_value()) {
+                reader.fail("the block format isn't supported");
+            }
+            if (reader.read<uint32_t>(44) != 0) {
+                reader.fail("supercompressed files aren't supported");
+            }
+            if (depth > 1 || layers > 1 || faces != 1) {
+                reader.fail("only 2D textures are supported");
+            }
+            if (level_count > MAX_LEVELS) {
+                reader.fail("the header is corrupt");
+            }
+            check_dimensions(reader, width, height);
+
+            CompressedImage image;
+            image.format = format.value();
+            for (uint32_t level = 0; level < level_count; ++level) {
+                const std::size_t index = KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_SIZE;
+                const auto offset       = reader.read<uint64_t>(index);
+                copy_level(image, reader, offset, std::max(width >> level, 1), std::max(height >> level, 1));
+                if (reader.read<uint64_t>(index + 8) != image.levels.back().size) {
+                    reader.fail(std::format("the size of mip level {} doesn't match its dimensions", level));
+                }
+            }
+            return image;
+        }
+
+        /**
+        * @brief Reverses the first `rows` rows of the 3-bit indices of a BC4 block, 12 bits per row.
+        */
+        void flip_bc4_block(uint8_t *block, int32_t rows) {
+            uint64_t indices = 0;
+            std::memcpy(&indices, block + 2, 6);
+            uint64_t flipped = indices;
+            for (int32_t row = 0; row < rows; ++row) {
+                const uint64_t bits = indices >> (12 * row) & 0xFFF;
+                flipped &= ~(uint64_t{0xFFF} << (12 * (rows - 1 - row)));
+                flipped |= bits << (12 * (rows - 1 - row));
+            }
+            std::memcpy(block + 2, &flipped, 6);
+        }
+
+        /**
+        * @brief Reverses the first `rows` rows of the 2-bit indices of a BC1 block, a byte per row.
+        */
+        void flip_bc1_block(uint8_t *block, int32_t rows) {
+            std::reverse(block + 4, block + 4 + rows);
+        }
+
+        void flip_block(BlockFormat format, uint8_t *block, int32_t rows) {
+            switch (format) {
+            case BlockFormat::BC1: flip_bc1_block(block, rows);
+                break;
+            case BlockFormat::BC3: flip_bc4_block(block, rows);
+                flip_bc1_block(block + 8, rows);
+                break;
+            case BlockFormat::BC4: flip_bc4_block(block, rows);
+                break;
+            case BlockFormat::BC5: flip_bc4_block(block, rows);
+                flip_bc4_block(block + 8, rows);
+                break;
+            default: RG_SHOULD_NOT_REACH_HERE("Block format {} can't be flipped", block_format_name(format));
+            }
+        }
+    } // namespace
+
+    std::string_view block_format_name(BlockFormat format) {
+        switch (format) {
+        case BlockFormat::BC1: return "BC1";
+        case BlockFormat::BC3: return "BC3";
+        case BlockFormat::BC4: return "BC4";
+        case BlockFormat::BC5: return "BC5";
+        case BlockFormat::BC7: return "BC7";
+        default: RG_SHOULD_NOT_REACH_HERE("Unknown block format {}", static_cast<uint32_t>(format));
+        }
+    }
+
+    std::size_t block_size(BlockFormat format) {
+        return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+    }
+
+    std::size_t CompressedImage::level_size(BlockFormat format, int32_t width, int32_t height) {
+        const std::size_t blocks_x = std::max((width + 3) / 4, 1);
+        const std::size_t blocks_y = std::max((height + 3) / 4, 1);
+        return blocks_x * blocks_y * block_size(format);
+    }
+
+    std::span<uint8_t> CompressedImage::add_level(int32_t width, int32_t height) {
+        const Level level{width, height, data.size(), level_size(format, width, height)};
+        levels.push_back(level);
+        data.resize(level.offset + level.size);
+        return std::span(data).subspan(level.offset, level.size);
+    }
+
+    bool CompressedImage::is_container(const std::filesystem::path &path) {
+        const auto extension = path.extension();
+        return extension == ".dds" || extension == ".ktx2";
+    }
+
+    CompressedImage CompressedImage::load(const std::filesystem::path &path) {
+        auto file = util::MappedFile::open(path);
+        if (!file.has_value()) {
+            throw util::EngineError(util::EngineError::Type::AssetLoadingError,
+                                    std::format("Failed to load compressed texture {}", path.string()));
+        }
+        const Reader reader(path, file->bytes());
+        CompressedImage image = path.extension() == ".ktx2" ? parse_ktx2(reader) : parse_dds(reader);
+        if (image.width() <= 0 || image.height() <= 0) {
+            reader.fail("the texture is empty");
+        }
+        return image;
+    }
+
+    bool CompressedImage::save_dds(const std::filesystem::path &path) const {
+        if (levels.empty()) {
+            return false;
+        }
+        std::array<uint32_t, 1 + DDS_HEADER_SIZE / 4> header{};
+        header[0]  = DDS_MAGIC;
+        header[1]  = DDS_HEADER_SIZE;
+        header[2]  = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+        header[3]  = static_cast<uint32_t>(height());
+        header[4]  = static_cast<uint32_t>(width());
+        header[5]  = static_cast<uint32_t>(levels.front().size);
+        header[7]  = static_cast<uint32_t>(levels.size());
+        header[19] = 32;
+        header[20] = DDPF_FOURCC;
+        header[21] = four_cc_from_format(format);
+        header[27] = DDSCAPS_TEXTURE | (levels.size() > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+        std::filesystem::path temporary_path = path;
+        temporary_path += ".tmp";
+        {
+            std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                return false;
+            }
+            file.write(reinterpret_cast<const char *>(header.data()), sizeof(header));
+            if (format == BlockFormat::BC7) {
+                const std::array<uint32_t, DX10_HEADER_SIZE / 4> dx10_header = {
+                        DXGI_FORMAT_BC7_UNORM, DDS_DIMENSION_TEXTURE2D, 0, 1, 0
+                };
+                file.write(reinterpret_cast<const char *>(dx10_header.data()), sizeof(dx10_header));
+            }
+            file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file.good()) {
+                return false;
+            }
+        }
+        std::filesystem::rename(temporary_path, path, error);
+        return !error;
+    }
+
+    bool CompressedImage::flip_vertically() {
+        if (format == BlockFormat::BC7) {
+            return false;
+        }
+        for (const auto &level: levels) {
+            if (level.height >= 4 && level.height % 4 != 0) {
+                return false;
+            }
+        }
+        const std::size_t size = block_size(format);
+        for (const auto &level: levels) {
+            const std::size_t blocks_x  = std::max((level.width + 3) / 4, 1);
+            const std::size_t blocks_y  = std::max((level.height + 3) / 4, 1);
+            const std::size_t row_size  = blocks_x * size;
+            const int32_t rows_in_block = std::min(level.height, 4);
+            uint8_t *blocks             = data.data() + level.offset;
+            for (std::size_t y = 0; y < blocks_y / 2; ++y) {
+                uint8_t *top    = blocks + y * row_size;
+                uint8_t *bottom = blocks + (blocks_y - 1 - y) * row_size;
+                std::swap_ranges(top, top + row_size, bottom);
+            }
+            for (std::size_t block = 0; block < blocks_x * blocks_y; ++block) {
+                flip_block(format, blocks + block * size, rows_in_block);
+            }
+        }
+        return true;
+    }
+} // namespace engine::resources
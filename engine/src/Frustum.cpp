@@ -0,0 +1,93 @@
+#include <engine/graphics/Frustum.hpp>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define RG_FRUSTUM_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace engine::graphics {
+
+    Frustum Frustum::from_matrix(const glm::mat4 &clip) {
+        // glm matrices are column major, clip[column][row].
+        auto row = [&](int i) {
+            return glm::vec4(clip[0][i], clip[1][i], clip[2][i], clip[3][i]);
+        };
+        Frustum frustum;
+        frustum.m_planes[Left]   = row(3) + row(0);
+        frustum.m_planes[Right]  = row(3) - row(0);
+        frustum.m_planes[Bottom] = row(3) + row(1);
+        frustum.m_planes[Top]    = row(3) - row(1);
+        frustum.m_planes[Near]   = row(3) + row(2);
+        frustum.m_planes[Far]    = row(3) - row(2);
+        for (auto &plane: frustum.m_planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    bool Frustum::intersects(const BoundingSphere &sphere) const {
+        for (const auto &plane: m_planes) {
+            if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Frustum::intersects(const BoundingBox &box) const {
+        for (const auto &plane: m_planes) {
+            // The box corner furthest along the plane normal.
+            const glm::vec3 corner(plane.x >= 0.0f ? box.max.x : box.min.x,
+                                   plane.y >= 0.0f ? box.max.y : box.min.y,
+                                   plane.z >= 0.0f ? box.max.z : box.min.z);
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::size_t Frustum::cull(const SphereBatch &batch, std::vector<uint8_t> &visible) const {
+        const std::size_t count = batch.size();
+        visible.resize(count);
+        std::size_t visible_count = 0;
+        std::size_t i             = 0;
+#ifdef RG_FRUSTUM_SSE
+        __m128 plane_x[PlaneCount], plane_y[PlaneCount], plane_z[PlaneCount], plane_w[PlaneCount];
+        for (int p = 0; p < PlaneCount; ++p) {
+            plane_x[p] = _mm_set1_ps(m_planes[p].x);
+            plane_y[p] = _mm_set1_ps(m_planes[p].y);
+            plane_z[p] = _mm_set1_ps(m_planes[p].z);
+            plane_w[p] = _mm_set1_ps(m_planes[p].w);
+        }
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            const __m128 x = _mm_loadu_ps(batch.x.data() + i);
+            const __m128 y = _mm_loadu_ps(batch.y.data() + i);
+            const __m128 z = _mm_loadu_ps(batch.z.data() + i);
+            const __m128 r = _mm_loadu_ps(batch.radius.data() + i);
+            __m128 inside  = _mm_cmpeq_ps(zero, zero);
+            for (int p = 0; p < PlaneCount; ++p) {
+                // dot(plane.xyz, center) + plane.w + radius >= 0
+                __m128 distance = _mm_add_ps(_mm_mul_ps(plane_x[p], x), plane_w[p]);
+                distance        = _mm_add_ps(distance, _mm_mul_ps(plane_y[p], y));
+                distance        = _mm_add_ps(distance, _mm_mul_ps(plane_z[p], z));
+                inside          = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, r), zero));
+            }
+            const int mask = _mm_movemask_ps(inside);
+            for (int lane = 0; lane < 4; ++lane) {
+                const uint8_t lane_visible = (mask >> lane) & 1;
+                visible[i + lane]          = lane_visible;
+                visible_count += lane_visible;
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            const bool sphere_visible = intersects(BoundingSphere{
+                    glm::vec3(batch.x[i], batch.y[i], batch.z[i]), batch.radius[i]
+            });
+            visible[i] = sphere_visible;
+            visible_count += sphere_visible;
+        }
+        return visible_count;
+    }
+}
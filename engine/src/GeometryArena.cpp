@@ -0,0 +1,232 @@
+#include <glad/glad.h>
+#include <engine/graphics/GeometryArena.hpp>
+#include <engine/graphics/OpenGL.hpp>
+#include <engine/resources/Mesh.hpp>
+#include <engine/util/Errors.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace engine::graphics {
+    namespace {
+        /**
+        * @brief Writes into the buffer through the copy target, so that the bound vertex array and its index buffer stay as they are.
+        */
+        void upload(uint32_t buffer, std::size_t offset, const void *data, std::size_t size) {
+            if (size == 0) {
+                return;
+            }
+            CHECKED_GL_CALL(glBindBuffer, GL_COPY_WRITE_BUFFER, buffer);
+            CHECKED_GL_CALL(glBufferSubData, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset),
+                            static_cast<GLsizeiptr>(size), data);
+            CHECKED_GL_CALL(glBindBuffer, GL_COPY_WRITE_BUFFER, 0);
+        }
+    } // namespace
+
+    RangeAllocator::RangeAllocator(uint32_t capacity) : m_capacity(capacity) {
+        if (capacity > 0) {
+            m_free.emplace_back(0, capacity);
+        }
+    }
+
+    std::optional<uint32_t> RangeAllocator::allocate(uint32_t count) {
+        for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+            auto &[offset, free_count] = *it;
+            if (free_count < count) {
+                continue;
+            }
+            const uint32_t result = offset;
+            offset += count;
+            free_count -= count;
+            if (free_count == 0) {
+                m_free.erase(it);
+            }
+            m_used += count;
+            return result;
+        }
+        return std::nullopt;
+    }
+
+    void RangeAllocator::free(uint32_t offset, uint32_t count) {
+        if (count == 0) {
+            return;
+        }
+        auto next = std::lower_bound(m_free.begin(), m_free.end(), std::make_pair(offset, 0u));
+        // Merge with the free range right after, then with the one right before.
+        if (next != m_free.end() && offset + count == next->first) {
+            next->first = offset;
+            next->second += count;
+        } else {
+            next = m_free.insert(next, std::make_pair(offset, count));
+        }
+        if (next != m_free.begin()) {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == next->first) {
+                previous->second += next->second;
+                m_free.erase(next);
+            }
+        }
+        m_used -= count;
+    }
+
+    GeometryArena *GeometryArena::instance() {
+        static GeometryArena arena;
+        return &arena;
+    }
+
+    GeometryRange GeometryArena::allocate(VertexFormat format, std::span<const std::byte> vertices,
+                                          std::span<const uint32_t> indices) {
+        const uint32_t stride       = vertex_size(format);
+        const auto vertex_count     = static_cast<uint32_t>(vertices.size() / stride);
+        const auto index_count      = static_cast<uint32_t>(indices.size());
+        RG_GUARANTEE(vertices.size() % stride == 0, "The vertex data isn't a whole number of vertices.");
+
+        GeometryRange range;
+        range.format       = format;
+        range.vertex_count = vertex_count;
+        range.index_count  = index_count;
+        Block *block       = nullptr;
+        for (uint32_t i = 0; i < m_blocks.size() && !block; ++i) {
+            Block &candidate = m_blocks[i];
+            if (candidate.format != format) {
+                continue;
+            }
+            const auto first_vertex = candidate.vertices.allocate(vertex_count);
+            if (!first_vertex.has_value()) {
+                continue;
+            }
+            const auto first_index = candidate.indices.allocate(index_count);
+            if (!first_index.has_value()) {
+                candidate.vertices.free(first_vertex.value(), vertex_count);
+                continue;
+            }
+            block             = &candidate;
+            range.block       = i;
+            range.base_vertex = static_cast<int32_t>(first_vertex.value());
+            range.first_index = first_index.value();
+        }
+        if (!block) {
+            block             = &create_block(format, vertex_count, index_count);
+            range.block       = static_cast<uint32_t>(m_blocks.size() - 1);
+            range.base_vertex = static_cast<int32_t>(block->vertices.allocate(vertex_count).value());
+            range.first_index = block->indices.allocate(index_count).value();
+        }
+        range.vao = block->vao;
+        upload(block->vbo, static_cast<std::size_t>(range.base_vertex) * stride, vertices.data(), vertices.size());
+        upload(block->ebo, static_cast<std::size_t>(range.first_index) * sizeof(uint32_t), indices.data(),
+               indices.size_bytes());
+        return range;
+    }
+
+    GeometryArena::Block &GeometryArena::create_block(VertexFormat format, uint32_t vertex_count,
+                                                      uint32_t index_count) {
+        const uint32_t stride = vertex_size(format);
+        Block block{
+                format, 0, 0, 0,
+                RangeAllocator(std::max(vertex_count, static_cast<uint32_t>(BLOCK_VERTEX_BYTES / stride))),
+                RangeAllocator(std::max(index_count, BLOCK_INDEX_COUNT))
+        };
+        CHECKED_GL_CALL(glGenVertexArrays, 1, &block.vao);
+        CHECKED_GL_CALL(glGenBuffers, 1, &block.vbo);
+        CHECKED_GL_CALL(glGenBuffers, 1, &block.ebo);
+
+        OpenGL::bind_vertex_array(block.vao);
+        CHECKED_GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, block.vbo);
+        CHECKED_GL_CALL(glBufferData, GL_ARRAY_BUFFER,
+                        static_cast<GLsizeiptr>(static_cast<std::size_t>(block.vertices.capacity()) * stride), nullptr,
+                        GL_STATIC_DRAW);
+        CHECKED_GL_CALL(glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, block.ebo);
+        CHECKED_GL_CALL(glBufferData, GL_ELEMENT_ARRAY_BUFFER,
+                        static_cast<GLsizeiptr>(static_cast<std::size_t>(block.indices.capacity()) * sizeof(uint32_t)),
+                        nullptr, GL_STATIC_DRAW);
+        set_vertex_attributes(format);
+        OpenGL::bind_vertex_array(0);
+        CHECKED_GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, 0);
+
+        spdlog::info("[GeometryArena]: created block {} for {} {} vertices and {} indices", m_blocks.size(),
+                     block.vertices.capacity(), vertex_format_name(format), block.indices.capacity());
+        return m_blocks.emplace_back(std::move(block));
+    }
+
+    void GeometryArena::free(const GeometryRange &range) {
+        if (range.block >= m_blocks.size() || m_blocks[range.block].vao != range.vao) {
+            return;
+        }
+        Block &block = m_blocks[range.block];
+        block.vertices.free(static_cast<uint32_t>(range.base_vertex), range.vertex_count);
+        block.indices.free(range.first_index, range.index_count);
+    }
+
+    void GeometryArena::attach_instance_buffer(const GeometryRange &range, uint32_t instance_vbo) {
+        Block &block = m_blocks[range.block];
+        if (block.instance_vbo == instance_vbo) {
+            return;
+        }
+        OpenGL::bind_vertex_array(block.vao);
+        CHECKED_GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, instance_vbo);
+        // A mat4 attribute takes four consecutive locations, one per column.
+        for (uint32_t column = 0; column < 4; ++column) {
+            const uint32_t location = resources::Mesh::INSTANCE_TRANSFORM_LOCATION + column;
+            CHECKED_GL_CALL(glEnableVertexAttribArray, location);
+            CHECKED_GL_CALL(glVertexAttribPointer, location, 4, GL_FLOAT, GL_FALSE,
+                            static_cast<GLsizei>(sizeof(glm::mat4)),
+                            reinterpret_cast<const void *>(column * sizeof(glm::vec4)));
+            CHECKED_GL_CALL(glVertexAttribDivisor, location, 1);
+        }
+        CHECKED_GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, 0);
+        block.instance_vbo = instance_vbo;
+    }
+
+    void GeometryArena::detach_instance_buffer(uint32_t instance_vbo) {
+        for (auto &block: m_blocks) {
+            if (block.instance_vbo == instance_vbo) {
+                block.instance_vbo = 0;
+            }
+        }
+    }
+
+    void GeometryArena::attach_draw_id_buffer(const GeometryRange &range, uint32_t draw_id_vbo) {
+        Block &block = m_blocks[range.block];
+        if (block.draw_id_vbo == draw_id_vbo) {
+            return;
+        }
+        OpenGL::bind_vertex_array(block.vao);
+        CHECKED_GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, draw_id_vbo);
+        CHECKED_GL_CALL(glEnableVertexAttribArray, DRAW_ID_LOCATION);
+        CHECKED_GL_CALL(glVertexAttribIPointer, DRAW_ID_LOCATION, 1, GL_UNSIGNED_INT,
+                        static_cast<GLsizei>(sizeof(uint32_t)), nullptr);
+        CHECKED_GL_CALL(glVertexAttribDivisor, DRAW_ID_LOCATION, 1);
+        CHECKED_GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, 0);
+        block.draw_id_vbo = draw_id_vbo;
+    }
+
+    void GeometryArena::detach_draw_id_buffer(uint32_t draw_id_vbo) {
+        for (auto &block: m_blocks) {
+            if (block.draw_id_vbo == draw_id_vbo) {
+                block.draw_id_vbo = 0;
+            }
+        }
+    }
+
+    void GeometryArena::terminate() {
+        for (auto &block: m_blocks) {
+            CHECKED_GL_CALL(glDeleteVertexArrays, 1, &block.vao);
+            CHECKED_GL_CALL(glDeleteBuffers, 1, &block.vbo);
+            CHECKED_GL_CALL(glDeleteBuffers, 1, &block.ebo);
+        }
+        m_blocks.clear();
+        OpenGL::invalidate_state();
+    }
+
+    GeometryArena::Stats GeometryArena::stats() const {
+        Stats result;
+        for (const auto &block: m_blocks) {
+            const std::size_t stride = vertex_size(block.format);
+            ++result.blocks;
+            result.vertex_bytes_used += block.vertices.used() * stride;
+            result.vertex_bytes_capacity += block.vertices.capacity() * stride;
+            result.index_bytes_used += block.indices.used() * sizeof(uint32_t);
+            result.index_bytes_capacity += block.indices.capacity() * sizeof(uint32_t);
+        }
+        return result;
+    }
+} // namespace engine::graphics
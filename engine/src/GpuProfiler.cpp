@@ -0,0 +1,105 @@
+#include <engine/graphics/GpuProfiler.hpp>
+#include <engine/graphics/OpenGL.hpp>
+#include <engine/util/Profiler.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace engine::graphics {
+    GpuProfiler *GpuProfiler::instance() {
+        static GpuProfiler profiler;
+        return &profiler;
+    }
+
+    void GpuProfiler::initialize(bool enabled) {
+        if (!enabled) {
+            return;
+        }
+        if (OpenGL::timestamp_query_bits() == 0) {
+            spdlog::info("[GpuProfiler]: the GPU timestamp counter has no bits, GPU zones are disabled.");
+            return;
+        }
+        m_queries.resize(FRAMES_IN_FLIGHT * MAX_ZONES_PER_FRAME * 2);
+        OpenGL::generate_queries(m_queries);
+        for (auto &frame: m_frames) {
+            frame.zones.reserve(MAX_ZONES_PER_FRAME);
+        }
+        m_available = true;
+    }
+
+    void GpuProfiler::terminate() {
+        if (!m_queries.empty()) {
+            OpenGL::delete_queries(m_queries);
+            m_queries.clear();
+        }
+        for (auto &frame: m_frames) {
+            frame.zones.clear();
+        }
+        m_available = false;
+    }
+
+    uint32_t GpuProfiler::begin_zone(std::string_view name) {
+        if (!m_available || !util::Profiler::instance()->enabled()) {
+            return INVALID_ZONE;
+        }
+        Frame &frame = m_frames[m_current_frame];
+        if (frame.zones.size() == MAX_ZONES_PER_FRAME) {
+            return INVALID_ZONE;
+        }
+        // The zone remembers its frame slot, so that it can end after the frame did.
+        const uint32_t zone = m_current_frame * MAX_ZONES_PER_FRAME + static_cast<uint32_t>(frame.zones.size());
+        OpenGL::query_timestamp(m_queries[zone * 2]);
+        frame.zones.push_back(Zone{name, m_queries[zone * 2], m_queries[zone * 2 + 1]});
+        return zone;
+    }
+
+    void GpuProfiler::end_zone(uint32_t zone) {
+        if (zone == INVALID_ZONE) {
+            return;
+        }
+        auto &zones          = m_frames[zone / MAX_ZONES_PER_FRAME].zones;
+        const uint32_t index = zone % MAX_ZONES_PER_FRAME;
+        if (index >= zones.size()) {
+            // The slot was reused while the zone was open.
+            return;
+        }
+        OpenGL::query_timestamp(zones[index].end_query);
+        zones[index].ended = true;
+    }
+
+    void GpuProfiler::end_frame() {
+        if (!m_available) {
+            return;
+        }
+        Frame &frame = m_frames[m_current_frame];
+        if (!frame.zones.empty()) {
+            frame.gpu_to_cpu_ns = static_cast<int64_t>(util::Profiler::now_ns()) -
+                                  static_cast<int64_t>(OpenGL::gpu_timestamp_ns());
+        }
+        m_current_frame = (m_current_frame + 1) % FRAMES_IN_FLIGHT;
+        Frame &oldest   = m_frames[m_current_frame];
+        if (!oldest.zones.empty() && !collect(oldest)) {
+            ++m_dropped_frames;
+        }
+        oldest.zones.clear();
+    }
+
+    bool GpuProfiler::collect(const Frame &frame) {
+        for (const auto &zone: frame.zones) {
+            if (zone.ended && !(OpenGL::query_result_available(zone.begin_query) &&
+                                OpenGL::query_result_available(zone.end_query))) {
+                return false;
+            }
+        }
+        auto profiler = util::Profiler::instance();
+        for (const auto &zone: frame.zones) {
+            if (!zone.ended) {
+                continue;
+            }
+            const uint64_t begin_ns = OpenGL::query_result(zone.begin_query);
+            const uint64_t end_ns   = OpenGL::query_result(zone.end_query);
+            profiler->record_gpu(zone.name, begin_ns + frame.gpu_to_cpu_ns,
+                                 std::max(begin_ns, end_ns) + frame.gpu_to_cpu_ns);
+        }
+        return true;
+    }
+} // namespace engine::graphics
@@ -4,16 +4,34 @@
 #include <imgui_impl_opengl3.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <engine/graphics/GeometryArena.hpp>
+#include <engine/graphics/GpuProfiler.hpp>
 #include <engine/graphics/GraphicsController.hpp>
 #include <engine/graphics/OpenGL.hpp>
+#include <engine/graphics/TextureStreamer.hpp>
+#include <engine/graphics/TextureUploader.hpp>
 #include <engine/platform/PlatformController.hpp>
+#include <engine/resources/Model.hpp>
 #include <engine/resources/Skybox.hpp>
+#include <engine/util/ArgParser.hpp>
+#include <engine/util/Configuration.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace engine::graphics {
 
     void GraphicsController::initialize() {
         const int opengl_initialized = gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
         RG_GUARANTEE(opengl_initialized, "OpenGL failed to init!");
+        const auto &config = util::Configuration::config();
+        if (!config.contains("graphics") || config["graphics"].value<bool>("multi_draw_indirect", true)) {
+            OpenGL::load_multi_draw_indirect(reinterpret_cast<void *(*)(const char *)>(glfwGetProcAddress));
+        }
+        spdlog::info("[Graphics]: batched draws use {}", OpenGL::multi_draw_indirect_supported()
+                                                             ? "glMultiDrawElementsIndirect"
+                                                             : "one glDrawElementsBaseVertex per draw");
 
         auto platform               = engine::core::Controller::get<platform::PlatformController>();
         auto handle                 = platform->window()->handle_();
@@ -29,6 +47,12 @@ namespace engine::graphics {
         m_ortho_params.Right  = static_cast<float>(platform->window()->width());
         m_ortho_params.Near   = 0.1f;
         m_ortho_params.Far    = 100.0f;
+        if (platform->headless()) {
+            // There is no default framebuffer to draw into, so everything is drawn into an offscreen one.
+            m_offscreen = OpenGL::create_framebuffer(platform->window()->width(), platform->window()->height());
+            CHECKED_GL_CALL(glBindFramebuffer, GL_FRAMEBUFFER, m_offscreen.fbo);
+            CHECKED_GL_CALL(glViewport, 0, 0, m_offscreen.width, m_offscreen.height);
+        }
         platform->register_platform_event_observer(
                 std::make_unique<GraphicsPlatformEventObserver>(this));
         IMGUI_CHECKVERSION();
@@ -37,9 +61,48 @@ namespace engine::graphics {
         (void) io;
         RG_GUARANTEE(ImGui_ImplGlfw_InitForOpenGL(handle, true), "ImGUI failed to initialize for OpenGL");
         RG_GUARANTEE(ImGui_ImplOpenGL3_Init("#version 330 core"), "ImGUI failed to initialize for OpenGL");
+
+        m_camera_buffer = OpenGL::create_uniform_buffer(sizeof(CameraBlock));
+        OpenGL::bind_uniform_buffer(UniformBinding::Camera, m_camera_buffer, 0, sizeof(CameraBlock));
+        m_object_buffer = OpenGL::create_uniform_buffer(sizeof(ObjectBlock));
+
+        GpuProfiler::instance()->initialize(!config.contains("profiler") ||
+                                            config["profiler"].value<bool>("gpu", true));
+
+        bool texture_upload             = true;
+        std::size_t upload_budget_bytes = 8u << 20;
+        if (config.contains("graphics") && config["graphics"].contains("texture_upload")) {
+            const auto &upload  = config["graphics"]["texture_upload"];
+            texture_upload      = upload.value<bool>("enabled", true);
+            upload_budget_bytes = upload.value<std::size_t>("frame_budget_mb", 8) << 20;
+        }
+        TextureUploader::instance()->initialize(texture_upload, upload_budget_bytes);
     }
 
     void GraphicsController::terminate() {
+        GpuProfiler::instance()->terminate();
+        TextureUploader::instance()->terminate();
+        m_render_queue.destroy();
+        GeometryArena::instance()->terminate();
+        if (m_camera_buffer != 0) {
+            OpenGL::delete_buffer(m_camera_buffer);
+            m_camera_buffer = 0;
+        }
+        if (m_object_buffer != 0) {
+            OpenGL::delete_buffer(m_object_buffer);
+            m_object_buffer = 0;
+        }
+        if (m_offscreen.fbo != 0) {
+            if (auto screenshot = util::ArgParser::instance()->arg<std::string>("--screenshot").value();
+                !screenshot.empty()) {
+                if (read_framebuffer().save_ppm(screenshot)) {
+                    spdlog::info("[Graphics]: saved the last frame to {}", screenshot);
+                } else {
+                    spdlog::error("[Graphics]: failed to save the last frame to {}", screenshot);
+                }
+            }
+            OpenGL::delete_framebuffer(m_offscreen);
+        }
         if (ImGui::GetCurrentContext()) {
             ImGui_ImplOpenGL3_Shutdown();
             ImGui_ImplGlfw_Shutdown();
@@ -60,28 +123,105 @@ namespace engine::graphics {
     }
 
     void GraphicsController::begin_gui() {
+        flush_render_queue();
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
     }
 
     void GraphicsController::end_gui() {
+        RG_PROFILE_GPU_ZONE("GPU::gui");
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        // ImGui sets the OpenGL state directly.
+        OpenGL::invalidate_state();
+    }
+
+    void GraphicsController::begin_draw() {
+        update_camera_uniforms();
+    }
+
+    void GraphicsController::update_camera_uniforms() {
+        const CameraBlock camera{projection_matrix(), m_camera.view_matrix(), glm::vec4(m_camera.Position, 1.0f)};
+        OpenGL::update_uniform_buffer(m_camera_buffer, std::as_bytes(std::span(&camera, 1)));
+        // Something else may have been bound to the binding point since the last frame.
+        OpenGL::bind_uniform_buffer(UniformBinding::Camera, m_camera_buffer, 0, sizeof(CameraBlock));
+    }
+
+    void GraphicsController::set_object_uniforms(const resources::Shader *shader, const glm::mat4 &transform) {
+        if (!shader->uses_uniform_block(UniformBinding::Object)) {
+            shader->set_mat4("model", transform);
+            return;
+        }
+        const ObjectBlock object{transform};
+        // Orphaned on every draw, so the draws before this one keep reading their own transform.
+        OpenGL::stream_uniform_buffer(m_object_buffer, std::as_bytes(std::span(&object, 1)));
+        // The render queue leaves the binding point at the range of its last draw.
+        OpenGL::bind_uniform_buffer(UniformBinding::Object, m_object_buffer, 0, sizeof(ObjectBlock));
+    }
+
+    void GraphicsController::end_draw() {
+        flush_render_queue();
+        m_render_stats = m_render_queue.stats();
+        m_render_queue.reset_stats();
+        m_state_stats = OpenGL::state_stats();
+        OpenGL::reset_state_stats();
+        GpuProfiler::instance()->end_frame();
+        TextureStreamer::instance()->end_frame();
+    }
+
+    resources::Image GraphicsController::read_framebuffer() {
+        flush_render_queue();
+        auto platform = engine::core::Controller::get<platform::PlatformController>();
+        return OpenGL::read_pixels(platform->window()->width(), platform->window()->height());
+    }
+
+    void GraphicsController::submit(const resources::Mesh *mesh, const resources::Shader *shader,
+                                    const glm::mat4 &transform, uint32_t lod) {
+        const auto world_sphere = mesh->bounds().sphere.transformed(transform);
+        const float depth       = glm::dot(world_sphere.center - m_camera.Position, m_camera.Front) /
+                                  m_perspective_params.Far;
+        // The projected diameter in pixels, like Model::screen_size but for the mesh.
+        const float distance      = glm::length(world_sphere.center - m_camera.Position);
+        const float screen_pixels = distance <= world_sphere.radius
+                                        ? std::numeric_limits<float>::infinity()
+                                        : world_sphere.radius / (distance * std::tan(m_perspective_params.FOV * 0.5f)) *
+                                          m_perspective_params.Height;
+        m_render_queue.submit(mesh, shader, transform, world_sphere, depth, lod, screen_pixels);
+    }
+
+    void GraphicsController::draw_model(const resources::Model *model, const resources::Shader *shader,
+                                        const glm::mat4 &transform) {
+        const uint32_t lod = model->select_lod(model->screen_size(transform, m_camera.Position, m_perspective_params));
+        for (const auto &mesh: model->meshes()) {
+            submit(&mesh, shader, transform, lod);
+        }
+    }
+
+    void GraphicsController::flush_render_queue() {
+        if (m_render_queue.size() == 0) {
+            return;
+        }
+        RG_PROFILE_GPU_ZONE("GPU::render_queue");
+        if (m_frustum_culling) {
+            const Frustum view_frustum = frustum();
+            m_render_queue.flush(&view_frustum);
+        } else {
+            m_render_queue.flush(nullptr);
+        }
     }
 
     void GraphicsController::draw_skybox(const resources::Shader *shader, const resources::Skybox *skybox) {
+        flush_render_queue();
+        RG_PROFILE_GPU_ZONE("GPU::skybox");
         glm::mat4 view = glm::mat4(glm::mat3(m_camera.view_matrix()));
         shader->use();
         shader->set_mat4("view", view);
         shader->set_mat4("projection", projection_matrix<>());
-        CHECKED_GL_CALL(glDepthFunc, GL_LEQUAL);
-        CHECKED_GL_CALL(glBindVertexArray, skybox->vao());
-        CHECKED_GL_CALL(glActiveTexture, GL_TEXTURE0);
-        CHECKED_GL_CALL(glBindTexture, GL_TEXTURE_CUBE_MAP, skybox->texture());
+        OpenGL::set_depth_func(GL_LEQUAL);
+        OpenGL::bind_vertex_array(skybox->vao());
+        OpenGL::bind_texture(std::max(shader->sampler_unit("skybox"), 0), GL_TEXTURE_CUBE_MAP, skybox->texture());
         CHECKED_GL_CALL(glDrawArrays, GL_TRIANGLES, 0, 36);
-        CHECKED_GL_CALL(glBindVertexArray, 0);
-        CHECKED_GL_CALL(glDepthFunc, GL_LESS); // set depth function back to default
-        CHECKED_GL_CALL(glBindTexture, GL_TEXTURE_CUBE_MAP, 0);
+        OpenGL::set_depth_func(GL_LESS); // set depth function back to default
     }
 }
@@ -0,0 +1,79 @@
+#include <engine/resources/Image.hpp>
+#include <engine/util/Errors.hpp>
+#include <engine/util/Utils.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stb_image.h>
+
+namespace engine::resources {
+    Image Image::load(const std::filesystem::path &path, bool flip_vertically) {
+        Image result;
+        // stbi_set_flip_vertically_on_load is global state, so we flip the rows ourselves to keep this thread-safe.
+        uint8_t *data = stbi_load(path.c_str(), &result.width, &result.height, &result.channels, 0);
+        defer {
+            stbi_image_free(data);
+        };
+        if (!data) {
+            throw util::EngineError(util::EngineError::Type::AssetLoadingError,
+                                    std::format("Failed to load texture {}", path.string()));
+        }
+        const std::size_t row_size = static_cast<std::size_t>(result.width) * result.channels;
+        result.pixels.resize(row_size * result.height);
+        if (flip_vertically) {
+            for (int32_t row = 0; row < result.height; ++row) {
+                std::memcpy(result.pixels.data() + row * row_size, data + (result.height - 1 - row) * row_size,
+                            row_size);
+            }
+        } else {
+            std::memcpy(result.pixels.data(), data, result.pixels.size());
+        }
+        return result;
+    }
+
+    Image Image::next_mip_level() const {
+        Image result;
+        result.width    = std::max(width / 2, 1);
+        result.height   = std::max(height / 2, 1);
+        result.channels = channels;
+        result.pixels.resize(static_cast<std::size_t>(result.width) * result.height * channels);
+        const auto pixel = [&](int32_t x, int32_t y) {
+            return pixels.data() + (static_cast<std::size_t>(std::min(y, height - 1)) * width + std::min(x, width - 1)) *
+                                   channels;
+        };
+        uint8_t *target = result.pixels.data();
+        for (int32_t y = 0; y < result.height; ++y) {
+            for (int32_t x = 0; x < result.width; ++x) {
+                const std::array<const uint8_t *, 4> samples = {
+                        pixel(2 * x, 2 * y), pixel(2 * x + 1, 2 * y), pixel(2 * x, 2 * y + 1), pixel(2 * x + 1, 2 * y + 1)
+                };
+                for (int32_t channel = 0; channel < channels; ++channel, ++target) {
+                    uint32_t sum = 0;
+                    for (const uint8_t *sample: samples) {
+                        sum += sample[channel];
+                    }
+                    *target = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+        return result;
+    }
+
+    bool Image::save_ppm(const std::filesystem::path &path) const {
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open() || channels == 0) {
+            return false;
+        }
+        file << std::format("P6\n{} {}\n255\n", width, height);
+        std::vector<uint8_t> rgb(static_cast<std::size_t>(width) * height * 3);
+        for (std::size_t pixel = 0; pixel < rgb.size() / 3; ++pixel) {
+            const uint8_t *source = pixels.data() + pixel * channels;
+            for (int32_t channel = 0; channel < 3; ++channel) {
+                rgb[pixel * 3 + channel] = source[channels >= 3 ? channel : 0];
+            }
+        }
+        file.write(reinterpret_cast<const char *>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+        return file.good();
+    }
+} // namespace engine::resources
@@ -0,0 +1,198 @@
+#include <engine/util/JobSystem.hpp>
+#include <spdlog/spdlog.h>
+#include <utility>
+
+namespace engine::util {
+    namespace {
+        thread_local uint32_t t_thread_index = 0;
+    }
+
+    JobSystem *JobSystem::instance() {
+        static JobSystem job_system;
+        return &job_system;
+    }
+
+    uint32_t JobSystem::thread_index() {
+        return t_thread_index;
+    }
+
+    void JobSystem::initialize(uint32_t worker_count) {
+        if (is_running()) {
+            return;
+        }
+        worker_count = std::max<uint32_t>(worker_count, 1);
+        m_queues.clear();
+        for (uint32_t i = 0; i <= worker_count; ++i) {
+            m_queues.emplace_back(std::make_unique<JobQueue>());
+        }
+        m_running.store(true, std::memory_order_release);
+        m_workers.reserve(worker_count);
+        for (uint32_t i = 1; i <= worker_count; ++i) {
+            m_workers.emplace_back([this, i](std::stop_token stop_token) {
+                worker_loop(stop_token, i);
+            });
+        }
+        spdlog::info("JobSystem initialized with {} workers.", worker_count);
+    }
+
+    void JobSystem::shutdown() {
+        if (!is_running()) {
+            return;
+        }
+        m_running.store(false, std::memory_order_release);
+        for (auto &worker: m_workers) {
+            worker.request_stop();
+        }
+        {
+            std::lock_guard lock(m_sleep_mutex);
+        }
+        m_job_available.notify_all();
+        m_workers.clear();
+        m_queues.clear();
+        m_queued.store(0);
+    }
+
+    void JobSystem::run(Job job, JobCounter *counter) {
+        if (counter) {
+            counter->m_pending.fetch_add(1, std::memory_order_acq_rel);
+        }
+        if (!is_running()) {
+            execute(QueuedJob{std::move(job), counter});
+            return;
+        }
+        push(QueuedJob{std::move(job), counter});
+    }
+
+    void JobSystem::run_after(JobCounter &dependency, Job job, JobCounter *counter) {
+        if (counter) {
+            counter->m_pending.fetch_add(1, std::memory_order_acq_rel);
+        }
+        {
+            std::lock_guard lock(dependency.m_mutex);
+            if (!dependency.done()) {
+                dependency.m_continuations.emplace_back([this, job = std::move(job), counter]() mutable {
+                    push_or_execute(QueuedJob{std::move(job), counter});
+                });
+                return;
+            }
+        }
+        push_or_execute(QueuedJob{std::move(job), counter});
+    }
+
+    void JobSystem::wait(JobCounter &counter) {
+        const uint32_t index = thread_index();
+        while (!counter.done()) {
+            if (auto job = find_job(index)) {
+                execute(std::move(job.value()));
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        std::exception_ptr exception;
+        {
+            // Also waits for the thread that finished the last job to release the counter.
+            std::lock_guard lock(counter.m_mutex);
+            exception = std::exchange(counter.m_exception, nullptr);
+        }
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    void JobSystem::worker_loop(std::stop_token stop_token, uint32_t index) {
+        t_thread_index = index;
+        while (!stop_token.stop_requested()) {
+            if (auto job = find_job(index)) {
+                execute(std::move(job.value()));
+                continue;
+            }
+            std::unique_lock lock(m_sleep_mutex);
+            m_job_available.wait(lock, stop_token, [this] {
+                return m_queued.load(std::memory_order_acquire) > 0;
+            });
+        }
+    }
+
+    void JobSystem::push_or_execute(QueuedJob job) {
+        if (is_running()) {
+            push(std::move(job));
+        } else {
+            execute(std::move(job));
+        }
+    }
+
+    void JobSystem::push(QueuedJob job) {
+        auto &queue = *m_queues[thread_index()];
+        {
+            std::lock_guard lock(queue.mutex);
+            queue.jobs.emplace_back(std::move(job));
+        }
+        m_queued.fetch_add(1, std::memory_order_release);
+        {
+            // Pairs with the predicate check of the sleeping workers, so the notification isn't lost.
+            std::lock_guard lock(m_sleep_mutex);
+        }
+        m_job_available.notify_one();
+    }
+
+    std::optional<JobSystem::QueuedJob> JobSystem::find_job(uint32_t index) {
+        if (m_queued.load(std::memory_order_acquire) == 0) {
+            return std::nullopt;
+        }
+        {
+            auto &own = *m_queues[index];
+            std::lock_guard lock(own.mutex);
+            if (!own.jobs.empty()) {
+                QueuedJob job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                m_queued.fetch_sub(1, std::memory_order_acq_rel);
+                return job;
+            }
+        }
+        const auto queue_count = static_cast<uint32_t>(m_queues.size());
+        for (uint32_t offset = 1; offset < queue_count; ++offset) {
+            auto &victim = *m_queues[(index + offset) % queue_count];
+            std::lock_guard lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                QueuedJob job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                m_queued.fetch_sub(1, std::memory_order_acq_rel);
+                return job;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void JobSystem::execute(QueuedJob job) {
+        try {
+            job.job();
+        } catch (...) {
+            if (job.counter) {
+                std::lock_guard lock(job.counter->m_mutex);
+                if (!job.counter->m_exception) {
+                    job.counter->m_exception = std::current_exception();
+                }
+            } else {
+                spdlog::error("[JobSystem]: a job without a counter threw an exception, the exception is dropped.");
+            }
+        }
+        finish(job.counter);
+    }
+
+    void JobSystem::finish(JobCounter *counter) {
+        if (!counter) {
+            return;
+        }
+        std::vector<Job> continuations;
+        {
+            std::lock_guard lock(counter->m_mutex);
+            if (counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+            continuations.swap(counter->m_continuations);
+        }
+        for (auto &continuation: continuations) {
+            continuation();
+        }
+    }
+} // namespace engine::util
@@ -0,0 +1,75 @@
+#include <engine/util/MappedFile.hpp>
+#include <fstream>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine::util {
+    std::optional<MappedFile> MappedFile::open(const std::filesystem::path &path) {
+        MappedFile result;
+#if !defined(_WIN32)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            return std::nullopt;
+        }
+        struct stat file_stat{};
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+            close(fd);
+            return std::nullopt;
+        }
+        void *data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping keeps the file referenced after the descriptor is closed.
+        close(fd);
+        if (data == MAP_FAILED) {
+            return std::nullopt;
+        }
+        result.m_data = static_cast<const std::byte *>(data);
+        result.m_size = file_stat.st_size;
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            return std::nullopt;
+        }
+        result.m_buffer.resize(file.tellg());
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(result.m_buffer.data()), result.m_buffer.size());
+        result.m_data = result.m_buffer.data();
+        result.m_size = result.m_buffer.size();
+#endif
+        return result;
+    }
+
+    MappedFile::MappedFile(MappedFile &&other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+        if (this != &other) {
+            release();
+            m_buffer = std::move(other.m_buffer);
+            m_data   = std::exchange(other.m_data, nullptr);
+            m_size   = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() {
+        release();
+    }
+
+    void MappedFile::release() {
+#if !defined(_WIN32)
+        if (m_data) {
+            munmap(const_cast<std::byte *>(m_data), m_size);
+        }
+#endif
+        m_buffer.clear();
+        m_data = nullptr;
+        m_size = 0;
+    }
+} // namespace engine::util
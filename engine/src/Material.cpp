@@ -0,0 +1,87 @@
+#include <glad/glad.h>
+#include <engine/graphics/OpenGL.hpp>
+#include <engine/graphics/TextureStreamer.hpp>
+#include <engine/resources/Material.hpp>
+#include <engine/resources/Shader.hpp>
+#include <engine/resources/TexturePack.hpp>
+#include <limits>
+#include <unordered_map>
+
+namespace engine::resources {
+    Material::Material(std::string name, std::vector<Texture *> textures, const graphics::MaterialBlock &constants)
+    : m_name(std::move(name))
+  , m_textures(std::move(textures))
+  , m_constants(constants) {
+        for (const auto texture: m_textures) {
+            m_texture_types.push_back(texture->type());
+        }
+        initialize();
+    }
+
+    Material::Material(std::string name, const TexturePack *pack, uint32_t layer,
+                       const graphics::MaterialBlock &constants)
+    : m_name(std::move(name))
+  , m_texture_types(pack->types())
+  , m_texture_pack(pack)
+  , m_texture_layer(layer)
+  , m_constants(constants) {
+        initialize();
+    }
+
+    void Material::initialize() {
+        for (const auto type: m_texture_types) {
+            m_sampler_layout = m_sampler_layout * 31 + static_cast<uint64_t>(type) + 1;
+        }
+        m_uniform_buffer = graphics::OpenGL::create_uniform_buffer(sizeof(graphics::MaterialBlock),
+                                                                   std::as_bytes(std::span(&m_constants, 1)));
+    }
+
+    void Material::bind(const Shader *shader) const {
+        const auto units = shader->texture_units(*this);
+        if (m_texture_pack) {
+            const auto &arrays = m_texture_pack->textures();
+            for (std::size_t i = 0; i < arrays.size(); i++) {
+                if (units[i] >= 0) {
+                    graphics::OpenGL::bind_texture(units[i], GL_TEXTURE_2D_ARRAY, arrays[i]);
+                }
+            }
+            if (const auto layer = shader->uniform(LAYER_UNIFORM); layer.valid()) {
+                shader->set_int(layer, static_cast<int>(m_texture_layer));
+            }
+        }
+        auto streamer = graphics::TextureStreamer::instance();
+        for (std::size_t i = 0; i < m_textures.size(); i++) {
+            if (units[i] >= 0) {
+                graphics::OpenGL::bind_texture(units[i], GL_TEXTURE_2D, m_textures[i]->id());
+                // A direct draw has no projected size to stream the texture by.
+                streamer->request(m_textures[i]->id(), std::numeric_limits<float>::infinity());
+            }
+        }
+        graphics::OpenGL::bind_uniform_buffer(graphics::UniformBinding::Material, m_uniform_buffer, 0,
+                                              sizeof(graphics::MaterialBlock));
+    }
+
+    void Material::set_constants(const graphics::MaterialBlock &constants) {
+        m_constants = constants;
+        graphics::OpenGL::update_uniform_buffer(m_uniform_buffer, std::as_bytes(std::span(&m_constants, 1)));
+    }
+
+    std::vector<std::string> Material::sampler_uniform_names() const {
+        std::unordered_map<std::string_view, uint32_t> counts;
+        std::vector<std::string> names;
+        names.reserve(m_texture_types.size());
+        for (const auto type: m_texture_types) {
+            const auto &texture_type = Texture::uniform_name_convention(type);
+            const auto count         = (counts[texture_type] += 1);
+            names.push_back(std::string(texture_type) + std::to_string(count));
+        }
+        return names;
+    }
+
+    void Material::destroy() {
+        if (m_uniform_buffer != 0) {
+            graphics::OpenGL::delete_buffer(m_uniform_buffer);
+            m_uniform_buffer = 0;
+        }
+    }
+} // namespace engine::resources
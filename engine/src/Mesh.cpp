@@ -1,70 +1,69 @@
 #include<glad/glad.h>
+#include <engine/graphics/GeometryArena.hpp>
+#include <engine/graphics/OpenGL.hpp>
 #include <engine/util/Utils.hpp>
 #include <engine/resources/Mesh.hpp>
 #include <engine/resources/Shader.hpp>
-#include <unordered_map>
+#include <algorithm>
+#include <cmath>
 
 namespace engine::resources {
 
-    Mesh::Mesh(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices,
-               std::vector<Texture *> textures) {
-        // NOLINTBEGIN
-        static_assert(std::is_trivial_v<Vertex>);
-        uint32_t VAO, VBO, EBO;
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indices[0]), indices.data(), GL_STATIC_DRAW);
-
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) offsetof(Vertex, Position));
-
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) offsetof(Vertex, Normal));
+    Mesh::Mesh(graphics::VertexFormat format, std::span<const std::byte> vertices, std::span<const uint32_t> indices,
+               const Material *material, const graphics::Bounds &bounds, std::span<const MeshLod> lods) :
+    m_lods(lods.begin(), lods.end()), m_material(material), m_bounds(bounds) {
+        if (m_lods.empty()) {
+            m_lods.push_back(MeshLod{0, static_cast<uint32_t>(indices.size()), 0.0f});
+        }
+        m_geometry = graphics::GeometryArena::instance()->allocate(format, vertices, indices);
+    }
 
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) offsetof(Vertex, TexCoords));
+    graphics::Bounds Mesh::compute_bounds(std::span<const Vertex> vertices) {
+        graphics::Bounds bounds;
+        for (const auto &vertex: vertices) {
+            bounds.box.expand(vertex.Position);
+        }
+        if (bounds.box.empty()) {
+            return bounds;
+        }
+        bounds.sphere.center = bounds.box.center();
+        float radius_squared = 0.0f;
+        for (const auto &vertex: vertices) {
+            const glm::vec3 offset = vertex.Position - bounds.sphere.center;
+            radius_squared         = std::max(radius_squared, glm::dot(offset, offset));
+        }
+        bounds.sphere.radius = std::sqrt(radius_squared);
+        return bounds;
+    }
 
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) offsetof(Vertex, Tangent));
+    void Mesh::draw(const Shader *shader, uint32_t lod) {
+        const MeshLod &level = this->lod(lod);
+        m_material->bind(shader);
+        graphics::OpenGL::bind_vertex_array(m_geometry.vao);
+        glDrawElementsBaseVertex(GL_TRIANGLES, level.index_count, GL_UNSIGNED_INT, index_offset(level),
+                                 m_geometry.base_vertex);
+    }
 
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) offsetof(Vertex, Bitangent));
+    void Mesh::draw_instanced(const Shader *shader, uint32_t instance_count, uint32_t lod) {
+        const MeshLod &level = this->lod(lod);
+        m_material->bind(shader);
+        graphics::OpenGL::bind_vertex_array(m_geometry.vao);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, level.index_count, GL_UNSIGNED_INT, index_offset(level),
+                                          instance_count, m_geometry.base_vertex);
+    }
 
-        glBindVertexArray(0);
-        // NOLINTEND
-        m_vao         = VAO;
-        m_num_indices = indices.size();
-        m_textures    = std::move(textures);
+    const void *Mesh::index_offset(const MeshLod &level) const {
+        return reinterpret_cast<const void *>(
+                static_cast<std::uintptr_t>(m_geometry.first_index + level.first_index) * sizeof(uint32_t));
     }
 
-    void Mesh::draw(const Shader *shader) {
-        std::unordered_map<std::string_view, uint32_t> counts;
-        std::string uniform_name;
-        uniform_name.reserve(32);
-        for (int i = 0; i < m_textures.size(); i++) {
-            glActiveTexture(GL_TEXTURE0 + i);
-            const auto &texture_type = Texture::uniform_name_convention(m_textures[i]->type());
-            uniform_name.append(texture_type);
-            const auto count = (counts[texture_type] += 1);
-            uniform_name.append(std::to_string(count));
-            shader->set_int(uniform_name, i);
-            glBindTexture(GL_TEXTURE_2D, m_textures[i]->id());
-            uniform_name.clear();
-        }
-        glBindVertexArray(m_vao);
-        glDrawElements(GL_TRIANGLES, m_num_indices, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    void Mesh::attach_instance_buffer(uint32_t instance_vbo) {
+        graphics::GeometryArena::instance()->attach_instance_buffer(m_geometry, instance_vbo);
     }
 
     void Mesh::destroy() {
-        glDeleteVertexArrays(1, &m_vao);
+        graphics::GeometryArena::instance()->free(m_geometry);
+        m_geometry = {};
     }
 
 }
@@ -0,0 +1,385 @@
+#include <engine/resources/MeshOptimizer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
+
+namespace engine::resources {
+    namespace {
+        /**
+        * @brief The LRU cache size the vertex cache order is scored for, and the constants of the scoring function,
+        * as tuned by Tom Forsyth in "Linear-Speed Vertex Cache Optimisation".
+        */
+        constexpr uint32_t SCORING_CACHE_SIZE = 32;
+        constexpr float CACHE_DECAY_POWER     = 1.5f;
+        constexpr float LAST_TRIANGLE_SCORE   = 0.75f;
+        constexpr float VALENCE_BOOST_SCALE   = 2.0f;
+        constexpr float VALENCE_BOOST_POWER   = 0.5f;
+
+        constexpr uint32_t NOT_REMAPPED = std::numeric_limits<uint32_t>::max();
+
+        float vertex_score(int32_t cache_position, uint32_t remaining_triangles) {
+            if (remaining_triangles == 0) {
+                return -1.0f;
+            }
+            float score = 0.0f;
+            if (cache_position >= 0) {
+                // The vertices of the last triangle get a fixed score, so that the next one doesn't just reuse its edge
+                // and strip around a single fan.
+                score = cache_position < 3
+                        ? LAST_TRIANGLE_SCORE
+                        : std::pow(1.0f - static_cast<float>(cache_position - 3) / (SCORING_CACHE_SIZE - 3),
+                                   CACHE_DECAY_POWER);
+            }
+            // Vertices with few triangles left are finished first, so that they leave the cache for good.
+            return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining_triangles), -VALENCE_BOOST_POWER);
+        }
+
+        /**
+        * @brief A FIFO vertex cache that counts the misses. Each miss stamps the vertex with the next time, so the
+        * vertex is cached while fewer than `size` other vertices were stamped after it.
+        */
+        class FifoCache {
+        public:
+            FifoCache(uint32_t vertex_count, uint32_t size) : m_timestamps(vertex_count, 0), m_size(size),
+                                                             m_time(size + 1) {
+            }
+
+            /**
+            * @returns The number of the vertices of the triangle that weren't cached.
+            */
+            uint32_t draw(const uint32_t *triangle) {
+                uint32_t misses = 0;
+                for (uint32_t k = 0; k < 3; ++k) {
+                    uint32_t &timestamp = m_timestamps[triangle[k]];
+                    if (m_time - timestamp > m_size) {
+                        timestamp = m_time++;
+                        ++misses;
+                    }
+                }
+                return misses;
+            }
+
+            /**
+            * @brief Evicts all the vertices.
+            */
+            void clear() {
+                m_time += m_size + 1;
+            }
+
+        private:
+            std::vector<uint32_t> m_timestamps;
+            uint32_t m_size;
+            uint32_t m_time;
+        };
+
+        uint64_t hash_bytes(const void *data, std::size_t size) {
+            // FNV-1a
+            uint64_t hash = 14695981039346656037ull;
+            const auto *bytes = static_cast<const unsigned char *>(data);
+            for (std::size_t i = 0; i < size; ++i) {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+            return hash;
+        }
+    } // namespace
+
+    uint32_t MeshOptimization::key() const {
+        if (!enabled) {
+            return 0;
+        }
+        // The threshold is kept in thousandths.
+        return 1u | static_cast<uint32_t>(std::lround(overdraw_threshold * 1000.0f)) << 1;
+    }
+
+    MeshOptimizationStats MeshOptimizer::optimize(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices,
+                                                  const MeshOptimization &settings) {
+        MeshOptimizationStats stats;
+        stats.vertices_before = static_cast<uint32_t>(vertices.size());
+        stats.before          = analyze_vertex_cache(indices, stats.vertices_before);
+        // Points and lines left by the triangulation aren't reordered.
+        if (indices.size() % 3 == 0) {
+            deduplicate_vertices(vertices, indices);
+            optimize_vertex_cache(indices, static_cast<uint32_t>(vertices.size()));
+            optimize_overdraw(indices, vertices, settings.overdraw_threshold);
+            optimize_vertex_fetch(vertices, indices);
+        }
+        stats.vertices_after = static_cast<uint32_t>(vertices.size());
+        stats.after          = analyze_vertex_cache(indices, stats.vertices_after);
+        return stats;
+    }
+
+    uint32_t MeshOptimizer::deduplicate_vertices(std::vector<Vertex> &vertices, std::span<uint32_t> indices) {
+        std::vector<uint32_t> remap(vertices.size());
+        std::vector<bool> first_copy(vertices.size(), false);
+        uint32_t unique_count = 0;
+        {
+            const Vertex *data = vertices.data();
+            auto hash          = [data](uint32_t i) {
+                return static_cast<std::size_t>(hash_bytes(&data[i], sizeof(Vertex)));
+            };
+            auto equal = [data](uint32_t a, uint32_t b) {
+                return std::memcmp(&data[a], &data[b], sizeof(Vertex)) == 0;
+            };
+            std::unordered_set<uint32_t, decltype(hash), decltype(equal)> unique(vertices.size(), hash, equal);
+            for (uint32_t i = 0; i < vertices.size(); ++i) {
+                auto [copy, inserted] = unique.insert(i);
+                first_copy[i]         = inserted;
+                remap[i]              = inserted ? unique_count++ : remap[*copy];
+            }
+        }
+        // remap[i] <= i, so the vertices can be moved down in place.
+        for (uint32_t i = 0; i < vertices.size(); ++i) {
+            if (first_copy[i]) {
+                vertices[remap[i]] = vertices[i];
+            }
+        }
+        vertices.resize(unique_count);
+        for (auto &index: indices) {
+            index = remap[index];
+        }
+        return unique_count;
+    }
+
+    void MeshOptimizer::optimize_vertex_cache(std::span<uint32_t> indices, uint32_t vertex_count) {
+        const std::size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0) {
+            return;
+        }
+        // The triangles of each vertex that aren't emitted yet are the first `remaining[v]` of its adjacency range.
+        std::vector<uint32_t> remaining(vertex_count, 0);
+        for (const auto index: indices) {
+            ++remaining[index];
+        }
+        std::vector<uint32_t> offsets(vertex_count + 1, 0);
+        std::inclusive_scan(remaining.begin(), remaining.end(), offsets.begin() + 1);
+        std::vector<uint32_t> adjacency(triangle_count * 3);
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (uint32_t t = 0; t < triangle_count; ++t) {
+                for (uint32_t k = 0; k < 3; ++k) {
+                    adjacency[fill[indices[t * 3 + k]]++] = t;
+                }
+            }
+        }
+
+        std::vector<int32_t> cache_position(vertex_count, -1);
+        std::vector<float> score(vertex_count);
+        for (uint32_t v = 0; v < vertex_count; ++v) {
+            score[v] = vertex_score(-1, remaining[v]);
+        }
+        auto triangle_score = [&](uint32_t t) {
+            return score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+        };
+
+        int64_t best       = 0;
+        float best_score   = triangle_score(0);
+        for (uint32_t t = 1; t < triangle_count; ++t) {
+            if (const float candidate = triangle_score(t); candidate > best_score) {
+                best       = t;
+                best_score = candidate;
+            }
+        }
+
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> next_cache;
+        cache.reserve(SCORING_CACHE_SIZE + 3);
+        next_cache.reserve(SCORING_CACHE_SIZE + 3);
+        std::size_t next_unemitted = 0;
+        while (output.size() < indices.size()) {
+            if (best < 0) {
+                // None of the cached vertices has triangles left; continue from the first triangle not emitted yet.
+                while (emitted[next_unemitted]) {
+                    ++next_unemitted;
+                }
+                best = static_cast<int64_t>(next_unemitted);
+            }
+            const auto triangle = static_cast<uint32_t>(best);
+            const uint32_t *corners = &indices[triangle * 3];
+            emitted[triangle] = true;
+            output.insert(output.end(), corners, corners + 3);
+            for (uint32_t k = 0; k < 3; ++k) {
+                const uint32_t v = corners[k];
+                auto begin       = adjacency.begin() + offsets[v];
+                auto end         = begin + remaining[v];
+                auto it          = std::find(begin, end, triangle);
+                if (it != end) {
+                    *it = *(end - 1);
+                    --remaining[v];
+                }
+            }
+
+            // The vertices of the triangle move to the front of the LRU cache.
+            next_cache.assign(corners, corners + 3);
+            for (const auto v: cache) {
+                if (v != corners[0] && v != corners[1] && v != corners[2]) {
+                    next_cache.push_back(v);
+                }
+            }
+            for (uint32_t i = 0; i < next_cache.size(); ++i) {
+                const uint32_t v  = next_cache[i];
+                cache_position[v] = i < SCORING_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+                score[v]          = vertex_score(cache_position[v], remaining[v]);
+            }
+
+            // Only the triangles of the vertices whose score changed can become the best.
+            best       = -1;
+            best_score = -1.0f;
+            for (const auto v: next_cache) {
+                for (uint32_t i = offsets[v]; i < offsets[v] + remaining[v]; ++i) {
+                    if (const float candidate = triangle_score(adjacency[i]); candidate > best_score) {
+                        best       = adjacency[i];
+                        best_score = candidate;
+                    }
+                }
+            }
+            if (next_cache.size() > SCORING_CACHE_SIZE) {
+                next_cache.resize(SCORING_CACHE_SIZE);
+            }
+            std::swap(cache, next_cache);
+        }
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    void MeshOptimizer::optimize_overdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices,
+                                          float threshold) {
+        const std::size_t triangle_count = indices.size() / 3;
+        if (triangle_count < 2) {
+            return;
+        }
+        FifoCache cache(static_cast<uint32_t>(vertices.size()), CACHE_SIZE);
+
+        // Hard boundaries are where the vertex cache order starts over with three new vertices; moving the
+        // clusters between them around costs nothing.
+        std::vector<std::size_t> hard_boundaries{0};
+        cache.draw(&indices[0]);
+        for (std::size_t t = 1; t < triangle_count; ++t) {
+            if (cache.draw(&indices[t * 3]) == 3) {
+                hard_boundaries.push_back(t);
+            }
+        }
+        hard_boundaries.push_back(triangle_count);
+
+        // Soft boundaries split a hard cluster where the part drawn so far, from a cold cache, has an ACMR within the
+        // threshold of the whole cluster's; the split costs at most that much of the cache efficiency.
+        std::vector<std::size_t> clusters;
+        for (std::size_t h = 0; h + 1 < hard_boundaries.size(); ++h) {
+            const std::size_t begin = hard_boundaries[h];
+            const std::size_t end   = hard_boundaries[h + 1];
+            cache.clear();
+            uint32_t cluster_misses = 0;
+            for (std::size_t t = begin; t < end; ++t) {
+                cluster_misses += cache.draw(&indices[t * 3]);
+            }
+            const float acmr_limit = threshold * static_cast<float>(cluster_misses) / static_cast<float>(end - begin);
+
+            cache.clear();
+            clusters.push_back(begin);
+            std::size_t cluster_begin = begin;
+            uint32_t misses           = 0;
+            for (std::size_t t = begin; t + 1 < end; ++t) {
+                misses += cache.draw(&indices[t * 3]);
+                if (static_cast<float>(misses) <= acmr_limit * static_cast<float>(t + 1 - cluster_begin)) {
+                    clusters.push_back(t + 1);
+                    cluster_begin = t + 1;
+                    misses        = 0;
+                    cache.clear();
+                }
+            }
+        }
+        clusters.push_back(triangle_count);
+
+        // Area-weighted centroids and normals of the clusters and of the whole mesh.
+        const std::size_t cluster_count = clusters.size() - 1;
+        std::vector<glm::vec3> centroids(cluster_count, glm::vec3(0.0f));
+        std::vector<glm::vec3> normals(cluster_count, glm::vec3(0.0f));
+        std::vector<float> areas(cluster_count, 0.0f);
+        glm::vec3 mesh_centroid(0.0f);
+        float mesh_area = 0.0f;
+        for (std::size_t c = 0; c < cluster_count; ++c) {
+            for (std::size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+                const glm::vec3 &p0    = vertices[indices[t * 3]].Position;
+                const glm::vec3 &p1    = vertices[indices[t * 3 + 1]].Position;
+                const glm::vec3 &p2    = vertices[indices[t * 3 + 2]].Position;
+                const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                const float area       = glm::length(normal);
+                centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+                normals[c] += normal;
+                areas[c] += area;
+            }
+            mesh_centroid += centroids[c];
+            mesh_area += areas[c];
+        }
+        if (mesh_area > 0.0f) {
+            mesh_centroid /= mesh_area;
+        }
+        std::vector<float> sort_keys(cluster_count, 0.0f);
+        for (std::size_t c = 0; c < cluster_count; ++c) {
+            const float normal_length = glm::length(normals[c]);
+            if (areas[c] > 0.0f && normal_length > 0.0f) {
+                sort_keys[c] = glm::dot(centroids[c] / areas[c] - mesh_centroid, normals[c] / normal_length);
+            }
+        }
+
+        // Clusters on the outside facing away from the center occlude the rest of the mesh, so they go first.
+        std::vector<std::size_t> order(cluster_count);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            return sort_keys[a] > sort_keys[b];
+        });
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+        for (const auto c: order) {
+            output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+        }
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    uint32_t MeshOptimizer::optimize_vertex_fetch(std::vector<Vertex> &vertices, std::span<uint32_t> indices) {
+        std::vector<uint32_t> remap(vertices.size(), NOT_REMAPPED);
+        uint32_t vertex_count = 0;
+        for (auto &index: indices) {
+            if (remap[index] == NOT_REMAPPED) {
+                remap[index] = vertex_count++;
+            }
+            index = remap[index];
+        }
+        std::vector<Vertex> reordered(vertex_count);
+        for (std::size_t v = 0; v < vertices.size(); ++v) {
+            if (remap[v] != NOT_REMAPPED) {
+                reordered[remap[v]] = vertices[v];
+            }
+        }
+        vertices = std::move(reordered);
+        return vertex_count;
+    }
+
+    VertexCacheStats MeshOptimizer::analyze_vertex_cache(std::span<const uint32_t> indices, uint32_t vertex_count,
+                                                         uint32_t cache_size) {
+        VertexCacheStats stats;
+        const std::size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0) {
+            return stats;
+        }
+        FifoCache cache(vertex_count, cache_size);
+        std::vector<bool> referenced(vertex_count, false);
+        for (std::size_t t = 0; t < triangle_count; ++t) {
+            stats.transformed += cache.draw(&indices[t * 3]);
+            for (uint32_t k = 0; k < 3; ++k) {
+                if (!referenced[indices[t * 3 + k]]) {
+                    referenced[indices[t * 3 + k]] = true;
+                    ++stats.referenced;
+                }
+            }
+        }
+        stats.triangles = static_cast<uint32_t>(triangle_count);
+        stats.acmr      = static_cast<float>(stats.transformed) / static_cast<float>(stats.triangles);
+        stats.atvr      = static_cast<float>(stats.transformed) / static_cast<float>(stats.referenced);
+        return stats;
+    }
+} // namespace engine::resources
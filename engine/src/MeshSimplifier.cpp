@@ -0,0 +1,394 @@
+#include <engine/resources/MeshOptimizer.hpp>
+#include <engine/resources/MeshSimplifier.hpp>
+#include <engine/util/Errors.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace engine::resources {
+    namespace {
+        /**
+        * @brief How much the planes through the border edges, perpendicular to their triangles, weigh against the
+        * triangle planes. Keeps the open borders from shrinking.
+        */
+        constexpr float BORDER_WEIGHT = 10.0f;
+
+        /**
+        * @brief A collapse is rejected if it turns a triangle by more than this, as the cosine of the angle of the normals.
+        */
+        constexpr float MIN_NORMAL_COSINE = 0.25f;
+
+        enum class VertexKind : uint8_t {
+            /**
+            * @brief Inside a manifold part of the mesh; collapses into any neighbour.
+            */
+            Manifold,
+            /**
+            * @brief On an open border; collapses into a neighbour along the border.
+            */
+            Border,
+            /**
+            * @brief On an attribute seam, a non-manifold edge or a border that meets itself; stays in place.
+            */
+            Locked,
+        };
+
+        /**
+        * @brief Sum of the squared distances from the planes added to it, weighted, as `p^T A p + 2 b^T p + c`.
+        */
+        struct Quadric {
+            float a00{0}, a11{0}, a22{0}, a01{0}, a02{0}, a12{0};
+            float b0{0}, b1{0}, b2{0};
+            float c{0};
+            float weight{0};
+
+            static Quadric plane(const glm::vec3 &normal, float distance, float weight) {
+                Quadric q;
+                q.a00    = weight * normal.x * normal.x;
+                q.a11    = weight * normal.y * normal.y;
+                q.a22    = weight * normal.z * normal.z;
+                q.a01    = weight * normal.x * normal.y;
+                q.a02    = weight * normal.x * normal.z;
+                q.a12    = weight * normal.y * normal.z;
+                q.b0     = weight * normal.x * distance;
+                q.b1     = weight * normal.y * distance;
+                q.b2     = weight * normal.z * distance;
+                q.c      = weight * distance * distance;
+                q.weight = weight;
+                return q;
+            }
+
+            Quadric &operator+=(const Quadric &other) {
+                a00 += other.a00, a11 += other.a11, a22 += other.a22;
+                a01 += other.a01, a02 += other.a02, a12 += other.a12;
+                b0 += other.b0, b1 += other.b1, b2 += other.b2;
+                c += other.c;
+                weight += other.weight;
+                return *this;
+            }
+
+            /**
+            * @brief Returns the weighted mean of the squared distances of the point `p` from the planes.
+            */
+            float error(const glm::vec3 &p) const {
+                if (weight <= 0.0f) {
+                    return 0.0f;
+                }
+                const float rx = a00 * p.x + a01 * p.y + a02 * p.z + 2.0f * b0;
+                const float ry = a01 * p.x + a11 * p.y + a12 * p.z + 2.0f * b1;
+                const float rz = a02 * p.x + a12 * p.y + a22 * p.z + 2.0f * b2;
+                return std::abs(rx * p.x + ry * p.y + rz * p.z + c) / weight;
+            }
+        };
+
+        uint64_t edge_key(uint32_t from, uint32_t to) {
+            return static_cast<uint64_t>(from) << 32 | to;
+        }
+
+        /**
+        * @brief Maps every vertex to the first vertex with the same position, so that the vertices split on the seams
+        * count as one point of the surface.
+        */
+        std::vector<uint32_t> position_ids(std::span<const glm::vec3> positions) {
+            struct PositionHash {
+                std::size_t operator()(const glm::vec3 &p) const {
+                    uint32_t bits[3];
+                    std::memcpy(bits, &p, sizeof(bits));
+                    return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+                }
+            };
+            std::unordered_map<glm::vec3, uint32_t, PositionHash> first_vertex(positions.size());
+            std::vector<uint32_t> result(positions.size());
+            for (uint32_t v = 0; v < positions.size(); ++v) {
+                result[v] = first_vertex.try_emplace(positions[v], v).first->second;
+            }
+            return result;
+        }
+
+        /**
+        * @brief Classifies the points of the current triangles, and finds their border edges.
+        * @param border_edges Receives the edges between points that only one triangle has.
+        */
+        std::vector<VertexKind> classify(std::span<const uint32_t> triangles, std::span<const uint32_t> position_id,
+                                         std::span<const uint32_t> copies,
+                                         std::unordered_set<uint64_t> &border_edges) {
+            std::unordered_map<uint64_t, uint32_t> edges(triangles.size());
+            for (std::size_t i = 0; i < triangles.size(); i += 3) {
+                for (uint32_t k = 0; k < 3; ++k) {
+                    ++edges[edge_key(position_id[triangles[i + k]], position_id[triangles[i + (k + 1) % 3]])];
+                }
+            }
+            std::vector<VertexKind> kinds(position_id.size(), VertexKind::Manifold);
+            std::vector<uint8_t> border_degree(position_id.size(), 0);
+            border_edges.clear();
+            for (const auto &[key, count]: edges) {
+                const auto from = static_cast<uint32_t>(key >> 32);
+                const auto to   = static_cast<uint32_t>(key);
+                if (count > 1) {
+                    kinds[from] = kinds[to] = VertexKind::Locked;
+                } else if (!edges.contains(edge_key(to, from))) {
+                    border_edges.insert(key);
+                    ++border_degree[from];
+                    ++border_degree[to];
+                }
+            }
+            for (uint32_t p = 0; p < kinds.size(); ++p) {
+                if (copies[p] > 1 || border_degree[p] > 2) {
+                    kinds[p] = VertexKind::Locked;
+                } else if (border_degree[p] > 0 && kinds[p] == VertexKind::Manifold) {
+                    kinds[p] = VertexKind::Border;
+                }
+            }
+            return kinds;
+        }
+    } // namespace
+
+    uint32_t LodGeneration::key() const {
+        if (levels == 0) {
+            return 0;
+        }
+        RG_GUARANTEE(levels <= MAX_LEVELS, "At most {} levels of detail fit the key", MAX_LEVELS);
+        // The reduction in thousandths and the error in ten-thousandths.
+        return levels | static_cast<uint32_t>(std::lround(reduction * 1000.0f)) % 1024u << 4 |
+               static_cast<uint32_t>(std::lround(max_error * 10000.0f)) << 14;
+    }
+
+    std::vector<uint32_t> MeshSimplifier::simplify(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+                                                   std::size_t target_index_count, float target_error,
+                                                   float *result_error) {
+        std::vector<uint32_t> result(indices.begin(), indices.end());
+        if (result_error) {
+            *result_error = 0.0f;
+        }
+        if (vertices.empty() || result.size() % 3 != 0 || result.size() <= target_index_count) {
+            return result;
+        }
+
+        // The errors are computed in the unit cube of the mesh, so the quadrics keep their precision in floats.
+        graphics::BoundingBox box;
+        for (const auto &vertex: vertices) {
+            box.expand(vertex.Position);
+        }
+        const glm::vec3 size = box.max - box.min;
+        const float extent   = std::max({size.x, size.y, size.z, std::numeric_limits<float>::min()});
+        std::vector<glm::vec3> positions(vertices.size());
+        for (std::size_t v = 0; v < vertices.size(); ++v) {
+            positions[v] = (vertices[v].Position - box.min) / extent;
+        }
+        const float error_limit = (target_error / extent) * (target_error / extent);
+
+        const std::vector<uint32_t> position_id = position_ids(positions);
+        std::vector<uint32_t> copies(vertices.size(), 0);
+        for (const auto id: position_id) {
+            ++copies[id];
+        }
+
+        std::unordered_set<uint64_t> border_edges;
+        std::vector<VertexKind> kinds = classify(result, position_id, copies, border_edges);
+
+        // The quadrics belong to the points, so the vertices split on a seam share theirs.
+        std::vector<Quadric> quadrics(vertices.size());
+        for (std::size_t i = 0; i < result.size(); i += 3) {
+            const glm::vec3 &p0 = positions[result[i]];
+            const glm::vec3 &p1 = positions[result[i + 1]];
+            const glm::vec3 &p2 = positions[result[i + 2]];
+            glm::vec3 normal    = glm::cross(p1 - p0, p2 - p0);
+            const float length  = glm::length(normal);
+            if (length == 0.0f) {
+                continue;
+            }
+            normal /= length;
+            const Quadric plane = Quadric::plane(normal, -glm::dot(normal, p0), length * 0.5f);
+            for (uint32_t k = 0; k < 3; ++k) {
+                quadrics[position_id[result[i + k]]] += plane;
+                const uint32_t from = position_id[result[i + k]];
+                const uint32_t to   = position_id[result[i + (k + 1) % 3]];
+                if (border_edges.contains(edge_key(from, to))) {
+                    const glm::vec3 edge = positions[to] - positions[from];
+                    glm::vec3 border_normal = glm::cross(edge, normal);
+                    const float edge_length = glm::length(border_normal);
+                    if (edge_length > 0.0f) {
+                        border_normal /= edge_length;
+                        const Quadric border = Quadric::plane(border_normal, -glm::dot(border_normal, positions[from]),
+                                                              edge_length * edge_length * BORDER_WEIGHT);
+                        quadrics[from] += border;
+                        quadrics[to] += border;
+                    }
+                }
+            }
+        }
+
+        struct Collapse {
+            uint32_t from;
+            uint32_t to;
+            float error;
+        };
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> remap(vertices.size());
+        std::vector<uint8_t> touched(vertices.size());
+        std::vector<uint32_t> adjacency_offsets(vertices.size() + 1);
+        std::vector<uint32_t> adjacency;
+        float max_error = 0.0f;
+
+        auto can_collapse = [&](uint32_t from, uint32_t to) {
+            const uint32_t from_point = position_id[from];
+            const uint32_t to_point   = position_id[to];
+            if (from_point == to_point) {
+                return false;
+            }
+            switch (kinds[from_point]) {
+            case VertexKind::Manifold: return true;
+            case VertexKind::Border: return border_edges.contains(edge_key(from_point, to_point)) ||
+                                            border_edges.contains(edge_key(to_point, from_point));
+            default: return false;
+            }
+        };
+
+        // Each pass collapses the cheapest edges whose vertices no other collapse of the pass touched,
+        // then rewrites the triangles and drops the degenerate ones.
+        while (result.size() > target_index_count) {
+            collapses.clear();
+            for (std::size_t i = 0; i < result.size(); i += 3) {
+                for (uint32_t k = 0; k < 3; ++k) {
+                    const uint32_t a = result[i + k];
+                    const uint32_t b = result[i + (k + 1) % 3];
+                    for (const auto &[from, to]: {std::pair(a, b), std::pair(b, a)}) {
+                        if (!can_collapse(from, to)) {
+                            continue;
+                        }
+                        Quadric merged = quadrics[position_id[from]];
+                        merged += quadrics[position_id[to]];
+                        const float error = merged.error(positions[to]);
+                        if (error <= error_limit) {
+                            collapses.push_back(Collapse{from, to, error});
+                        }
+                    }
+                }
+            }
+            if (collapses.empty()) {
+                break;
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+                return a.error < b.error;
+            });
+
+            // The triangles of each vertex, for the flip test.
+            std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+            for (const auto index: result) {
+                ++adjacency_offsets[index + 1];
+            }
+            std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(), adjacency_offsets.begin());
+            adjacency.resize(result.size());
+            {
+                std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+                for (std::size_t i = 0; i < result.size(); ++i) {
+                    adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+            std::iota(remap.begin(), remap.end(), 0);
+            std::fill(touched.begin(), touched.end(), 0);
+
+            auto flips = [&](uint32_t from, uint32_t to) {
+                for (uint32_t i = adjacency_offsets[from]; i < adjacency_offsets[from + 1]; ++i) {
+                    const uint32_t *triangle = &result[adjacency[i] * 3];
+                    glm::vec3 corners[3];
+                    glm::vec3 moved[3];
+                    bool has_to = false;
+                    for (uint32_t k = 0; k < 3; ++k) {
+                        const uint32_t corner = remap[triangle[k]];
+                        has_to |= corner == to;
+                        corners[k] = positions[corner];
+                        moved[k]   = corner == from ? positions[to] : corners[k];
+                    }
+                    if (has_to) {
+                        // The triangle collapses with the edge.
+                        continue;
+                    }
+                    const glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                    const glm::vec3 after  = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+                    if (glm::dot(before, after) < MIN_NORMAL_COSINE * glm::length(before) * glm::length(after)) {
+                        return true;
+                    }
+                }
+                return false;
+            };
+
+            const std::size_t target_triangles = target_index_count / 3;
+            std::size_t triangles              = result.size() / 3;
+            std::size_t collapsed              = 0;
+            for (const auto &collapse: collapses) {
+                if (triangles <= target_triangles) {
+                    break;
+                }
+                if (touched[collapse.from] || touched[collapse.to] || flips(collapse.from, collapse.to)) {
+                    continue;
+                }
+                remap[collapse.from]   = collapse.to;
+                touched[collapse.from] = touched[collapse.to] = 1;
+                quadrics[position_id[collapse.to]] += quadrics[position_id[collapse.from]];
+                max_error = std::max(max_error, collapse.error);
+                // An edge inside the mesh takes its two triangles with it, a border edge one.
+                triangles -= kinds[position_id[collapse.from]] == VertexKind::Border ? 1 : 2;
+                ++collapsed;
+            }
+            if (collapsed == 0) {
+                break;
+            }
+
+            std::size_t write = 0;
+            for (std::size_t i = 0; i < result.size(); i += 3) {
+                const uint32_t a = remap[result[i]];
+                const uint32_t b = remap[result[i + 1]];
+                const uint32_t c = remap[result[i + 2]];
+                if (position_id[a] == position_id[b] || position_id[b] == position_id[c] ||
+                    position_id[a] == position_id[c]) {
+                    continue;
+                }
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+            kinds = classify(result, position_id, copies, border_edges);
+        }
+
+        if (result_error) {
+            *result_error = std::sqrt(max_error) * extent;
+        }
+        return result;
+    }
+
+    std::vector<MeshLod> MeshSimplifier::generate_lods(std::span<const Vertex> vertices,
+                                                       std::vector<uint32_t> &indices, float radius,
+                                                       const LodGeneration &settings) {
+        const auto full_count = static_cast<uint32_t>(indices.size());
+        std::vector<MeshLod> lods{MeshLod{0, full_count, 0.0f}};
+        if (radius <= 0.0f || full_count % 3 != 0) {
+            return lods;
+        }
+        // Every level is simplified from the full mesh, so its error is measured against the full mesh too.
+        const std::vector<uint32_t> full(indices.begin(), indices.end());
+        std::size_t previous_count = full_count;
+        float target_fraction      = 1.0f;
+        for (uint32_t level = 1; level <= settings.levels; ++level) {
+            target_fraction *= settings.reduction;
+            const auto target_count = static_cast<std::size_t>(static_cast<float>(full_count) * target_fraction) / 3 * 3;
+            float error             = 0.0f;
+            auto simplified = simplify(vertices, full, target_count, settings.max_error * radius, &error);
+            if (simplified.empty() || simplified.size() * 20 > previous_count * 19) {
+                break;
+            }
+            MeshOptimizer::optimize_vertex_cache(simplified, static_cast<uint32_t>(vertices.size()));
+            lods.push_back(MeshLod{
+                    static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), error / radius
+            });
+            indices.insert(indices.end(), simplified.begin(), simplified.end());
+            previous_count = simplified.size();
+        }
+        return lods;
+    }
+} // namespace engine::resources
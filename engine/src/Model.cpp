@@ -1,17 +1,101 @@
-
+#include <glad/glad.h>
+#include <engine/graphics/GeometryArena.hpp>
+#include <engine/graphics/GpuProfiler.hpp>
+#include <engine/graphics/GraphicsController.hpp>
+#include <engine/graphics/OpenGL.hpp>
 #include <engine/resources/Model.hpp>
+#include <cmath>
+#include <limits>
 
 namespace engine::resources {
 
     void Model::draw(const Shader *shader) {
+        RG_PROFILE_GPU_ZONE("GPU::Model::draw");
         for (auto &mesh: m_meshes) {
             mesh.draw(shader);
         }
     }
 
+    void Model::draw(const Shader *shader, const glm::mat4 &transform) {
+        RG_PROFILE_GPU_ZONE("GPU::Model::draw");
+        core::Controller::get<graphics::GraphicsController>()->set_object_uniforms(shader, transform);
+        for (auto &mesh: m_meshes) {
+            mesh.draw(shader);
+        }
+    }
+
+    void Model::draw(const Shader *shader, const glm::mat4 &transform, const glm::vec3 &camera_position,
+                     const graphics::PerspectiveMatrixParams &perspective) {
+        RG_PROFILE_GPU_ZONE("GPU::Model::draw");
+        core::Controller::get<graphics::GraphicsController>()->set_object_uniforms(shader, transform);
+        const uint32_t lod = select_lod(screen_size(transform, camera_position, perspective));
+        for (auto &mesh: m_meshes) {
+            mesh.draw(shader, lod);
+        }
+    }
+
+    float Model::screen_size(const glm::mat4 &transform, const glm::vec3 &camera_position,
+                             const graphics::PerspectiveMatrixParams &perspective) const {
+        const auto sphere    = m_bounds.sphere.transformed(transform);
+        const float distance = glm::length(sphere.center - camera_position);
+        if (distance <= sphere.radius) {
+            return std::numeric_limits<float>::infinity();
+        }
+        // The projected diameter over the height of the view volume at the distance of the center, 2 * d * tan(fov / 2).
+        return sphere.radius / (distance * std::tan(perspective.FOV * 0.5f));
+    }
+
+    uint32_t Model::select_lod(float screen_size) const {
+        uint32_t lod = 0;
+        while (lod < m_lod_screen_sizes.size() && screen_size < m_lod_screen_sizes[lod]) {
+            ++lod;
+        }
+        return lod;
+    }
+
+    uint32_t Model::lod_count() const {
+        uint32_t result = 1;
+        for (const auto &mesh: m_meshes) {
+            result = std::max(result, mesh.lod_count());
+        }
+        return result;
+    }
+
+    void Model::draw_instanced(const Shader *shader, std::span<const glm::mat4> transforms) {
+        if (transforms.empty() || m_meshes.empty()) {
+            return;
+        }
+        RG_PROFILE_GPU_ZONE("GPU::Model::draw_instanced");
+        if (m_instance_vbo == 0) {
+            CHECKED_GL_CALL(glGenBuffers, 1, &m_instance_vbo);
+        }
+        CHECKED_GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, m_instance_vbo);
+        if (transforms.size() > m_instance_capacity) {
+            // Grow geometrically so that a slowly growing instance count doesn't change the storage size every frame.
+            m_instance_capacity = std::max(transforms.size(), m_instance_capacity * 2);
+        }
+        // Orphan the previous storage, so the upload doesn't wait for the draws still reading the last transforms.
+        CHECKED_GL_CALL(glBufferData, GL_ARRAY_BUFFER, m_instance_capacity * sizeof(glm::mat4), nullptr,
+                        GL_STREAM_DRAW);
+        CHECKED_GL_CALL(glBufferSubData, GL_ARRAY_BUFFER, 0, transforms.size_bytes(), transforms.data());
+        CHECKED_GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, 0);
+
+        for (auto &mesh: m_meshes) {
+            // The vertex array is shared with other models, which may have attached their own instance buffer since.
+            mesh.attach_instance_buffer(m_instance_vbo);
+            mesh.draw_instanced(shader, static_cast<uint32_t>(transforms.size()));
+        }
+    }
+
     void Model::destroy() {
         for (auto &mesh: m_meshes) {
             mesh.destroy();
         }
+        if (m_instance_vbo != 0) {
+            graphics::GeometryArena::instance()->detach_instance_buffer(m_instance_vbo);
+            CHECKED_GL_CALL(glDeleteBuffers, 1, &m_instance_vbo);
+            m_instance_vbo      = 0;
+            m_instance_capacity = 0;
+        }
     }
 }
@@ -1,7 +1,8 @@
 #include <glad/glad.h>
 #include <filesystem>
+#include <algorithm>
 #include <array>
-#include <stb_image.h>
+#include <cstring>
 #include <engine/graphics/OpenGL.hpp>
 #include <engine/resources/Shader.hpp>
 #include <engine/resources/ShaderCompiler.hpp>
@@ -10,6 +11,213 @@
 #include <engine/util/Utils.hpp>
 
 namespace engine::graphics {
+    namespace {
+        constexpr uint32_t UNKNOWN = ~uint32_t{0};
+        constexpr uint32_t SHADOWED_TEXTURE_UNITS = 32;
+        constexpr std::array<uint32_t, 4> SHADOWED_TEXTURE_TARGETS = {
+                GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BUFFER
+        };
+        constexpr std::array<uint32_t, 5> SHADOWED_CAPABILITIES = {
+                GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_STENCIL_TEST, GL_SCISSOR_TEST
+        };
+        constexpr uint32_t SHADOWED_UNIFORM_BINDINGS = UNIFORM_BLOCK_NAMES.size();
+
+        // OpenGL 4.3, not in the 3.3 core glad loader.
+        constexpr GLenum DRAW_INDIRECT_BUFFER = 0x8F3F;
+        using MultiDrawElementsIndirect = void (APIENTRYP)(GLenum mode, GLenum type, const void *indirect,
+                                                           GLsizei drawcount, GLsizei stride);
+        MultiDrawElementsIndirect g_multi_draw_elements_indirect = nullptr;
+
+        // GL_EXT_texture_compression_s3tc and OpenGL 4.2, not in the 3.3 core glad loader.
+        constexpr GLenum COMPRESSED_RGBA_S3TC_DXT1 = 0x83F1;
+        constexpr GLenum COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+        constexpr GLenum COMPRESSED_RGBA_BPTC_UNORM = 0x8E8C;
+
+        void stream_buffer(GLenum target, uint32_t buffer, std::span<const std::byte> data) {
+            CHECKED_GL_CALL(glBindBuffer, target, buffer);
+            CHECKED_GL_CALL(glBufferData, target, static_cast<GLsizeiptr>(data.size()), data.data(), GL_STREAM_DRAW);
+        }
+
+        struct UniformBufferRange {
+            uint32_t buffer{UNKNOWN};
+            std::size_t offset{0};
+            std::size_t size{0};
+
+            bool operator==(const UniformBufferRange &) const = default;
+        };
+
+        /**
+        * @brief The OpenGL state as last set through the OpenGL class. UNKNOWN when it may have changed elsewhere.
+        * The context is only used on the main thread, so the shadow is too.
+        */
+        struct StateShadow {
+            uint32_t program{UNKNOWN};
+            uint32_t vao{UNKNOWN};
+            uint32_t active_unit{UNKNOWN};
+            uint32_t depth_func{UNKNOWN};
+            std::array<std::array<uint32_t, SHADOWED_TEXTURE_TARGETS.size()>, SHADOWED_TEXTURE_UNITS> textures;
+            std::array<uint32_t, SHADOWED_CAPABILITIES.size()> capabilities;
+            std::array<UniformBufferRange, SHADOWED_UNIFORM_BINDINGS> uniform_buffers;
+
+            StateShadow() {
+                invalidate();
+            }
+
+            void invalidate() {
+                program     = UNKNOWN;
+                vao         = UNKNOWN;
+                active_unit = UNKNOWN;
+                depth_func  = UNKNOWN;
+                for (auto &unit: textures) {
+                    unit.fill(UNKNOWN);
+                }
+                capabilities.fill(UNKNOWN);
+                uniform_buffers.fill(UniformBufferRange{});
+            }
+        };
+
+        StateShadow g_state;
+        OpenGL::StateStats g_state_stats;
+
+        template<std::size_t N>
+        std::size_t index_of(const std::array<uint32_t, N> &values, uint32_t value) {
+            return static_cast<std::size_t>(std::find(values.begin(), values.end(), value) - values.begin());
+        }
+
+        bool is_sampler_type(uint32_t type) {
+            switch (type) {
+            case GL_SAMPLER_1D:
+            case GL_SAMPLER_2D:
+            case GL_SAMPLER_3D:
+            case GL_SAMPLER_CUBE:
+            case GL_SAMPLER_1D_SHADOW:
+            case GL_SAMPLER_2D_SHADOW:
+            case GL_SAMPLER_1D_ARRAY:
+            case GL_SAMPLER_2D_ARRAY:
+            case GL_SAMPLER_1D_ARRAY_SHADOW:
+            case GL_SAMPLER_2D_ARRAY_SHADOW:
+            case GL_SAMPLER_CUBE_SHADOW:
+            case GL_SAMPLER_2D_MULTISAMPLE:
+            case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+            case GL_SAMPLER_2D_RECT:
+            case GL_SAMPLER_2D_RECT_SHADOW:
+            case GL_SAMPLER_BUFFER:
+            case GL_INT_SAMPLER_2D:
+            case GL_INT_SAMPLER_3D:
+            case GL_INT_SAMPLER_CUBE:
+            case GL_INT_SAMPLER_2D_ARRAY:
+            case GL_UNSIGNED_INT_SAMPLER_2D:
+            case GL_UNSIGNED_INT_SAMPLER_3D:
+            case GL_UNSIGNED_INT_SAMPLER_CUBE:
+            case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY: return true;
+            default: return false;
+            }
+        }
+    } // namespace
+
+    bool OpenGL::use_program(uint32_t program) {
+        if (g_state.program == program) {
+            ++g_state_stats.program_binds_elided;
+            return false;
+        }
+        CHECKED_GL_CALL(glUseProgram, program);
+        g_state.program = program;
+        ++g_state_stats.program_binds;
+        return true;
+    }
+
+    bool OpenGL::bind_vertex_array(uint32_t vao) {
+        if (g_state.vao == vao) {
+            ++g_state_stats.vao_binds_elided;
+            return false;
+        }
+        CHECKED_GL_CALL(glBindVertexArray, vao);
+        g_state.vao = vao;
+        ++g_state_stats.vao_binds;
+        return true;
+    }
+
+    bool OpenGL::bind_texture(uint32_t unit, uint32_t target, uint32_t texture) {
+        const std::size_t target_index = index_of(SHADOWED_TEXTURE_TARGETS, target);
+        const bool shadowed            = unit < SHADOWED_TEXTURE_UNITS && target_index < SHADOWED_TEXTURE_TARGETS.size();
+        if (shadowed && g_state.textures[unit][target_index] == texture) {
+            ++g_state_stats.texture_binds_elided;
+            return false;
+        }
+        if (g_state.active_unit != unit) {
+            CHECKED_GL_CALL(glActiveTexture, GL_TEXTURE0 + unit);
+            g_state.active_unit = unit;
+            ++g_state_stats.active_unit_changes;
+        } else {
+            ++g_state_stats.active_unit_changes_elided;
+        }
+        CHECKED_GL_CALL(glBindTexture, target, texture);
+        if (shadowed) {
+            g_state.textures[unit][target_index] = texture;
+        }
+        ++g_state_stats.texture_binds;
+        return true;
+    }
+
+    bool OpenGL::bind_uniform_buffer(UniformBinding binding, uint32_t buffer, std::size_t offset, std::size_t size) {
+        const auto index    = static_cast<uint32_t>(binding);
+        const bool shadowed = index < SHADOWED_UNIFORM_BINDINGS;
+        const UniformBufferRange range{buffer, offset, size};
+        if (shadowed && g_state.uniform_buffers[index] == range) {
+            ++g_state_stats.uniform_buffer_binds_elided;
+            return false;
+        }
+        CHECKED_GL_CALL(glBindBufferRange, GL_UNIFORM_BUFFER, index, buffer, static_cast<GLintptr>(offset),
+                        static_cast<GLsizeiptr>(size));
+        if (shadowed) {
+            g_state.uniform_buffers[index] = range;
+        }
+        ++g_state_stats.uniform_buffer_binds;
+        return true;
+    }
+
+    bool OpenGL::set_depth_func(uint32_t func) {
+        if (g_state.depth_func == func) {
+            ++g_state_stats.depth_func_changes_elided;
+            return false;
+        }
+        CHECKED_GL_CALL(glDepthFunc, func);
+        g_state.depth_func = func;
+        ++g_state_stats.depth_func_changes;
+        return true;
+    }
+
+    bool OpenGL::set_capability(uint32_t capability, bool enabled) {
+        const std::size_t index = index_of(SHADOWED_CAPABILITIES, capability);
+        const bool shadowed     = index < SHADOWED_CAPABILITIES.size();
+        if (shadowed && g_state.capabilities[index] == static_cast<uint32_t>(enabled)) {
+            ++g_state_stats.capability_changes_elided;
+            return false;
+        }
+        if (enabled) {
+            CHECKED_GL_CALL(glEnable, capability);
+        } else {
+            CHECKED_GL_CALL(glDisable, capability);
+        }
+        if (shadowed) {
+            g_state.capabilities[index] = static_cast<uint32_t>(enabled);
+        }
+        ++g_state_stats.capability_changes;
+        return true;
+    }
+
+    void OpenGL::invalidate_state() {
+        g_state.invalidate();
+    }
+
+    const OpenGL::StateStats &OpenGL::state_stats() {
+        return g_state_stats;
+    }
+
+    void OpenGL::reset_state_stats() {
+        g_state_stats = StateStats{};
+    }
+
     int32_t OpenGL::shader_type_to_opengl_type(resources::ShaderType type) {
         switch (type) {
         case resources::ShaderType::Vertex: return GL_VERTEX_SHADER;
@@ -20,33 +228,121 @@ namespace engine::graphics {
     }
 
     uint32_t OpenGL::generate_texture(const std::filesystem::path &path, bool flip_uvs) {
+        return generate_texture(resources::Image::load(path, flip_uvs));
+    }
+
+    uint32_t OpenGL::generate_texture(const resources::Image &image) {
         uint32_t texture_id = 0;
         CHECKED_GL_CALL(glGenTextures, 1, &texture_id);
+        int32_t format = texture_format(image.channels);
 
-        int32_t width, height, nr_components;
-        stbi_set_flip_vertically_on_load(flip_uvs);
-        uint8_t *data = stbi_load(path.c_str(), &width, &height, &nr_components, 0);
-        defer {
-            stbi_image_free(data);
-        };
-        if (data) {
-            int32_t format = texture_format(nr_components);
+        bind_texture(0, GL_TEXTURE_2D, texture_id);
+        CHECKED_GL_CALL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+        CHECKED_GL_CALL(glTexImage2D, GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE,
+                        image.pixels.data());
+        CHECKED_GL_CALL(glGenerateMipmap, GL_TEXTURE_2D);
+
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return texture_id;
+    }
 
-            CHECKED_GL_CALL(glBindTexture, GL_TEXTURE_2D, texture_id);
-            CHECKED_GL_CALL(glTexImage2D, GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            CHECKED_GL_CALL(glGenerateMipmap, GL_TEXTURE_2D);
+    uint32_t OpenGL::generate_texture(const resources::CompressedImage &image) {
+        RG_GUARANTEE(supported_block_formats() & 1u << static_cast<uint32_t>(image.format),
+                     "The OpenGL context doesn't support {} textures.", resources::block_format_name(image.format));
+        uint32_t texture_id = 0;
+        CHECKED_GL_CALL(glGenTextures, 1, &texture_id);
+        const GLenum format = compressed_texture_format(image.format);
 
-            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        } else {
-            throw util::EngineError(util::EngineError::Type::AssetLoadingError,
-                                    std::format("Failed to load texture {}", path.string()));
+        bind_texture(0, GL_TEXTURE_2D, texture_id);
+        for (std::size_t level = 0; level < image.levels.size(); ++level) {
+            const auto &mip  = image.levels[level];
+            const auto blocks = image.level_data(level);
+            CHECKED_GL_CALL(glCompressedTexImage2D, GL_TEXTURE_2D, static_cast<GLint>(level), format, mip.width,
+                            mip.height, 0, static_cast<GLsizei>(blocks.size()), blocks.data());
+        }
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size() - 1));
+
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return texture_id;
+    }
+
+    uint32_t OpenGL::generate_texture(const resources::BakedTexture &texture) {
+        const auto block_format = texture.block_format();
+        RG_GUARANTEE(!block_format.has_value() || supported_block_formats() & 1u << static_cast<uint32_t>(*block_format),
+                     "The OpenGL context doesn't support {} textures.", resources::block_format_name(*block_format));
+        uint32_t texture_id = 0;
+        CHECKED_GL_CALL(glGenTextures, 1, &texture_id);
+
+        bind_texture(0, GL_TEXTURE_2D, texture_id);
+        CHECKED_GL_CALL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+        for (uint32_t level = 0; level < texture.level_count(); ++level) {
+            const auto mip = texture.level(level);
+            if (block_format.has_value()) {
+                CHECKED_GL_CALL(glCompressedTexImage2D, GL_TEXTURE_2D, static_cast<GLint>(level),
+                                compressed_texture_format(*block_format), mip.width, mip.height, 0,
+                                static_cast<GLsizei>(mip.data.size()), mip.data.data());
+            } else {
+                const int32_t format = texture_format(texture.channels());
+                CHECKED_GL_CALL(glTexImage2D, GL_TEXTURE_2D, static_cast<GLint>(level), format, mip.width, mip.height, 0,
+                                format, GL_UNSIGNED_BYTE, mip.data.data());
+            }
         }
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture.level_count() - 1));
+
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         return texture_id;
     }
 
+    uint32_t OpenGL::compressed_texture_format(resources::BlockFormat format) {
+        switch (format) {
+        // The BC1 blocks with punch-through alpha are transparent, as in the file.
+        case resources::BlockFormat::BC1: return COMPRESSED_RGBA_S3TC_DXT1;
+        case resources::BlockFormat::BC3: return COMPRESSED_RGBA_S3TC_DXT5;
+        case resources::BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+        case resources::BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+        case resources::BlockFormat::BC7: return COMPRESSED_RGBA_BPTC_UNORM;
+        default: RG_SHOULD_NOT_REACH_HERE("Unknown block format {}", static_cast<uint32_t>(format));
+        }
+    }
+
+    uint32_t OpenGL::supported_block_formats() {
+        static const uint32_t supported = [] {
+            using resources::BlockFormat;
+            uint32_t formats = 1u << static_cast<uint32_t>(BlockFormat::BC4) |
+                               1u << static_cast<uint32_t>(BlockFormat::BC5);
+            int32_t major = 0;
+            int32_t minor = 0;
+            CHECKED_GL_CALL(glGetIntegerv, GL_MAJOR_VERSION, &major);
+            CHECKED_GL_CALL(glGetIntegerv, GL_MINOR_VERSION, &minor);
+            if (major > 4 || (major == 4 && minor >= 2)) {
+                formats |= 1u << static_cast<uint32_t>(BlockFormat::BC7);
+            }
+            int32_t extension_count = 0;
+            CHECKED_GL_CALL(glGetIntegerv, GL_NUM_EXTENSIONS, &extension_count);
+            for (int32_t i = 0; i < extension_count; ++i) {
+                const std::string_view extension = reinterpret_cast<const char *>(
+                        CHECKED_GL_CALL(glGetStringi, GL_EXTENSIONS, static_cast<GLuint>(i)));
+                if (extension == "GL_EXT_texture_compression_s3tc") {
+                    formats |= 1u << static_cast<uint32_t>(BlockFormat::BC1) |
+                            1u << static_cast<uint32_t>(BlockFormat::BC3);
+                } else if (extension == "GL_ARB_texture_compression_bptc") {
+                    formats |= 1u << static_cast<uint32_t>(BlockFormat::BC7);
+                }
+            }
+            return formats;
+        }();
+        return supported;
+    }
+
     int32_t OpenGL::texture_format(int32_t number_of_channels) {
         switch (number_of_channels) {
         case 1: return GL_RED;
@@ -69,11 +365,12 @@ namespace engine::graphics {
         uint32_t skybox_vbo = 0;
         CHECKED_GL_CALL(glGenVertexArrays, 1, &skybox_vao);
         CHECKED_GL_CALL(glGenBuffers, 1, &skybox_vbo);
-        CHECKED_GL_CALL(glBindVertexArray, skybox_vao);
+        bind_vertex_array(skybox_vao);
         CHECKED_GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, skybox_vbo);
         CHECKED_GL_CALL(glBufferData, GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
         CHECKED_GL_CALL(glEnableVertexAttribArray, 0);
         CHECKED_GL_CALL(glVertexAttribPointer, 0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0); // NOLINT
+        bind_vertex_array(0);
         return skybox_vao;
     }
 
@@ -98,6 +395,196 @@ namespace engine::graphics {
         return infoLog;
     }
 
+    bool OpenGL::shader_program_linked_successfully(ShaderProgramId program_id) {
+        int success;
+        CHECKED_GL_CALL(glGetProgramiv, program_id, GL_LINK_STATUS, &success);
+        return success;
+    }
+
+    std::string OpenGL::get_link_error_message(ShaderProgramId program_id) {
+        char infoLog[512];
+        CHECKED_GL_CALL(glGetProgramInfoLog, program_id, 512, nullptr, infoLog);
+        return infoLog;
+    }
+
+    resources::UniformLocations OpenGL::get_active_uniforms(ShaderProgramId program_id) {
+        resources::UniformLocations result;
+        int32_t uniform_count = 0;
+        int32_t max_name_length = 0;
+        CHECKED_GL_CALL(glGetProgramiv, program_id, GL_ACTIVE_UNIFORMS, &uniform_count);
+        CHECKED_GL_CALL(glGetProgramiv, program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+        std::string name(std::max(max_name_length, 1), '\0');
+        for (int32_t i = 0; i < uniform_count; ++i) {
+            int32_t name_length = 0;
+            int32_t array_size  = 0;
+            uint32_t type       = 0;
+            CHECKED_GL_CALL(glGetActiveUniform, program_id, i, static_cast<int32_t>(name.size()), &name_length,
+                            &array_size, &type, name.data());
+            std::string uniform_name(name.data(), name_length);
+            int32_t location = CHECKED_GL_CALL(glGetUniformLocation, program_id, uniform_name.c_str());
+            if (location == -1) {
+                continue;
+            }
+            result.emplace(uniform_name, location);
+            // Arrays are reported once as `name[0]`; register the base name and every element.
+            if (uniform_name.ends_with("[0]")) {
+                std::string base_name = uniform_name.substr(0, uniform_name.size() - 3);
+                result.emplace(base_name, location);
+                for (int32_t element = 1; element < array_size; ++element) {
+                    std::string element_name = std::format("{}[{}]", base_name, element);
+                    result.emplace(element_name,
+                                   CHECKED_GL_CALL(glGetUniformLocation, program_id, element_name.c_str()));
+                }
+            }
+        }
+        return result;
+    }
+
+    resources::SamplerUnits OpenGL::assign_sampler_units(ShaderProgramId program_id) {
+        resources::SamplerUnits result;
+        int32_t uniform_count   = 0;
+        int32_t max_name_length = 0;
+        CHECKED_GL_CALL(glGetProgramiv, program_id, GL_ACTIVE_UNIFORMS, &uniform_count);
+        CHECKED_GL_CALL(glGetProgramiv, program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+        std::string name(std::max(max_name_length, 1), '\0');
+        int32_t unit = 0;
+        use_program(program_id);
+        for (int32_t i = 0; i < uniform_count; ++i) {
+            int32_t name_length = 0;
+            int32_t array_size  = 0;
+            uint32_t type       = 0;
+            CHECKED_GL_CALL(glGetActiveUniform, program_id, i, static_cast<int32_t>(name.size()), &name_length,
+                            &array_size, &type, name.data());
+            if (!is_sampler_type(type)) {
+                continue;
+            }
+            std::string uniform_name(name.data(), name_length);
+            const bool is_array = uniform_name.ends_with("[0]");
+            if (is_array) {
+                uniform_name.resize(uniform_name.size() - 3);
+            }
+            for (int32_t element = 0; element < array_size; ++element) {
+                std::string element_name = is_array ? std::format("{}[{}]", uniform_name, element) : uniform_name;
+                int32_t location = CHECKED_GL_CALL(glGetUniformLocation, program_id, element_name.c_str());
+                if (location == -1) {
+                    continue;
+                }
+                if (unit == SHADOWED_TEXTURE_UNITS) {
+                    throw util::EngineError(util::EngineError::Type::ShaderCompilationError,
+                                            std::format("Shader program {} samples more than {} textures.",
+                                                        program_id, SHADOWED_TEXTURE_UNITS));
+                }
+                CHECKED_GL_CALL(glUniform1i, location, unit);
+                result.emplace(std::move(element_name), unit++);
+            }
+        }
+        return result;
+    }
+
+    uint32_t OpenGL::bind_uniform_blocks(ShaderProgramId program_id) {
+        uint32_t used_blocks = 0;
+        for (uint32_t binding = 0; binding < UNIFORM_BLOCK_NAMES.size(); ++binding) {
+            const std::string name(UNIFORM_BLOCK_NAMES[binding]);
+            const uint32_t block_index = CHECKED_GL_CALL(glGetUniformBlockIndex, program_id, name.c_str());
+            if (block_index == GL_INVALID_INDEX) {
+                continue;
+            }
+            CHECKED_GL_CALL(glUniformBlockBinding, program_id, block_index, binding);
+            used_blocks |= 1u << binding;
+        }
+        return used_blocks;
+    }
+
+    std::size_t OpenGL::uniform_buffer_offset_alignment() {
+        static const std::size_t alignment = [] {
+            int32_t value = 0;
+            CHECKED_GL_CALL(glGetIntegerv, GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+            return static_cast<std::size_t>(std::max(value, 1));
+        }();
+        return alignment;
+    }
+
+    uint32_t OpenGL::create_uniform_buffer(std::size_t size, std::span<const std::byte> data) {
+        uint32_t buffer = 0;
+        CHECKED_GL_CALL(glGenBuffers, 1, &buffer);
+        CHECKED_GL_CALL(glBindBuffer, GL_UNIFORM_BUFFER, buffer);
+        CHECKED_GL_CALL(glBufferData, GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_DYNAMIC_DRAW);
+        if (!data.empty()) {
+            CHECKED_GL_CALL(glBufferSubData, GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(std::min(size, data.size())),
+                            data.data());
+        }
+        return buffer;
+    }
+
+    void OpenGL::update_uniform_buffer(uint32_t buffer, std::span<const std::byte> data, std::size_t offset) {
+        CHECKED_GL_CALL(glBindBuffer, GL_UNIFORM_BUFFER, buffer);
+        CHECKED_GL_CALL(glBufferSubData, GL_UNIFORM_BUFFER, static_cast<GLintptr>(offset),
+                        static_cast<GLsizeiptr>(data.size()), data.data());
+    }
+
+    void OpenGL::stream_uniform_buffer(uint32_t buffer, std::span<const std::byte> data) {
+        stream_buffer(GL_UNIFORM_BUFFER, buffer, data);
+    }
+
+    void OpenGL::delete_buffer(uint32_t buffer) {
+        CHECKED_GL_CALL(glDeleteBuffers, 1, &buffer);
+        // The id can be reused by a new buffer, which the shadow would then think is already bound.
+        invalidate_state();
+    }
+
+    OpenGL::TextureBuffer OpenGL::create_texture_buffer(uint32_t internal_format) {
+        TextureBuffer texture_buffer;
+        CHECKED_GL_CALL(glGenBuffers, 1, &texture_buffer.buffer);
+        CHECKED_GL_CALL(glBindBuffer, GL_TEXTURE_BUFFER, texture_buffer.buffer);
+        CHECKED_GL_CALL(glGenTextures, 1, &texture_buffer.texture);
+        // Any unit will do, the binding only attaches the buffer to the texture.
+        bind_texture(0, GL_TEXTURE_BUFFER, texture_buffer.texture);
+        CHECKED_GL_CALL(glTexBuffer, GL_TEXTURE_BUFFER, internal_format, texture_buffer.buffer);
+        CHECKED_GL_CALL(glBindBuffer, GL_TEXTURE_BUFFER, 0);
+        return texture_buffer;
+    }
+
+    void OpenGL::stream_texture_buffer(const TextureBuffer &texture_buffer, std::span<const std::byte> data) {
+        // The texture keeps reading the same buffer object, so orphaning its storage doesn't need a new glTexBuffer.
+        stream_buffer(GL_TEXTURE_BUFFER, texture_buffer.buffer, data);
+    }
+
+    void OpenGL::delete_texture_buffer(TextureBuffer &texture_buffer) {
+        CHECKED_GL_CALL(glDeleteTextures, 1, &texture_buffer.texture);
+        CHECKED_GL_CALL(glDeleteBuffers, 1, &texture_buffer.buffer);
+        texture_buffer = {};
+        invalidate_state();
+    }
+
+    bool OpenGL::load_multi_draw_indirect(void *(*loader)(const char *name)) {
+        int32_t major = 0;
+        int32_t minor = 0;
+        CHECKED_GL_CALL(glGetIntegerv, GL_MAJOR_VERSION, &major);
+        CHECKED_GL_CALL(glGetIntegerv, GL_MINOR_VERSION, &minor);
+        g_multi_draw_elements_indirect = nullptr;
+        if (major > 4 || (major == 4 && minor >= 3)) {
+            g_multi_draw_elements_indirect = reinterpret_cast<MultiDrawElementsIndirect>(
+                    loader("glMultiDrawElementsIndirect"));
+        }
+        return g_multi_draw_elements_indirect != nullptr;
+    }
+
+    bool OpenGL::multi_draw_indirect_supported() {
+        return g_multi_draw_elements_indirect != nullptr;
+    }
+
+    void OpenGL::stream_indirect_buffer(uint32_t buffer, std::span<const DrawElementsIndirectCommand> commands) {
+        stream_buffer(DRAW_INDIRECT_BUFFER, buffer, std::as_bytes(commands));
+    }
+
+    void OpenGL::multi_draw_elements_indirect(uint32_t buffer, std::size_t first_command, uint32_t command_count) {
+        RG_GUARANTEE(g_multi_draw_elements_indirect != nullptr, "glMultiDrawElementsIndirect isn't loaded.");
+        CHECKED_GL_CALL(glBindBuffer, DRAW_INDIRECT_BUFFER, buffer);
+        CHECKED_GL_CALL(g_multi_draw_elements_indirect, GL_TRIANGLES, GL_UNSIGNED_INT,
+                        reinterpret_cast<const void *>(first_command * sizeof(DrawElementsIndirectCommand)),
+                        static_cast<GLsizei>(command_count), 0);
+    }
+
     std::string_view gl_call_error_description(GLenum error) {
         switch (error) {
         case GL_NO_ERROR: return
@@ -128,30 +615,36 @@ namespace engine::graphics {
     uint32_t face_index(std::string_view name);
 
     uint32_t OpenGL::load_skybox_textures(const std::filesystem::path &path, bool flip_uvs) {
+        return generate_cubemap(decode_skybox_faces(path, flip_uvs));
+    }
+
+    std::array<resources::Image, 6> OpenGL::decode_skybox_faces(const std::filesystem::path &path, bool flip_uvs) {
         RG_GUARANTEE(std::filesystem::is_directory(path),
                      "Directory '{}' doesn't exist. Please specify path to be a directory to where the cubemap textures are located. The cubemap textures should be named: right, left, top, bottom, front, back; by their respective faces in the cubemap.",
                      path.string())
         ;
+        std::array<resources::Image, 6> faces;
+        for (const auto &file: std::filesystem::directory_iterator(path)) {
+            uint32_t i = face_index(file.path().stem().c_str());
+            faces[i]   = resources::Image::load(absolute(file), flip_uvs);
+        }
+        for (const auto &face: faces) {
+            RG_GUARANTEE(!face.pixels.empty(),
+                         "Skybox '{}' is missing a face. The cubemap textures should be named: right, left, top, bottom, front, back.",
+                         path.string());
+        }
+        return faces;
+    }
+
+    uint32_t OpenGL::generate_cubemap(const std::array<resources::Image, 6> &faces) {
         uint32_t texture_id;
         CHECKED_GL_CALL(glGenTextures, 1, &texture_id);
-        CHECKED_GL_CALL(glBindTexture, GL_TEXTURE_CUBE_MAP, texture_id);
-
-        int width, height, nr_channels;
-        for (const auto &file: std::filesystem::directory_iterator(path)) {
-            stbi_set_flip_vertically_on_load(flip_uvs);
-            unsigned char *data = stbi_load(absolute(file).c_str(), &width, &height, &nr_channels, 0);
-            defer {
-                stbi_image_free(data);
-            };
-            if (data) {
-                uint32_t i = face_index(file.path().stem().c_str());
-                CHECKED_GL_CALL(glTexImage2D, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB,
-                                GL_UNSIGNED_BYTE,
-                                data);
-            } else {
-                throw util::EngineError(util::EngineError::Type::AssetLoadingError,
-                                        std::format("Failed to load skybox texture {}", path.string()));
-            }
+        bind_texture(0, GL_TEXTURE_CUBE_MAP, texture_id);
+        CHECKED_GL_CALL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+        for (uint32_t i = 0; i < faces.size(); ++i) {
+            int32_t format = texture_format(faces[i].channels);
+            CHECKED_GL_CALL(glTexImage2D, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, faces[i].width,
+                            faces[i].height, 0, format, GL_UNSIGNED_BYTE, faces[i].pixels.data());
         }
         CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -163,17 +656,111 @@ namespace engine::graphics {
     }
 
     void OpenGL::enable_depth_testing() {
-        CHECKED_GL_CALL(glEnable, GL_DEPTH_TEST);
+        set_capability(GL_DEPTH_TEST, true);
     }
 
     void OpenGL::disable_depth_testing() {
-        CHECKED_GL_CALL(glDisable, GL_DEPTH_TEST);
+        set_capability(GL_DEPTH_TEST, false);
     }
 
     void OpenGL::clear_buffers() {
         CHECKED_GL_CALL(glClear, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
     }
 
+    void OpenGL::finish() {
+        glFinish();
+    }
+
+    OpenGL::Framebuffer OpenGL::create_framebuffer(int32_t width, int32_t height) {
+        Framebuffer framebuffer{.width = width, .height = height};
+        CHECKED_GL_CALL(glGenFramebuffers, 1, &framebuffer.fbo);
+        CHECKED_GL_CALL(glBindFramebuffer, GL_FRAMEBUFFER, framebuffer.fbo);
+
+        CHECKED_GL_CALL(glGenRenderbuffers, 1, &framebuffer.color);
+        CHECKED_GL_CALL(glBindRenderbuffer, GL_RENDERBUFFER, framebuffer.color);
+        CHECKED_GL_CALL(glRenderbufferStorage, GL_RENDERBUFFER, GL_RGBA8, width, height);
+        CHECKED_GL_CALL(glFramebufferRenderbuffer, GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                        framebuffer.color);
+
+        CHECKED_GL_CALL(glGenRenderbuffers, 1, &framebuffer.depth_stencil);
+        CHECKED_GL_CALL(glBindRenderbuffer, GL_RENDERBUFFER, framebuffer.depth_stencil);
+        CHECKED_GL_CALL(glRenderbufferStorage, GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        CHECKED_GL_CALL(glFramebufferRenderbuffer, GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+                        framebuffer.depth_stencil);
+        CHECKED_GL_CALL(glBindRenderbuffer, GL_RENDERBUFFER, 0);
+
+        const uint32_t status = CHECKED_GL_CALL(glCheckFramebufferStatus, GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            delete_framebuffer(framebuffer);
+            throw util::EngineError(util::EngineError::Type::OpenGLError,
+                                    std::format("Offscreen framebuffer {}x{} is incomplete, status: {:#x}.",
+                                                width, height, status));
+        }
+        return framebuffer;
+    }
+
+    void OpenGL::delete_framebuffer(Framebuffer &framebuffer) {
+        CHECKED_GL_CALL(glBindFramebuffer, GL_FRAMEBUFFER, 0);
+        CHECKED_GL_CALL(glDeleteRenderbuffers, 1, &framebuffer.color);
+        CHECKED_GL_CALL(glDeleteRenderbuffers, 1, &framebuffer.depth_stencil);
+        CHECKED_GL_CALL(glDeleteFramebuffers, 1, &framebuffer.fbo);
+        framebuffer = Framebuffer{};
+    }
+
+    resources::Image OpenGL::read_pixels(int32_t width, int32_t height) {
+        resources::Image image{.width = width, .height = height, .channels = 4, .pixels = {}};
+        const std::size_t row_size = static_cast<std::size_t>(width) * 4;
+        image.pixels.resize(row_size * height);
+        CHECKED_GL_CALL(glPixelStorei, GL_PACK_ALIGNMENT, 1);
+        CHECKED_GL_CALL(glReadPixels, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+        // OpenGL returns the bottom row first.
+        std::vector<uint8_t> row(row_size);
+        for (int32_t top = 0, bottom = height - 1; top < bottom; ++top, --bottom) {
+            uint8_t *top_row    = image.pixels.data() + top * row_size;
+            uint8_t *bottom_row = image.pixels.data() + bottom * row_size;
+            std::memcpy(row.data(), top_row, row_size);
+            std::memcpy(top_row, bottom_row, row_size);
+            std::memcpy(bottom_row, row.data(), row_size);
+        }
+        return image;
+    }
+
+    int32_t OpenGL::timestamp_query_bits() {
+        int32_t bits = 0;
+        CHECKED_GL_CALL(glGetQueryiv, GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+        return bits;
+    }
+
+    void OpenGL::generate_queries(std::span<uint32_t> queries) {
+        CHECKED_GL_CALL(glGenQueries, static_cast<GLsizei>(queries.size()), queries.data());
+    }
+
+    void OpenGL::delete_queries(std::span<const uint32_t> queries) {
+        CHECKED_GL_CALL(glDeleteQueries, static_cast<GLsizei>(queries.size()), queries.data());
+    }
+
+    void OpenGL::query_timestamp(uint32_t query) {
+        CHECKED_GL_CALL(glQueryCounter, query, GL_TIMESTAMP);
+    }
+
+    bool OpenGL::query_result_available(uint32_t query) {
+        uint32_t available = GL_FALSE;
+        CHECKED_GL_CALL(glGetQueryObjectuiv, query, GL_QUERY_RESULT_AVAILABLE, &available);
+        return available == GL_TRUE;
+    }
+
+    uint64_t OpenGL::query_result(uint32_t query) {
+        uint64_t result = 0;
+        CHECKED_GL_CALL(glGetQueryObjectui64v, query, GL_QUERY_RESULT, &result);
+        return result;
+    }
+
+    uint64_t OpenGL::gpu_timestamp_ns() {
+        int64_t timestamp = 0;
+        CHECKED_GL_CALL(glGetInteger64v, GL_TIMESTAMP, &timestamp);
+        return static_cast<uint64_t>(timestamp);
+    }
+
     uint32_t face_index(std::string_view name) {
         if (name == "right") {
             return 0;
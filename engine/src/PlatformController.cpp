@@ -11,6 +11,7 @@
 #include <spdlog/spdlog.h>
 #include <utility>
 #include <engine/graphics/OpenGL.hpp>
+#include <engine/util/ArgParser.hpp>
 #include <engine/util/Configuration.hpp>
 
 namespace engine::platform {
@@ -35,8 +36,40 @@ namespace engine::platform {
 
     void initialize_key_maps();
 
+    /**
+    * @brief Creates an invisible window on the null platform, with a context that needs no display.
+    * Tries the surfaceless EGL first, which works on GPU nodes and with Mesa llvmpipe, then the OSMesa software renderer.
+    */
+    static GLFWwindow *create_headless_window(int width, int height, const std::string &title,
+                                              std::string_view context_api) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        std::vector<std::pair<int, std::string_view> > apis;
+        if (context_api != "osmesa") {
+            apis.emplace_back(GLFW_EGL_CONTEXT_API, "EGL");
+        }
+        if (context_api != "egl") {
+            apis.emplace_back(GLFW_OSMESA_CONTEXT_API, "OSMesa");
+        }
+        for (const auto &[api, api_name]: apis) {
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+            if (GLFWwindow *handle = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr)) {
+                spdlog::info("Platform[headless, {} context]", api_name);
+                return handle;
+            }
+            spdlog::warn("Platform[headless]: failed to create the {} context.", api_name);
+        }
+        return nullptr;
+    }
+
     void PlatformController::initialize() {
-        if (glfwPlatformSupported(GLFW_PLATFORM_X11)) {
+        util::Configuration::json &config = util::Configuration::config();
+        m_headless    = util::ArgParser::instance()->flag("--headless") ||
+                        config["window"].value<bool>("headless", false);
+        m_frame_limit = util::ArgParser::instance()->arg<int>("--frames", 0).value();
+        if (m_headless) {
+            RG_GUARANTEE(glfwPlatformSupported(GLFW_PLATFORM_NULL), "GLFW was built without the null platform.");
+            glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        } else if (glfwPlatformSupported(GLFW_PLATFORM_X11)) {
             glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_X11);
         } else if (glfwPlatformSupported(GLFW_PLATFORM_WAYLAND)) {
             glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_WAYLAND);
@@ -49,11 +82,13 @@ namespace engine::platform {
         glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
         glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-        util::Configuration::json &config = util::Configuration::config();
         int window_width = config["window"]["width"];
         int window_height = config["window"]["height"];
         std::string window_title = config["window"]["title"];
-        GLFWwindow *handle = glfwCreateWindow(window_width, window_height, window_title.c_str(), nullptr, nullptr);
+        GLFWwindow *handle = m_headless
+                             ? create_headless_window(window_width, window_height, window_title,
+                                                      config["window"].value<std::string>("headless_context", ""))
+                             : glfwCreateWindow(window_width, window_height, window_title.c_str(), nullptr, nullptr);
         RG_GUARANTEE(handle, "GLFW3 platform failed to create a Window.");
         m_window = Window(handle, window_width, window_height, window_title);
 
@@ -85,9 +120,12 @@ namespace engine::platform {
 
     bool PlatformController::loop() {
         m_frame_time.previous = m_frame_time.current;
-        m_frame_time.current  = glfwGetTime();
+        m_frame_time.current  = m_fixed_dt > 0.0f ? m_frame_time.previous + m_fixed_dt : glfwGetTime();
         m_frame_time.dt       = m_frame_time.current - m_frame_time.previous;
 
+        if (m_frame_limit > 0 && m_frame_count++ == m_frame_limit) {
+            return false;
+        }
         return !glfwWindowShouldClose(m_window.handle_());
     }
 
@@ -100,6 +138,10 @@ namespace engine::platform {
     }
 
     void PlatformController::swap_buffers() {
+        if (m_headless) {
+            // The frame stays in the offscreen framebuffer, see graphics::GraphicsController::read_framebuffer.
+            return;
+        }
         glfwSwapBuffers(m_window.handle_());
     }
 
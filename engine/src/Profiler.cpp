@@ -0,0 +1,217 @@
+#include <imgui.h>
+#include <engine/util/Profiler.hpp>
+#include <json.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+namespace engine::util {
+    namespace {
+        thread_local void *t_thread_buffer = nullptr;
+    }
+
+    Profiler *Profiler::instance() {
+        static Profiler profiler;
+        return &profiler;
+    }
+
+    Profiler::ThreadBuffer *Profiler::thread_buffer() {
+        if (!t_thread_buffer) {
+            t_thread_buffer = register_buffer({});
+        }
+        return static_cast<ThreadBuffer *>(t_thread_buffer);
+    }
+
+    Profiler::ThreadBuffer *Profiler::register_buffer(std::string name) {
+        std::lock_guard lock(m_buffers_mutex);
+        auto buffer       = std::make_unique<ThreadBuffer>();
+        buffer->thread_id = static_cast<uint32_t>(m_buffers.size());
+        buffer->name      = name.empty() ? std::format("Thread {}", buffer->thread_id) : std::move(name);
+        return m_buffers.emplace_back(std::move(buffer)).get();
+    }
+
+    void Profiler::push(ThreadBuffer &buffer, const ProfileEvent &event) {
+        const uint32_t head = buffer.head.load(std::memory_order_relaxed);
+        const uint32_t tail = buffer.tail.load(std::memory_order_acquire);
+        if (head - tail == THREAD_BUFFER_SIZE) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer.events[head % THREAD_BUFFER_SIZE] = event;
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Profiler::record(std::string_view name, uint64_t begin_ns, uint64_t end_ns) {
+        push(*thread_buffer(), ProfileEvent{name, begin_ns, end_ns});
+    }
+
+    void Profiler::record_gpu(std::string_view name, uint64_t begin_ns, uint64_t end_ns) {
+        if (!m_gpu_buffer) {
+            m_gpu_buffer = register_buffer("GPU");
+        }
+        push(*m_gpu_buffer, ProfileEvent{name, begin_ns, end_ns});
+    }
+
+    void Profiler::end_frame() {
+        const uint64_t now = now_ns();
+        if (m_frame_begin_ns != 0 && enabled()) {
+            record("Frame", m_frame_begin_ns, now);
+        }
+        m_frame_begin_ns = now;
+        {
+            std::lock_guard lock(m_buffers_mutex);
+            for (auto &buffer: m_buffers) {
+                drain(*buffer);
+            }
+        }
+        if (m_capture_frames_left > 0 && --m_capture_frames_left == 0) {
+            if (write_chrome_trace(m_capture_path)) {
+                spdlog::info("[Profiler]: wrote {} events to {}", m_capture.size(), m_capture_path.string());
+            } else {
+                spdlog::error("[Profiler]: failed to write the trace to {}", m_capture_path.string());
+            }
+            m_capture.clear();
+        }
+    }
+
+    void Profiler::drain(ThreadBuffer &buffer) {
+        const uint32_t tail = buffer.tail.load(std::memory_order_relaxed);
+        const uint32_t head = buffer.head.load(std::memory_order_acquire);
+        for (uint32_t i = tail; i != head; ++i) {
+            const ProfileEvent &event = buffer.events[i % THREAD_BUFFER_SIZE];
+            auto zone                 = m_zones.find(event.name);
+            if (zone == m_zones.end()) {
+                zone = m_zones.emplace(std::string(event.name), ZoneHistory{}).first;
+            }
+            ZoneHistory &history             = zone->second;
+            history.samples_ms[history.next] = static_cast<float>(event.end_ns - event.begin_ns) / 1e6f;
+            history.next                     = (history.next + 1) % HISTORY_SIZE;
+            history.count                    = std::min(history.count + 1, HISTORY_SIZE);
+            if (m_capture_frames_left > 0) {
+                // The name may point to a temporary owner, like a controller name; the map key lives as long as the profiler.
+                m_capture.push_back(CapturedEvent{ProfileEvent{zone->first, event.begin_ns, event.end_ns},
+                                                  buffer.thread_id});
+            }
+        }
+        buffer.tail.store(head, std::memory_order_release);
+    }
+
+    std::vector<ZoneStats> Profiler::zone_stats() const {
+        std::vector<ZoneStats> result;
+        result.reserve(m_zones.size());
+        std::vector<float> samples;
+        for (const auto &[name, history]: m_zones) {
+            if (history.count == 0) {
+                continue;
+            }
+            samples.assign(history.samples_ms.begin(), history.samples_ms.begin() + history.count);
+            ZoneStats stats;
+            stats.name    = name;
+            stats.samples = history.count;
+            stats.last_ms = history.samples_ms[(history.next + HISTORY_SIZE - 1) % HISTORY_SIZE];
+            double sum    = 0.0;
+            for (const float sample: samples) {
+                sum += sample;
+            }
+            stats.avg_ms = sum / static_cast<double>(samples.size());
+            stats.min_ms = *std::min_element(samples.begin(), samples.end());
+            const auto p99 = samples.begin() + static_cast<std::ptrdiff_t>(
+                                     std::ceil(0.99 * static_cast<double>(samples.size())) - 1);
+            std::nth_element(samples.begin(), p99, samples.end());
+            stats.p99_ms = *p99;
+            result.push_back(stats);
+        }
+        std::sort(result.begin(), result.end(), [](const ZoneStats &a, const ZoneStats &b) {
+            return a.name < b.name;
+        });
+        return result;
+    }
+
+    void Profiler::capture(uint32_t frame_count, std::filesystem::path path) {
+        m_capture.clear();
+        m_capture_frames_left = frame_count;
+        m_capture_path        = std::move(path);
+    }
+
+    bool Profiler::write_chrome_trace(const std::filesystem::path &path) const {
+        using json = nlohmann::json;
+        uint64_t origin_ns = std::numeric_limits<uint64_t>::max();
+        for (const auto &captured: m_capture) {
+            origin_ns = std::min(origin_ns, captured.event.begin_ns);
+        }
+        json events = json::array();
+        {
+            std::lock_guard lock(m_buffers_mutex);
+            for (const auto &buffer: m_buffers) {
+                events.push_back({
+                        {"name", "thread_name"}, {"ph", "M"}, {"pid", 0}, {"tid", buffer->thread_id},
+                        {"args", {{"name", buffer->name}}}
+                });
+            }
+        }
+        for (const auto &[event, thread_id]: m_capture) {
+            events.push_back({
+                    {"name", event.name},
+                    {"ph", "X"},
+                    {"pid", 0},
+                    {"tid", thread_id},
+                    {"ts", static_cast<double>(event.begin_ns - origin_ns) / 1e3},
+                    {"dur", static_cast<double>(event.end_ns - event.begin_ns) / 1e3}
+            });
+        }
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << json{{"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}}.dump();
+        return file.good();
+    }
+
+    uint64_t Profiler::dropped_events() const {
+        std::lock_guard lock(m_buffers_mutex);
+        uint64_t dropped = 0;
+        for (const auto &buffer: m_buffers) {
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+        return dropped;
+    }
+
+    void Profiler::draw_gui() {
+        ImGui::Begin("Profiler");
+        bool profiler_enabled = enabled();
+        if (ImGui::Checkbox("Enabled", &profiler_enabled)) {
+            set_enabled(profiler_enabled);
+        }
+        ImGui::SameLine();
+        if (is_capturing()) {
+            ImGui::Text("Capturing, %u frames left...", m_capture_frames_left);
+        } else if (ImGui::Button("Capture 120 frames")) {
+            capture(120, "profile_trace.json");
+        }
+        ImGui::Text("Dropped events: %llu", static_cast<unsigned long long>(dropped_events()));
+        if (ImGui::BeginTable("zones", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Zone");
+            ImGui::TableSetupColumn("min ms");
+            ImGui::TableSetupColumn("avg ms");
+            ImGui::TableSetupColumn("p99 ms");
+            ImGui::TableSetupColumn("last ms");
+            ImGui::TableHeadersRow();
+            for (const auto &stats: zone_stats()) {
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(stats.name.data(), stats.name.data() + stats.name.size());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.min_ms);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.avg_ms);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.p99_ms);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.last_ms);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+} // namespace engine::util
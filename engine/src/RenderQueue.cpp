@@ -0,0 +1,358 @@
+#include <glad/glad.h>
+#include <engine/graphics/GeometryArena.hpp>
+#include <engine/graphics/OpenGL.hpp>
+#include <engine/graphics/RenderQueue.hpp>
+#include <engine/graphics/TextureStreamer.hpp>
+#include <engine/resources/Mesh.hpp>
+#include <engine/resources/Shader.hpp>
+#include <engine/resources/TexturePack.hpp>
+#include <engine/util/JobSystem.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace engine::graphics {
+    namespace {
+        constexpr uint64_t SHADER_BITS   = 12;
+        constexpr uint64_t MATERIAL_BITS = 20;
+        constexpr uint64_t VAO_BITS      = 16;
+        constexpr uint64_t DEPTH_BITS    = 16;
+
+        constexpr uint64_t mask(uint64_t bits) {
+            return (uint64_t{1} << bits) - 1;
+        }
+
+        /**
+        * @brief Hashes the textures first, so that the materials sharing the textures still sort next to each other.
+        * The packed materials hash only the arrays of their pack, so all the materials of a pack sort together.
+        */
+        uint64_t material_hash(const resources::Material *material) {
+            uint64_t hash = 0xcbf29ce484222325;
+            if (const auto pack = material->texture_pack()) {
+                for (const auto texture: pack->textures()) {
+                    hash = (hash ^ texture) * 0x100000001b3;
+                }
+                return hash ^ (hash >> MATERIAL_BITS);
+            }
+            for (const auto texture: material->textures()) {
+                hash = (hash ^ texture->id()) * 0x100000001b3;
+            }
+            hash = (hash ^ material->uniform_buffer()) * 0x100000001b3;
+            return hash ^ (hash >> MATERIAL_BITS);
+        }
+
+        std::size_t align_up(std::size_t value, std::size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    } // namespace
+
+    uint64_t RenderQueue::sort_key(const resources::Shader *shader, const resources::Mesh *mesh, float depth) {
+        const auto quantized_depth = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * mask(DEPTH_BITS));
+        return (shader->id() & mask(SHADER_BITS)) << (MATERIAL_BITS + VAO_BITS + DEPTH_BITS) |
+               (material_hash(mesh->material()) & mask(MATERIAL_BITS)) << (VAO_BITS + DEPTH_BITS) |
+               (mesh->vao() & mask(VAO_BITS)) << DEPTH_BITS |
+               quantized_depth;
+    }
+
+    void RenderQueue::submit(const resources::Mesh *mesh, const resources::Shader *shader, const glm::mat4 &transform,
+                             const BoundingSphere &world_sphere, float depth, uint32_t lod, float screen_pixels) {
+        m_keys.emplace_back(sort_key(shader, mesh, depth), static_cast<uint32_t>(m_items.size()));
+        m_items.push_back(Item{mesh, shader, transform, lod, screen_pixels});
+        m_spheres.push(world_sphere);
+        ++m_stats.submitted;
+    }
+
+    void RenderQueue::flush(const Frustum *frustum) {
+        if (m_items.empty()) {
+            return;
+        }
+        if (frustum) {
+            const std::size_t visible_count = frustum->cull(m_spheres, m_visible);
+            if (visible_count != m_items.size()) {
+                std::erase_if(m_keys, [this](const auto &key) {
+                    return !m_visible[key.second];
+                });
+                m_stats.culled += static_cast<uint32_t>(m_items.size() - visible_count);
+            }
+        }
+        std::sort(m_keys.begin(), m_keys.end());
+        upload_draws();
+
+        // Every visible draw reports its size, not only the first one of a batch.
+        auto streamer = TextureStreamer::instance();
+        if (streamer->enabled()) {
+            for (const auto &[key, index]: m_keys) {
+                const Item &item = m_items[index];
+                for (const auto texture: item.mesh->material()->textures()) {
+                    streamer->request(texture->id(), item.screen_pixels);
+                }
+            }
+        }
+
+        // The binds go through the OpenGL state shadow, so the state left by the previous flush
+        // or by the direct draws is reused too.
+        const resources::Shader *current_shader = nullptr;
+        resources::UniformHandle model_uniform;
+        resources::UniformHandle layer_uniform;
+        bool uses_object_block = false;
+        bool batched           = false;
+        bool per_draw_material = false;
+        // The sampler uniforms were set to fixed units when the programs were linked,
+        // so a new material only needs a lookup of the units its textures go to.
+        uint64_t current_sampler_layout = 0;
+        std::span<const int8_t> texture_units;
+
+        for (std::size_t draw = 0; draw < m_keys.size();) {
+            const Item &item                   = m_items[m_keys[draw].second];
+            const resources::Material *material = item.mesh->material();
+            if (item.shader != current_shader) {
+                if (OpenGL::use_program(item.shader->id())) {
+                    ++m_stats.program_binds;
+                } else {
+                    ++m_stats.program_binds_elided;
+                }
+                current_shader         = item.shader;
+                uses_object_block      = item.shader->uses_uniform_block(UniformBinding::Object);
+                model_uniform          = uses_object_block ? resources::UniformHandle{} : item.shader->uniform("model");
+                layer_uniform          = item.shader->uniform(resources::Material::LAYER_UNIFORM);
+                current_sampler_layout = material->sampler_layout();
+                texture_units          = item.shader->texture_units(*material);
+                const int32_t transforms_unit = item.shader->sampler_unit(DRAW_TRANSFORMS_SAMPLER);
+                batched                       = transforms_unit >= 0;
+                if (batched) {
+                    if (OpenGL::bind_texture(transforms_unit, GL_TEXTURE_BUFFER, m_transform_buffer.texture)) {
+                        ++m_stats.texture_binds;
+                    } else {
+                        ++m_stats.texture_binds_elided;
+                    }
+                }
+                const int32_t materials_unit = item.shader->sampler_unit(DRAW_MATERIALS_SAMPLER);
+                per_draw_material            = batched && materials_unit >= 0;
+                if (per_draw_material) {
+                    if (OpenGL::bind_texture(materials_unit, GL_TEXTURE_BUFFER, m_material_buffer.texture)) {
+                        ++m_stats.texture_binds;
+                    } else {
+                        ++m_stats.texture_binds_elided;
+                    }
+                }
+            } else {
+                ++m_stats.program_binds_elided;
+                if (material->sampler_layout() != current_sampler_layout) {
+                    current_sampler_layout = material->sampler_layout();
+                    texture_units          = item.shader->texture_units(*material);
+                }
+            }
+
+            if (const auto pack = material->texture_pack()) {
+                const auto &arrays = pack->textures();
+                for (std::size_t i = 0; i < arrays.size(); ++i) {
+                    if (texture_units[i] < 0) {
+                        continue;
+                    }
+                    if (OpenGL::bind_texture(texture_units[i], GL_TEXTURE_2D_ARRAY, arrays[i])) {
+                        ++m_stats.texture_binds;
+                    } else {
+                        ++m_stats.texture_binds_elided;
+                    }
+                }
+            } else {
+                const auto &textures = material->textures();
+                for (std::size_t i = 0; i < textures.size(); ++i) {
+                    if (texture_units[i] < 0) {
+                        continue;
+                    }
+                    if (OpenGL::bind_texture(texture_units[i], GL_TEXTURE_2D, textures[i]->id())) {
+                        ++m_stats.texture_binds;
+                    } else {
+                        ++m_stats.texture_binds_elided;
+                    }
+                }
+            }
+
+            if (OpenGL::bind_vertex_array(item.mesh->vao())) {
+                ++m_stats.vao_binds;
+            } else {
+                ++m_stats.vao_binds_elided;
+            }
+
+            if (OpenGL::bind_uniform_buffer(UniformBinding::Material, material->uniform_buffer(), 0,
+                                            sizeof(MaterialBlock))) {
+                ++m_stats.uniform_buffer_binds;
+            } else {
+                ++m_stats.uniform_buffer_binds_elided;
+            }
+            // A batch without per-draw materials has a single material, so its layer is set once for all its draws.
+            if (material->texture_pack() && layer_uniform.valid()) {
+                item.shader->set_int(layer_uniform, static_cast<int>(material->texture_layer()));
+            }
+            if (batched) {
+                const std::size_t count = batch_size(draw, per_draw_material);
+                draw_batch(draw, count);
+                draw += count;
+                continue;
+            }
+            if (uses_object_block) {
+                if (OpenGL::bind_uniform_buffer(UniformBinding::Object, m_object_buffer, draw * m_object_stride,
+                                                sizeof(ObjectBlock))) {
+                    ++m_stats.uniform_buffer_binds;
+                } else {
+                    ++m_stats.uniform_buffer_binds_elided;
+                }
+            } else {
+                // Shaders without the Object block still get the transform through the `model` uniform.
+                item.shader->set_mat4(model_uniform, item.transform);
+            }
+            // The command was built for the level of detail of the draw in upload_draws.
+            const auto &command = m_commands[draw];
+            CHECKED_GL_CALL(glDrawElementsBaseVertex, GL_TRIANGLES, static_cast<GLsizei>(command.count),
+                            GL_UNSIGNED_INT,
+                            reinterpret_cast<const void *>(static_cast<std::uintptr_t>(command.first_index) *
+                                                           sizeof(uint32_t)),
+                            command.base_vertex);
+            ++m_stats.draw_calls;
+            m_stats.triangles += command.count / 3;
+            ++draw;
+        }
+        m_items.clear();
+        m_keys.clear();
+        m_spheres.clear();
+    }
+
+    void RenderQueue::upload_draws() {
+        if (m_object_stride == 0) {
+            m_object_stride = align_up(sizeof(ObjectBlock), OpenGL::uniform_buffer_offset_alignment());
+        }
+        const std::size_t draws = m_keys.size();
+        m_objects.resize(draws * m_object_stride);
+        m_transforms.resize(draws);
+        m_materials.resize(draws * MATERIAL_TEXELS);
+        m_commands.resize(draws);
+        // Every draw writes only its own slots, so the chunks of a large queue can be filled concurrently.
+        util::JobSystem::instance()->parallel_for<std::size_t>(0, draws, [this](std::size_t draw) {
+            const Item &item     = m_items[m_keys[draw].second];
+            const auto &geometry = item.mesh->geometry();
+            const auto &lod      = item.mesh->lod(item.lod);
+            const ObjectBlock object{item.transform};
+            std::memcpy(m_objects.data() + draw * m_object_stride, &object, sizeof(ObjectBlock));
+            m_transforms[draw] = item.transform;
+            const auto *material  = item.mesh->material();
+            const auto &constants = material->constants();
+            m_materials[draw * MATERIAL_TEXELS]     = constants.diffuse;
+            m_materials[draw * MATERIAL_TEXELS + 1] = constants.specular;
+            m_materials[draw * MATERIAL_TEXELS + 2] = glm::vec4(constants.shininess,
+                                                                static_cast<float>(material->texture_layer()), 0.0f,
+                                                                0.0f);
+            m_commands[draw]   = OpenGL::DrawElementsIndirectCommand{
+                    .count          = lod.index_count,
+                    .instance_count = 1,
+                    .first_index    = geometry.first_index + lod.first_index,
+                    .base_vertex    = geometry.base_vertex,
+                    .base_instance  = static_cast<uint32_t>(draw),
+            };
+        }, PARALLEL_BUILD_GRAIN);
+
+        if (m_object_buffer == 0) {
+            m_object_buffer = OpenGL::create_uniform_buffer(m_objects.size());
+        }
+        // One upload for all the draws of the flush; each draw then only binds its range.
+        OpenGL::stream_uniform_buffer(m_object_buffer, m_objects);
+
+        if (m_transform_buffer.buffer == 0) {
+            m_transform_buffer = OpenGL::create_texture_buffer(GL_RGBA32F);
+        }
+        OpenGL::stream_texture_buffer(m_transform_buffer, std::as_bytes(std::span(m_transforms)));
+        if (m_material_buffer.buffer == 0) {
+            m_material_buffer = OpenGL::create_texture_buffer(GL_RGBA32F);
+        }
+        OpenGL::stream_texture_buffer(m_material_buffer, std::as_bytes(std::span(m_materials)));
+        if (!OpenGL::multi_draw_indirect_supported()) {
+            return;
+        }
+        if (m_indirect_buffer == 0) {
+            CHECKED_GL_CALL(glGenBuffers, 1, &m_indirect_buffer);
+        }
+        OpenGL::stream_indirect_buffer(m_indirect_buffer, m_commands);
+        if (draws > m_draw_id_capacity) {
+            if (m_draw_id_buffer == 0) {
+                CHECKED_GL_CALL(glGenBuffers, 1, &m_draw_id_buffer);
+            }
+            // The ids never change, so the buffer is only rewritten when it grows.
+            m_draw_id_capacity = std::max(draws, m_draw_id_capacity * 2);
+            std::vector<uint32_t> ids(m_draw_id_capacity);
+            for (std::size_t i = 0; i < ids.size(); ++i) {
+                ids[i] = static_cast<uint32_t>(i);
+            }
+            CHECKED_GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, m_draw_id_buffer);
+            CHECKED_GL_CALL(glBufferData, GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(ids.size() * sizeof(uint32_t)),
+                            ids.data(), GL_STATIC_DRAW);
+            CHECKED_GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, 0);
+        }
+    }
+
+    std::size_t RenderQueue::batch_size(std::size_t first, bool per_draw_material) const {
+        const Item &head                    = m_items[m_keys[first].second];
+        const resources::Material *material = head.mesh->material();
+        // With the material constants and the layer read per draw, the materials of a pack only differ in the data.
+        const resources::TexturePack *pack = per_draw_material ? material->texture_pack() : nullptr;
+        std::size_t last                   = first + 1;
+        while (last < m_keys.size()) {
+            const Item &item = m_items[m_keys[last].second];
+            const bool same_material = item.mesh->material() == material ||
+                                       (pack != nullptr && item.mesh->material()->texture_pack() == pack);
+            if (item.shader != head.shader || !same_material || item.mesh->vao() != head.mesh->vao()) {
+                break;
+            }
+            ++last;
+        }
+        return last - first;
+    }
+
+    void RenderQueue::draw_batch(std::size_t first, std::size_t count) {
+        const auto &head = m_items[m_keys[first].second].mesh->geometry();
+        if (OpenGL::multi_draw_indirect_supported()) {
+            GeometryArena::instance()->attach_draw_id_buffer(head, m_draw_id_buffer);
+            OpenGL::multi_draw_elements_indirect(m_indirect_buffer, first, static_cast<uint32_t>(count));
+            ++m_stats.draw_calls;
+        } else {
+            // Without the base instance there is no per-draw id inside a glMultiDrawElements*,
+            // so the commands go one by one with the id in a constant attribute.
+            for (std::size_t draw = first; draw < first + count; ++draw) {
+                const auto &command = m_commands[draw];
+                CHECKED_GL_CALL(glVertexAttribI1ui, GeometryArena::DRAW_ID_LOCATION, command.base_instance);
+                CHECKED_GL_CALL(glDrawElementsBaseVertex, GL_TRIANGLES, static_cast<GLsizei>(command.count),
+                                GL_UNSIGNED_INT,
+                                reinterpret_cast<const void *>(static_cast<std::uintptr_t>(command.first_index) *
+                                                               sizeof(uint32_t)),
+                                command.base_vertex);
+            }
+            m_stats.draw_calls += static_cast<uint32_t>(count);
+        }
+        for (std::size_t draw = first; draw < first + count; ++draw) {
+            m_stats.triangles += m_commands[draw].count / 3;
+        }
+        ++m_stats.batches;
+        m_stats.batched_draws += static_cast<uint32_t>(count);
+    }
+
+    void RenderQueue::destroy() {
+        if (m_object_buffer != 0) {
+            OpenGL::delete_buffer(m_object_buffer);
+            m_object_buffer = 0;
+        }
+        if (m_transform_buffer.buffer != 0) {
+            OpenGL::delete_texture_buffer(m_transform_buffer);
+        }
+        if (m_material_buffer.buffer != 0) {
+            OpenGL::delete_texture_buffer(m_material_buffer);
+        }
+        if (m_indirect_buffer != 0) {
+            OpenGL::delete_buffer(m_indirect_buffer);
+            m_indirect_buffer = 0;
+        }
+        if (m_draw_id_buffer != 0) {
+            GeometryArena::instance()->detach_draw_id_buffer(m_draw_id_buffer);
+            OpenGL::delete_buffer(m_draw_id_buffer);
+            m_draw_id_buffer   = 0;
+            m_draw_id_capacity = 0;
+        }
+    }
+} // namespace engine::graphics
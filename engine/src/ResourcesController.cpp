@@ -1,22 +1,181 @@
+#include <algorithm>
+#include <iterator>
 #include <unordered_set>
 #include <utility>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <engine/graphics/OpenGL.hpp>
+#include <engine/graphics/TextureStreamer.hpp>
+#include <engine/graphics/TextureUploader.hpp>
+#include <engine/resources/Image.hpp>
+#include <engine/resources/MeshOptimizer.hpp>
+#include <engine/resources/MeshSimplifier.hpp>
 #include <engine/resources/ResourcesController.hpp>
 #include <engine/resources/ShaderCompiler.hpp>
+#include <engine/resources/TextureCompressor.hpp>
+#include <engine/resources/TexturePack.hpp>
 #include <engine/util/Configuration.hpp>
 #include <engine/util/Errors.hpp>
+#include <engine/util/JobSystem.hpp>
 #include <spdlog/spdlog.h>
 
 namespace engine::resources {
 
     void ResourcesController::initialize() {
+        m_load_begin       = std::chrono::steady_clock::now();
+        const auto &config = util::Configuration::config();
+        m_import_settings.flags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace;
+        graphics::TextureStreaming texture_streaming;
+        if (config.contains("resources")) {
+            m_model_cache   = config["resources"].value<bool>("model_cache", true);
+            m_texture_cache = config["resources"].value<bool>("texture_cache", true);
+            if (config["resources"].contains("vertex_compression")) {
+                const auto &compression  = config["resources"]["vertex_compression"];
+                auto &vertex_compression = m_import_settings.vertex_compression;
+                vertex_compression.enabled            = compression.value<bool>("enabled", true);
+                vertex_compression.half_positions     = compression.value<bool>("half_positions", false);
+                vertex_compression.position_tolerance = compression.value<float>("position_tolerance", 0.0005f);
+            }
+            if (config["resources"].contains("mesh_optimization")) {
+                const auto &optimization = config["resources"]["mesh_optimization"];
+                auto &mesh_optimization  = m_import_settings.mesh_optimization;
+                mesh_optimization.enabled            = optimization.value<bool>("enabled", true);
+                mesh_optimization.overdraw_threshold = optimization.value<float>("overdraw_threshold", 1.05f);
+            }
+            if (config["resources"].contains("texture_compression")) {
+                const auto &compression       = config["resources"]["texture_compression"];
+                m_texture_compression.enabled = compression.value<bool>("enabled", true);
+                m_texture_compression.bc7     = compression.value<bool>("bc7", false);
+            }
+            if (config["resources"].contains("texture_packing")) {
+                const auto &packing        = config["resources"]["texture_packing"];
+                m_texture_packing.max_size = packing.value<int32_t>("max_size", 512);
+                // OpenGL 3.3 guarantees 256 layers.
+                m_texture_packing.layers   = std::clamp(packing.value<uint32_t>("layers", 16), 1u, 256u);
+            }
+            if (config["resources"].contains("texture_streaming")) {
+                const auto &streaming          = config["resources"]["texture_streaming"];
+                texture_streaming.enabled      = streaming.value<bool>("enabled", false);
+                texture_streaming.budget_bytes = streaming.value<std::size_t>("budget_mb", 256) << 20;
+                texture_streaming.initial_size = streaming.value<int32_t>("initial_size", 64);
+                texture_streaming.mip_bias     = streaming.value<float>("mip_bias", 0.0f);
+            }
+        }
+        graphics::TextureStreamer::instance()->initialize(texture_streaming);
+        m_block_formats = graphics::OpenGL::supported_block_formats();
+        if (config.contains("resources") && config["resources"].value<bool>("async_loading", false)) {
+            m_async_loading = util::JobSystem::instance()->is_running();
+            if (m_async_loading) {
+                spdlog::info("[ResourcesController]: loading resources asynchronously on {} job workers",
+                             util::JobSystem::instance()->worker_count());
+            }
+        }
         load_shaders();
         load_models();
         load_textures();
         load_skyboxes();
+        record_load_time();
+    }
+
+    void ResourcesController::record_load_time() {
+        if (m_load_time_ms < 0.0 && pending_count() == 0) {
+            m_load_time_ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - m_load_begin).count();
+            spdlog::info("[ResourcesController]: resources loaded in {:.1f} ms", m_load_time_ms);
+        }
+    }
+
+    void ResourcesController::poll_events() {
+        if (async_loading()) {
+            run_main_thread_tasks();
+        }
+        // The streamed textures queue their levels after loading too.
+        graphics::TextureUploader::instance()->update();
+        if (async_loading()) {
+            record_load_time();
+        }
+    }
+
+    std::size_t ResourcesController::pending_count() const {
+        // The levels streamed in after the coarse ones are queued by the draws, not by loading.
+        return m_pending_count + graphics::TextureUploader::instance()->stats().pending_textures -
+               graphics::TextureStreamer::instance()->stats().streaming_in;
+    }
+
+    void ResourcesController::terminate() {
+        // Decoded resources that didn't reach the main thread are dropped. The jobs still decoding finish
+        // before the JobSystem shuts down, and their results are dropped with the controller.
+        std::lock_guard lock(m_main_thread_tasks_mutex);
+        m_main_thread_tasks.clear();
+        m_pending_count = 0;
+        m_async_loading = false;
+        graphics::TextureStreamer::instance()->terminate();
+        // The graphics controller terminates after this one, so the context is still there.
+        for (auto &pack: m_texture_packs) {
+            pack->destroy();
+        }
+        m_texture_packs.clear();
+    }
+
+    void ResourcesController::finish_loading() {
+        while (m_pending_count > 0) {
+            {
+                std::unique_lock lock(m_main_thread_tasks_mutex);
+                m_main_thread_task_queued.wait(lock, [this] {
+                    return !m_main_thread_tasks.empty();
+                });
+            }
+            run_main_thread_tasks();
+        }
+        graphics::TextureUploader::instance()->flush();
+        record_load_time();
+    }
+
+    template<typename TDecoded>
+    void ResourcesController::load_async(std::function<TDecoded()> decode, std::function<void(TDecoded)> create) {
+        ++m_pending_count;
+        util::JobSystem::instance()->run([this, decode = std::move(decode), create = std::move(create)] {
+            std::function<void()> main_thread_task;
+            try {
+                auto decoded     = std::make_shared<TDecoded>(decode());
+                main_thread_task = [create, decoded] {
+                    create(std::move(*decoded));
+                };
+            } catch (...) {
+                // Errors are rethrown on the main thread, where the App handles them.
+                main_thread_task = [error = std::current_exception()] {
+                    std::rethrow_exception(error);
+                };
+            }
+            {
+                std::lock_guard lock(m_main_thread_tasks_mutex);
+                m_main_thread_tasks.emplace_back(std::move(main_thread_task));
+            }
+            m_main_thread_task_queued.notify_one();
+        });
+    }
+
+    void ResourcesController::run_main_thread_tasks() {
+        std::vector<std::function<void()> > tasks;
+        {
+            std::lock_guard lock(m_main_thread_tasks_mutex);
+            tasks.swap(m_main_thread_tasks);
+        }
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            try {
+                tasks[i]();
+            } catch (...) {
+                --m_pending_count;
+                // The tasks after the failed one stay queued for the next poll, so their resources still get created.
+                std::lock_guard lock(m_main_thread_tasks_mutex);
+                m_main_thread_tasks.insert(m_main_thread_tasks.begin(), std::make_move_iterator(tasks.begin() + i + 1),
+                                           std::make_move_iterator(tasks.end()));
+                throw;
+            }
+            --m_pending_count;
+        }
+        record_load_time();
     }
 
     void ResourcesController::load_shaders() {
@@ -67,7 +226,7 @@ namespace engine::resources {
 
     /**
      * @class AssimpSceneProcessor
-     * @brief Processes the meshes in an Assimp scene.
+     * @brief Processes the meshes in an Assimp scene into CPU-side @ref MeshData.
      */
     class AssimpSceneProcessor {
     public:
@@ -75,11 +234,11 @@ namespace engine::resources {
          * @brief Processes the meshes in the scene.
          * @returns The meshes in the scene.
          */
-        std::vector<Mesh> process_meshes();
+        std::vector<MeshData> process_meshes();
 
-        explicit AssimpSceneProcessor(ResourcesController *resources_controller, const aiScene *scene,
-                                      std::filesystem::path model_path) :
-        m_scene(scene), m_model_path(std::move(model_path)), m_resources_controller(resources_controller) {
+        explicit AssimpSceneProcessor(const aiScene *scene, std::filesystem::path model_path,
+                                      const ImportSettings &settings = {}) :
+        m_scene(scene), m_model_path(std::move(model_path)), m_settings(settings) {
         }
 
     private:
@@ -87,16 +246,23 @@ namespace engine::resources {
 
         void process_mesh(aiMesh *mesh);
 
-        std::vector<Texture *> process_materials(const aiMaterial *material);
+        std::vector<TextureReference> process_materials(const aiMaterial *material);
 
-        void process_material_type(std::vector<Texture *> &textures, const aiMaterial *material, aiTextureType type);
+        static graphics::MaterialBlock process_material_constants(const aiMaterial *material);
+
+        void process_material_type(std::vector<TextureReference> &textures, const aiMaterial *material,
+                                   aiTextureType type);
 
         static TextureType assimp_texture_type_to_engine(aiTextureType type);
 
-        std::vector<Mesh> m_meshes;
+        std::vector<MeshData> m_meshes;
         const aiScene *m_scene;
         std::filesystem::path m_model_path;
-        ResourcesController *m_resources_controller;
+        ImportSettings m_settings;
+        /**
+        * @brief The totals of the @ref MeshOptimizer::optimize stats of the processed meshes.
+        */
+        MeshOptimizationStats m_optimization_stats;
     };
 
     Model *ResourcesController::model(
@@ -113,51 +279,406 @@ namespace engine::resources {
                                                std::filesystem::path(
                                                        config["resources"]["models"][name]["path"].get<
                                                            std::string>());
-            Assimp::Importer importer;
-            int flags = aiProcess_Triangulate | aiProcess_GenSmoothNormals |
-                        aiProcess_CalcTangentSpace;
-            if (config["resources"]["models"][name].value<bool>("flip_uvs", false)) {
-                flags |= aiProcess_FlipUVs;
+            const auto &model_config = config["resources"]["models"][name];
+            ImportSettings settings  = m_import_settings;
+            if (model_config.value<bool>("flip_uvs", false)) {
+                settings.flags |= aiProcess_FlipUVs;
+            }
+            std::vector<float> lod_screen_sizes;
+            if (model_config.contains("lods")) {
+                const auto &lods = model_config["lods"];
+                lod_screen_sizes = lods.value<std::vector<float> >("screen_sizes", {});
+                std::sort(lod_screen_sizes.begin(), lod_screen_sizes.end(), std::greater<>());
+                if (lod_screen_sizes.size() > LodGeneration::MAX_LEVELS) {
+                    spdlog::warn("[ResourcesController]: model {} has {} lods, only the first {} are generated", name,
+                                 lod_screen_sizes.size(), LodGeneration::MAX_LEVELS);
+                    lod_screen_sizes.resize(LodGeneration::MAX_LEVELS);
+                }
+                settings.lods.levels    = static_cast<uint32_t>(lod_screen_sizes.size());
+                settings.lods.reduction = lods.value<float>("reduction", 0.5f);
+                settings.lods.max_error = lods.value<float>("max_error", 0.02f);
             }
 
             spdlog::info("load_model(name={}, path={})", name, model_path.string());
-            const aiScene *scene =
-                    importer.ReadFile(model_path, flags);
+            result          = std::make_unique<Model>(Model());
+            result->m_path  = model_path;
+            result->m_name  = name;
+            result->m_lod_screen_sizes = std::move(lod_screen_sizes);
+            Model *model    = result.get();
+            const std::filesystem::path cache_directory = m_model_cache ? m_cache_path / "models" : std::filesystem::path();
+            const bool pack_textures = model_config.value<bool>("pack_textures", false);
+            auto decode = [model_path, settings, cache_directory, pack_textures, packing = m_texture_packing,
+                           compression = m_texture_compression, block_formats = m_block_formats,
+                           texture_cache = m_texture_cache ? m_cache_path / "textures" : std::filesystem::path()] {
+                DecodedModel decoded{load_baked_model(model_path, settings, cache_directory), {}};
+                if (pack_textures) {
+                    decoded.textures = decode_model_textures(decoded.model, packing, compression, block_formats,
+                                                             texture_cache);
+                }
+                return decoded;
+            };
+            auto create = [this, model, pack_textures](DecodedModel decoded) {
+                create_meshes(model, decoded.model, pack_textures ? &decoded.textures : nullptr);
+            };
+            if (async_loading()) {
+                load_async<DecodedModel>(std::move(decode), std::move(create));
+            } else {
+                create(decode());
+            }
+        }
+        return result.get();
+    }
 
-            if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-                throw util::EngineError(util::EngineError::Type::AssetLoadingError,
-                                        std::format("Assimp error while reading model: {} from path {}.",
-                                                    model_path.string(), name));
+    std::vector<MeshData> ResourcesController::import_model(const std::filesystem::path &model_path,
+                                                            const ImportSettings &settings) {
+        Assimp::Importer importer;
+        const aiScene *scene =
+                importer.ReadFile(model_path, settings.flags);
+
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+            throw util::EngineError(util::EngineError::Type::AssetLoadingError,
+                                    std::format("Assimp error while reading model: {}.", model_path.string()));
+        }
+        AssimpSceneProcessor scene_processor(scene, model_path, settings);
+        return scene_processor.process_meshes();
+    }
+
+    BakedModel ResourcesController::load_baked_model(const std::filesystem::path &model_path,
+                                                     const ImportSettings &settings,
+                                                     const std::filesystem::path &cache_directory) {
+        const auto key = BakedModelKey::of(model_path, settings);
+        if (cache_directory.empty()) {
+            return BakedModel::bake(key, import_model(model_path, settings));
+        }
+        const auto baked_path = cache_directory / BakedModel::file_name(model_path, settings.flags);
+        if (auto baked_model = BakedModel::open(baked_path, key)) {
+            spdlog::info("[ResourcesController]: loaded baked model {}", baked_path.string());
+            return std::move(baked_model.value());
+        }
+        auto baked_model = BakedModel::bake(key, import_model(model_path, settings));
+        if (!baked_model.write(baked_path)) {
+            spdlog::warn("[ResourcesController]: failed to write the baked model {}", baked_path.string());
+        }
+        return baked_model;
+    }
+
+    void ResourcesController::create_meshes(Model *model, const BakedModel &baked_model,
+                                            std::unordered_map<std::string, DecodedTexture> *textures) {
+        const auto meshes_data = baked_model.meshes();
+        // A model packs the textures of all its materials or of none, so that all its meshes draw with the same shader.
+        bool pack_textures = textures != nullptr;
+        for (std::size_t i = 0; pack_textures && i < meshes_data.size(); ++i) {
+            const auto &mesh_data = meshes_data[i];
+            if (m_materials.contains(std::format("{}/{}", model->name(), mesh_data.material_index))) {
+                continue;
+            }
+            if (const auto reason = unpackable_reason(mesh_data.textures, *textures); !reason.empty()) {
+                spdlog::warn("[ResourcesController]: model {} doesn't pack its textures, material {} {}",
+                             model->name(), mesh_data.material_index, reason);
+                pack_textures = false;
+            }
+        }
+        std::vector<Mesh> meshes;
+        meshes.reserve(meshes_data.size());
+        for (const auto &mesh_data: meshes_data) {
+            const auto material_name = std::format("{}/{}", model->name(), mesh_data.material_index);
+            Material *mesh_material  = nullptr;
+            if (auto existing = m_materials.find(material_name); existing != m_materials.end()) {
+                mesh_material = existing->second.get();
+            } else {
+                if (pack_textures) {
+                    mesh_material = pack_material(material_name, mesh_data.textures, *textures, mesh_data.material);
+                }
+                if (mesh_material == nullptr) {
+                    std::vector<Texture *> material_textures;
+                    material_textures.reserve(mesh_data.textures.size());
+                    for (const auto &texture_reference: mesh_data.textures) {
+                        material_textures.emplace_back(textures != nullptr
+                                                           ? model_texture(texture_reference, *textures)
+                                                           : texture(texture_reference.path.string(),
+                                                                     texture_reference.path, texture_reference.type));
+                    }
+                    mesh_material = material(material_name, std::move(material_textures), mesh_data.material);
+                }
+            }
+            meshes.emplace_back(Mesh(mesh_data.vertex_format, mesh_data.vertices, mesh_data.indices, mesh_material,
+                                     mesh_data.bounds, mesh_data.lods));
+            model->m_bounds = graphics::Bounds::merge(model->m_bounds, mesh_data.bounds);
+        }
+        model->m_meshes = std::move(meshes);
+        model->m_ready  = true;
+    }
+
+    std::string ResourcesController::unpackable_reason(
+            std::span<const TextureReference> references,
+            const std::unordered_map<std::string, DecodedTexture> &textures) const {
+        if (references.empty()) {
+            return "has no textures";
+        }
+        for (const auto &reference: references) {
+            const auto decoded = textures.find(reference.path.string());
+            if (decoded == textures.end()) {
+                return std::format("didn't decode {}", reference.path.string());
+            }
+            const auto packable = packable_texture(decoded->second);
+            if (!packable.has_value()) {
+                return std::format("has no mip chain of {}", reference.path.string());
             }
-            AssimpSceneProcessor scene_processor(this, scene, model_path);
-            std::vector<Mesh> meshes = scene_processor.process_meshes();
-            result                   = std::make_unique<Model>(Model(std::move(meshes), model_path,
-                                                   name));
+            if (std::max(packable->first.width, packable->first.height) > m_texture_packing.max_size) {
+                return std::format("has {} larger than {}px", reference.path.string(), m_texture_packing.max_size);
+            }
+        }
+        return {};
+    }
+
+    Material *ResourcesController::pack_material(const std::string &name,
+                                                 std::span<const TextureReference> references,
+                                                 const std::unordered_map<std::string, DecodedTexture> &textures,
+                                                 const graphics::MaterialBlock &constants) {
+        if (!unpackable_reason(references, textures).empty()) {
+            return nullptr;
         }
+        std::vector<TextureType> types;
+        std::vector<TextureClass> classes;
+        std::vector<std::vector<BakedTexture::Level> > levels;
+        for (const auto &reference: references) {
+            auto packable = packable_texture(textures.at(reference.path.string()));
+            types.push_back(reference.type);
+            classes.push_back(packable->first);
+            levels.push_back(std::move(packable->second));
+        }
+        auto pack = std::find_if(m_texture_packs.begin(), m_texture_packs.end(), [&](const auto &candidate) {
+            return !candidate->full() && candidate->types() == types && candidate->classes() == classes;
+        });
+        if (pack == m_texture_packs.end()) {
+            spdlog::info("[ResourcesController]: packing {} textures of {}x{} into arrays of {} layers",
+                         types.size(), classes.front().width, classes.front().height, m_texture_packing.layers);
+            pack = m_texture_packs.insert(m_texture_packs.end(), std::unique_ptr<TexturePack>(
+                                                  new TexturePack(types, classes, levels, m_texture_packing.layers)));
+        }
+        const uint32_t layer = (*pack)->add(levels);
+        auto &result         = m_materials[name];
+        result               = std::unique_ptr<Material>(new Material(name, pack->get(), layer, constants));
         return result.get();
     }
 
+    Texture *ResourcesController::model_texture(const TextureReference &reference,
+                                                std::unordered_map<std::string, DecodedTexture> &textures) {
+        const auto name    = reference.path.string();
+        const auto decoded = textures.find(name);
+        if (m_textures.contains(name) || decoded == textures.end()) {
+            return texture(name, reference.path, reference.type);
+        }
+        auto &result     = m_textures[name];
+        result           = std::make_unique<Texture>(Texture(0, reference.type, reference.path, reference.path.stem()));
+        Texture *created = result.get();
+        upload_texture(created, std::move(decoded->second));
+        textures.erase(decoded);
+        if (!async_loading()) {
+            graphics::TextureUploader::instance()->flush();
+        }
+        return created;
+    }
+
+    std::unordered_map<std::string, ResourcesController::DecodedTexture> ResourcesController::decode_model_textures(
+            const BakedModel &baked_model, const TexturePacking &packing, const TextureCompression &settings,
+            uint32_t block_formats, const std::filesystem::path &cache_directory) {
+        std::unordered_map<std::string, DecodedTexture> textures;
+        for (const auto &mesh_data: baked_model.meshes()) {
+            for (const auto &reference: mesh_data.textures) {
+                const auto name = reference.path.string();
+                if (textures.contains(name)) {
+                    continue;
+                }
+                auto decoded = decode_texture(reference.path, reference.type, false, settings, block_formats,
+                                              cache_directory);
+                // Without the cache the pixels come without a mip chain.
+                if (const auto image = std::get_if<Image>(&decoded);
+                    image != nullptr && std::max(image->width, image->height) <= packing.max_size) {
+                    decoded = BakedTexture::bake(BakedTextureKey::of(reference.path, 0), *image);
+                }
+                textures.emplace(name, std::move(decoded));
+            }
+        }
+        return textures;
+    }
+
+    std::optional<std::pair<TextureClass, std::vector<BakedTexture::Level> > > ResourcesController::packable_texture(
+            const DecodedTexture &decoded) {
+        if (const auto compressed = std::get_if<CompressedImage>(&decoded)) {
+            TextureClass texture_class{compressed->levels.front().width, compressed->levels.front().height,
+                                       static_cast<uint32_t>(compressed->levels.size()),
+                                       graphics::OpenGL::compressed_texture_format(compressed->format), 0};
+            std::vector<BakedTexture::Level> levels;
+            for (std::size_t level = 0; level < compressed->levels.size(); ++level) {
+                levels.push_back(BakedTexture::Level{compressed->levels[level].width, compressed->levels[level].height,
+                                                     std::as_bytes(compressed->level_data(level))});
+            }
+            return std::make_pair(texture_class, std::move(levels));
+        }
+        if (const auto baked = std::get_if<BakedTexture>(&decoded)) {
+            const auto block_format = baked->block_format();
+            TextureClass texture_class{baked->level(0).width, baked->level(0).height, baked->level_count(),
+                                       block_format.has_value()
+                                           ? graphics::OpenGL::compressed_texture_format(*block_format)
+                                           : 0,
+                                       baked->channels()};
+            std::vector<BakedTexture::Level> levels;
+            for (uint32_t level = 0; level < baked->level_count(); ++level) {
+                levels.push_back(baked->level(level));
+            }
+            return std::make_pair(texture_class, std::move(levels));
+        }
+        return std::nullopt;
+    }
+
     Texture *ResourcesController::texture(const std::string &name,
                                           const std::filesystem::path &path,
                                           TextureType type, bool flip_uvs) {
         auto &result = m_textures[name];
         if (!result) {
             spdlog::info("Loading texture: {}", path.string());
-            result = std::make_unique<Texture>(Texture(graphics::OpenGL::generate_texture(path, flip_uvs), type, path,
-                                                       path.stem()));
+            result           = std::make_unique<Texture>(Texture(0, type, path, path.stem()));
+            Texture *texture = result.get();
+            const auto cache_directory = m_texture_cache ? m_cache_path / "textures" : std::filesystem::path();
+            if (async_loading()) {
+                load_async<DecodedTexture>([path, type, flip_uvs, settings = m_texture_compression,
+                                               block_formats = m_block_formats, cache_directory] {
+                    return decode_texture(path, type, flip_uvs, settings, block_formats, cache_directory);
+                }, [texture](DecodedTexture decoded) {
+                    upload_texture(texture, std::move(decoded));
+                });
+            } else {
+                auto decoded = decode_texture(path, type, flip_uvs, m_texture_compression, m_block_formats,
+                                              cache_directory);
+                if (graphics::TextureStreamer::instance()->enabled()) {
+                    upload_texture(texture, std::move(decoded));
+                    graphics::TextureUploader::instance()->flush();
+                } else {
+                    texture->m_id = std::visit([](const auto &image) {
+                        return graphics::OpenGL::generate_texture(image);
+                    }, decoded);
+                }
+            }
         }
         return result.get();
     }
 
+    void ResourcesController::upload_texture(Texture *texture, DecodedTexture decoded) {
+        const auto on_ready = [texture](uint32_t id) {
+            texture->m_id = id;
+        };
+        std::visit([&on_ready](auto &image) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(image)>, Image>) {
+                graphics::TextureUploader::instance()->upload(std::move(image), on_ready);
+            } else {
+                // The streamer hands the texture on to the uploader when streaming is disabled.
+                graphics::TextureStreamer::instance()->add(std::move(image), on_ready);
+            }
+        }, decoded);
+    }
+
+    ResourcesController::DecodedTexture ResourcesController::decode_texture(
+            const std::filesystem::path &path, TextureType type, bool flip_uvs, const TextureCompression &settings,
+            uint32_t block_formats, const std::filesystem::path &cache_directory) {
+        const auto supported = [block_formats](const CompressedImage &image) {
+            return (block_formats & 1u << static_cast<uint32_t>(image.format)) != 0;
+        };
+        if (CompressedImage::is_container(path)) {
+            auto image = CompressedImage::load(path);
+            if (!supported(image)) {
+                throw util::EngineError(util::EngineError::Type::AssetLoadingError,
+                                        std::format("The OpenGL context doesn't support the {} texture {}.",
+                                                    block_format_name(image.format), path.string()));
+            }
+            if (flip_uvs && !image.flip_vertically()) {
+                spdlog::warn("[ResourcesController]: the {} texture {} can't be flipped, it's used as it is",
+                             block_format_name(image.format), path.string());
+            }
+            return image;
+        }
+        for (const auto *extension: {".ktx2", ".dds"}) {
+            auto variant_path = path;
+            variant_path.replace_extension(extension);
+            if (!std::filesystem::exists(variant_path)) {
+                continue;
+            }
+            try {
+                auto image = CompressedImage::load(variant_path);
+                if (supported(image) && (!flip_uvs || image.flip_vertically())) {
+                    spdlog::info("[ResourcesController]: using the compressed variant {}", variant_path.string());
+                    return image;
+                }
+                spdlog::warn("[ResourcesController]: can't use the {} variant {}", block_format_name(image.format),
+                             variant_path.string());
+            } catch (const util::EngineError &error) {
+                spdlog::warn("[ResourcesController]: {}", error.message());
+            }
+        }
+        std::optional<BakedTextureKey> key;
+        std::filesystem::path baked_path;
+        if (!cache_directory.empty()) {
+            key        = BakedTextureKey::of(path, TextureCompressor::settings_key(type, flip_uvs, block_formats, settings));
+            baked_path = cache_directory / BakedTexture::file_name(path, type, flip_uvs);
+            if (auto baked = BakedTexture::open(baked_path, key.value())) {
+                return std::move(baked.value());
+            }
+        }
+        auto image        = Image::load(path, flip_uvs);
+        const auto format = settings.enabled
+                                ? TextureCompressor::choose_format(image, type, block_formats, settings)
+                                : std::nullopt;
+        std::optional<CompressedImage> compressed;
+        if (format.has_value()) {
+            compressed = TextureCompressor::compress(image, format.value(), type == TextureType::Normal);
+            spdlog::info("[ResourcesController]: transcoded {} to {}, {} KiB instead of {} KiB", path.string(),
+                         block_format_name(compressed->format), compressed->data.size() / 1024,
+                         image.pixels.size() * 4 / 3 / 1024);
+        }
+        if (!key.has_value()) {
+            if (compressed.has_value()) {
+                return std::move(compressed.value());
+            }
+            return image;
+        }
+        auto baked = compressed.has_value()
+                         ? BakedTexture::bake(key.value(), compressed.value())
+                         : BakedTexture::bake(key.value(), image);
+        if (!baked.write(baked_path)) {
+            spdlog::warn("[ResourcesController]: failed to write the baked texture {}", baked_path.string());
+        }
+        return baked;
+    }
+
     Skybox *ResourcesController::skybox(const std::string &name,
                                         const std::filesystem::path &path,
                                         bool flip_uvs) {
         auto &result = m_sky_boxes[name];
         if (!result) {
             spdlog::info("Loading skybox: {}", path.string());
-            result = std::make_unique<Skybox>(Skybox(graphics::OpenGL::init_skybox_cube(),
-                                                     graphics::OpenGL::load_skybox_textures(path, flip_uvs),
-                                                     path, name));
+            result         = std::make_unique<Skybox>(Skybox(graphics::OpenGL::init_skybox_cube(), 0, path, name));
+            Skybox *skybox = result.get();
+            if (async_loading()) {
+                using Faces = std::array<Image, 6>;
+                load_async<Faces>([path, flip_uvs] {
+                    return graphics::OpenGL::decode_skybox_faces(path, flip_uvs);
+                }, [skybox](Faces faces) {
+                    graphics::TextureUploader::instance()->upload_cubemap(std::move(faces), [skybox](uint32_t id) {
+                        skybox->m_texture_id = id;
+                    });
+                });
+            } else {
+                skybox->m_texture_id = graphics::OpenGL::load_skybox_textures(path, flip_uvs);
+            }
+        }
+        return result.get();
+    }
+
+    Material *ResourcesController::material(const std::string &name, std::vector<Texture *> textures,
+                                            const graphics::MaterialBlock &constants) {
+        auto &result = m_materials[name];
+        if (!result) {
+            result = std::unique_ptr<Material>(new Material(name, std::move(textures), constants));
         }
         return result.get();
     }
@@ -170,9 +691,22 @@ namespace engine::resources {
         return result.get();
     }
 
-    std::vector<Mesh> AssimpSceneProcessor::process_meshes() {
+    std::vector<MeshData> AssimpSceneProcessor::process_meshes() {
         m_meshes.clear();
+        m_optimization_stats = {};
         process_node(m_scene->mRootNode);
+        if (m_settings.mesh_optimization.enabled && m_optimization_stats.before.triangles > 0) {
+            const auto &[vertices_before, vertices_after, before, after] = m_optimization_stats;
+            auto acmr = [](const VertexCacheStats &stats) {
+                return static_cast<float>(stats.transformed) / static_cast<float>(stats.triangles);
+            };
+            auto atvr = [](const VertexCacheStats &stats) {
+                return static_cast<float>(stats.transformed) / static_cast<float>(std::max(stats.referenced, 1u));
+            };
+            spdlog::info("[AssimpSceneProcessor]: optimized {} meshes of {}: {} -> {} vertices, ACMR {:.3f} -> {:.3f}, "
+                         "ATVR {:.3f} -> {:.3f}", m_meshes.size(), m_model_path.string(), vertices_before,
+                         vertices_after, acmr(before), acmr(after), atvr(before), atvr(after));
+        }
         return std::move(m_meshes);
     }
 
@@ -225,13 +759,63 @@ namespace engine::resources {
             }
         }
 
-        auto material                   = m_scene->mMaterials[mesh->mMaterialIndex];
-        std::vector<Texture *> textures = process_materials(material);
-        m_meshes.emplace_back(Mesh(vertices, indices, std::move(textures)));
+        if (m_settings.mesh_optimization.enabled) {
+            const auto stats = MeshOptimizer::optimize(vertices, indices, m_settings.mesh_optimization);
+            spdlog::debug("[AssimpSceneProcessor]: mesh {}: {} -> {} vertices, ACMR {:.3f} -> {:.3f}, "
+                          "ATVR {:.3f} -> {:.3f}", mesh->mName.C_Str(), stats.vertices_before, stats.vertices_after,
+                          stats.before.acmr, stats.after.acmr, stats.before.atvr, stats.after.atvr);
+            auto accumulate = [](VertexCacheStats &total, const VertexCacheStats &mesh_stats) {
+                total.triangles += mesh_stats.triangles;
+                total.referenced += mesh_stats.referenced;
+                total.transformed += mesh_stats.transformed;
+            };
+            m_optimization_stats.vertices_before += stats.vertices_before;
+            m_optimization_stats.vertices_after += stats.vertices_after;
+            accumulate(m_optimization_stats.before, stats.before);
+            accumulate(m_optimization_stats.after, stats.after);
+        }
+
+        auto material = m_scene->mMaterials[mesh->mMaterialIndex];
+        auto bounds   = Mesh::compute_bounds(vertices);
+        std::vector<MeshLod> lods;
+        if (m_settings.lods.levels > 0) {
+            if (!m_settings.mesh_optimization.enabled) {
+                // Collapsing an edge moves the vertices of all the triangles around it, which requires shared vertices.
+                MeshOptimizer::deduplicate_vertices(vertices, indices);
+            }
+            lods = MeshSimplifier::generate_lods(vertices, indices, bounds.sphere.radius, m_settings.lods);
+            for (uint32_t level = 1; level < lods.size(); ++level) {
+                spdlog::debug("[AssimpSceneProcessor]: mesh {} LOD {}: {} triangles, error {:.4f}", mesh->mName.C_Str(),
+                              level, lods[level].index_count / 3, lods[level].error);
+            }
+        }
+        auto vertex_format = graphics::choose_vertex_format(vertices, bounds, m_settings.vertex_compression);
+        m_meshes.emplace_back(MeshData{std::move(vertices), std::move(indices), process_materials(material), bounds,
+                                       mesh->mMaterialIndex, process_material_constants(material), vertex_format,
+                                       std::move(lods)});
+    }
+
+    graphics::MaterialBlock AssimpSceneProcessor::process_material_constants(const aiMaterial *material) {
+        graphics::MaterialBlock constants;
+        aiColor4D color;
+        if (material->Get(AI_MATKEY_COLOR_DIFFUSE, color) == AI_SUCCESS) {
+            constants.diffuse = glm::vec4(color.r, color.g, color.b, 1.0f);
+        }
+        if (material->Get(AI_MATKEY_COLOR_SPECULAR, color) == AI_SUCCESS) {
+            constants.specular = glm::vec4(color.r, color.g, color.b, 1.0f);
+        }
+        float value = 0.0f;
+        if (material->Get(AI_MATKEY_OPACITY, value) == AI_SUCCESS) {
+            constants.diffuse.a = value;
+        }
+        if (material->Get(AI_MATKEY_SHININESS, value) == AI_SUCCESS && value > 0.0f) {
+            constants.shininess = value;
+        }
+        return constants;
     }
 
-    std::vector<Texture *> AssimpSceneProcessor::process_materials(const aiMaterial *material) {
-        std::vector<Texture *> textures;
+    std::vector<TextureReference> AssimpSceneProcessor::process_materials(const aiMaterial *material) {
+        std::vector<TextureReference> textures;
         auto ai_texture_types = {
                 aiTextureType_DIFFUSE,
                 aiTextureType_SPECULAR,
@@ -245,16 +829,14 @@ namespace engine::resources {
         return textures;
     }
 
-    void AssimpSceneProcessor::process_material_type(std::vector<Texture *> &textures, const aiMaterial *material,
-                                                     aiTextureType type) {
+    void AssimpSceneProcessor::process_material_type(std::vector<TextureReference> &textures,
+                                                     const aiMaterial *material, aiTextureType type) {
         auto material_count = material->GetTextureCount(type);
         for (uint32_t i = 0; i < material_count; ++i) {
             aiString ai_texture_path_string;
             material->GetTexture(type, i, &ai_texture_path_string);
             std::filesystem::path texture_path = m_model_path.parent_path() / ai_texture_path_string.C_Str();
-            Texture *texture                   = m_resources_controller->texture(texture_path.string(), texture_path,
-                                                               assimp_texture_type_to_engine(type));
-            textures.emplace_back(texture);
+            textures.emplace_back(TextureReference{std::move(texture_path), assimp_texture_type_to_engine(type)});
         }
     }
 
@@ -1,71 +1,134 @@
 #include <glad/glad.h>
 #include <engine/resources/Shader.hpp>
+#include <engine/resources/Material.hpp>
 #include <engine/graphics/OpenGL.hpp>
+#include <algorithm>
 
 namespace engine::resources {
 
     void Shader::use() const {
-        glUseProgram(m_shaderId);
+        graphics::OpenGL::use_program(m_shaderId);
     }
 
     void Shader::destroy() const {
         glDeleteProgram(m_shaderId);
+        graphics::OpenGL::invalidate_state();
     }
 
     unsigned Shader::id() const {
         return m_shaderId;
     }
 
+    UniformHandle Shader::uniform(std::string_view name) const {
+        if (auto it = m_uniforms.find(name); it != m_uniforms.end()) {
+            return UniformHandle{it->second};
+        }
+        return UniformHandle{};
+    }
+
+    int32_t Shader::sampler_unit(std::string_view name) const {
+        if (auto it = m_sampler_units.find(name); it != m_sampler_units.end()) {
+            return it->second;
+        }
+        return -1;
+    }
+
+    std::span<const int8_t> Shader::texture_units(const Material &material) const {
+        auto bindings = std::find_if(m_texture_bindings.begin(), m_texture_bindings.end(), [&](const auto &entry) {
+            return entry.sampler_layout == material.sampler_layout() &&
+                   entry.units.size() == material.texture_types().size();
+        });
+        if (bindings == m_texture_bindings.end()) {
+            TextureBindings created{material.sampler_layout(), {}};
+            for (const auto &name: material.sampler_uniform_names()) {
+                created.units.push_back(static_cast<int8_t>(sampler_unit(name)));
+            }
+            bindings = m_texture_bindings.insert(m_texture_bindings.end(), std::move(created));
+        }
+        return bindings->units;
+    }
+
     void Shader::set_bool(const std::string &name, bool value) const {
-        uint32_t location = CHECKED_GL_CALL(glGetUniformLocation, m_shaderId, name.c_str());
-        CHECKED_GL_CALL(glUniform1i, location, static_cast<int>(value));
+        set_bool(uniform(name), value);
     }
 
     void Shader::set_int(const std::string &name, int value) const {
-        uint32_t location = CHECKED_GL_CALL(glGetUniformLocation, m_shaderId, name.c_str());
-        CHECKED_GL_CALL(glUniform1i, location, value);
+        set_int(uniform(name), value);
     }
 
     void Shader::set_float(const std::string &name, float value) const {
-        uint32_t location = CHECKED_GL_CALL(glGetUniformLocation, m_shaderId, name.c_str());
-        CHECKED_GL_CALL(glUniform1f, location, value);
+        set_float(uniform(name), value);
     }
 
     void Shader::set_vec2(const std::string &name, const glm::vec2 &value) const {
-        uint32_t location = CHECKED_GL_CALL(glGetUniformLocation, m_shaderId, name.c_str());
-        CHECKED_GL_CALL(glUniform2fv, location, 1, &value[0]);
+        set_vec2(uniform(name), value);
     }
 
     void Shader::set_vec3(const std::string &name, const glm::vec3 &value) const {
-        uint32_t location = CHECKED_GL_CALL(glGetUniformLocation, m_shaderId, name.c_str());
-        CHECKED_GL_CALL(glUniform3fv, location, 1, &value[0]);
+        set_vec3(uniform(name), value);
     }
 
     void Shader::set_vec4(const std::string &name, const glm::vec4 &value) const {
-        uint32_t location = CHECKED_GL_CALL(glGetUniformLocation, m_shaderId, name.c_str());
-        CHECKED_GL_CALL(glUniform4fv, location, 1, &value[0]);
+        set_vec4(uniform(name), value);
     }
 
     void Shader::set_mat2(const std::string &name, const glm::mat2 &mat) const {
-        uint32_t location = CHECKED_GL_CALL(glGetUniformLocation, m_shaderId, name.c_str());
-        CHECKED_GL_CALL(glUniformMatrix2fv, location, 1, GL_FALSE, &mat[0][0]);
+        set_mat2(uniform(name), mat);
     }
 
     void Shader::set_mat3(const std::string &name, const glm::mat3 &mat) const {
-        uint32_t location = CHECKED_GL_CALL(glGetUniformLocation, m_shaderId, name.c_str());
-        CHECKED_GL_CALL(glUniformMatrix3fv, location, 1, GL_FALSE, &mat[0][0]);
+        set_mat3(uniform(name), mat);
     }
 
     void Shader::set_mat4(const std::string &name, const glm::mat4 &mat) const {
-        uint32_t location = CHECKED_GL_CALL(glGetUniformLocation, m_shaderId, name.c_str());
-        CHECKED_GL_CALL(glUniformMatrix4fv, location, 1, GL_FALSE, &mat[0][0]);
+        set_mat4(uniform(name), mat);
+    }
+
+    void Shader::set_bool(UniformHandle uniform, bool value) const {
+        CHECKED_GL_CALL(glUniform1i, uniform.location, static_cast<int>(value));
+    }
+
+    void Shader::set_int(UniformHandle uniform, int value) const {
+        CHECKED_GL_CALL(glUniform1i, uniform.location, value);
+    }
+
+    void Shader::set_float(UniformHandle uniform, float value) const {
+        CHECKED_GL_CALL(glUniform1f, uniform.location, value);
+    }
+
+    void Shader::set_vec2(UniformHandle uniform, const glm::vec2 &value) const {
+        CHECKED_GL_CALL(glUniform2fv, uniform.location, 1, &value[0]);
+    }
+
+    void Shader::set_vec3(UniformHandle uniform, const glm::vec3 &value) const {
+        CHECKED_GL_CALL(glUniform3fv, uniform.location, 1, &value[0]);
+    }
+
+    void Shader::set_vec4(UniformHandle uniform, const glm::vec4 &value) const {
+        CHECKED_GL_CALL(glUniform4fv, uniform.location, 1, &value[0]);
+    }
+
+    void Shader::set_mat2(UniformHandle uniform, const glm::mat2 &mat) const {
+        CHECKED_GL_CALL(glUniformMatrix2fv, uniform.location, 1, GL_FALSE, &mat[0][0]);
+    }
+
+    void Shader::set_mat3(UniformHandle uniform, const glm::mat3 &mat) const {
+        CHECKED_GL_CALL(glUniformMatrix3fv, uniform.location, 1, GL_FALSE, &mat[0][0]);
+    }
+
+    void Shader::set_mat4(UniformHandle uniform, const glm::mat4 &mat) const {
+        CHECKED_GL_CALL(glUniformMatrix4fv, uniform.location, 1, GL_FALSE, &mat[0][0]);
     }
 
-    Shader::Shader(unsigned shader_id, std::string name, std::string source, std::filesystem::path source_path):
+    Shader::Shader(unsigned shader_id, std::string name, std::string source, std::filesystem::path source_path,
+                   UniformLocations uniforms, SamplerUnits sampler_units, uint32_t uniform_blocks):
     m_shaderId(shader_id)
   , m_name(std::move(name))
   , m_source(std::move(source))
-  , m_source_path(std::move(source_path)) {
+  , m_source_path(std::move(source_path))
+  , m_uniforms(std::move(uniforms))
+  , m_sampler_units(std::move(sampler_units))
+  , m_uniform_blocks(uniform_blocks) {
     }
 
 }
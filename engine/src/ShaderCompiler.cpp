@@ -15,7 +15,9 @@ namespace engine::resources {
         ShaderCompiler compiler(std::move(shader_name), std::move(shader_source));
         ShaderParsingResult parsing_result     = compiler.parse_source();
         OpenGL::ShaderProgramId shader_program = compiler.compile(parsing_result);
-        Shader result(shader_program, shader_name, shader_source, "");
+        Shader result(shader_program, std::move(compiler.m_shader_name), std::move(compiler.m_sources), "",
+                      std::move(compiler.m_uniforms), std::move(compiler.m_sampler_units),
+                      compiler.m_uniform_blocks);
         return result;
     }
 
@@ -40,6 +42,15 @@ namespace engine::resources {
             glAttachShader(shader_program_id, geometry_shader_id);
         }
         glLinkProgram(shader_program_id);
+        if (!OpenGL::shader_program_linked_successfully(shader_program_id)) {
+            std::string message = OpenGL::get_link_error_message(shader_program_id);
+            glDeleteProgram(shader_program_id);
+            throw util::EngineError(util::EngineError::Type::ShaderCompilationError,
+                                    std::format("Shader program {} linking failed:\n{}", m_shader_name, message));
+        }
+        m_uniforms       = OpenGL::get_active_uniforms(shader_program_id);
+        m_sampler_units  = OpenGL::assign_sampler_units(shader_program_id);
+        m_uniform_blocks = OpenGL::bind_uniform_blocks(shader_program_id);
         return shader_program_id;
     }
 
@@ -87,7 +98,8 @@ namespace engine::resources {
         ShaderCompiler compiler(std::move(shader_name), std::move(shader_source));
         ShaderParsingResult parsing_result     = compiler.parse_source();
         OpenGL::ShaderProgramId shader_program = compiler.compile(parsing_result);
-        Shader result(shader_program, shader_name, shader_source, shader_path);
+        Shader result(shader_program, std::move(compiler.m_shader_name), std::move(compiler.m_sources), shader_path,
+                      std::move(compiler.m_uniforms));
         return result;
     }
 
@@ -1,4 +1,6 @@
 #include <glad/glad.h>
+#include <engine/graphics/OpenGL.hpp>
+#include <engine/graphics/TextureStreamer.hpp>
 #include <engine/resources/Texture.hpp>
 #include <engine/util/Errors.hpp>
 
@@ -14,13 +16,14 @@ namespace engine::resources {
     }
 
     void Texture::destroy() {
+        graphics::TextureStreamer::instance()->remove(m_id);
         glDeleteTextures(1, &m_id);
+        graphics::OpenGL::invalidate_state();
     }
 
     void Texture::bind(int32_t sampler) {
         RG_GUARANTEE(sampler >= GL_TEXTURE0 && sampler <= GL_TEXTURE31, "sampler out of range");
-        glActiveTexture(sampler);
-        glBindTexture(GL_TEXTURE_2D, m_id);
+        graphics::OpenGL::bind_texture(sampler - GL_TEXTURE0, GL_TEXTURE_2D, m_id);
     }
 
     std::string_view Texture::uniform_name_convention(TextureType type) {
@@ -0,0 +1,521 @@
+#include <engine/resources/TextureCompressor.hpp>
+#include <engine/util/Errors.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <string>
+
+namespace engine::resources {
+    namespace {
+        /**
+        * @brief The 16 pixels of a 4x4 block, RGBA, row by row.
+        */
+        using Block = std::array<uint8_t, 64>;
+
+        /**
+        * @brief Expands the pixels of the `image` to RGBA. Gray images are copied into all three colors.
+        */
+        Image to_rgba(const Image &image) {
+            Image rgba;
+            rgba.width    = image.width;
+            rgba.height   = image.height;
+            rgba.channels = 4;
+            const std::size_t pixel_count = static_cast<std::size_t>(image.width) * image.height;
+            rgba.pixels.resize(pixel_count * 4);
+            for (std::size_t pixel = 0; pixel < pixel_count; ++pixel) {
+                const uint8_t *source = image.pixels.data() + pixel * image.channels;
+                uint8_t *target       = rgba.pixels.data() + pixel * 4;
+                switch (image.channels) {
+                case 1:
+                case 2: target[0] = target[1] = target[2] = source[0];
+                    target[3] = image.channels == 2 ? source[1] : 255;
+                    break;
+                case 3: std::memcpy(target, source, 3);
+                    target[3] = 255;
+                    break;
+                case 4: std::memcpy(target, source, 4);
+                    break;
+                default: RG_SHOULD_NOT_REACH_HERE("Unknown channels {}", image.channels);
+                }
+            }
+            return rgba;
+        }
+
+        /**
+        * @brief Scales the averaged normals of a mip level back to unit length. The average of unit vectors
+        * is shorter than 1, and shading with it darkens the distant surfaces.
+        */
+        void renormalize(Image &rgba) {
+            for (std::size_t pixel = 0; pixel < rgba.pixels.size(); pixel += 4) {
+                std::array<float, 3> normal;
+                for (int32_t axis = 0; axis < 3; ++axis) {
+                    normal[axis] = rgba.pixels[pixel + axis] / 127.5f - 1.0f;
+                }
+                const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                if (length < 1e-6f) {
+                    continue;
+                }
+                for (int32_t axis = 0; axis < 3; ++axis) {
+                    rgba.pixels[pixel + axis] = static_cast<uint8_t>(std::lround(
+                            std::clamp((normal[axis] / length + 1.0f) * 127.5f, 0.0f, 255.0f)));
+                }
+            }
+        }
+
+        /**
+        * @brief Copies the block at (`block_x`, `block_y`), repeating the last row and column for the blocks
+        * that stick out of the image.
+        */
+        Block read_block(const Image &rgba, int32_t block_x, int32_t block_y) {
+            Block block;
+            for (int32_t y = 0; y < 4; ++y) {
+                const int32_t source_y = std::min(block_y * 4 + y, rgba.height - 1);
+                for (int32_t x = 0; x < 4; ++x) {
+                    const int32_t source_x = std::min(block_x * 4 + x, rgba.width - 1);
+                    std::memcpy(&block[(y * 4 + x) * 4],
+                                &rgba.pixels[(static_cast<std::size_t>(source_y) * rgba.width + source_x) * 4], 4);
+                }
+            }
+            return block;
+        }
+
+        /**
+        * @brief Finds the unit direction in which the first `Channels` channels of the block vary the most, with power
+        * iteration on their covariance matrix.
+        * @returns false if all the pixels are the same.
+        */
+        template<int Channels>
+        bool principal_axis(const Block &block, std::array<float, Channels> &mean, std::array<float, Channels> &axis) {
+            mean.fill(0.0f);
+            for (int32_t pixel = 0; pixel < 16; ++pixel) {
+                for (int32_t channel = 0; channel < Channels; ++channel) {
+                    mean[channel] += block[pixel * 4 + channel] / 16.0f;
+                }
+            }
+            std::array<std::array<float, Channels>, Channels> covariance{};
+            for (int32_t pixel = 0; pixel < 16; ++pixel) {
+                std::array<float, Channels> delta;
+                for (int32_t channel = 0; channel < Channels; ++channel) {
+                    delta[channel] = block[pixel * 4 + channel] - mean[channel];
+                }
+                for (int32_t row = 0; row < Channels; ++row) {
+                    for (int32_t column = 0; column < Channels; ++column) {
+                        covariance[row][column] += delta[row] * delta[column];
+                    }
+                }
+            }
+            // Start from the covariances of the channel that varies the most.
+            int32_t largest = 0;
+            for (int32_t channel = 1; channel < Channels; ++channel) {
+                if (covariance[channel][channel] > covariance[largest][largest]) {
+                    largest = channel;
+                }
+            }
+            if (covariance[largest][largest] < 1e-3f) {
+                return false;
+            }
+            axis = covariance[largest];
+            for (int32_t iteration = 0; iteration < 8; ++iteration) {
+                std::array<float, Channels> next{};
+                float length = 0.0f;
+                for (int32_t row = 0; row < Channels; ++row) {
+                    for (int32_t column = 0; column < Channels; ++column) {
+                        next[row] += covariance[row][column] * axis[column];
+                    }
+                    length = std::max(length, std::abs(next[row]));
+                }
+                if (length < 1e-12f) {
+                    return false;
+                }
+                for (int32_t channel = 0; channel < Channels; ++channel) {
+                    axis[channel] = next[channel] / length;
+                }
+            }
+            float length = 0.0f;
+            for (int32_t channel = 0; channel < Channels; ++channel) {
+                length += axis[channel] * axis[channel];
+            }
+            length = std::sqrt(length);
+            for (int32_t channel = 0; channel < Channels; ++channel) {
+                axis[channel] /= length;
+            }
+            return true;
+        }
+
+        uint16_t to_565(const std::array<float, 3> &color) {
+            const auto r = static_cast<uint16_t>(std::lround(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f));
+            const auto g = static_cast<uint16_t>(std::lround(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f));
+            const auto b = static_cast<uint16_t>(std::lround(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f));
+            return static_cast<uint16_t>(r << 11 | g << 5 | b);
+        }
+
+        std::array<float, 3> from_565(uint16_t color) {
+            const uint32_t r = color >> 11 & 31;
+            const uint32_t g = color >> 5 & 63;
+            const uint32_t b = color & 31;
+            return {
+                    static_cast<float>(r << 3 | r >> 2), static_cast<float>(g << 2 | g >> 4),
+                    static_cast<float>(b << 3 | b >> 2)
+            };
+        }
+
+        /**
+        * @brief Picks the nearest of the 4 colors between the endpoints for every pixel, and writes the BC1 block
+        * in the 4 color mode, which needs the first endpoint to be the larger one.
+        * @returns The squared error of the block.
+        */
+        float write_bc1(const Block &block, uint16_t color0, uint16_t color1, uint8_t *out) {
+            if (color0 < color1) {
+                std::swap(color0, color1);
+            }
+            const auto end0 = from_565(color0);
+            const auto end1 = from_565(color1);
+            std::array<std::array<float, 3>, 4> palette = {end0, end1, end0, end1};
+            for (int32_t channel = 0; channel < 3; ++channel) {
+                palette[2][channel] = (2.0f * end0[channel] + end1[channel]) / 3.0f;
+                palette[3][channel] = (end0[channel] + 2.0f * end1[channel]) / 3.0f;
+            }
+            uint32_t indices = 0;
+            float error      = 0.0f;
+            for (int32_t pixel = 0; pixel < 16; ++pixel) {
+                uint32_t best_index = 0;
+                float best_error    = INFINITY;
+                // With equal endpoints the block is in the 3 color mode, and index 3 is black; index 0 is exact anyway.
+                const uint32_t index_count = color0 == color1 ? 1 : 4;
+                for (uint32_t index = 0; index < index_count; ++index) {
+                    float distance = 0.0f;
+                    for (int32_t channel = 0; channel < 3; ++channel) {
+                        const float delta = palette[index][channel] - block[pixel * 4 + channel];
+                        distance += delta * delta;
+                    }
+                    if (distance < best_error) {
+                        best_error = distance;
+                        best_index = index;
+                    }
+                }
+                indices |= best_index << (2 * pixel);
+                error += best_error;
+            }
+            std::memcpy(out, &color0, 2);
+            std::memcpy(out + 2, &color1, 2);
+            std::memcpy(out + 4, &indices, 4);
+            return error;
+        }
+
+        void encode_bc1(const Block &block, uint8_t *out) {
+            std::array<float, 3> mean;
+            std::array<float, 3> axis;
+            if (!principal_axis<3>(block, mean, axis)) {
+                const uint16_t color = to_565(mean);
+                write_bc1(block, color, color, out);
+                return;
+            }
+            float min_t = INFINITY;
+            float max_t = -INFINITY;
+            for (int32_t pixel = 0; pixel < 16; ++pixel) {
+                float t = 0.0f;
+                for (int32_t channel = 0; channel < 3; ++channel) {
+                    t += (block[pixel * 4 + channel] - mean[channel]) * axis[channel];
+                }
+                min_t = std::min(min_t, t);
+                max_t = std::max(max_t, t);
+            }
+            // Pulling the endpoints in by a sixteenth of the range lowers the error of the 565 rounding on average.
+            const float inset = (max_t - min_t) / 16.0f;
+            std::array<float, 3> end0;
+            std::array<float, 3> end1;
+            for (int32_t channel = 0; channel < 3; ++channel) {
+                end0[channel] = mean[channel] + axis[channel] * (max_t - inset);
+                end1[channel] = mean[channel] + axis[channel] * (min_t + inset);
+            }
+            float error = write_bc1(block, to_565(end0), to_565(end1), out);
+
+            // Refit the endpoints to the chosen indices by least squares, and keep them if they're better.
+            uint32_t indices = 0;
+            std::memcpy(&indices, out + 4, 4);
+            uint16_t color0 = 0;
+            uint16_t color1 = 0;
+            std::memcpy(&color0, out, 2);
+            std::memcpy(&color1, out + 2, 2);
+            if (color0 == color1) {
+                return;
+            }
+            constexpr std::array<float, 4> weights = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+            float aa = 0.0f;
+            float ab = 0.0f;
+            float bb = 0.0f;
+            std::array<float, 3> ap{};
+            std::array<float, 3> bp{};
+            for (int32_t pixel = 0; pixel < 16; ++pixel) {
+                const float a = weights[indices >> (2 * pixel) & 3];
+                const float b = 1.0f - a;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (int32_t channel = 0; channel < 3; ++channel) {
+                    ap[channel] += a * block[pixel * 4 + channel];
+                    bp[channel] += b * block[pixel * 4 + channel];
+                }
+            }
+            const float determinant = aa * bb - ab * ab;
+            if (std::abs(determinant) < 1e-6f) {
+                return;
+            }
+            for (int32_t channel = 0; channel < 3; ++channel) {
+                end0[channel] = (bb * ap[channel] - ab * bp[channel]) / determinant;
+                end1[channel] = (aa * bp[channel] - ab * ap[channel]) / determinant;
+            }
+            std::array<uint8_t, 8> refined;
+            if (write_bc1(block, to_565(end0), to_565(end1), refined.data()) < error) {
+                std::memcpy(out, refined.data(), refined.size());
+            }
+        }
+
+        /**
+        * @brief Encodes one channel of the block between its minimum and maximum, in the mode with 6 interpolated values.
+        */
+        void encode_bc4(const Block &block, int32_t channel, uint8_t *out) {
+            uint8_t low  = 255;
+            uint8_t high = 0;
+            for (int32_t pixel = 0; pixel < 16; ++pixel) {
+                low  = std::min(low, block[pixel * 4 + channel]);
+                high = std::max(high, block[pixel * 4 + channel]);
+            }
+            out[0]           = high;
+            out[1]           = low;
+            uint64_t indices = 0;
+            if (high != low) {
+                for (int32_t pixel = 0; pixel < 16; ++pixel) {
+                    // The position between the endpoints, 0 at high and 7 at low; index 0 is high, 1 is low
+                    // and 2 to 7 are the values in between.
+                    const auto step = static_cast<uint64_t>(
+                            std::lround(7.0f * (high - block[pixel * 4 + channel]) / (high - low)));
+                    const uint64_t index = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+                    indices |= index << (3 * pixel);
+                }
+            }
+            std::memcpy(out + 2, &indices, 6);
+        }
+
+        /**
+        * @brief Writes bits into a block from the lowest bit of its first byte up. The block has to start zeroed.
+        */
+        class BitWriter {
+        public:
+            explicit BitWriter(uint8_t *out) : m_out(out) {
+            }
+
+            void write(uint32_t value, uint32_t bits) {
+                for (uint32_t bit = 0; bit < bits; ++bit, ++m_position) {
+                    if (value >> bit & 1) {
+                        m_out[m_position / 8] |= static_cast<uint8_t>(1 << m_position % 8);
+                    }
+                }
+            }
+
+        private:
+            uint8_t *m_out;
+            uint32_t m_position{0};
+        };
+
+        constexpr std::array<int32_t, 16> BC7_WEIGHTS = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        /**
+        * @brief Quantizes an RGBA endpoint to the 7 bits per channel and the shared lowest bit of BC7 mode 6,
+        * choosing the lowest bit that is closer.
+        */
+        std::array<int32_t, 4> quantize_bc7_endpoint(const std::array<float, 4> &endpoint, uint32_t &p_bit) {
+            std::array<int32_t, 4> best{};
+            float best_error = INFINITY;
+            for (uint32_t p = 0; p < 2; ++p) {
+                std::array<int32_t, 4> quantized;
+                float error = 0.0f;
+                for (int32_t channel = 0; channel < 4; ++channel) {
+                    const float value = std::clamp(endpoint[channel], 0.0f, 255.0f);
+                    const int32_t q   = std::clamp(static_cast<int32_t>(std::lround((value - p) / 2.0f)), 0, 127);
+                    quantized[channel] = q << 1 | static_cast<int32_t>(p);
+                    error += (quantized[channel] - value) * (quantized[channel] - value);
+                }
+                if (error < best_error) {
+                    best_error = error;
+                    best       = quantized;
+                    p_bit      = p;
+                }
+            }
+            return best;
+        }
+
+        void encode_bc7(const Block &block, uint8_t *out) {
+            std::array<float, 4> mean;
+            std::array<float, 4> axis;
+            std::array<float, 4> end0;
+            std::array<float, 4> end1;
+            if (principal_axis<4>(block, mean, axis)) {
+                float min_t = INFINITY;
+                float max_t = -INFINITY;
+                for (int32_t pixel = 0; pixel < 16; ++pixel) {
+                    float t = 0.0f;
+                    for (int32_t channel = 0; channel < 4; ++channel) {
+                        t += (block[pixel * 4 + channel] - mean[channel]) * axis[channel];
+                    }
+                    min_t = std::min(min_t, t);
+                    max_t = std::max(max_t, t);
+                }
+                for (int32_t channel = 0; channel < 4; ++channel) {
+                    end0[channel] = mean[channel] + axis[channel] * min_t;
+                    end1[channel] = mean[channel] + axis[channel] * max_t;
+                }
+            } else {
+                end0 = end1 = mean;
+            }
+            uint32_t p0 = 0;
+            uint32_t p1 = 0;
+            auto e0     = quantize_bc7_endpoint(end0, p0);
+            auto e1     = quantize_bc7_endpoint(end1, p1);
+
+            std::array<std::array<int32_t, 4>, 16> palette;
+            for (int32_t index = 0; index < 16; ++index) {
+                for (int32_t channel = 0; channel < 4; ++channel) {
+                    palette[index][channel] = (e0[channel] * (64 - BC7_WEIGHTS[index]) +
+                                               e1[channel] * BC7_WEIGHTS[index] + 32) >> 6;
+                }
+            }
+            std::array<int32_t, 4> direction;
+            int32_t length = 0;
+            for (int32_t channel = 0; channel < 4; ++channel) {
+                direction[channel] = e1[channel] - e0[channel];
+                length += direction[channel] * direction[channel];
+            }
+            std::array<uint32_t, 16> indices{};
+            for (int32_t pixel = 0; pixel < 16 && length > 0; ++pixel) {
+                // Project onto the line for the first guess, then check the neighbours against the rounded palette.
+                int32_t dot = 0;
+                for (int32_t channel = 0; channel < 4; ++channel) {
+                    dot += (block[pixel * 4 + channel] - e0[channel]) * direction[channel];
+                }
+                const int32_t weight = std::clamp(dot * 64 / length, 0, 64);
+                const auto guess     = static_cast<int32_t>(
+                        std::lower_bound(BC7_WEIGHTS.begin(), BC7_WEIGHTS.end(), weight) - BC7_WEIGHTS.begin());
+                int32_t best_error = INT32_MAX;
+                for (int32_t index = std::max(guess - 1, 0); index <= std::min(guess + 1, 15); ++index) {
+                    int32_t error = 0;
+                    for (int32_t channel = 0; channel < 4; ++channel) {
+                        const int32_t delta = palette[index][channel] - block[pixel * 4 + channel];
+                        error += delta * delta;
+                    }
+                    if (error < best_error) {
+                        best_error     = error;
+                        indices[pixel] = static_cast<uint32_t>(index);
+                    }
+                }
+            }
+            // The highest bit of the first index is implied 0; swapping the endpoints makes it so.
+            if (indices[0] & 8) {
+                std::swap(e0, e1);
+                std::swap(p0, p1);
+                for (auto &index: indices) {
+                    index = 15 - index;
+                }
+            }
+
+            std::memset(out, 0, 16);
+            BitWriter writer(out);
+            writer.write(1 << 6, 7);
+            for (int32_t channel = 0; channel < 4; ++channel) {
+                writer.write(static_cast<uint32_t>(e0[channel] >> 1), 7);
+                writer.write(static_cast<uint32_t>(e1[channel] >> 1), 7);
+            }
+            writer.write(p0, 1);
+            writer.write(p1, 1);
+            writer.write(indices[0], 3);
+            for (int32_t pixel = 1; pixel < 16; ++pixel) {
+                writer.write(indices[pixel], 4);
+            }
+        }
+
+        void encode_block(BlockFormat format, const Block &block, uint8_t *out) {
+            switch (format) {
+            case BlockFormat::BC1: encode_bc1(block, out);
+                break;
+            case BlockFormat::BC3: encode_bc4(block, 3, out);
+                encode_bc1(block, out + 8);
+                break;
+            case BlockFormat::BC4: encode_bc4(block, 0, out);
+                break;
+            case BlockFormat::BC5: encode_bc4(block, 0, out);
+                encode_bc4(block, 1, out + 8);
+                break;
+            case BlockFormat::BC7: encode_bc7(block, out);
+                break;
+            default: RG_SHOULD_NOT_REACH_HERE("Unknown block format {}", static_cast<uint32_t>(format));
+            }
+        }
+
+        bool supports(uint32_t supported_formats, BlockFormat format) {
+            return supported_formats & 1u << static_cast<uint32_t>(format);
+        }
+    } // namespace
+
+    std::optional<BlockFormat> TextureCompressor::choose_format(const Image &image, TextureType type,
+                                                                uint32_t supported_formats,
+                                                                const TextureCompression &settings) {
+        std::optional<BlockFormat> format;
+        if (type == TextureType::Normal) {
+            format = BlockFormat::BC5;
+        } else if (image.channels == 1) {
+            format = BlockFormat::BC4;
+        } else {
+            bool opaque = true;
+            if (image.channels == 2 || image.channels == 4) {
+                for (std::size_t alpha = image.channels - 1; alpha < image.pixels.size() && opaque;
+                     alpha += image.channels) {
+                    opaque = image.pixels[alpha] == 255;
+                }
+            }
+            if (settings.bc7 && supports(supported_formats, BlockFormat::BC7)) {
+                format = BlockFormat::BC7;
+            } else {
+                format = opaque ? BlockFormat::BC1 : BlockFormat::BC3;
+            }
+        }
+        if (!supports(supported_formats, format.value())) {
+            return std::nullopt;
+        }
+        return format;
+    }
+
+    CompressedImage TextureCompressor::compress(const Image &image, BlockFormat format, bool normal_map) {
+        CompressedImage result;
+        result.format          = format;
+        Image level            = to_rgba(image);
+        const std::size_t size = block_size(format);
+        while (true) {
+            auto blocks            = result.add_level(level.width, level.height);
+            const int32_t blocks_x = std::max((level.width + 3) / 4, 1);
+            const int32_t blocks_y = std::max((level.height + 3) / 4, 1);
+            for (int32_t block_y = 0; block_y < blocks_y; ++block_y) {
+                for (int32_t block_x = 0; block_x < blocks_x; ++block_x) {
+                    encode_block(format, read_block(level, block_x, block_y),
+                                 blocks.data() + (static_cast<std::size_t>(block_y) * blocks_x + block_x) * size);
+                }
+            }
+            if (level.width == 1 && level.height == 1) {
+                break;
+            }
+            level = level.next_mip_level();
+            if (normal_map) {
+                renormalize(level);
+            }
+        }
+        return result;
+    }
+
+    uint64_t TextureCompressor::settings_key(TextureType type, bool flip_vertically, uint32_t supported_formats,
+                                             const TextureCompression &settings) {
+        return std::hash<std::string>{}(std::format("{}:{}:{}:{}:{}:{}", static_cast<int32_t>(type), flip_vertically,
+                                                    supported_formats, settings.enabled, settings.bc7, VERSION));
+    }
+} // namespace engine::resources
@@ -0,0 +1,87 @@
+#include <glad/glad.h>
+#include <engine/graphics/OpenGL.hpp>
+#include <engine/resources/TexturePack.hpp>
+#include <engine/util/Errors.hpp>
+
+namespace engine::resources {
+    TexturePack::TexturePack(std::vector<TextureType> types, std::vector<TextureClass> classes,
+                             const std::vector<std::vector<BakedTexture::Level> > &textures, uint32_t capacity)
+    : m_types(std::move(types))
+  , m_classes(std::move(classes))
+  , m_capacity(capacity) {
+        RG_GUARANTEE(m_types.size() == m_classes.size() && m_classes.size() == textures.size(),
+                     "A texture pack needs a class for each of its textures");
+        m_textures.resize(m_classes.size());
+        CHECKED_GL_CALL(glGenTextures, static_cast<GLsizei>(m_textures.size()), m_textures.data());
+        for (std::size_t i = 0; i < m_textures.size(); ++i) {
+            const auto &texture_class = m_classes[i];
+            auto &level_sizes         = m_level_sizes.emplace_back();
+            graphics::OpenGL::bind_texture(0, GL_TEXTURE_2D_ARRAY, m_textures[i]);
+            for (uint32_t level = 0; level < texture_class.level_count; ++level) {
+                const auto &mip = textures[i][level];
+                level_sizes.push_back(mip.data.size());
+                // Only the storage of all the layers; the layers are uploaded by add.
+                if (texture_class.compressed_format != 0) {
+                    CHECKED_GL_CALL(glCompressedTexImage3D, GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level),
+                                    texture_class.compressed_format, mip.width, mip.height,
+                                    static_cast<GLsizei>(m_capacity), 0,
+                                    static_cast<GLsizei>(mip.data.size() * m_capacity), nullptr);
+                } else {
+                    const int32_t format = graphics::OpenGL::texture_format(texture_class.channels);
+                    CHECKED_GL_CALL(glTexImage3D, GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), format, mip.width,
+                                    mip.height, static_cast<GLsizei>(m_capacity), 0, format, GL_UNSIGNED_BYTE,
+                                    nullptr);
+                }
+            }
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL,
+                            static_cast<GLint>(texture_class.level_count - 1));
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+    }
+
+    uint32_t TexturePack::add(const std::vector<std::vector<BakedTexture::Level> > &textures) {
+        RG_GUARANTEE(!full(), "The texture pack is full");
+        RG_GUARANTEE(textures.size() == m_textures.size(), "The material doesn't match the texture pack");
+        const uint32_t layer = m_layer_count++;
+        CHECKED_GL_CALL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+        for (std::size_t i = 0; i < m_textures.size(); ++i) {
+            const auto &texture_class = m_classes[i];
+            graphics::OpenGL::bind_texture(0, GL_TEXTURE_2D_ARRAY, m_textures[i]);
+            for (uint32_t level = 0; level < texture_class.level_count; ++level) {
+                const auto &mip = textures[i][level];
+                RG_GUARANTEE(mip.data.size() == m_level_sizes[i][level], "The level doesn't match the texture pack");
+                if (texture_class.compressed_format != 0) {
+                    CHECKED_GL_CALL(glCompressedTexSubImage3D, GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), 0, 0,
+                                    static_cast<GLint>(layer), mip.width, mip.height, 1,
+                                    texture_class.compressed_format, static_cast<GLsizei>(mip.data.size()),
+                                    mip.data.data());
+                } else {
+                    CHECKED_GL_CALL(glTexSubImage3D, GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), 0, 0,
+                                    static_cast<GLint>(layer), mip.width, mip.height, 1,
+                                    graphics::OpenGL::texture_format(texture_class.channels), GL_UNSIGNED_BYTE,
+                                    mip.data.data());
+                }
+            }
+        }
+        return layer;
+    }
+
+    std::size_t TexturePack::size_bytes() const {
+        std::size_t bytes = 0;
+        for (const auto &level_sizes: m_level_sizes) {
+            for (const auto size: level_sizes) {
+                bytes += size * m_capacity;
+            }
+        }
+        return bytes;
+    }
+
+    void TexturePack::destroy() {
+        CHECKED_GL_CALL(glDeleteTextures, static_cast<GLsizei>(m_textures.size()), m_textures.data());
+        graphics::OpenGL::invalidate_state();
+        m_textures.clear();
+    }
+} // namespace engine::resources
@@ -0,0 +1,271 @@
+#include <glad/glad.h>
+#include <engine/graphics/OpenGL.hpp>
+#include <engine/graphics/TextureStreamer.hpp>
+#include <engine/util/Errors.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+
+namespace engine::graphics {
+    TextureStreamer *TextureStreamer::instance() {
+        static TextureStreamer streamer;
+        return &streamer;
+    }
+
+    void TextureStreamer::initialize(const TextureStreaming &settings) {
+        m_settings           = settings;
+        m_stats.budget_bytes = settings.enabled ? settings.budget_bytes : 0;
+        if (settings.enabled) {
+            spdlog::info("[TextureStreamer]: streaming textures within {} MiB, starting from {}px",
+                         settings.budget_bytes >> 20, settings.initial_size);
+        }
+    }
+
+    void TextureStreamer::terminate() {
+        if (m_settings.enabled) {
+            spdlog::info("[TextureStreamer]: the textures needed {:.1f} MiB at most, {} levels loaded, {} evicted",
+                         m_stats.peak_required_bytes / 1048576.0, m_stats.levels_loaded, m_stats.levels_evicted);
+        }
+        m_entries.clear();
+        m_resident_bytes = 0;
+        m_stats          = Stats{};
+        m_settings       = TextureStreaming{};
+    }
+
+    void TextureStreamer::add(resources::BakedTexture texture, TextureUploader::OnReady on_ready) {
+        if (!m_settings.enabled || texture.level_count() < 2) {
+            TextureUploader::instance()->upload(std::move(texture), std::move(on_ready));
+            return;
+        }
+        const auto block_format = texture.block_format();
+        RG_GUARANTEE(!block_format.has_value() || OpenGL::supported_block_formats() & 1u << static_cast<uint32_t>(*block_format),
+                     "The OpenGL context doesn't support {} textures.", resources::block_format_name(*block_format));
+        auto source = std::make_shared<resources::BakedTexture>(std::move(texture));
+        Entry entry;
+        entry.compressed_format = block_format.has_value() ? OpenGL::compressed_texture_format(*block_format) : 0;
+        for (uint32_t level = 0; level < source->level_count(); ++level) {
+            const auto mip = source->level(level);
+            entry.levels.push_back(TextureUploader::Level{GL_TEXTURE_2D, static_cast<int32_t>(level), mip.width,
+                                                          mip.height, source->channels(), mip.data});
+        }
+        entry.source = std::move(source);
+        start(std::move(entry), std::move(on_ready));
+    }
+
+    void TextureStreamer::add(resources::CompressedImage image, TextureUploader::OnReady on_ready) {
+        if (!m_settings.enabled || image.levels.size() < 2) {
+            TextureUploader::instance()->upload(std::move(image), std::move(on_ready));
+            return;
+        }
+        RG_GUARANTEE(OpenGL::supported_block_formats() & 1u << static_cast<uint32_t>(image.format),
+                     "The OpenGL context doesn't support {} textures.", resources::block_format_name(image.format));
+        auto source = std::make_shared<resources::CompressedImage>(std::move(image));
+        Entry entry;
+        entry.compressed_format = OpenGL::compressed_texture_format(source->format);
+        for (std::size_t level = 0; level < source->levels.size(); ++level) {
+            const auto &mip = source->levels[level];
+            entry.levels.push_back(TextureUploader::Level{GL_TEXTURE_2D, static_cast<int32_t>(level), mip.width,
+                                                          mip.height, 0, std::as_bytes(source->level_data(level))});
+        }
+        entry.source = std::move(source);
+        start(std::move(entry), std::move(on_ready));
+    }
+
+    void TextureStreamer::start(Entry entry, TextureUploader::OnReady on_ready) {
+        const auto level_count = static_cast<int32_t>(entry.levels.size());
+        int32_t coarse_level   = 0;
+        while (coarse_level + 1 < level_count &&
+               std::max(entry.levels[coarse_level].width, entry.levels[coarse_level].height) > m_settings.initial_size) {
+            ++coarse_level;
+        }
+        entry.coarse_level   = coarse_level;
+        entry.required_level = coarse_level;
+        entry.loading_level  = coarse_level;
+        // Nothing is resident until the coarse levels are uploaded.
+        entry.resident_level = level_count;
+
+        uint32_t texture = 0;
+        CHECKED_GL_CALL(glGenTextures, 1, &texture);
+        OpenGL::bind_texture(0, GL_TEXTURE_2D, texture);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, coarse_level);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level_count - 1);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        std::vector coarse_levels(entry.levels.begin() + coarse_level, entry.levels.end());
+        m_resident_bytes += level_bytes(entry, coarse_level);
+        const uint32_t compressed_format = entry.compressed_format;
+        auto source                      = entry.source;
+        m_entries.emplace(texture, std::move(entry));
+        TextureUploader::instance()->upload_levels(texture, compressed_format, std::move(coarse_levels),
+                                                   std::move(source),
+                                                   [this, on_ready = std::move(on_ready)](uint32_t id) {
+                                                       on_loaded(id);
+                                                       on_ready(id);
+                                                   });
+    }
+
+    void TextureStreamer::remove(uint32_t texture) {
+        const auto it = m_entries.find(texture);
+        if (it == m_entries.end()) {
+            return;
+        }
+        TextureUploader::instance()->cancel(texture);
+        const Entry &entry = it->second;
+        m_resident_bytes -= level_bytes(entry, entry.loading_level >= 0
+                                                   ? std::min(entry.loading_level, entry.resident_level)
+                                                   : entry.resident_level);
+        m_entries.erase(it);
+    }
+
+    void TextureStreamer::request(uint32_t texture, float screen_pixels) {
+        if (m_entries.empty()) {
+            return;
+        }
+        const auto it = m_entries.find(texture);
+        if (it == m_entries.end()) {
+            return;
+        }
+        it->second.screen_pixels   = std::max(it->second.screen_pixels, screen_pixels);
+        it->second.last_used_frame = m_frame;
+    }
+
+    void TextureStreamer::on_loaded(uint32_t texture) {
+        const auto it = m_entries.find(texture);
+        if (it == m_entries.end()) {
+            return;
+        }
+        Entry &entry         = it->second;
+        entry.resident_level = std::min(entry.resident_level, entry.loading_level);
+        entry.loading_level  = -1;
+        OpenGL::bind_texture(0, GL_TEXTURE_2D, texture);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.resident_level);
+        ++m_stats.levels_loaded;
+    }
+
+    int32_t TextureStreamer::required_level(const Entry &entry, float screen_pixels) const {
+        if (std::isinf(screen_pixels)) {
+            return 0;
+        }
+        const auto size   = static_cast<float>(std::max(entry.levels.front().width, entry.levels.front().height));
+        const float level = std::floor(std::log2(size / std::max(screen_pixels, 1.0f)) + m_settings.mip_bias);
+        return std::clamp(static_cast<int32_t>(level), 0, entry.coarse_level);
+    }
+
+    void TextureStreamer::end_frame() {
+        if (m_entries.empty()) {
+            ++m_frame;
+            return;
+        }
+        std::vector<uint32_t> wanted;
+        for (auto &[texture, entry]: m_entries) {
+            if (entry.last_used_frame == m_frame) {
+                entry.required_level = required_level(entry, entry.screen_pixels);
+                entry.screen_pixels  = 0.0f;
+            }
+            // The textures that weren't drawn keep the level they last needed, but only the drawn ones stream in,
+            // or the textures out of sight would keep evicting each other's levels.
+            if (entry.last_used_frame == m_frame && entry.loading_level < 0 &&
+                entry.required_level < entry.resident_level) {
+                wanted.push_back(texture);
+            }
+        }
+        // The textures missing the most levels look the blurriest, so they go first.
+        std::sort(wanted.begin(), wanted.end(), [this](uint32_t a, uint32_t b) {
+            const Entry &entry_a = m_entries.at(a);
+            const Entry &entry_b = m_entries.at(b);
+            return entry_a.resident_level - entry_a.required_level > entry_b.resident_level - entry_b.required_level;
+        });
+        bool missed = false;
+        for (const uint32_t texture: wanted) {
+            Entry &entry        = m_entries.at(texture);
+            const int32_t level = entry.resident_level - 1;
+            const auto bytes    = entry.levels[level].data.size();
+            if (!make_room(bytes, texture)) {
+                missed = true;
+                continue;
+            }
+            entry.loading_level = level;
+            m_resident_bytes += bytes;
+            TextureUploader::instance()->upload_levels(texture, entry.compressed_format, {entry.levels[level]},
+                                                       entry.source, [this](uint32_t id) {
+                                                           on_loaded(id);
+                                                       });
+        }
+        if (missed) {
+            ++m_stats.budget_misses;
+        }
+        std::size_t required_bytes = 0;
+        for (const auto &[texture, entry]: m_entries) {
+            required_bytes += level_bytes(entry, entry.required_level);
+        }
+        m_stats.peak_required_bytes = std::max(m_stats.peak_required_bytes, required_bytes);
+        ++m_frame;
+    }
+
+    bool TextureStreamer::make_room(std::size_t bytes, uint32_t texture) {
+        while (m_resident_bytes + bytes > m_settings.budget_bytes) {
+            uint32_t victim     = 0;
+            Entry *victim_entry = nullptr;
+            for (auto &[other, entry]: m_entries) {
+                if (other == texture || entry.loading_level >= 0 || entry.resident_level >= entry.coarse_level) {
+                    continue;
+                }
+                // The textures drawn in this frame only give up the levels finer than they need.
+                if (entry.last_used_frame == m_frame && entry.resident_level >= entry.required_level) {
+                    continue;
+                }
+                if (victim_entry == nullptr || entry.last_used_frame < victim_entry->last_used_frame) {
+                    victim       = other;
+                    victim_entry = &entry;
+                }
+            }
+            if (victim_entry == nullptr) {
+                return false;
+            }
+            evict(victim, *victim_entry);
+        }
+        return true;
+    }
+
+    void TextureStreamer::evict(uint32_t texture, Entry &entry) {
+        const auto &level = entry.levels[entry.resident_level];
+        ++entry.resident_level;
+        m_resident_bytes -= level.data.size();
+        ++m_stats.levels_evicted;
+        OpenGL::bind_texture(0, GL_TEXTURE_2D, texture);
+        CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.resident_level);
+        // An empty level frees its storage; the texture stays complete from the base level on.
+        if (entry.compressed_format != 0) {
+            CHECKED_GL_CALL(glCompressedTexImage2D, GL_TEXTURE_2D, level.level, entry.compressed_format, 0, 0, 0, 0,
+                            nullptr);
+        } else {
+            const int32_t format = OpenGL::texture_format(level.channels);
+            CHECKED_GL_CALL(glTexImage2D, GL_TEXTURE_2D, level.level, format, 0, 0, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        }
+    }
+
+    std::size_t TextureStreamer::level_bytes(const Entry &entry, int32_t first_level) {
+        std::size_t bytes = 0;
+        for (auto level = static_cast<std::size_t>(std::max(first_level, 0)); level < entry.levels.size(); ++level) {
+            bytes += entry.levels[level].data.size();
+        }
+        return bytes;
+    }
+
+    TextureStreamer::Stats TextureStreamer::stats() const {
+        Stats stats          = m_stats;
+        stats.textures       = static_cast<uint32_t>(m_entries.size());
+        stats.resident_bytes = m_resident_bytes;
+        for (const auto &[texture, entry]: m_entries) {
+            stats.loading += entry.loading_level >= 0;
+            stats.streaming_in += entry.loading_level >= 0 && entry.loading_level < entry.coarse_level;
+            stats.fully_resident += entry.loading_level < 0 && entry.resident_level <= entry.required_level;
+            stats.required_bytes += level_bytes(entry, entry.required_level);
+            stats.full_bytes += level_bytes(entry, 0);
+        }
+        return stats;
+    }
+} // namespace engine::graphics
@@ -0,0 +1,365 @@
+#include <glad/glad.h>
+#include <engine/graphics/OpenGL.hpp>
+#include <engine/graphics/TextureUploader.hpp>
+#include <engine/util/Errors.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+
+namespace engine::graphics {
+    namespace {
+        constexpr std::size_t STAGING_ALIGNMENT = 16;
+
+        std::size_t align_up(std::size_t value) {
+            return (value + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+        }
+
+        /**
+        * @brief Returns the offset into the bound pixel unpack buffer in the form the `gl*TexSubImage2D` take it.
+        */
+        const void *buffer_offset(std::size_t offset) {
+            return reinterpret_cast<const void *>(static_cast<std::uintptr_t>(offset));
+        }
+    } // namespace
+
+    TextureUploader *TextureUploader::instance() {
+        static TextureUploader uploader;
+        return &uploader;
+    }
+
+    void TextureUploader::initialize(bool enabled, std::size_t frame_budget_bytes) {
+        if (!enabled || frame_budget_bytes == 0) {
+            spdlog::info("[TextureUploader]: textures are uploaded directly");
+            return;
+        }
+        m_segment_size        = align_up(frame_budget_bytes);
+        m_stats.staging_bytes = m_segment_size * FRAMES_IN_FLIGHT;
+        CHECKED_GL_CALL(glGenBuffers, 1, &m_buffer);
+        CHECKED_GL_CALL(glBindBuffer, GL_PIXEL_UNPACK_BUFFER, m_buffer);
+        CHECKED_GL_CALL(glBufferData, GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(m_stats.staging_bytes), nullptr,
+                        GL_STREAM_DRAW);
+        // A bound pixel unpack buffer turns the pointers of every other texture upload into offsets.
+        CHECKED_GL_CALL(glBindBuffer, GL_PIXEL_UNPACK_BUFFER, 0);
+        m_available = true;
+        spdlog::info("[TextureUploader]: uploading up to {} KiB of texture data per frame", m_segment_size / 1024);
+    }
+
+    void TextureUploader::terminate() {
+        for (auto &fence: m_fences) {
+            if (fence != nullptr) {
+                CHECKED_GL_CALL(glDeleteSync, static_cast<GLsync>(fence));
+                fence = nullptr;
+            }
+        }
+        if (m_buffer != 0) {
+            OpenGL::delete_buffer(m_buffer);
+            m_buffer = 0;
+        }
+        if (!m_queue.empty()) {
+            for (const auto &upload: m_queue) {
+                CHECKED_GL_CALL(glDeleteTextures, 1, &upload.texture);
+            }
+            m_queue.clear();
+            OpenGL::invalidate_state();
+        }
+        m_current_segment = 0;
+        m_stats           = Stats{};
+        m_available       = false;
+    }
+
+    void TextureUploader::upload(resources::Image image, OnReady on_ready) {
+        auto source = std::make_shared<resources::Image>(std::move(image));
+        Upload upload;
+        upload.target           = GL_TEXTURE_2D;
+        upload.generate_mipmaps = true;
+        upload.levels.push_back(Level{GL_TEXTURE_2D, 0, source->width, source->height, source->channels,
+                                      std::as_bytes(std::span(source->pixels))});
+        upload.source   = std::move(source);
+        upload.on_ready = std::move(on_ready);
+        enqueue(std::move(upload));
+    }
+
+    void TextureUploader::upload(resources::CompressedImage image, OnReady on_ready) {
+        RG_GUARANTEE(OpenGL::supported_block_formats() & 1u << static_cast<uint32_t>(image.format),
+                     "The OpenGL context doesn't support {} textures.", resources::block_format_name(image.format));
+        auto source = std::make_shared<resources::CompressedImage>(std::move(image));
+        Upload upload;
+        upload.target            = GL_TEXTURE_2D;
+        upload.compressed_format = OpenGL::compressed_texture_format(source->format);
+        for (std::size_t level = 0; level < source->levels.size(); ++level) {
+            const auto &mip = source->levels[level];
+            upload.levels.push_back(Level{GL_TEXTURE_2D, static_cast<int32_t>(level), mip.width, mip.height, 0,
+                                          std::as_bytes(source->level_data(level))});
+        }
+        upload.source   = std::move(source);
+        upload.on_ready = std::move(on_ready);
+        enqueue(std::move(upload));
+    }
+
+    void TextureUploader::upload(resources::BakedTexture texture, OnReady on_ready) {
+        const auto block_format = texture.block_format();
+        RG_GUARANTEE(!block_format.has_value() || OpenGL::supported_block_formats() & 1u << static_cast<uint32_t>(*block_format),
+                     "The OpenGL context doesn't support {} textures.", resources::block_format_name(*block_format));
+        auto source = std::make_shared<resources::BakedTexture>(std::move(texture));
+        Upload upload;
+        upload.target            = GL_TEXTURE_2D;
+        upload.compressed_format = block_format.has_value() ? OpenGL::compressed_texture_format(*block_format) : 0;
+        for (uint32_t level = 0; level < source->level_count(); ++level) {
+            const auto mip = source->level(level);
+            upload.levels.push_back(Level{GL_TEXTURE_2D, static_cast<int32_t>(level), mip.width, mip.height,
+                                          source->channels(), mip.data});
+        }
+        upload.source   = std::move(source);
+        upload.on_ready = std::move(on_ready);
+        enqueue(std::move(upload));
+    }
+
+    void TextureUploader::upload_cubemap(std::array<resources::Image, 6> faces, OnReady on_ready) {
+        auto source = std::make_shared<std::array<resources::Image, 6> >(std::move(faces));
+        Upload upload;
+        upload.target = GL_TEXTURE_CUBE_MAP;
+        for (uint32_t i = 0; i < source->size(); ++i) {
+            const auto &face = (*source)[i];
+            upload.levels.push_back(Level{GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, face.width, face.height, face.channels,
+                                          std::as_bytes(std::span(face.pixels))});
+        }
+        upload.source   = std::move(source);
+        upload.on_ready = std::move(on_ready);
+        enqueue(std::move(upload));
+    }
+
+    void TextureUploader::upload_levels(uint32_t texture, uint32_t compressed_format, std::vector<Level> levels,
+                                        std::shared_ptr<const void> source, OnReady on_ready) {
+        Upload upload;
+        upload.texture           = texture;
+        upload.target            = GL_TEXTURE_2D;
+        upload.compressed_format = compressed_format;
+        upload.levels            = std::move(levels);
+        upload.source            = std::move(source);
+        upload.on_ready          = std::move(on_ready);
+        enqueue(std::move(upload));
+    }
+
+    void TextureUploader::cancel(uint32_t texture) {
+        std::erase_if(m_queue, [texture](const Upload &upload) {
+            return upload.texture == texture;
+        });
+    }
+
+    void TextureUploader::enqueue(Upload upload) {
+        const bool created = upload.texture == 0;
+        if (created) {
+            CHECKED_GL_CALL(glGenTextures, 1, &upload.texture);
+        }
+        OpenGL::bind_texture(0, upload.target, upload.texture);
+        CHECKED_GL_CALL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+        for (const auto &level: upload.levels) {
+            // With the ring only the storage is allocated here, the rows come later through the staging buffer.
+            const void *data = m_available ? nullptr : level.data.data();
+            if (upload.compressed_format != 0) {
+                CHECKED_GL_CALL(glCompressedTexImage2D, level.target, level.level, upload.compressed_format, level.width,
+                                level.height, 0, static_cast<GLsizei>(level.data.size()), data);
+            } else {
+                const int32_t format = OpenGL::texture_format(level.channels);
+                CHECKED_GL_CALL(glTexImage2D, level.target, level.level, format, level.width, level.height, 0, format,
+                                GL_UNSIGNED_BYTE, data);
+            }
+        }
+        // The owner of an existing texture has set its parameters.
+        if (created && upload.target == GL_TEXTURE_CUBE_MAP) {
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        } else if (created) {
+            if (!upload.generate_mipmaps) {
+                CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                                static_cast<GLint>(upload.levels.size() - 1));
+            }
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            CHECKED_GL_CALL(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+        if (!m_available) {
+            for (const auto &level: upload.levels) {
+                m_stats.uploaded_bytes += level.data.size();
+            }
+            upload.next_level = upload.levels.size();
+            finish(std::move(upload));
+            return;
+        }
+        m_queue.push_back(std::move(upload));
+    }
+
+    int32_t TextureUploader::row_count(const Upload &upload, const Level &level) {
+        return upload.compressed_format != 0 ? (level.height + 3) / 4 : level.height;
+    }
+
+    std::size_t TextureUploader::row_size(const Upload &upload, const Level &level) {
+        return level.data.size() / row_count(upload, level);
+    }
+
+    void TextureUploader::upload_rows(const Upload &upload, const Level &level, int32_t first_row, int32_t row_count,
+                                      const void *data) {
+        OpenGL::bind_texture(0, upload.target, upload.texture);
+        const int32_t pixels_per_row = upload.compressed_format != 0 ? 4 : 1;
+        const int32_t y              = first_row * pixels_per_row;
+        const int32_t height         = std::min(row_count * pixels_per_row, level.height - y);
+        if (upload.compressed_format != 0) {
+            CHECKED_GL_CALL(glCompressedTexSubImage2D, level.target, level.level, 0, y, level.width, height,
+                            upload.compressed_format, static_cast<GLsizei>(row_count * row_size(upload, level)), data);
+        } else {
+            const int32_t format = OpenGL::texture_format(level.channels);
+            CHECKED_GL_CALL(glTexSubImage2D, level.target, level.level, 0, y, level.width, height, format,
+                            GL_UNSIGNED_BYTE, data);
+        }
+    }
+
+    void TextureUploader::update() {
+        if (!m_available || m_queue.empty()) {
+            return;
+        }
+        void *&fence = m_fences[m_current_segment];
+        if (fence != nullptr) {
+            const GLenum status = CHECKED_GL_CALL(glClientWaitSync, static_cast<GLsync>(fence), 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                ++m_stats.stalled_frames;
+                return;
+            }
+            CHECKED_GL_CALL(glDeleteSync, static_cast<GLsync>(fence));
+            fence = nullptr;
+        }
+
+        // Takes the next rows of the queued textures, in order, until the segment is full.
+        std::vector<Copy> copies;
+        std::size_t used = 0;
+        for (std::size_t i = 0; i < m_queue.size() && used < m_segment_size; ++i) {
+            Upload &upload = m_queue[i];
+            while (upload.next_level < upload.levels.size()) {
+                const Level &level         = upload.levels[upload.next_level];
+                const int32_t total_rows   = row_count(upload, level);
+                const std::size_t row_size = TextureUploader::row_size(upload, level);
+                const auto rows            = static_cast<int32_t>(std::min<std::size_t>(
+                        total_rows - upload.next_row, (m_segment_size - used) / row_size));
+                if (rows == 0) {
+                    break;
+                }
+                copies.push_back(Copy{i, upload.next_level, upload.next_row, rows, used});
+                used = std::min(align_up(used + rows * row_size), m_segment_size);
+                upload.next_row += rows;
+                if (upload.next_row == total_rows) {
+                    ++upload.next_level;
+                    upload.next_row = 0;
+                }
+            }
+            if (upload.next_level < upload.levels.size()) {
+                break;
+            }
+        }
+        if (copies.empty()) {
+            // A single row is larger than the frame budget; it goes directly rather than never.
+            Upload &upload      = m_queue.front();
+            const Level &level  = upload.levels[upload.next_level];
+            const auto row_size = TextureUploader::row_size(upload, level);
+            CHECKED_GL_CALL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+            upload_rows(upload, level, upload.next_row, 1, level.data.data() + upload.next_row * row_size);
+            m_stats.uploaded_bytes += row_size;
+            if (++upload.next_row == row_count(upload, level)) {
+                ++upload.next_level;
+                upload.next_row = 0;
+            }
+        } else {
+            const std::size_t segment_offset = m_current_segment * m_segment_size;
+            CHECKED_GL_CALL(glBindBuffer, GL_PIXEL_UNPACK_BUFFER, m_buffer);
+            // The fence guarantees the GPU is done with the segment, so the driver doesn't have to synchronize.
+            auto *staging = static_cast<std::byte *>(CHECKED_GL_CALL(
+                    glMapBufferRange, GL_PIXEL_UNPACK_BUFFER, static_cast<GLintptr>(segment_offset),
+                    static_cast<GLsizeiptr>(used),
+                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+            bool staged = staging != nullptr;
+            if (staged) {
+                for (const auto &copy: copies) {
+                    const Upload &upload = m_queue[copy.upload];
+                    const Level &level   = upload.levels[copy.level];
+                    const auto row_size  = TextureUploader::row_size(upload, level);
+                    std::memcpy(staging + copy.offset, level.data.data() + copy.first_row * row_size,
+                                copy.row_count * row_size);
+                }
+                // The contents of the mapping are lost if the unmap fails, e.g. after a display mode change.
+                staged = CHECKED_GL_CALL(glUnmapBuffer, GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+            }
+            if (!staged) {
+                spdlog::warn("[TextureUploader]: the staging buffer couldn't be written, uploading directly");
+                CHECKED_GL_CALL(glBindBuffer, GL_PIXEL_UNPACK_BUFFER, 0);
+            }
+            CHECKED_GL_CALL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+            for (const auto &copy: copies) {
+                const Upload &upload = m_queue[copy.upload];
+                const Level &level   = upload.levels[copy.level];
+                const auto row_size  = TextureUploader::row_size(upload, level);
+                upload_rows(upload, level, copy.first_row, copy.row_count,
+                            staged
+                                ? buffer_offset(segment_offset + copy.offset)
+                                : level.data.data() + copy.first_row * row_size);
+                m_stats.uploaded_bytes += copy.row_count * row_size;
+            }
+            if (staged) {
+                fence = CHECKED_GL_CALL(glFenceSync, GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                CHECKED_GL_CALL(glBindBuffer, GL_PIXEL_UNPACK_BUFFER, 0);
+            }
+            m_current_segment = (m_current_segment + 1) % FRAMES_IN_FLIGHT;
+        }
+
+        // The textures are taken in order, so the finished ones are at the front of the queue.
+        while (!m_queue.empty() && m_queue.front().next_level == m_queue.front().levels.size()) {
+            Upload upload = std::move(m_queue.front());
+            m_queue.pop_front();
+            finish(std::move(upload));
+        }
+    }
+
+    void TextureUploader::flush() {
+        if (m_queue.empty()) {
+            return;
+        }
+        CHECKED_GL_CALL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+        while (!m_queue.empty()) {
+            Upload upload = std::move(m_queue.front());
+            m_queue.pop_front();
+            for (; upload.next_level < upload.levels.size(); ++upload.next_level) {
+                const Level &level  = upload.levels[upload.next_level];
+                const auto size    = row_size(upload, level);
+                const int32_t rows = row_count(upload, level) - upload.next_row;
+                upload_rows(upload, level, upload.next_row, rows, level.data.data() + upload.next_row * size);
+                m_stats.uploaded_bytes += rows * size;
+                upload.next_row = 0;
+            }
+            finish(std::move(upload));
+        }
+    }
+
+    void TextureUploader::finish(Upload upload) {
+        if (upload.generate_mipmaps) {
+            OpenGL::bind_texture(0, upload.target, upload.texture);
+            CHECKED_GL_CALL(glGenerateMipmap, upload.target);
+        }
+        ++m_stats.uploaded_textures;
+        upload.on_ready(upload.texture);
+    }
+
+    TextureUploader::Stats TextureUploader::stats() const {
+        Stats stats            = m_stats;
+        stats.pending_textures = static_cast<uint32_t>(m_queue.size());
+        for (const auto &upload: m_queue) {
+            for (std::size_t i = upload.next_level; i < upload.levels.size(); ++i) {
+                stats.pending_bytes += upload.levels[i].data.size();
+            }
+            if (upload.next_level < upload.levels.size()) {
+                stats.pending_bytes -= upload.next_row * row_size(upload, upload.levels[upload.next_level]);
+            }
+        }
+        return stats;
+    }
+} // namespace engine::graphics
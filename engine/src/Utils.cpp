@@ -90,6 +90,7 @@ namespace engine::util {
         for (int i = 0; i < m_argc; ++i) {
             std::string_view token(m_argv[i]);
             if (token == arg_name) {
+                RG_GUARANTEE(i + 1 < m_argc, "No get_arg_value for argument: \"{}\" provided.", arg_name);
                 std::string arg_value(m_argv[i + 1]);
                 RG_GUARANTEE(!arg_value.starts_with("--"), "No get_arg_value for argument: \"{}\" provided.", arg_name);
                 return arg_value;
@@ -98,6 +99,15 @@ namespace engine::util {
         return "";
     }
 
+    bool ArgParser::flag(std::string_view name) const {
+        for (int i = 0; i < m_argc; ++i) {
+            if (std::string_view(m_argv[i]) == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     std::string read_text_file(const std::filesystem::path &path) {
         RG_GUARANTEE(std::filesystem::exists(path), "File {} doesn't exist.", path.string());
         std::ifstream file(path);
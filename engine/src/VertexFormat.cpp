@@ -0,0 +1,215 @@
+#include <glad/glad.h>
+#include <glm/gtc/packing.hpp>
+#include <glm/packing.hpp>
+#include <engine/graphics/OpenGL.hpp>
+#include <engine/graphics/VertexFormat.hpp>
+#include <engine/resources/Mesh.hpp>
+#include <engine/util/Errors.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace engine::graphics {
+    namespace {
+        struct CompactVertex {
+            glm::vec3 position;
+            uint32_t normal;
+            uint32_t tex_coords;
+            uint32_t tangent;
+        };
+
+        struct CompactHalfPositionVertex {
+            std::array<uint16_t, 4> position;
+            uint32_t normal;
+            uint32_t tex_coords;
+            uint32_t tangent;
+        };
+
+        static_assert(sizeof(CompactVertex) == 24);
+        static_assert(sizeof(CompactHalfPositionVertex) == 20);
+
+        /**
+        * @brief Half floats have 11 significant bits, so above this the uvs of a texture repeated a few times
+        * lose more than a texel of a 1024 texture.
+        */
+        constexpr float MAX_HALF_TEX_COORD = 4.0f;
+
+        /**
+        * @brief The largest finite half float; larger coordinates would turn into infinities.
+        */
+        constexpr float MAX_HALF = 65504.0f;
+
+        /**
+        * @brief Packs the unit vector `v` and the `w` in {-1, 0, 1} as `GL_INT_2_10_10_10_REV`.
+        */
+        uint32_t pack_direction(const glm::vec3 &v, float w) {
+            const float length = glm::length(v);
+            return glm::packSnorm3x10_1x2(glm::vec4(length > 0.0f ? v / length : v, w));
+        }
+
+        template<typename TCompactVertex>
+        void encode_shading(const resources::Vertex &vertex, TCompactVertex &out) {
+            // The bitangent is -1 or 1 times cross(normal, tangent), so its sign is all the compact formats keep.
+            const float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f
+                                     ? -1.0f
+                                     : 1.0f;
+            out.normal     = pack_direction(vertex.Normal, 0.0f);
+            out.tex_coords = glm::packHalf2x16(vertex.TexCoords);
+            out.tangent    = pack_direction(vertex.Tangent, handedness);
+        }
+
+        /**
+        * @brief Returns the largest rounding error of the coordinates in the `box` stored as half floats,
+        * or infinity if they don't fit the half float range.
+        */
+        float half_position_error(const BoundingBox &box) {
+            const glm::vec3 largest = glm::max(glm::abs(box.min), glm::abs(box.max));
+            const float magnitude   = std::max({largest.x, largest.y, largest.z});
+            if (magnitude == 0.0f) {
+                return 0.0f;
+            }
+            if (!(magnitude <= MAX_HALF)) {
+                return std::numeric_limits<float>::infinity();
+            }
+            // The spacing of the half floats in [2^e, 2^(e+1)) is 2^(e-10), and rounding is off by half of it.
+            return std::ldexp(1.0f, std::ilogb(magnitude) - 11);
+        }
+    } // namespace
+
+    uint32_t vertex_size(VertexFormat format) {
+        switch (format) {
+        case VertexFormat::Standard: return sizeof(resources::Vertex);
+        case VertexFormat::Compact: return sizeof(CompactVertex);
+        case VertexFormat::CompactHalfPosition: return sizeof(CompactHalfPositionVertex);
+        default: RG_SHOULD_NOT_REACH_HERE("Unhandled vertex format: {}", static_cast<uint32_t>(format));
+        }
+    }
+
+    std::string_view vertex_format_name(VertexFormat format) {
+        switch (format) {
+        case VertexFormat::Standard: return "Standard";
+        case VertexFormat::Compact: return "Compact";
+        case VertexFormat::CompactHalfPosition: return "CompactHalfPosition";
+        default: RG_SHOULD_NOT_REACH_HERE("Unhandled vertex format: {}", static_cast<uint32_t>(format));
+        }
+    }
+
+    void set_vertex_attributes(VertexFormat format) {
+        using resources::Vertex;
+        switch (format) {
+        case VertexFormat::Standard: {
+            // NOLINTBEGIN
+            CHECKED_GL_CALL(glEnableVertexAttribArray, 0);
+            CHECKED_GL_CALL(glVertexAttribPointer, 0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                            (void *) offsetof(Vertex, Position));
+            CHECKED_GL_CALL(glEnableVertexAttribArray, 1);
+            CHECKED_GL_CALL(glVertexAttribPointer, 1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                            (void *) offsetof(Vertex, Normal));
+            CHECKED_GL_CALL(glEnableVertexAttribArray, 2);
+            CHECKED_GL_CALL(glVertexAttribPointer, 2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                            (void *) offsetof(Vertex, TexCoords));
+            CHECKED_GL_CALL(glEnableVertexAttribArray, 3);
+            CHECKED_GL_CALL(glVertexAttribPointer, 3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                            (void *) offsetof(Vertex, Tangent));
+            CHECKED_GL_CALL(glEnableVertexAttribArray, 4);
+            CHECKED_GL_CALL(glVertexAttribPointer, 4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                            (void *) offsetof(Vertex, Bitangent));
+            // NOLINTEND
+            break;
+        }
+        case VertexFormat::Compact:
+        case VertexFormat::CompactHalfPosition: {
+            // The two compact formats only differ in the position, the rest of the vertex is laid out the same.
+            const bool half_position = format == VertexFormat::CompactHalfPosition;
+            const auto stride        = static_cast<GLsizei>(vertex_size(format));
+            const std::size_t shading_offset = half_position
+                                               ? offsetof(CompactHalfPositionVertex, normal)
+                                               : offsetof(CompactVertex, normal);
+            // NOLINTBEGIN
+            CHECKED_GL_CALL(glEnableVertexAttribArray, 0);
+            CHECKED_GL_CALL(glVertexAttribPointer, 0, 3, half_position ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, stride,
+                            (void *) 0);
+            CHECKED_GL_CALL(glEnableVertexAttribArray, 1);
+            CHECKED_GL_CALL(glVertexAttribPointer, 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                            (void *) shading_offset);
+            CHECKED_GL_CALL(glEnableVertexAttribArray, 2);
+            CHECKED_GL_CALL(glVertexAttribPointer, 2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+                            (void *) (shading_offset + sizeof(uint32_t)));
+            CHECKED_GL_CALL(glEnableVertexAttribArray, 3);
+            CHECKED_GL_CALL(glVertexAttribPointer, 3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                            (void *) (shading_offset + 2 * sizeof(uint32_t)));
+            // NOLINTEND
+            break;
+        }
+        default: RG_SHOULD_NOT_REACH_HERE("Unhandled vertex format: {}", static_cast<uint32_t>(format));
+        }
+    }
+
+    void encode_vertices(VertexFormat format, std::span<const resources::Vertex> vertices, std::span<std::byte> out) {
+        RG_GUARANTEE(out.size() >= vertices.size() * vertex_size(format), "The vertex encoding output is too small.");
+        switch (format) {
+        case VertexFormat::Standard: {
+            std::memcpy(out.data(), vertices.data(), vertices.size_bytes());
+            break;
+        }
+        case VertexFormat::Compact: {
+            for (std::size_t i = 0; i < vertices.size(); ++i) {
+                CompactVertex vertex;
+                vertex.position = vertices[i].Position;
+                encode_shading(vertices[i], vertex);
+                std::memcpy(out.data() + i * sizeof(CompactVertex), &vertex, sizeof(CompactVertex));
+            }
+            break;
+        }
+        case VertexFormat::CompactHalfPosition: {
+            for (std::size_t i = 0; i < vertices.size(); ++i) {
+                CompactHalfPositionVertex vertex;
+                const glm::vec3 &position = vertices[i].Position;
+                vertex.position = {
+                        glm::packHalf1x16(position.x), glm::packHalf1x16(position.y), glm::packHalf1x16(position.z),
+                        glm::packHalf1x16(1.0f)
+                };
+                encode_shading(vertices[i], vertex);
+                std::memcpy(out.data() + i * sizeof(CompactHalfPositionVertex), &vertex,
+                            sizeof(CompactHalfPositionVertex));
+            }
+            break;
+        }
+        default: RG_SHOULD_NOT_REACH_HERE("Unhandled vertex format: {}", static_cast<uint32_t>(format));
+        }
+    }
+
+    uint32_t VertexCompression::key() const {
+        if (!enabled) {
+            return 0;
+        }
+        if (!half_positions) {
+            return 1;
+        }
+        // The tolerance only matters with the half positions; it's kept in millionths of the diagonal.
+        return 3u | static_cast<uint32_t>(std::lround(position_tolerance * 1e6f)) << 2;
+    }
+
+    VertexFormat choose_vertex_format(std::span<const resources::Vertex> vertices, const Bounds &bounds,
+                                      const VertexCompression &compression) {
+        if (!compression.enabled || vertices.empty()) {
+            return VertexFormat::Standard;
+        }
+        const bool tex_coords_fit = std::all_of(vertices.begin(), vertices.end(), [](const resources::Vertex &vertex) {
+            return std::abs(vertex.TexCoords.x) <= MAX_HALF_TEX_COORD &&
+                   std::abs(vertex.TexCoords.y) <= MAX_HALF_TEX_COORD;
+        });
+        if (!tex_coords_fit) {
+            return VertexFormat::Standard;
+        }
+        if (compression.half_positions && !bounds.box.empty()) {
+            const float diagonal = glm::length(bounds.box.max - bounds.box.min);
+            if (half_position_error(bounds.box) <= compression.position_tolerance * diagonal) {
+                return VertexFormat::CompactHalfPosition;
+            }
+        }
+        return VertexFormat::Compact;
+    }
+} // namespace engine::graphics
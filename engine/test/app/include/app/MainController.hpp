@@ -29,6 +29,8 @@ namespace engine::test::app {
 
         void draw_backpack();
 
+        void draw_crates();
+
         void update_camera();
 
         float m_backpack_scale{1.0f};
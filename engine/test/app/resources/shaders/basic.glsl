@@ -9,9 +9,15 @@ out vec2 TexCoords;
 out vec3 Normal;
 out vec3 FragPos;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec4 camera_position;
+};
+
+layout (std140) uniform Object {
+    mat4 model;
+};
 
 void main()
 {
@@ -30,6 +36,12 @@ in vec2 TexCoords;
 
 uniform sampler2D texture_diffuse1;
 
+layout (std140) uniform Material {
+    vec4 diffuse_color;
+    vec4 specular_color;
+    float shininess;
+};
+
 void main() {
-    FragColor = vec4(texture(texture_diffuse1, TexCoords).rgb, 1.0);
+    FragColor = vec4(texture(texture_diffuse1, TexCoords).rgb * diffuse_color.rgb, 1.0);
 }
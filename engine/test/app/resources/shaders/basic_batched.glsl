@@ -0,0 +1,49 @@
+//#shader vertex
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 9) in uint aDrawId;
+
+out vec2 TexCoords;
+out vec3 Normal;
+out vec3 FragPos;
+
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec4 camera_position;
+};
+
+uniform samplerBuffer draw_transforms;
+
+void main()
+{
+    int base = int(aDrawId) * 4;
+    mat4 model = mat4(texelFetch(draw_transforms, base), texelFetch(draw_transforms, base + 1),
+                      texelFetch(draw_transforms, base + 2), texelFetch(draw_transforms, base + 3));
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = aNormal;
+    TexCoords = aTexCoords;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
+
+//#shader fragment
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D texture_diffuse1;
+
+layout (std140) uniform Material {
+    vec4 diffuse_color;
+    vec4 specular_color;
+    float shininess;
+};
+
+void main() {
+    FragColor = vec4(texture(texture_diffuse1, TexCoords).rgb * diffuse_color.rgb, 1.0);
+}
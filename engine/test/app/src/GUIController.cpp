@@ -1,6 +1,7 @@
 #include <imgui.h>
 #include <engine/core/Engine.hpp>
 #include <app/GUIController.hpp>
+#include <app/MainController.hpp>
 #include <engine/graphics/GraphicsController.hpp>
 
 namespace engine::test::app {
@@ -34,6 +35,56 @@ namespace engine::test::app {
         ImGui::Text("(Yaw, Pitch): (%f, %f)", c.Yaw, c.Pitch);
         ImGui::Text("Camera front: (%f, %f, %f)", c.Front.x, c.Front.y, c.Front.z);
         ImGui::End();
+
+        // Draw render queue stats of the last frame
+        const auto &stats = graphics->render_stats();
+        ImGui::Begin("Render stats");
+        ImGui::Text("Submitted: %u (culled %u)", stats.submitted, stats.culled);
+        ImGui::Text("Draw calls: %u", stats.draw_calls);
+        ImGui::Text("Batches: %u (%u meshes)", stats.batches, stats.batched_draws);
+        ImGui::Text("Program binds: %u (elided %u)", stats.program_binds, stats.program_binds_elided);
+        ImGui::Text("Texture binds: %u (elided %u)", stats.texture_binds, stats.texture_binds_elided);
+        ImGui::Text("VAO binds: %u (elided %u)", stats.vao_binds, stats.vao_binds_elided);
+        ImGui::Text("Uniform buffer binds: %u (elided %u)", stats.uniform_buffer_binds, stats.uniform_buffer_binds_elided);
+        const auto &state = graphics->state_stats();
+        ImGui::Text("GL state calls elided: %u (depth func %u/%u, enables %u/%u)", state.elided(),
+                    state.depth_func_changes, state.depth_func_changes_elided, state.capability_changes,
+                    state.capability_changes_elided);
+        const auto arena = engine::graphics::GeometryArena::instance()->stats();
+        ImGui::Text("Geometry arena: %u blocks, vertices %.1f/%.1f MiB, indices %.1f/%.1f MiB", arena.blocks,
+                    arena.vertex_bytes_used / 1048576.0, arena.vertex_bytes_capacity / 1048576.0,
+                    arena.index_bytes_used / 1048576.0, arena.index_bytes_capacity / 1048576.0);
+        const auto uploads = engine::graphics::TextureUploader::instance()->stats();
+        ImGui::Text("Texture uploads: %u pending (%.1f MiB), %llu done (%.1f MiB), %llu stalled frames",
+                    uploads.pending_textures, uploads.pending_bytes / 1048576.0,
+                    static_cast<unsigned long long>(uploads.uploaded_textures), uploads.uploaded_bytes / 1048576.0,
+                    static_cast<unsigned long long>(uploads.stalled_frames));
+        const auto streaming = engine::graphics::TextureStreamer::instance()->stats();
+        ImGui::Text("Texture streaming: %u/%u resident, %.1f/%.1f MiB (needs %.1f), %llu loaded, %llu evicted",
+                    streaming.fully_resident, streaming.textures, streaming.resident_bytes / 1048576.0,
+                    streaming.budget_bytes / 1048576.0, streaming.required_bytes / 1048576.0,
+                    static_cast<unsigned long long>(streaming.levels_loaded),
+                    static_cast<unsigned long long>(streaming.levels_evicted));
+        ImGui::End();
+
+        // Draw update timing of the last frame; controllers marked with * are on the critical path
+        ImGui::Begin("Update timing");
+        const core::Controller *controllers[] = {
+                engine::core::Controller::get<platform::PlatformController>(),
+                graphics,
+                engine::core::Controller::get<resources::ResourcesController>(),
+                engine::core::Controller::get<MainController>(),
+                this,
+        };
+        for (const auto controller: controllers) {
+            const auto &timing = controller->update_timing();
+            ImGui::Text("%c %-22s start %7.3f ms, took %7.3f ms, thread %u", timing.on_critical_path ? '*' : ' ',
+                        std::string(controller->name()).c_str(), timing.start_ms, timing.duration_ms,
+                        timing.thread_index);
+        }
+        ImGui::End();
+
+        util::Profiler::instance()->draw_gui();
         graphics->end_gui();
     }
 }
@@ -49,6 +49,7 @@ namespace engine::test::app {
 
     void MainController::draw() {
         draw_backpack();
+        draw_crates();
         draw_skybox();
     }
 
@@ -60,11 +61,17 @@ namespace engine::test::app {
         auto graphics = engine::core::Controller::get<engine::graphics::GraphicsController>();
         auto shader   = engine::core::Controller::get<engine::resources::ResourcesController>()->shader("basic");
         auto backpack = engine::core::Controller::get<engine::resources::ResourcesController>()->model("backpack");
-        shader->use();
-        shader->set_mat4("projection", graphics->projection_matrix());
-        shader->set_mat4("view", graphics->camera()->view_matrix());
-        shader->set_mat4("model", scale(glm::mat4(1.0f), glm::vec3(m_backpack_scale)));
-        backpack->draw(shader);
+        graphics->draw_model(backpack, shader, scale(glm::mat4(1.0f), glm::vec3(m_backpack_scale)));
+    }
+
+    void MainController::draw_crates() {
+        auto graphics = engine::core::Controller::get<engine::graphics::GraphicsController>();
+        // The crate packs its textures, so all the crates draw in one batch with the materials of the pack.
+        auto shader   = engine::core::Controller::get<engine::resources::ResourcesController>()->shader("basic_packed");
+        auto crate    = engine::core::Controller::get<engine::resources::ResourcesController>()->model("crate");
+        for (int i = 0; i < 8; ++i) {
+            graphics->draw_model(crate, shader, translate(glm::mat4(1.0f), glm::vec3(2.0f * i - 8.0f, -3.0f, -4.0f)));
+        }
     }
 
     void MainController::draw_skybox() {